@@ -511,8 +511,11 @@ gdk_directfb_window_new (GdkWindow              *parent,
                                   (attributes->cursor) : NULL));
 
   if (parent_private)
-    parent_private->children = g_list_prepend (parent_private->children,
-                                               window);
+    {
+      parent_private->children = g_list_prepend (parent_private->children,
+                                                 window);
+      _gdk_window_children_changed ((GdkWindow *) parent_private);
+    }
 
   /* we hold a reference count on ourselves */
   g_object_ref (window);
@@ -874,6 +877,7 @@ gdk_directfb_window_raise (GdkWindow *window)
 
   parent->children = g_list_remove (parent->children, window);
   parent->children = g_list_prepend (parent->children, window);
+  _gdk_window_children_changed ((GdkWindow *) parent);
 
   return TRUE;
 }
@@ -889,6 +893,7 @@ gdk_directfb_window_lower (GdkWindow *window)
 
   parent->children = g_list_remove (parent->children, window);
   parent->children = g_list_append (parent->children, window);
+  _gdk_window_children_changed ((GdkWindow *) parent);
 }
 
 static gboolean
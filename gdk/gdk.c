@@ -81,7 +81,9 @@ static const GDebugKey gdk_debug_keys[] = {
   {"multihead",	    GDK_DEBUG_MULTIHEAD},
   {"xinerama",	    GDK_DEBUG_XINERAMA},
   {"draw",	    GDK_DEBUG_DRAW},
-  {"eventloop",	    GDK_DEBUG_EVENTLOOP}
+  {"eventloop",	    GDK_DEBUG_EVENTLOOP},
+  {"frames",	    GDK_DEBUG_FRAMES},
+  {"roundtrips",    GDK_DEBUG_ROUNDTRIPS}
 };
 
 static const int gdk_ndebug_keys = G_N_ELEMENTS (gdk_debug_keys);
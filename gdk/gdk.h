@@ -40,6 +40,7 @@
 #include <gdk/gdkenumtypes.h>
 #include <gdk/gdkevents.h>
 #include <gdk/gdkfont.h>
+#include <gdk/gdkframeclock.h>
 #include <gdk/gdkgc.h>
 #include <gdk/gdkimage.h>
 #include <gdk/gdkinput.h>
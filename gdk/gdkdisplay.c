@@ -290,6 +290,87 @@ gdk_display_put_event (GdkDisplay     *display,
   g_main_context_wakeup (NULL); 
 }
 
+typedef struct
+{
+  guint motion;
+  guint scroll;
+  guint configure;
+} GdkCompressedEvents;
+
+static GdkCompressedEvents *
+get_compressed_events (GdkDisplay *display)
+{
+  GdkCompressedEvents *counts;
+
+  counts = g_object_get_data (G_OBJECT (display), "gdk-compressed-events");
+  if (counts == NULL)
+    {
+      counts = g_new0 (GdkCompressedEvents, 1);
+      g_object_set_data_full (G_OBJECT (display), "gdk-compressed-events",
+			      counts, g_free);
+    }
+
+  return counts;
+}
+
+void
+_gdk_display_count_compressed_event (GdkDisplay   *display,
+				     GdkEventType  type)
+{
+  GdkCompressedEvents *counts = get_compressed_events (display);
+
+  switch (type)
+    {
+    case GDK_MOTION_NOTIFY:
+      counts->motion++;
+      break;
+    case GDK_SCROLL:
+      counts->scroll++;
+      break;
+    case GDK_CONFIGURE:
+      counts->configure++;
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+/**
+ * gdk_display_get_n_compressed_events:
+ * @display: a #GdkDisplay
+ * @type: %GDK_MOTION_NOTIFY, %GDK_SCROLL or %GDK_CONFIGURE
+ *
+ * Returns how many events of type @type were merged into later events
+ * on @display, and thus never delivered on their own, because their
+ * window asked for it with gdk_window_set_event_compression().
+ *
+ * Return value: the number of compressed events
+ *
+ * Since: 2.24
+ **/
+guint
+gdk_display_get_n_compressed_events (GdkDisplay   *display,
+				     GdkEventType  type)
+{
+  GdkCompressedEvents *counts;
+
+  g_return_val_if_fail (GDK_IS_DISPLAY (display), 0);
+
+  counts = get_compressed_events (display);
+
+  switch (type)
+    {
+    case GDK_MOTION_NOTIFY:
+      return counts->motion;
+    case GDK_SCROLL:
+      return counts->scroll;
+    case GDK_CONFIGURE:
+      return counts->configure;
+    default:
+      return 0;
+    }
+}
+
 /**
  * gdk_pointer_ungrab:
  * @time_: a timestamp from a #GdkEvent, or %GDK_CURRENT_TIME if no 
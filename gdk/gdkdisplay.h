@@ -165,6 +165,8 @@ GdkEvent* gdk_display_get_event  (GdkDisplay     *display);
 GdkEvent* gdk_display_peek_event (GdkDisplay     *display);
 void      gdk_display_put_event  (GdkDisplay     *display,
 				  const GdkEvent *event);
+guint     gdk_display_get_n_compressed_events (GdkDisplay   *display,
+                                               GdkEventType  type);
 
 void gdk_display_add_client_message_filter (GdkDisplay   *display,
 					    GdkAtom       message_type,
@@ -34,6 +34,7 @@
 #include "gdkwindow.h"
 #include "gdkscreen.h"
 #include "gdkpixbuf.h"
+#include "gdkpixelkernels.h"
 #include "gdkalias.h"
 
 static GdkImage*    gdk_drawable_real_get_image (GdkDrawable     *drawable,
@@ -1383,214 +1384,6 @@ _gdk_drawable_ref_cairo_surface (GdkDrawable *drawable)
   return GDK_DRAWABLE_GET_CLASS (drawable)->ref_cairo_surface (drawable);
 }
 
-static void
-composite (guchar *src_buf,
-	   gint    src_rowstride,
-	   guchar *dest_buf,
-	   gint    dest_rowstride,
-	   gint    width,
-	   gint    height)
-{
-  guchar *src = src_buf;
-  guchar *dest = dest_buf;
-
-  while (height--)
-    {
-      gint twidth = width;
-      guchar *p = src;
-      guchar *q = dest;
-
-      while (twidth--)
-	{
-	  guchar a = p[3];
-	  guint t;
-
-	  t = a * p[0] + (255 - a) * q[0] + 0x80;
-	  q[0] = (t + (t >> 8)) >> 8;
-	  t = a * p[1] + (255 - a) * q[1] + 0x80;
-	  q[1] = (t + (t >> 8)) >> 8;
-	  t = a * p[2] + (255 - a) * q[2] + 0x80;
-	  q[2] = (t + (t >> 8)) >> 8;
-
-	  p += 4;
-	  q += 3;
-	}
-      
-      src += src_rowstride;
-      dest += dest_rowstride;
-    }
-}
-
-static void
-composite_0888 (guchar      *src_buf,
-		gint         src_rowstride,
-		guchar      *dest_buf,
-		gint         dest_rowstride,
-		GdkByteOrder dest_byte_order,
-		gint         width,
-		gint         height)
-{
-  guchar *src = src_buf;
-  guchar *dest = dest_buf;
-
-  while (height--)
-    {
-      gint twidth = width;
-      guchar *p = src;
-      guchar *q = dest;
-
-      if (dest_byte_order == GDK_LSB_FIRST)
-	{
-	  while (twidth--)
-	    {
-	      guint t;
-	      
-	      t = p[3] * p[2] + (255 - p[3]) * q[0] + 0x80;
-	      q[0] = (t + (t >> 8)) >> 8;
-	      t = p[3] * p[1] + (255 - p[3]) * q[1] + 0x80;
-	      q[1] = (t + (t >> 8)) >> 8;
-	      t = p[3] * p[0] + (255 - p[3]) * q[2] + 0x80;
-	      q[2] = (t + (t >> 8)) >> 8;
-	      p += 4;
-	      q += 4;
-	    }
-	}
-      else
-	{
-	  while (twidth--)
-	    {
-	      guint t;
-	      
-	      t = p[3] * p[0] + (255 - p[3]) * q[1] + 0x80;
-	      q[1] = (t + (t >> 8)) >> 8;
-	      t = p[3] * p[1] + (255 - p[3]) * q[2] + 0x80;
-	      q[2] = (t + (t >> 8)) >> 8;
-	      t = p[3] * p[2] + (255 - p[3]) * q[3] + 0x80;
-	      q[3] = (t + (t >> 8)) >> 8;
-	      p += 4;
-	      q += 4;
-	    }
-	}
-      
-      src += src_rowstride;
-      dest += dest_rowstride;
-    }
-}
-
-#ifdef USE_MEDIALIB
-static void
-composite_0888_medialib (guchar      *src_buf,
-			 gint         src_rowstride,
-			 guchar      *dest_buf,
-			 gint         dest_rowstride,
-			 GdkByteOrder dest_byte_order,
-			 gint         width,
-			 gint         height)
-{
-  guchar *src  = src_buf;
-  guchar *dest = dest_buf;
-
-  mlib_image img_src, img_dst;
-
-  mlib_ImageSetStruct (&img_dst,
-                       MLIB_BYTE,
-                       4,
-                       width,
-                       height,
-                       dest_rowstride,
-                       dest_buf);
-
-  mlib_ImageSetStruct (&img_src,
-                       MLIB_BYTE,
-                       4,
-                       width,
-                       height,
-                       src_rowstride,
-                       src_buf);
-
-  if (dest_byte_order == GDK_LSB_FIRST)
-      mlib_ImageBlendRGBA2BGRA (&img_dst, &img_src);
-  else
-      mlib_ImageBlendRGBA2ARGB (&img_dst, &img_src);
-}
-#endif
-
-static void
-composite_565 (guchar      *src_buf,
-	       gint         src_rowstride,
-	       guchar      *dest_buf,
-	       gint         dest_rowstride,
-	       GdkByteOrder dest_byte_order,
-	       gint         width,
-	       gint         height)
-{
-  guchar *src = src_buf;
-  guchar *dest = dest_buf;
-
-  while (height--)
-    {
-      gint twidth = width;
-      guchar *p = src;
-      gushort *q = (gushort *)dest;
-
-      while (twidth--)
-	{
-	  guchar a = p[3];
-	  guint tr, tg, tb;
-	  guint tr1, tg1, tb1;
-	  guint tmp = *q;
-
-#if 1
-	  /* This is fast, and corresponds to what composite() above does
-	   * if we converted to 8-bit first.
-	   */
-	  tr = (tmp & 0xf800);
-	  tr1 = a * p[0] + (255 - a) * ((tr >> 8) + (tr >> 13)) + 0x80;
-	  tg = (tmp & 0x07e0);
-	  tg1 = a * p[1] + (255 - a) * ((tg >> 3) + (tg >> 9)) + 0x80;
-	  tb = (tmp & 0x001f);
-	  tb1 = a * p[2] + (255 - a) * ((tb << 3) + (tb >> 2)) + 0x80;
-
-	  *q = (((tr1 + (tr1 >> 8)) & 0xf800) |
-		(((tg1 + (tg1 >> 8)) & 0xfc00) >> 5)  |
-		((tb1 + (tb1 >> 8)) >> 11));
-#else
-	  /* This version correspond to the result we get with XRENDER -
-	   * a bit of precision is lost since we convert to 8 bit after premultiplying
-	   * instead of at the end
-	   */
-	  guint tr2, tg2, tb2;
-	  guint tr3, tg3, tb3;
-	  
-	  tr = (tmp & 0xf800);
-	  tr1 = (255 - a) * ((tr >> 8) + (tr >> 13)) + 0x80;
-	  tr2 = a * p[0] + 0x80;
-	  tr3 = ((tr1 + (tr1 >> 8)) >> 8) + ((tr2 + (tr2 >> 8)) >> 8);
-
-	  tg = (tmp & 0x07e0);
-	  tg1 = (255 - a) * ((tg >> 3) + (tg >> 9)) + 0x80;
-	  tg2 = a * p[0] + 0x80;
-	  tg3 = ((tg1 + (tg1 >> 8)) >> 8) + ((tg2 + (tg2 >> 8)) >> 8);
-
-	  tb = (tmp & 0x001f);
-	  tb1 = (255 - a) * ((tb << 3) + (tb >> 2)) + 0x80;
-	  tb2 = a * p[0] + 0x80;
-	  tb3 = ((tb1 + (tb1 >> 8)) >> 8) + ((tb2 + (tb2 >> 8)) >> 8);
-
-	  *q = (((tr3 & 0xf8) << 8) |
-		((tg3 & 0xfc) << 3) |
-		((tb3 >> 3)));
-#endif
-	  
-	  p += 4;
-	  q++;
-	}
-      
-      src += src_rowstride;
-      dest += dest_rowstride;
-    }
-}
-
 /* Implementation of the old vfunc in terms of the new one
    in case someone calls it directly (which they shouldn't!) */
 static void
@@ -1725,13 +1518,8 @@ gdk_drawable_real_draw_pixbuf (GdkDrawable  *drawable,
   if (gdk_pixbuf_get_has_alpha (pixbuf))
     {
       GdkVisual *visual = gdk_drawable_get_visual (drawable);
-      void (*composite_func) (guchar       *src_buf,
-			      gint          src_rowstride,
-			      guchar       *dest_buf,
-			      gint          dest_rowstride,
-			      GdkByteOrder  dest_byte_order,
-			      gint          width,
-			      gint          height) = NULL;
+      const GdkPixelKernels *kernels = _gdk_pixel_kernels_get ();
+      GdkCompositeFunc composite_func = NULL;
 
       /* First we see if we have a visual-specific composition function that can composite
        * the pixbuf data directly onto the image
@@ -1746,21 +1534,12 @@ gdk_drawable_real_draw_pixbuf (GdkDrawable  *drawable,
 	      visual->red_mask   == 0xf800 &&
 	      visual->green_mask == 0x07e0 &&
 	      visual->blue_mask  == 0x001f)
-	    composite_func = composite_565;
+	    composite_func = kernels->composite_565;
 	  else if (visual->depth == 24 && bits_per_pixel == 32 &&
 		   visual->red_mask   == 0xff0000 &&
 		   visual->green_mask == 0x00ff00 &&
 		   visual->blue_mask  == 0x0000ff)
-	    {
-#ifdef USE_MEDIALIB
-	      if (_gdk_use_medialib ())
-	        composite_func = composite_0888_medialib;
-	      else
-	        composite_func = composite_0888;
-#else
-	      composite_func = composite_0888;
-#endif
-	    }
+	    composite_func = kernels->composite_0888;
 	}
 
       /* We can't use our composite func if we are required to dither
@@ -1813,11 +1592,12 @@ gdk_drawable_real_draw_pixbuf (GdkDrawable  *drawable,
 						     width, height);
 	  
 	  if (composited)
-	    composite (gdk_pixbuf_get_pixels (pixbuf) + src_y * gdk_pixbuf_get_rowstride (pixbuf) + src_x * 4,
-		       gdk_pixbuf_get_rowstride (pixbuf),
-		       gdk_pixbuf_get_pixels (composited),
-		       gdk_pixbuf_get_rowstride (composited),
-		       width, height);
+	    kernels->composite_888 (gdk_pixbuf_get_pixels (pixbuf) + src_y * gdk_pixbuf_get_rowstride (pixbuf) + src_x * 4,
+				    gdk_pixbuf_get_rowstride (pixbuf),
+				    gdk_pixbuf_get_pixels (composited),
+				    gdk_pixbuf_get_rowstride (composited),
+				    GDK_LSB_FIRST,
+				    width, height);
 	}
     }
 
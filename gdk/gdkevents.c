@@ -199,12 +199,232 @@ _gdk_event_queue_remove_link (GdkDisplay *display,
     display->queued_tail = node->prev;
 }
 
+static GdkEventCompressFlags
+event_get_compression (GdkEvent *event)
+{
+  GdkWindowObject *private = (GdkWindowObject *)event->any.window;
+
+  if (private == NULL || private->destroyed)
+    return GDK_EVENT_COMPRESS_NONE;
+
+  return private->event_compression;
+}
+
+static gboolean
+event_is_pending (GList *node)
+{
+  return (((GdkEventPrivate *)node->data)->flags & GDK_EVENT_PENDING) != 0;
+}
+
+static gboolean
+scroll_phase_is_mergeable (GdkEventScrollPhase phase)
+{
+  return phase == GDK_EVENT_SCROLL_PHASE_NONE ||
+         phase == GDK_EVENT_SCROLL_PHASE_ACTIVE;
+}
+
+/* Finds the queued event that the event at @node can be merged into,
+ * if any. Motion and scroll events are only merged with the event
+ * right after them, so that they stay ordered with respect to
+ * everything else. Only smooth scroll events are merged: widgets take
+ * deltas as pixels, but a wheel click as a step. Configure events are
+ * merged with the next configure event of their window as long as no
+ * other event for the window comes in between.
+ */
+static GList *
+find_merge_target (GList *node)
+{
+  GdkEvent *event = node->data;
+  GdkEventCompressFlags flags = event_get_compression (event);
+  GdkEvent *next;
+  GList *l;
+
+  switch (event->type)
+    {
+    case GDK_MOTION_NOTIFY:
+      if (!(flags & GDK_EVENT_COMPRESS_MOTION) || event->motion.is_hint)
+	return NULL;
+
+      l = node->next;
+      if (l == NULL || event_is_pending (l))
+	return NULL;
+
+      next = l->data;
+      if (next->type == GDK_MOTION_NOTIFY &&
+	  next->motion.window == event->motion.window &&
+	  next->motion.device == event->motion.device &&
+	  next->motion.state == event->motion.state &&
+	  !next->motion.is_hint)
+	return l;
+      break;
+
+    case GDK_SCROLL:
+      if (!(flags & GDK_EVENT_COMPRESS_SCROLL) ||
+	  !event->scroll.has_deltas ||
+	  !scroll_phase_is_mergeable (event->scroll.phase))
+	return NULL;
+
+      l = node->next;
+      if (l == NULL || event_is_pending (l))
+	return NULL;
+
+      next = l->data;
+      if (next->type == GDK_SCROLL &&
+	  next->scroll.has_deltas &&
+	  next->scroll.window == event->scroll.window &&
+	  next->scroll.device == event->scroll.device &&
+	  next->scroll.state == event->scroll.state &&
+	  next->scroll.phase == event->scroll.phase &&
+	  next->scroll.momentum_phase == event->scroll.momentum_phase &&
+	  next->scroll.direction == event->scroll.direction)
+	return l;
+      break;
+
+    case GDK_CONFIGURE:
+      if (!(flags & GDK_EVENT_COMPRESS_CONFIGURE))
+	return NULL;
+
+      for (l = node->next; l != NULL && !event_is_pending (l); l = l->next)
+	{
+	  next = l->data;
+	  if (next->any.window == event->any.window)
+	    return next->type == GDK_CONFIGURE ? l : NULL;
+	}
+      break;
+
+    default:
+      break;
+    }
+
+  return NULL;
+}
+
+/* Folds @event into the later event @into */
+static void
+merge_event (GdkEvent *event,
+	     GdkEvent *into)
+{
+  GdkEventPrivate *private = (GdkEventPrivate *)event;
+  GdkEventPrivate *into_private = (GdkEventPrivate *)into;
+
+  switch (event->type)
+    {
+    case GDK_MOTION_NOTIFY:
+      if (event_get_compression (event) & GDK_EVENT_COMPRESS_MOTION_HISTORY)
+	{
+	  GdkTimeCoord *coord;
+	  GPtrArray *history;
+
+	  /* The history of @event, then @event itself, goes before
+	   * whatever @into already has.
+	   */
+	  history = private->motion_history;
+	  private->motion_history = NULL;
+	  if (history == NULL)
+	    history = g_ptr_array_new ();
+
+	  coord = g_new0 (GdkTimeCoord, 1);
+	  coord->time = event->motion.time;
+	  coord->axes[0] = event->motion.x;
+	  coord->axes[1] = event->motion.y;
+	  g_ptr_array_add (history, coord);
+
+	  if (into_private->motion_history)
+	    {
+	      guint i;
+
+	      for (i = 0; i < into_private->motion_history->len; i++)
+		g_ptr_array_add (history,
+				 g_ptr_array_index (into_private->motion_history, i));
+	      g_ptr_array_free (into_private->motion_history, TRUE);
+	    }
+
+	  into_private->motion_history = history;
+	}
+      break;
+
+    case GDK_SCROLL:
+      into->scroll.delta_x += event->scroll.delta_x;
+      into->scroll.delta_y += event->scroll.delta_y;
+      break;
+
+    default:
+      break;
+    }
+}
+
+/* Merges the event at @node into later events for windows that asked
+ * for it, and returns the node of the event that should be delivered
+ * in its place.
+ */
+static GList *
+compress_events (GdkDisplay *display,
+		 GList      *node)
+{
+  GList *target;
+  GdkEvent *event;
+
+  while (node != NULL &&
+	 (target = find_merge_target (node)) != NULL)
+    {
+      event = node->data;
+
+      merge_event (event, target->data);
+      _gdk_display_count_compressed_event (display, event->type);
+
+      _gdk_event_queue_remove_link (display, node);
+      g_list_free_1 (node);
+      gdk_event_free (event);
+
+      /* A configure event may have been merged past other events */
+      node = _gdk_event_queue_find_first (display);
+    }
+
+  return node;
+}
+
+/**
+ * _gdk_event_queue_wants_more:
+ * @display: a #GdkDisplay
+ *
+ * Checks whether the last event on the queue might be merged with
+ * the next one, in which case the windowing system should read ahead
+ * before the queued events are delivered.
+ *
+ * Return value: %TRUE if more events should be queued
+ **/
+gboolean
+_gdk_event_queue_wants_more (GdkDisplay *display)
+{
+  GdkEvent *event;
+
+  if (display->queued_tail == NULL ||
+      event_is_pending (display->queued_tail))
+    return FALSE;
+
+  event = display->queued_tail->data;
+
+  switch (event->type)
+    {
+    case GDK_MOTION_NOTIFY:
+      return (event_get_compression (event) & GDK_EVENT_COMPRESS_MOTION) != 0;
+    case GDK_SCROLL:
+      return (event->scroll.has_deltas &&
+	      (event_get_compression (event) & GDK_EVENT_COMPRESS_SCROLL) != 0);
+    case GDK_CONFIGURE:
+      return (event_get_compression (event) & GDK_EVENT_COMPRESS_CONFIGURE) != 0;
+    default:
+      return FALSE;
+    }
+}
+
 /**
  * _gdk_event_unqueue:
  * @display: a #GdkDisplay
  * 
  * Removes and returns the first event from the event
- * queue that is not still being filled in.
+ * queue that is not still being filled in. Events of windows that
+ * asked for compression may be merged into later events first.
  * 
  * Return value: the event, or %NULL. Ownership is transferred
  * to the caller.
@@ -216,6 +436,8 @@ _gdk_event_unqueue (GdkDisplay *display)
   GList *tmp_list;
 
   tmp_list = _gdk_event_queue_find_first (display);
+  if (tmp_list)
+    tmp_list = compress_events (display, tmp_list);
 
   if (tmp_list)
     {
@@ -449,6 +671,17 @@ gdk_event_copy (const GdkEvent *event)
       GdkEventPrivate *private = (GdkEventPrivate *)event;
 
       new_private->screen = private->screen;
+
+      if (private->motion_history)
+	{
+	  guint i;
+
+	  new_private->motion_history = g_ptr_array_new ();
+	  for (i = 0; i < private->motion_history->len; i++)
+	    g_ptr_array_add (new_private->motion_history,
+			     g_memdup (g_ptr_array_index (private->motion_history, i),
+				       sizeof (GdkTimeCoord)));
+	}
     }
   
   switch (event->any.type)
@@ -571,6 +804,14 @@ gdk_event_free (GdkEvent *event)
 
   _gdk_windowing_event_data_free (event);
 
+  if (((GdkEventPrivate *)event)->motion_history)
+    {
+      GPtrArray *history = ((GdkEventPrivate *)event)->motion_history;
+
+      g_ptr_array_foreach (history, (GFunc) g_free, NULL);
+      g_ptr_array_free (history, TRUE);
+    }
+
   g_hash_table_remove (event_hash, event);
   g_slice_free (GdkEventPrivate, (GdkEventPrivate*) event);
 }
@@ -991,6 +1232,62 @@ gdk_event_request_motions (const GdkEventMotion *event)
     }
 }
 
+/**
+ * gdk_event_get_motion_history:
+ * @event: a #GdkEvent
+ * @events: (out) (array length=n_events): location to store a newly
+ *   allocated array of #GdkTimeCoord, or %NULL
+ * @n_events: location to store the length of @events, or %NULL
+ *
+ * Retrieves the motion events that were merged into @event because
+ * its window compresses motion events with
+ * %GDK_EVENT_COMPRESS_MOTION_HISTORY set. They are ordered from the
+ * oldest to the most recent; for each one the x and y coordinates,
+ * in the coordinates of the event window, are stored in the first
+ * two elements of @axes. Free the array with gdk_device_free_history().
+ *
+ * Return value: %TRUE if @event is a motion event that other events
+ *   were merged into
+ *
+ * Since: 2.24
+ **/
+gboolean
+gdk_event_get_motion_history (const GdkEvent  *event,
+			      GdkTimeCoord  ***events,
+			      gint            *n_events)
+{
+  GPtrArray *history;
+  GdkTimeCoord **coords;
+  guint i;
+
+  g_return_val_if_fail (event != NULL, FALSE);
+
+  if (events)
+    *events = NULL;
+  if (n_events)
+    *n_events = 0;
+
+  if (event->type != GDK_MOTION_NOTIFY || !gdk_event_is_allocated (event))
+    return FALSE;
+
+  history = ((GdkEventPrivate *)event)->motion_history;
+  if (history == NULL)
+    return FALSE;
+
+  if (events)
+    {
+      coords = g_new (GdkTimeCoord *, history->len);
+      for (i = 0; i < history->len; i++)
+	coords[i] = g_memdup (g_ptr_array_index (history, i), sizeof (GdkTimeCoord));
+      *events = coords;
+    }
+
+  if (n_events)
+    *n_events = history->len;
+
+  return TRUE;
+}
+
 /**
  * gdk_event_set_screen:
  * @event: a #GdkEvent
@@ -192,6 +192,18 @@ typedef enum
   GDK_ALL_EVENTS_MASK		= 0x3FFFFE
 } GdkEventMask;
 
+/* Events that may be merged before they are delivered to a window.
+ * (See gdk_window_set_event_compression()).
+ */
+typedef enum
+{
+  GDK_EVENT_COMPRESS_NONE           = 0,
+  GDK_EVENT_COMPRESS_MOTION         = 1 << 0,
+  GDK_EVENT_COMPRESS_MOTION_HISTORY = 1 << 1,
+  GDK_EVENT_COMPRESS_SCROLL         = 1 << 2,
+  GDK_EVENT_COMPRESS_CONFIGURE      = 1 << 3
+} GdkEventCompressFlags;
+
 typedef enum
 {
   GDK_VISIBILITY_UNOBSCURED,
@@ -614,6 +626,9 @@ gboolean  gdk_event_get_axis            (const GdkEvent  *event,
                                          GdkAxisUse       axis_use,
                                          gdouble         *value);
 void      gdk_event_request_motions     (const GdkEventMotion *event);
+gboolean  gdk_event_get_motion_history  (const GdkEvent  *event,
+                                         GdkTimeCoord  ***events,
+                                         gint            *n_events);
 void	  gdk_event_handler_set 	(GdkEventFunc    func,
 					 gpointer        data,
 					 GDestroyNotify  notify);
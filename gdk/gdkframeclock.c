@@ -0,0 +1,458 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Modified by the GTK+ Team and others 1997-2000.  See the AUTHORS
+ * file for a list of people on the GTK+ Team.  See the ChangeLog
+ * files for a list of changes.  These files are distributed with
+ * GTK+ at ftp://ftp.gtk.org/pub/gtk/.
+ */
+
+#include "config.h"
+
+#include "gdkframeclock.h"
+#include "gdkinternals.h"
+#include "gdkalias.h"
+
+/**
+ * SECTION:gdkframeclock
+ * @Short_description: Pacing of redraws
+ * @Title: Frame Clock
+ *
+ * Invalidated windows aren't repainted right away. Instead GDK
+ * collects the work that is needed on screen into frames: each frame
+ * runs the callbacks that animate things (%GDK_FRAME_PHASE_UPDATE),
+ * then the ones that size and position widgets
+ * (%GDK_FRAME_PHASE_LAYOUT), then paints the invalid areas of all
+ * windows and flushes the output to the windowing system.
+ *
+ * Frames are run from the main loop at %GDK_PRIORITY_REDRAW, as soon
+ * as it is idle. While something is animating, that is while there
+ * are update callbacks or callbacks that asked to be called again,
+ * frames run no more often than the rate set with
+ * gdk_frame_clock_set_rate(). Resizes, relayouts and redraws on
+ * their own are never held back, so gtk_events_pending() keeps
+ * returning %TRUE until they are done.
+ *
+ * How long each part of the recent frames took can be found with
+ * gdk_frame_clock_get_timings(), and is printed for every frame when
+ * the <literal>frames</literal> debug option is set in
+ * <envar>GDK_DEBUG</envar>.
+ */
+
+#define DEFAULT_FRAME_RATE 60.0
+/* Number of frames whose timings are kept */
+#define TIMINGS_HISTORY 64
+
+typedef struct _GdkFrameCallback GdkFrameCallback;
+
+struct _GdkFrameCallback
+{
+  guint id;
+  GdkFramePhase phase;
+  GdkFrameFunc func;
+  gpointer data;
+  GDestroyNotify notify;
+  /* Callbacks added while a phase runs wait for the next frame */
+  guint64 serial;
+  guint removed : 1;
+};
+
+static gdouble frame_rate = DEFAULT_FRAME_RATE;
+static guint frame_source = 0;
+
+static GList *callbacks = NULL;
+static guint next_callback_id = 1;
+static guint64 callback_serial = 0;
+
+static gboolean in_frame = FALSE;
+static gboolean frame_requested = FALSE;
+static guint64 n_frames = 0;
+static gint64 frame_time = 0;
+/* Callbacks up to this serial were there when the last frame began */
+static guint64 frame_serial = 0;
+
+static GdkFrameTimings history[TIMINGS_HISTORY];
+
+static void frame_clock_schedule (void);
+
+static void
+frame_callback_free (GdkFrameCallback *callback)
+{
+  if (callback->notify)
+    callback->notify (callback->data);
+
+  g_slice_free (GdkFrameCallback, callback);
+}
+
+/* Removed callbacks stay in the list while a frame runs, so that the
+ * phases can keep walking it.
+ */
+static void
+frame_callback_remove (GList *link)
+{
+  GdkFrameCallback *callback = link->data;
+
+  if (in_frame)
+    {
+      callback->removed = TRUE;
+      return;
+    }
+
+  callbacks = g_list_delete_link (callbacks, link);
+  frame_callback_free (callback);
+}
+
+static void
+sweep_callbacks (void)
+{
+  GList *l = callbacks;
+
+  while (l)
+    {
+      GList *next = l->next;
+
+      if (((GdkFrameCallback *) l->data)->removed)
+        frame_callback_remove (l);
+
+      l = next;
+    }
+}
+
+static gint64
+run_phase (GdkFramePhase phase)
+{
+  gint64 start = g_get_monotonic_time ();
+  guint64 serial = callback_serial;
+  GList *l;
+
+  for (l = callbacks; l; l = l->next)
+    {
+      GdkFrameCallback *callback = l->data;
+
+      if (callback->removed ||
+          callback->phase != phase ||
+          callback->serial > serial)
+        continue;
+
+      if (!callback->func (frame_time, callback->data))
+        callback->removed = TRUE;
+    }
+
+  return g_get_monotonic_time () - start;
+}
+
+static gboolean
+frame_dispatch (gpointer data)
+{
+  GdkFrameTimings *frame;
+  GList *l;
+
+  frame_source = 0;
+
+  n_frames++;
+  frame_time = g_get_monotonic_time ();
+  frame_serial = callback_serial;
+
+  frame = &history[n_frames % TIMINGS_HISTORY];
+  frame->frame_counter = n_frames;
+  frame->frame_time = frame_time;
+
+  in_frame = TRUE;
+
+  frame->update_time = run_phase (GDK_FRAME_PHASE_UPDATE);
+  frame->layout_time = run_phase (GDK_FRAME_PHASE_LAYOUT);
+
+  /* Whatever was invalidated up to here gets painted now */
+  frame_requested = FALSE;
+  _gdk_window_process_all_updates (frame);
+
+  in_frame = FALSE;
+
+  sweep_callbacks ();
+
+  GDK_NOTE (FRAMES,
+            g_message ("frame %" G_GUINT64_FORMAT ": update %" G_GINT64_FORMAT
+                       " us, layout %" G_GINT64_FORMAT " us, paint %" G_GINT64_FORMAT
+                       " us, flush %" G_GINT64_FORMAT " us",
+                       frame->frame_counter, frame->update_time, frame->layout_time,
+                       frame->paint_time, frame->flush_time));
+
+  for (l = callbacks; l; l = l->next)
+    if (!((GdkFrameCallback *) l->data)->removed)
+      frame_requested = TRUE;
+
+  if (frame_requested)
+    frame_clock_schedule ();
+
+  return FALSE;
+}
+
+/* Whether frames are run for an animation, and should be paced */
+static gboolean
+frame_clock_is_animating (void)
+{
+  GList *l;
+
+  for (l = callbacks; l; l = l->next)
+    {
+      GdkFrameCallback *callback = l->data;
+
+      if (callback->removed)
+        continue;
+
+      if (callback->phase == GDK_FRAME_PHASE_UPDATE ||
+          callback->serial <= frame_serial)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+frame_clock_schedule (void)
+{
+  gint64 interval, elapsed;
+
+  if (in_frame)
+    {
+      frame_requested = TRUE;
+      return;
+    }
+
+  if (frame_source)
+    return;
+
+  frame_requested = FALSE;
+
+  interval = frame_rate > 0 ? G_USEC_PER_SEC / frame_rate : 0;
+  elapsed = g_get_monotonic_time () - frame_time;
+
+  if (n_frames == 0 || elapsed >= interval || !frame_clock_is_animating ())
+    frame_source = gdk_threads_add_idle_full (GDK_PRIORITY_REDRAW,
+                                              frame_dispatch,
+                                              NULL, NULL);
+  else
+    frame_source = gdk_threads_add_timeout_full (GDK_PRIORITY_REDRAW,
+                                                 (interval - elapsed + 999) / 1000,
+                                                 frame_dispatch,
+                                                 NULL, NULL);
+}
+
+/**
+ * gdk_frame_clock_set_rate:
+ * @frames_per_second: the highest number of frames per second, or 0
+ *
+ * Sets how often frames may run. With a rate of 0, frames aren't
+ * paced, and run whenever the main loop is idle and something needs
+ * to be done. The default is 60 frames per second.
+ *
+ * Since: 2.24
+ **/
+void
+gdk_frame_clock_set_rate (gdouble frames_per_second)
+{
+  g_return_if_fail (frames_per_second >= 0);
+
+  frame_rate = frames_per_second;
+
+  /* Let a waiting frame pick up the new pace */
+  if (frame_source)
+    {
+      g_source_remove (frame_source);
+      frame_source = 0;
+      frame_clock_schedule ();
+    }
+}
+
+/**
+ * gdk_frame_clock_get_rate:
+ *
+ * Gets the rate set with gdk_frame_clock_set_rate().
+ *
+ * Return value: the highest number of frames per second, or 0 if
+ *   frames aren't paced
+ *
+ * Since: 2.24
+ **/
+gdouble
+gdk_frame_clock_get_rate (void)
+{
+  return frame_rate;
+}
+
+/**
+ * gdk_frame_clock_add_callback:
+ * @phase: the phase of the frame to run @func in
+ * @func: the function to call
+ * @data: data to pass to @func
+ * @notify: function to call when the callback is removed, or %NULL
+ *
+ * Has @func called in @phase of every frame until it returns %FALSE
+ * or is removed with gdk_frame_clock_remove_callback(). A frame is
+ * requested as long as there are callbacks, so animations should
+ * only keep theirs while they are running.
+ *
+ * A callback added while its phase is running is first called in
+ * the next frame; a layout callback added from an update callback
+ * runs in the same frame.
+ *
+ * Return value: the id of the callback
+ *
+ * Since: 2.24
+ **/
+guint
+gdk_frame_clock_add_callback (GdkFramePhase  phase,
+                              GdkFrameFunc   func,
+                              gpointer       data,
+                              GDestroyNotify notify)
+{
+  GdkFrameCallback *callback;
+
+  g_return_val_if_fail (func != NULL, 0);
+
+  callback = g_slice_new0 (GdkFrameCallback);
+  callback->id = next_callback_id++;
+  callback->phase = phase;
+  callback->func = func;
+  callback->data = data;
+  callback->notify = notify;
+  callback->serial = ++callback_serial;
+
+  callbacks = g_list_append (callbacks, callback);
+
+  frame_clock_schedule ();
+
+  return callback->id;
+}
+
+/**
+ * gdk_frame_clock_remove_callback:
+ * @id: the id returned by gdk_frame_clock_add_callback()
+ *
+ * Removes a frame callback.
+ *
+ * Since: 2.24
+ **/
+void
+gdk_frame_clock_remove_callback (guint id)
+{
+  GList *l;
+
+  for (l = callbacks; l; l = l->next)
+    {
+      GdkFrameCallback *callback = l->data;
+
+      if (callback->id == id && !callback->removed)
+        {
+          frame_callback_remove (l);
+          return;
+        }
+    }
+
+  g_warning ("%s: no frame callback with id %u", G_STRFUNC, id);
+}
+
+/**
+ * gdk_frame_clock_request_frame:
+ *
+ * Makes sure a frame is run, even if no window is invalid and no
+ * callback is waiting. GDK requests frames itself when windows are
+ * invalidated, so this is rarely needed.
+ *
+ * Since: 2.24
+ **/
+void
+gdk_frame_clock_request_frame (void)
+{
+  frame_clock_schedule ();
+}
+
+/**
+ * gdk_frame_clock_get_frame_time:
+ *
+ * Gets the time of the current frame, so that everything updated in
+ * one frame is updated to the same point in time. Outside of a frame,
+ * this is the current time.
+ *
+ * Return value: a time in the timebase of g_get_monotonic_time()
+ *
+ * Since: 2.24
+ **/
+gint64
+gdk_frame_clock_get_frame_time (void)
+{
+  if (in_frame)
+    return frame_time;
+
+  return g_get_monotonic_time ();
+}
+
+/**
+ * gdk_frame_clock_get_frame_counter:
+ *
+ * Gets the number of the current frame, or of the last one that ran
+ * when called outside of a frame.
+ *
+ * Return value: the number of frames run so far
+ *
+ * Since: 2.24
+ **/
+guint64
+gdk_frame_clock_get_frame_counter (void)
+{
+  return n_frames;
+}
+
+/**
+ * gdk_frame_clock_get_timings:
+ * @frame_counter: the number of a frame
+ * @timings: return location for the timings
+ *
+ * Gets where the time of a recent frame went. Only the timings of
+ * the last few frames are kept.
+ *
+ * Return value: %TRUE if the timings of the frame were known
+ *
+ * Since: 2.24
+ **/
+gboolean
+gdk_frame_clock_get_timings (guint64          frame_counter,
+                             GdkFrameTimings *timings)
+{
+  GdkFrameTimings *frame;
+
+  g_return_val_if_fail (timings != NULL, FALSE);
+
+  frame = &history[frame_counter % TIMINGS_HISTORY];
+
+  if (frame_counter == 0 || frame->frame_counter != frame_counter)
+    return FALSE;
+
+  /* The current frame isn't finished yet */
+  if (in_frame && frame_counter == n_frames)
+    return FALSE;
+
+  *timings = *frame;
+
+  return TRUE;
+}
+
+#define __GDK_FRAME_CLOCK_C__
+#include "gdkaliasdef.c"
@@ -0,0 +1,115 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Modified by the GTK+ Team and others 1997-2000.  See the AUTHORS
+ * file for a list of people on the GTK+ Team.  See the ChangeLog
+ * files for a list of changes.  These files are distributed with
+ * GTK+ at ftp://ftp.gtk.org/pub/gtk/.
+ */
+
+#if !defined (__GDK_H_INSIDE__) && !defined (GDK_COMPILATION)
+#error "Only <gdk/gdk.h> can be included directly."
+#endif
+
+#ifndef __GDK_FRAME_CLOCK_H__
+#define __GDK_FRAME_CLOCK_H__
+
+#include <gdk/gdktypes.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GdkFrameTimings GdkFrameTimings;
+
+/**
+ * GdkFramePhase:
+ * @GDK_FRAME_PHASE_UPDATE: callbacks that advance animations and
+ *   invalidate what they change
+ * @GDK_FRAME_PHASE_LAYOUT: callbacks that size and position widgets
+ *
+ * The phases of a frame that callbacks can be added to. Each frame
+ * runs the update callbacks, then the layout callbacks, then paints
+ * the invalid areas of all windows and flushes the displays.
+ *
+ * Since: 2.24
+ */
+typedef enum
+{
+  GDK_FRAME_PHASE_UPDATE,
+  GDK_FRAME_PHASE_LAYOUT
+} GdkFramePhase;
+
+/**
+ * GdkFrameFunc:
+ * @frame_time: the time the frame started, in the timebase of
+ *   g_get_monotonic_time()
+ * @data: user data passed to gdk_frame_clock_add_callback()
+ *
+ * The type of the callbacks run for every frame.
+ *
+ * Returns: %FALSE to remove the callback, %TRUE to have it called
+ *   again in the next frame
+ *
+ * Since: 2.24
+ */
+typedef gboolean (*GdkFrameFunc) (gint64   frame_time,
+                                  gpointer data);
+
+/**
+ * GdkFrameTimings:
+ * @frame_counter: the number of the frame
+ * @frame_time: the time the frame started, in the timebase of
+ *   g_get_monotonic_time()
+ * @update_time: microseconds spent in update callbacks
+ * @layout_time: microseconds spent in layout callbacks
+ * @paint_time: microseconds spent painting windows
+ * @flush_time: microseconds spent flushing the displays
+ *
+ * Where the time of one frame went.
+ *
+ * Since: 2.24
+ */
+struct _GdkFrameTimings
+{
+  guint64 frame_counter;
+  gint64  frame_time;
+  gint64  update_time;
+  gint64  layout_time;
+  gint64  paint_time;
+  gint64  flush_time;
+};
+
+void     gdk_frame_clock_set_rate          (gdouble          frames_per_second);
+gdouble  gdk_frame_clock_get_rate          (void);
+
+guint    gdk_frame_clock_add_callback      (GdkFramePhase    phase,
+                                            GdkFrameFunc     func,
+                                            gpointer         data,
+                                            GDestroyNotify   notify);
+void     gdk_frame_clock_remove_callback   (guint            id);
+void     gdk_frame_clock_request_frame     (void);
+
+gint64   gdk_frame_clock_get_frame_time    (void);
+guint64  gdk_frame_clock_get_frame_counter (void);
+gboolean gdk_frame_clock_get_timings       (guint64          frame_counter,
+                                            GdkFrameTimings *timings);
+
+G_END_DECLS
+
+#endif /* __GDK_FRAME_CLOCK_H__ */
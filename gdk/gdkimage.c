@@ -518,32 +518,64 @@ scratch_image_info_for_depth (GdkScreen *screen,
 static gint sincelast;
 #endif
 
-static gint
-alloc_scratch_image (GdkScratchImageInfo *image_info)
+static void
+flush_scratch_images (GdkScratchImageInfo *image_info)
 {
-  if (image_info->static_image_idx == N_REGIONS)
-    {
 #ifndef NO_FLUSH
-      gdk_flush ();
+  gdk_flush ();
 #endif
 #ifdef VERBOSE
-      g_print ("flush, %d puts since last flush\n", sincelast);
-      sincelast = 0;
+  g_print ("flush, %d puts since last flush\n", sincelast);
+  sincelast = 0;
 #endif
-      image_info->static_image_idx = 0;
-
-      /* Mark all regions that we might be filling in as completely
-       * full, to force new tiles to be allocated for subsequent
-       * images
-       */
-      image_info->horiz_y = GDK_SCRATCH_IMAGE_HEIGHT;
-      image_info->vert_x = GDK_SCRATCH_IMAGE_WIDTH;
-      image_info->tile_x = GDK_SCRATCH_IMAGE_WIDTH;
-      image_info->tile_y1 = image_info->tile_y2 = GDK_SCRATCH_IMAGE_HEIGHT;
-    }
+  image_info->static_image_idx = 0;
+
+  /* Mark all regions that we might be filling in as completely
+   * full, to force new tiles to be allocated for subsequent
+   * images
+   */
+  image_info->horiz_y = GDK_SCRATCH_IMAGE_HEIGHT;
+  image_info->vert_x = GDK_SCRATCH_IMAGE_WIDTH;
+  image_info->tile_x = GDK_SCRATCH_IMAGE_WIDTH;
+  image_info->tile_y1 = image_info->tile_y2 = GDK_SCRATCH_IMAGE_HEIGHT;
+}
+
+static gint
+alloc_scratch_image (GdkScratchImageInfo *image_info)
+{
+  if (image_info->static_image_idx == N_REGIONS)
+    flush_scratch_images (image_info);
+
   return image_info->static_image_idx++;
 }
 
+/**
+ * _gdk_image_reserve_scratch:
+ * @screen: a #GdkScreen
+ * @depth: depth of the images
+ * @n_images: number of scratch images about to be allocated
+ *
+ * Makes sure that the next @n_images calls to _gdk_image_get_scratch()
+ * for @depth return distinct memory without flushing, so that they
+ * can all be filled in before any of them is put. @n_images must not
+ * be larger than the number of scratch regions, which is 6.
+ **/
+void
+_gdk_image_reserve_scratch (GdkScreen *screen,
+			    gint       depth,
+			    gint       n_images)
+{
+  GdkScratchImageInfo *image_info;
+
+  g_return_if_fail (GDK_IS_SCREEN (screen));
+  g_return_if_fail (n_images <= N_REGIONS);
+
+  image_info = scratch_image_info_for_depth (screen, depth);
+
+  if (image_info->static_image_idx + n_images > N_REGIONS)
+    flush_scratch_images (image_info);
+}
+
 /**
  * _gdk_image_get_scratch:
  * @screen: a #GdkScreen
@@ -559,7 +591,8 @@ alloc_scratch_image (GdkScratchImageInfo *image_info)
  * 
  * Return value: a scratch image. This must be used by a
  *  call to gdk_image_put() before any other calls to
- *  _gdk_image_get_scratch()
+ *  _gdk_image_get_scratch(), unless they were reserved with
+ *  _gdk_image_reserve_scratch()
  **/
 GdkImage *
 _gdk_image_get_scratch (GdkScreen   *screen,
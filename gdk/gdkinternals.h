@@ -32,6 +32,7 @@
 #include <gio/gio.h>
 #include <gdk/gdktypes.h>
 #include <gdk/gdkwindow.h>
+#include <gdk/gdkframeclock.h>
 #include <gdk/gdkprivate.h>
 #ifdef USE_MEDIALIB
 #include <gdk/gdkmedialib.h>
@@ -92,7 +93,9 @@ typedef enum {
   GDK_DEBUG_MULTIHEAD	  = 1 <<12,
   GDK_DEBUG_XINERAMA	  = 1 <<13,
   GDK_DEBUG_DRAW	  = 1 <<14,
-  GDK_DEBUG_EVENTLOOP     = 1 <<15
+  GDK_DEBUG_EVENTLOOP     = 1 <<15,
+  GDK_DEBUG_FRAMES        = 1 <<16,
+  GDK_DEBUG_ROUNDTRIPS    = 1 <<17
 } GdkDebugFlag;
 
 #ifndef GDK_DISABLE_DEPRECATED
@@ -175,6 +178,7 @@ struct _GdkEventPrivate
   guint      flags;
   GdkScreen *screen;
   gpointer   windowing_data;
+  GPtrArray *motion_history; /* GdkTimeCoord of merged motion events */
 };
 
 /* Tracks information about the pointer grab on this display */
@@ -198,6 +202,7 @@ typedef struct _GdkInputWindow GdkInputWindow;
 /* Private version of GdkWindowObject. The initial part of this strucuture
    is public for historical reasons. Don't change that part */
 typedef struct _GdkWindowPaint             GdkWindowPaint;
+typedef struct _GdkChildIndex              GdkChildIndex;
 
 struct _GdkWindowObject
 {
@@ -282,6 +287,9 @@ struct _GdkWindowObject
   guint outstanding_surfaces; /* only set on impl window */
 
   cairo_pattern_t *background;
+
+  GdkChildIndex *child_index; /* Spatial index of the children, or NULL */
+  GdkEventCompressFlags event_compression;
 };
 
 #define GDK_WINDOW_TYPE(d) (((GdkWindowObject*)(GDK_WINDOW (d)))->window_type)
@@ -298,6 +306,7 @@ extern gchar     *_gdk_display_arg_name;
 
 void      _gdk_events_queue  (GdkDisplay *display);
 GdkEvent* _gdk_event_unqueue (GdkDisplay *display);
+gboolean  _gdk_event_queue_wants_more (GdkDisplay *display);
 
 void _gdk_event_filter_unref        (GdkWindow      *window,
 				     GdkEventFilter *filter);
@@ -341,6 +350,9 @@ GdkImage *_gdk_image_get_scratch (GdkScreen *screen,
 				  gint	     depth,
 				  gint	    *x,
 				  gint	    *y);
+void      _gdk_image_reserve_scratch (GdkScreen *screen,
+				      gint       depth,
+				      gint       n_images);
 
 GdkImage *_gdk_drawable_copy_to_image (GdkDrawable  *drawable,
 				       GdkImage     *image,
@@ -358,6 +370,12 @@ cairo_surface_t * _gdk_drawable_create_cairo_surface (GdkDrawable *drawable,
 						      int width,
 						      int height);
 
+/* Paint buffer pool */
+GdkPixmap *_gdk_paint_buffer_acquire (GdkWindow *window,
+				      gint       width,
+				      gint       height);
+void       _gdk_paint_buffer_release (GdkPixmap *pixmap);
+
 /* GC caching */
 GdkGC *_gdk_drawable_get_scratch_gc (GdkDrawable *drawable,
 				     gboolean     graphics_exposures);
@@ -401,10 +419,12 @@ void       _gdk_window_destroy           (GdkWindow      *window,
                                           gboolean        foreign_destroy);
 void       _gdk_window_clear_update_area (GdkWindow      *window);
 void       _gdk_window_update_size       (GdkWindow      *window);
+void       _gdk_window_children_changed  (GdkWindow      *window);
 gboolean   _gdk_window_update_viewable   (GdkWindow      *window);
 
 void       _gdk_window_process_updates_recurse (GdkWindow *window,
                                                 GdkRegion *expose_region);
+void       _gdk_window_process_all_updates     (GdkFrameTimings *timings);
 
 void       _gdk_screen_close             (GdkScreen      *screen);
 
@@ -626,6 +646,8 @@ void _gdk_display_set_has_keyboard_grab (GdkDisplay *display,
 void _gdk_display_unset_has_keyboard_grab (GdkDisplay *display,
 					   gboolean implicit);
 void _gdk_display_enable_motion_hints     (GdkDisplay *display);
+void _gdk_display_count_compressed_event  (GdkDisplay   *display,
+					   GdkEventType  type);
 
 
 void _gdk_window_invalidate_for_expose (GdkWindow       *window,
@@ -0,0 +1,391 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Modified by the GTK+ Team and others 1997-2000.  See the AUTHORS
+ * file for a list of people on the GTK+ Team.  See the ChangeLog
+ * files for a list of changes.  These files are distributed with
+ * GTK+ at ftp://ftp.gtk.org/pub/gtk/.
+ */
+
+/* Pool of the pixmaps used as double buffers by GdkWindow paints.
+ *
+ * Every expose used to create a pixmap the size of the exposed area
+ * and free it again at the end of the paint, which on X11 costs a
+ * server round of allocation plus a new cairo surface each time.
+ * Instead, paints take a pixmap from the pool of their screen and
+ * depth, and give it back when they are done. Sizes are rounded up to
+ * buckets so that buffers fit the slightly different areas of
+ * consecutive frames, and buffers that haven't been used for a while
+ * are freed.
+ */
+
+#include "config.h"
+
+#include "gdkinternals.h"
+#include "gdkpixmap.h"
+#include "gdkscreen.h"
+#include "gdkalias.h"
+
+/* Buffer sizes are rounded up to a multiple of this */
+#define BUCKET_SIZE 64
+/* Don't hand out buffers more than this times larger than needed */
+#define MAX_WASTE 4
+/* Limits on what the pools keep around, over all screens */
+#define MAX_BUFFERS 8
+#define MAX_POOLED_BYTES (64 * 1024 * 1024)
+/* Buffers unused for this long are freed */
+#define MAX_AGE_SECONDS 10
+#define TRIM_INTERVAL_SECONDS 5
+
+typedef struct _GdkPaintBufferPool  GdkPaintBufferPool;
+typedef struct _GdkPaintBuffer      GdkPaintBuffer;
+typedef struct _GdkPaintBufferStats GdkPaintBufferStats;
+
+/* One per screen and depth */
+struct _GdkPaintBufferPool
+{
+  GdkScreen *screen;
+  gint depth;
+
+  /* Most recently used first */
+  GList *buffers;
+};
+
+struct _GdkPaintBuffer
+{
+  GdkPixmap *pixmap;
+  GdkColormap *colormap;
+  gint depth;
+  gint width;
+  gint height;
+  gsize size;
+  gint64 last_used;
+};
+
+/* Counters reported by GDK_DEBUG=draw */
+struct _GdkPaintBufferStats
+{
+  guint hits;
+  guint misses;
+  guint n_buffers;     /* buffers currently in the pools */
+  gsize pooled_bytes;  /* memory held by those buffers */
+};
+
+static GSList *pools = NULL;
+static GdkPaintBufferStats stats;
+static guint trim_id = 0;
+
+static const char surface_key[] = "gdk-paint-buffer-surface";
+
+static gsize
+buffer_size (GdkScreen *screen,
+             gint       depth,
+             gint       width,
+             gint       height)
+{
+  gint bits = _gdk_windowing_get_bits_for_depth (gdk_screen_get_display (screen),
+                                                 depth);
+
+  return (gsize) width * height * ((bits + 7) / 8);
+}
+
+static void
+paint_buffer_free (GdkPaintBuffer *buffer)
+{
+  stats.n_buffers--;
+  stats.pooled_bytes -= buffer->size;
+
+  g_object_unref (buffer->pixmap);
+  g_free (buffer);
+}
+
+static void
+paint_buffer_pool_remove (GdkPaintBufferPool *pool,
+                          GList              *link)
+{
+  paint_buffer_free (link->data);
+  pool->buffers = g_list_delete_link (pool->buffers, link);
+}
+
+static void
+display_closed (GdkDisplay *display,
+                gboolean    is_error,
+                gpointer    data)
+{
+  GSList *l = pools;
+
+  g_signal_handlers_disconnect_by_func (display, display_closed, NULL);
+
+  while (l)
+    {
+      GdkPaintBufferPool *pool = l->data;
+
+      l = l->next;
+
+      if (gdk_screen_get_display (pool->screen) != display)
+        continue;
+
+      while (pool->buffers)
+        paint_buffer_pool_remove (pool, pool->buffers);
+
+      pools = g_slist_remove (pools, pool);
+      g_free (pool);
+    }
+}
+
+static GdkPaintBufferPool *
+paint_buffer_pool_get (GdkScreen *screen,
+                       gint       depth)
+{
+  GdkPaintBufferPool *pool;
+  GSList *l;
+  gboolean display_known = FALSE;
+
+  for (l = pools; l; l = l->next)
+    {
+      pool = l->data;
+
+      if (pool->screen == screen && pool->depth == depth)
+        return pool;
+
+      if (gdk_screen_get_display (pool->screen) == gdk_screen_get_display (screen))
+        display_known = TRUE;
+    }
+
+  if (!display_known)
+    g_signal_connect (gdk_screen_get_display (screen), "closed",
+                      G_CALLBACK (display_closed), NULL);
+
+  pool = g_new0 (GdkPaintBufferPool, 1);
+  pool->screen = screen;
+  pool->depth = depth;
+
+  pools = g_slist_prepend (pools, pool);
+
+  return pool;
+}
+
+static gboolean
+trim_pools (gpointer data)
+{
+  gint64 now = g_get_monotonic_time ();
+  GSList *l;
+
+  for (l = pools; l; l = l->next)
+    {
+      GdkPaintBufferPool *pool = l->data;
+      GList *link = pool->buffers;
+
+      while (link)
+        {
+          GdkPaintBuffer *buffer = link->data;
+          GList *next = link->next;
+
+          if (now - buffer->last_used >= MAX_AGE_SECONDS * G_USEC_PER_SEC)
+            paint_buffer_pool_remove (pool, link);
+
+          link = next;
+        }
+    }
+
+  GDK_NOTE (DRAW,
+            g_message ("paint buffers: %u hits, %u misses, %u pooled (%" G_GSIZE_FORMAT " bytes)",
+                       stats.hits, stats.misses, stats.n_buffers, stats.pooled_bytes));
+
+  if (stats.n_buffers == 0)
+    {
+      trim_id = 0;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Frees the least recently used buffers until the pools are within
+ * their limits.
+ */
+static void
+enforce_limits (void)
+{
+  while (stats.n_buffers > MAX_BUFFERS ||
+         stats.pooled_bytes > MAX_POOLED_BYTES)
+    {
+      GdkPaintBufferPool *oldest_pool = NULL;
+      GList *oldest = NULL;
+      GSList *l;
+
+      for (l = pools; l; l = l->next)
+        {
+          GdkPaintBufferPool *pool = l->data;
+          GList *last = g_list_last (pool->buffers);
+
+          if (last &&
+              (oldest == NULL ||
+               ((GdkPaintBuffer *) last->data)->last_used <
+               ((GdkPaintBuffer *) oldest->data)->last_used))
+            {
+              oldest_pool = pool;
+              oldest = last;
+            }
+        }
+
+      if (oldest == NULL)
+        break;
+
+      paint_buffer_pool_remove (oldest_pool, oldest);
+    }
+}
+
+/**
+ * _gdk_paint_buffer_acquire:
+ * @window: the window that is painted
+ * @width: the width needed
+ * @height: the height needed
+ *
+ * Returns a pixmap compatible with @window of at least @width by
+ * @height pixels, taking it from the pool if one is available. The
+ * contents of the pixmap are undefined.
+ *
+ * Return value: a pixmap, to be given back with
+ *   _gdk_paint_buffer_release()
+ **/
+GdkPixmap *
+_gdk_paint_buffer_acquire (GdkWindow *window,
+                           gint       width,
+                           gint       height)
+{
+  GdkColormap *colormap = gdk_drawable_get_colormap (window);
+  GdkScreen *screen = gdk_drawable_get_screen (window);
+  gint depth = gdk_drawable_get_depth (window);
+  GdkPaintBufferPool *pool;
+  GdkPaintBuffer *best = NULL;
+  GdkPixmap *pixmap;
+  GList *l, *best_link = NULL;
+  gint64 max_area;
+
+  width = MAX (width, 1);
+  height = MAX (height, 1);
+
+  if (colormap == NULL)
+    return gdk_pixmap_new (window, width, height, -1);
+
+  width = (width + BUCKET_SIZE - 1) / BUCKET_SIZE * BUCKET_SIZE;
+  height = (height + BUCKET_SIZE - 1) / BUCKET_SIZE * BUCKET_SIZE;
+  max_area = (gint64) width * height * MAX_WASTE;
+
+  pool = paint_buffer_pool_get (screen, depth);
+
+  for (l = pool->buffers; l; l = l->next)
+    {
+      GdkPaintBuffer *buffer = l->data;
+
+      if (buffer->colormap != colormap ||
+          buffer->width < width || buffer->height < height ||
+          (gint64) buffer->width * buffer->height > max_area)
+        continue;
+
+      if (best == NULL ||
+          buffer->width * buffer->height < best->width * best->height)
+        {
+          best = buffer;
+          best_link = l;
+        }
+    }
+
+  if (best)
+    {
+      stats.hits++;
+      stats.n_buffers--;
+      stats.pooled_bytes -= best->size;
+
+      pixmap = best->pixmap;
+      g_free (best);
+      pool->buffers = g_list_delete_link (pool->buffers, best_link);
+
+      return pixmap;
+    }
+
+  stats.misses++;
+
+  pixmap = gdk_pixmap_new (window, width, height, -1);
+
+  /* Keep the cairo surface alive along with the pixmap, so that it is
+   * reused too.
+   */
+  g_object_set_data_full (G_OBJECT (pixmap), surface_key,
+                          _gdk_drawable_ref_cairo_surface (pixmap),
+                          (GDestroyNotify) cairo_surface_destroy);
+
+  return pixmap;
+}
+
+/**
+ * _gdk_paint_buffer_release:
+ * @pixmap: a pixmap returned by _gdk_paint_buffer_acquire()
+ *
+ * Gives @pixmap back to the pool, or frees it if someone else still
+ * holds a reference to it.
+ **/
+void
+_gdk_paint_buffer_release (GdkPixmap *pixmap)
+{
+  GdkColormap *colormap = gdk_drawable_get_colormap (pixmap);
+  GdkScreen *screen;
+  GdkPaintBufferPool *pool;
+  GdkPaintBuffer *buffer;
+  cairo_surface_t *surface;
+
+  if (colormap == NULL || G_OBJECT (pixmap)->ref_count > 1 ||
+      g_object_get_data (G_OBJECT (pixmap), surface_key) == NULL)
+    {
+      g_object_unref (pixmap);
+      return;
+    }
+
+  /* Paints move the device offset around */
+  surface = g_object_get_data (G_OBJECT (pixmap), surface_key);
+  cairo_surface_set_device_offset (surface, 0, 0);
+
+  screen = gdk_drawable_get_screen (pixmap);
+
+  buffer = g_new (GdkPaintBuffer, 1);
+  buffer->pixmap = pixmap;
+  buffer->colormap = colormap;
+  buffer->depth = gdk_drawable_get_depth (pixmap);
+  gdk_drawable_get_size (pixmap, &buffer->width, &buffer->height);
+  buffer->size = buffer_size (screen, buffer->depth,
+                              buffer->width, buffer->height);
+  buffer->last_used = g_get_monotonic_time ();
+
+  pool = paint_buffer_pool_get (screen, buffer->depth);
+  pool->buffers = g_list_prepend (pool->buffers, buffer);
+
+  stats.n_buffers++;
+  stats.pooled_bytes += buffer->size;
+
+  enforce_limits ();
+
+  if (trim_id == 0 && stats.n_buffers > 0)
+    trim_id = gdk_threads_add_timeout_seconds (TRIM_INTERVAL_SECONDS,
+                                               trim_pools, NULL);
+}
+
+#define __GDK_PAINT_BUFFERS_C__
+#include "gdkaliasdef.c"
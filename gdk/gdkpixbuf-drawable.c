@@ -33,6 +33,7 @@
 #include "gdkwindow.h"
 #include "gdkpixbuf.h"
 #include "gdkpixmap.h"
+#include "gdkpixelkernels.h"
 #include "gdkinternals.h"
 #include "gdkalias.h"
 
@@ -421,33 +422,13 @@ rgb565lsb (GdkImage    *image,
 	   int          y2,
 	   GdkColormap *colormap)
 {
-  int xx, yy;
-  int bpl;
+  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp;
 
-  register guint16 *s;
-  register guint8 *o;
+  d (printf ("16 bits/pixel, lsb, no alpha\n"));
 
-  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp, *orow = pixels;
-
-  bpl = image->bpl;
-
-  for (yy = y1; yy < y2; yy++)
-    {
-      s = (guint16 *) srow;
-      o = (guint8 *) orow;
-      for (xx = x1; xx < x2; xx ++)
-	{
-	  register guint32 data = *s++;
-#ifdef BIG
-	  data = SWAP16 (data);
-#endif	  
-	  *o++ = R8fromRGB565 (data);
-	  *o++ = G8fromRGB565 (data);
-	  *o++ = B8fromRGB565 (data);
-	}
-      srow += bpl;
-      orow += rowstride;
-    }
+  _gdk_pixel_kernels_get ()->convert_565_to_rgb (srow, image->bpl,
+                                                 pixels, rowstride,
+                                                 x2 - x1, y2 - y1);
 }
 
 /*
@@ -509,33 +490,13 @@ rgb565alsb (GdkImage    *image,
             int          y2,
 	    GdkColormap *colormap)
 {
-  int xx, yy;
-  int bpl;
+  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp;
 
-  register guint16 *s;
-  register guint32 *o;
+  d (printf ("16 bits/pixel, lsb, with alpha\n"));
 
-  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp, *orow = pixels;
-
-  bpl = image->bpl;
-
-  for (yy = y1; yy < y2; yy++)
-    {
-      s = (guint16 *) srow;
-      o = (guint32 *) orow;
-      for (xx = x1; xx < x2; xx ++)
-	{
-	  register guint32 data = *s++;
-#ifdef LITTLE
-	  *o++ = ABGR8888fromRGB565 (data);
-#else
-	  data = SWAP16 (data);
-	  *o++ = RGBA8888fromRGB565 (data);
-#endif
-	}
-      srow += bpl;
-      orow += rowstride;
-    }
+  _gdk_pixel_kernels_get ()->convert_565_to_rgba (srow, image->bpl,
+                                                  pixels, rowstride,
+                                                  x2 - x1, y2 - y1);
 }
 
 /*
@@ -769,33 +730,13 @@ rgb888alsb (GdkImage    *image,
             int          y2,
 	    GdkColormap *colormap)
 {
-  int xx, yy;
-  int bpl;
-
-  guint8 *s;	/* for byte order swapping */
-  guint8 *o;
-  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp, *orow = pixels;
-
-  bpl = image->bpl;
+  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp;
 
   d (printf ("32 bits/pixel with alpha\n"));
 
-  /* lsb data */
-  for (yy = y1; yy < y2; yy++)
-    {
-      s = srow;
-      o = orow;
-      for (xx = x1; xx < x2; xx++)
-	{
-	  *o++ = s[2];
-	  *o++ = s[1];
-	  *o++ = s[0];
-	  *o++ = 0xff;
-	  s += 4;
-	}
-      srow += bpl;
-      orow += rowstride;
-    }
+  _gdk_pixel_kernels_get ()->convert_0888_to_rgba (srow, image->bpl,
+                                                   pixels, rowstride,
+                                                   x2 - x1, y2 - y1);
 }
 
 static void
@@ -808,30 +749,13 @@ rgb888lsb (GdkImage    *image,
            int          y2,
 	   GdkColormap *colormap)
 {
-  int xx, yy;
-  int bpl;
-
-  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp, *orow = pixels;
-  guint8 *o, *s;
-
-  bpl = image->bpl;
+  guint8 *srow = (guint8*)image->mem + y1 * image->bpl + x1 * image->bpp;
 
   d (printf ("32 bit, lsb, no alpha\n"));
 
-  for (yy = y1; yy < y2; yy++)
-    {
-      s = srow;
-      o = orow;
-      for (xx = x1; xx < x2; xx++)
-	{
-	  *o++ = s[2];
-	  *o++ = s[1];
-	  *o++ = s[0];
-	  s += 4;
-	}
-      srow += bpl;
-      orow += rowstride;
-    }
+  _gdk_pixel_kernels_get ()->convert_0888_to_rgb (srow, image->bpl,
+                                                  pixels, rowstride,
+                                                  x2 - x1, y2 - y1);
 }
 
 static void
@@ -1013,6 +937,33 @@ static const cfunc convert_map[] = {
   rgb888lsb,rgb888msb,rgb888alsb,rgb888amsb
 };
 
+typedef struct
+{
+  cfunc        func;
+  GdkImage    *image;
+  guchar      *pixels;
+  int          rowstride;
+  int          x;
+  int          y;
+  int          width;
+  GdkColormap *cmap;
+} ConvertRowsData;
+
+static void
+convert_rows (gint     first_row,
+              gint     n_rows,
+              gpointer data)
+{
+  ConvertRowsData *convert = data;
+  int y = convert->y + first_row;
+
+  (* convert->func) (convert->image,
+                     convert->pixels + first_row * convert->rowstride,
+                     convert->rowstride,
+                     convert->x, y, convert->x + convert->width, y + n_rows,
+                     convert->cmap);
+}
+
 /*
  * perform actual conversion
  *
@@ -1123,11 +1074,32 @@ rgbconvert (GdkImage    *image,
     }
   else
     {
+      ConvertRowsData convert;
+
       index |= bank << 2;
       d (g_print ("converting with index %d\n", index));
-      (* convert_map[index]) (image, pixels, rowstride,
-                              x, y, x + width, y + height,
-                              cmap);
+
+      /* The LSB-first 565 and 0888 converters are the GdkPixelKernels
+       * ones, which only read the image, so big images can be
+       * converted a band of rows per thread. The others stay on the
+       * calling thread.
+       */
+      if ((bank == 3 || bank == 4) && image->byte_order == GDK_LSB_FIRST)
+        {
+          convert.func = convert_map[index];
+          convert.image = image;
+          convert.pixels = pixels;
+          convert.rowstride = rowstride;
+          convert.x = x;
+          convert.y = y;
+          convert.width = width;
+          convert.cmap = cmap;
+          _gdk_pixel_rows_parallel (height, width, convert_rows, &convert);
+        }
+      else
+        (* convert_map[index]) (image, pixels, rowstride,
+                                x, y, x + width, y + height,
+                                cmap);
     }
 }
 
@@ -0,0 +1,1917 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Modified by the GTK+ Team and others 1997-2000.  See the AUTHORS
+ * file for a list of people on the GTK+ Team.  See the ChangeLog
+ * files for a list of changes.  These files are distributed with
+ * GTK+ at ftp://ftp.gtk.org/pub/gtk/.
+ */
+
+/* Pixel compositing kernels used by gdk_draw_pixbuf(), and the
+ * converters used by gdk_pixbuf_get_from_drawable().
+ *
+ * Each instruction set gets a GdkPixelKernels table. The SIMD
+ * versions evaluate exactly the same integer expressions as the C
+ * ones, in 16-bit lanes, so their tables give bit-identical output;
+ * rows are finished off with the C kernel. The mediaLib blend is the
+ * exception and may differ from the C result.
+ *
+ * SSE2 and NEON are used when the compiler targets them; AVX2 is
+ * compiled with a target attribute and picked at runtime if the CPU
+ * supports it. Setting GDK_DISABLE_SIMD in the environment forces the
+ * C kernels.
+ */
+
+#include "config.h"
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2_KERNELS 1
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS 1
+#define AVX2_FUNC __attribute__ ((target ("avx2")))
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_KERNELS 1
+#endif
+
+#include "gdkmedialib.h"
+#include "gdkpixelkernels.h"
+#include "gdkalias.h"
+
+static void
+composite_888_c (guchar      *src_buf,
+		 gint         src_rowstride,
+		 guchar      *dest_buf,
+		 gint         dest_rowstride,
+		 GdkByteOrder dest_byte_order,
+		 gint         width,
+		 gint         height)
+{
+  guchar *src = src_buf;
+  guchar *dest = dest_buf;
+
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src;
+      guchar *q = dest;
+
+      while (twidth--)
+	{
+	  guchar a = p[3];
+	  guint t;
+
+	  t = a * p[0] + (255 - a) * q[0] + 0x80;
+	  q[0] = (t + (t >> 8)) >> 8;
+	  t = a * p[1] + (255 - a) * q[1] + 0x80;
+	  q[1] = (t + (t >> 8)) >> 8;
+	  t = a * p[2] + (255 - a) * q[2] + 0x80;
+	  q[2] = (t + (t >> 8)) >> 8;
+
+	  p += 4;
+	  q += 3;
+	}
+      
+      src += src_rowstride;
+      dest += dest_rowstride;
+    }
+}
+
+static void
+composite_0888_c (guchar      *src_buf,
+		  gint         src_rowstride,
+		  guchar      *dest_buf,
+		  gint         dest_rowstride,
+		  GdkByteOrder dest_byte_order,
+		  gint         width,
+		  gint         height)
+{
+  guchar *src = src_buf;
+  guchar *dest = dest_buf;
+
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src;
+      guchar *q = dest;
+
+      if (dest_byte_order == GDK_LSB_FIRST)
+	{
+	  while (twidth--)
+	    {
+	      guint t;
+	      
+	      t = p[3] * p[2] + (255 - p[3]) * q[0] + 0x80;
+	      q[0] = (t + (t >> 8)) >> 8;
+	      t = p[3] * p[1] + (255 - p[3]) * q[1] + 0x80;
+	      q[1] = (t + (t >> 8)) >> 8;
+	      t = p[3] * p[0] + (255 - p[3]) * q[2] + 0x80;
+	      q[2] = (t + (t >> 8)) >> 8;
+	      p += 4;
+	      q += 4;
+	    }
+	}
+      else
+	{
+	  while (twidth--)
+	    {
+	      guint t;
+	      
+	      t = p[3] * p[0] + (255 - p[3]) * q[1] + 0x80;
+	      q[1] = (t + (t >> 8)) >> 8;
+	      t = p[3] * p[1] + (255 - p[3]) * q[2] + 0x80;
+	      q[2] = (t + (t >> 8)) >> 8;
+	      t = p[3] * p[2] + (255 - p[3]) * q[3] + 0x80;
+	      q[3] = (t + (t >> 8)) >> 8;
+	      p += 4;
+	      q += 4;
+	    }
+	}
+      
+      src += src_rowstride;
+      dest += dest_rowstride;
+    }
+}
+
+#ifdef USE_MEDIALIB
+static void
+composite_0888_medialib (guchar      *src_buf,
+			 gint         src_rowstride,
+			 guchar      *dest_buf,
+			 gint         dest_rowstride,
+			 GdkByteOrder dest_byte_order,
+			 gint         width,
+			 gint         height)
+{
+  guchar *src  = src_buf;
+  guchar *dest = dest_buf;
+
+  mlib_image img_src, img_dst;
+
+  mlib_ImageSetStruct (&img_dst,
+                       MLIB_BYTE,
+                       4,
+                       width,
+                       height,
+                       dest_rowstride,
+                       dest_buf);
+
+  mlib_ImageSetStruct (&img_src,
+                       MLIB_BYTE,
+                       4,
+                       width,
+                       height,
+                       src_rowstride,
+                       src_buf);
+
+  if (dest_byte_order == GDK_LSB_FIRST)
+      mlib_ImageBlendRGBA2BGRA (&img_dst, &img_src);
+  else
+      mlib_ImageBlendRGBA2ARGB (&img_dst, &img_src);
+}
+#endif
+
+static void
+composite_565_c (guchar      *src_buf,
+		 gint         src_rowstride,
+		 guchar      *dest_buf,
+		 gint         dest_rowstride,
+		 GdkByteOrder dest_byte_order,
+		 gint         width,
+		 gint         height)
+{
+  guchar *src = src_buf;
+  guchar *dest = dest_buf;
+
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src;
+      gushort *q = (gushort *)dest;
+
+      while (twidth--)
+	{
+	  guchar a = p[3];
+	  guint tr, tg, tb;
+	  guint tr1, tg1, tb1;
+	  guint tmp = *q;
+
+#if 1
+	  /* This is fast, and corresponds to what composite_888_c() above does
+	   * if we converted to 8-bit first.
+	   */
+	  tr = (tmp & 0xf800);
+	  tr1 = a * p[0] + (255 - a) * ((tr >> 8) + (tr >> 13)) + 0x80;
+	  tg = (tmp & 0x07e0);
+	  tg1 = a * p[1] + (255 - a) * ((tg >> 3) + (tg >> 9)) + 0x80;
+	  tb = (tmp & 0x001f);
+	  tb1 = a * p[2] + (255 - a) * ((tb << 3) + (tb >> 2)) + 0x80;
+
+	  *q = (((tr1 + (tr1 >> 8)) & 0xf800) |
+		(((tg1 + (tg1 >> 8)) & 0xfc00) >> 5)  |
+		((tb1 + (tb1 >> 8)) >> 11));
+#else
+	  /* This version correspond to the result we get with XRENDER -
+	   * a bit of precision is lost since we convert to 8 bit after premultiplying
+	   * instead of at the end
+	   */
+	  guint tr2, tg2, tb2;
+	  guint tr3, tg3, tb3;
+	  
+	  tr = (tmp & 0xf800);
+	  tr1 = (255 - a) * ((tr >> 8) + (tr >> 13)) + 0x80;
+	  tr2 = a * p[0] + 0x80;
+	  tr3 = ((tr1 + (tr1 >> 8)) >> 8) + ((tr2 + (tr2 >> 8)) >> 8);
+
+	  tg = (tmp & 0x07e0);
+	  tg1 = (255 - a) * ((tg >> 3) + (tg >> 9)) + 0x80;
+	  tg2 = a * p[0] + 0x80;
+	  tg3 = ((tg1 + (tg1 >> 8)) >> 8) + ((tg2 + (tg2 >> 8)) >> 8);
+
+	  tb = (tmp & 0x001f);
+	  tb1 = (255 - a) * ((tb << 3) + (tb >> 2)) + 0x80;
+	  tb2 = a * p[0] + 0x80;
+	  tb3 = ((tb1 + (tb1 >> 8)) >> 8) + ((tb2 + (tb2 >> 8)) >> 8);
+
+	  *q = (((tr3 & 0xf8) << 8) |
+		((tg3 & 0xfc) << 3) |
+		((tb3 >> 3)));
+#endif
+	  
+	  p += 4;
+	  q++;
+	}
+      
+      src += src_rowstride;
+      dest += dest_rowstride;
+    }
+}
+
+/* The readback converters read the image bytewise, so the C versions
+ * don't depend on the host byte order.
+ */
+static void
+convert_0888_to_rgb_c (const guchar *src_buf,
+		       gint          src_rowstride,
+		       guchar       *dest_buf,
+		       gint          dest_rowstride,
+		       gint          width,
+		       gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      while (twidth--)
+	{
+	  *o++ = s[2];
+	  *o++ = s[1];
+	  *o++ = s[0];
+	  s += 4;
+	}
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_0888_to_rgba_c (const guchar *src_buf,
+			gint          src_rowstride,
+			guchar       *dest_buf,
+			gint          dest_rowstride,
+			gint          width,
+			gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      while (twidth--)
+	{
+	  *o++ = s[2];
+	  *o++ = s[1];
+	  *o++ = s[0];
+	  *o++ = 0xff;
+	  s += 4;
+	}
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+#define R8fromRGB565(d) ((((d) >> 8) & 0xf8) | (((d) >> 13) & 0x7))
+#define G8fromRGB565(d) ((((d) >> 3) & 0xfc) | (((d) >> 9)  & 0x3))
+#define B8fromRGB565(d) ((((d) << 3) & 0xf8) | (((d) >> 2)  & 0x7))
+
+static void
+convert_565_to_rgb_c (const guchar *src_buf,
+		      gint          src_rowstride,
+		      guchar       *dest_buf,
+		      gint          dest_rowstride,
+		      gint          width,
+		      gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      while (twidth--)
+	{
+	  guint d = s[0] | (s[1] << 8);
+
+	  *o++ = R8fromRGB565 (d);
+	  *o++ = G8fromRGB565 (d);
+	  *o++ = B8fromRGB565 (d);
+	  s += 2;
+	}
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_565_to_rgba_c (const guchar *src_buf,
+		       gint          src_rowstride,
+		       guchar       *dest_buf,
+		       gint          dest_rowstride,
+		       gint          width,
+		       gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      while (twidth--)
+	{
+	  guint d = s[0] | (s[1] << 8);
+
+	  *o++ = R8fromRGB565 (d);
+	  *o++ = G8fromRGB565 (d);
+	  *o++ = B8fromRGB565 (d);
+	  *o++ = 0xff;
+	  s += 2;
+	}
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_rgb_to_0888_c (const guchar *src_buf,
+		       gint          src_rowstride,
+		       guchar       *dest_buf,
+		       gint          dest_rowstride,
+		       gint          width,
+		       gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      while (twidth--)
+	{
+	  o[0] = s[2];
+	  o[1] = s[1];
+	  o[2] = s[0];
+	  o[3] = 0xff;
+	  s += 3;
+	  o += 4;
+	}
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+/* When both buffers are word aligned, the inner loop loads 3 words
+ * (i.e. 4 24-bit pixels), does a lot of shifting and masking, then
+ * writes 2 words.
+ */
+static void
+convert_rgb_to_565_c (const guchar *src_buf,
+		      gint          src_rowstride,
+		      guchar       *dest_buf,
+		      gint          dest_rowstride,
+		      gint          width,
+		      gint          height)
+{
+  while (height--)
+    {
+      gint x;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      x = 0;
+      if ((((guintptr) o | (guintptr) s) & 3) == 0)
+	{
+	  for (; x < width - 3; x += 4)
+	    {
+	      guint32 r1b0g0r0 = ((const guint32 *) s)[0];
+	      guint32 g2r2b1g1 = ((const guint32 *) s)[1];
+	      guint32 b3g3r3b2 = ((const guint32 *) s)[2];
+
+	      ((guint32 *) o)[0] =
+		((r1b0g0r0 & 0xf8) << 8) |
+		((r1b0g0r0 & 0xfc00) >> 5) |
+		((r1b0g0r0 & 0xf80000) >> 19) |
+		(r1b0g0r0 & 0xf8000000) |
+		((g2r2b1g1 & 0xfc) << 19) |
+		((g2r2b1g1 & 0xf800) << 5);
+	      ((guint32 *) o)[1] =
+		((g2r2b1g1 & 0xf80000) >> 8) |
+		((g2r2b1g1 & 0xfc000000) >> 21) |
+		((b3g3r3b2 & 0xf8) >> 3) |
+		((b3g3r3b2 & 0xf800) << 16) |
+		((b3g3r3b2 & 0xfc0000) << 3) |
+		((b3g3r3b2 & 0xf8000000) >> 11);
+	      s += 12;
+	      o += 8;
+	    }
+	}
+
+      for (; x < width; x++)
+	{
+	  ((guint16 *) o)[0] = ((s[0] & 0xf8) << 8) |
+	    ((s[1] & 0xfc) << 3) |
+	    (s[2] >> 3);
+	  s += 3;
+	  o += 2;
+	}
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+#else
+static void
+convert_rgb_to_565_c (const guchar *src_buf,
+		      gint          src_rowstride,
+		      guchar       *dest_buf,
+		      gint          dest_rowstride,
+		      gint          width,
+		      gint          height)
+{
+  while (height--)
+    {
+      gint x;
+      const guchar *s = src_buf;
+
+      for (x = 0; x < width; x++)
+	{
+	  ((guint16 *) dest_buf)[x] = ((s[0] & 0xf8) << 8) |
+	    ((s[1] & 0xfc) << 3) |
+	    (s[2] >> 3);
+	  s += 3;
+	}
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+#endif
+
+#ifdef HAVE_SSE2_KERNELS
+
+/* Composites the 4 RGBA pixels in @s onto the 4 32-bit pixels in @d.
+ * The padding byte of @d gets an alpha of 0, which leaves it unchanged:
+ * (255 * d + 0x80 + ((255 * d + 0x80) >> 8)) >> 8 == d
+ */
+static inline __m128i
+blend_0888_sse2 (__m128i  s,
+                 __m128i  d,
+                 gboolean lsb)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i c255 = _mm_set1_epi16 (255);
+  const __m128i c80 = _mm_set1_epi16 (0x80);
+  __m128i s_lo = _mm_unpacklo_epi8 (s, zero);
+  __m128i s_hi = _mm_unpackhi_epi8 (s, zero);
+  __m128i d_lo = _mm_unpacklo_epi8 (d, zero);
+  __m128i d_hi = _mm_unpackhi_epi8 (d, zero);
+  __m128i a_lo, a_hi, na_lo, na_hi, mask;
+  __m128i t_lo, t_hi;
+
+  a_lo = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s_lo, _MM_SHUFFLE (3, 3, 3, 3)),
+                              _MM_SHUFFLE (3, 3, 3, 3));
+  a_hi = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s_hi, _MM_SHUFFLE (3, 3, 3, 3)),
+                              _MM_SHUFFLE (3, 3, 3, 3));
+
+  if (lsb)
+    {
+      /* RGBA onto BGRx */
+      s_lo = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s_lo, _MM_SHUFFLE (3, 0, 1, 2)),
+                                  _MM_SHUFFLE (3, 0, 1, 2));
+      s_hi = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s_hi, _MM_SHUFFLE (3, 0, 1, 2)),
+                                  _MM_SHUFFLE (3, 0, 1, 2));
+      mask = _mm_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1);
+    }
+  else
+    {
+      /* RGBA onto xRGB */
+      s_lo = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s_lo, _MM_SHUFFLE (2, 1, 0, 3)),
+                                  _MM_SHUFFLE (2, 1, 0, 3));
+      s_hi = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s_hi, _MM_SHUFFLE (2, 1, 0, 3)),
+                                  _MM_SHUFFLE (2, 1, 0, 3));
+      mask = _mm_set_epi16 (-1, -1, -1, 0, -1, -1, -1, 0);
+    }
+
+  a_lo = _mm_and_si128 (a_lo, mask);
+  a_hi = _mm_and_si128 (a_hi, mask);
+  na_lo = _mm_sub_epi16 (c255, a_lo);
+  na_hi = _mm_sub_epi16 (c255, a_hi);
+
+  t_lo = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (a_lo, s_lo),
+                                       _mm_mullo_epi16 (na_lo, d_lo)),
+                        c80);
+  t_hi = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (a_hi, s_hi),
+                                       _mm_mullo_epi16 (na_hi, d_hi)),
+                        c80);
+  t_lo = _mm_srli_epi16 (_mm_add_epi16 (t_lo, _mm_srli_epi16 (t_lo, 8)), 8);
+  t_hi = _mm_srli_epi16 (_mm_add_epi16 (t_hi, _mm_srli_epi16 (t_hi, 8)), 8);
+
+  return _mm_packus_epi16 (t_lo, t_hi);
+}
+
+static void
+composite_0888_sse2 (guchar      *src_buf,
+		     gint         src_rowstride,
+		     guchar      *dest_buf,
+		     gint         dest_rowstride,
+		     GdkByteOrder dest_byte_order,
+		     gint         width,
+		     gint         height)
+{
+  gboolean lsb = dest_byte_order == GDK_LSB_FIRST;
+
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src_buf;
+      guchar *q = dest_buf;
+
+      for (; twidth >= 4; twidth -= 4, p += 16, q += 16)
+	{
+	  __m128i s = _mm_loadu_si128 ((const __m128i *) p);
+	  __m128i d = _mm_loadu_si128 ((const __m128i *) q);
+
+	  _mm_storeu_si128 ((__m128i *) q, blend_0888_sse2 (s, d, lsb));
+	}
+
+      if (twidth)
+	composite_0888_c (p, 0, q, 0, dest_byte_order, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+/* Composites the 8 RGBA pixels in @s0 and @s1 onto the 8 565 pixels
+ * in @d, see composite_565_c().
+ */
+static inline __m128i
+blend_565_sse2 (__m128i s0,
+                __m128i s1,
+                __m128i d)
+{
+  const __m128i mask8 = _mm_set1_epi32 (0xff);
+  const __m128i c255 = _mm_set1_epi16 (255);
+  const __m128i c80 = _mm_set1_epi16 (0x80);
+  __m128i r, g, b, a, na;
+  __m128i tr, tg, tb;
+
+  /* Little endian, so a pixel reads as 0xAABBGGRR */
+  r = _mm_packs_epi32 (_mm_and_si128 (s0, mask8),
+                       _mm_and_si128 (s1, mask8));
+  g = _mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (s0, 8), mask8),
+                       _mm_and_si128 (_mm_srli_epi32 (s1, 8), mask8));
+  b = _mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (s0, 16), mask8),
+                       _mm_and_si128 (_mm_srli_epi32 (s1, 16), mask8));
+  a = _mm_packs_epi32 (_mm_srli_epi32 (s0, 24),
+                       _mm_srli_epi32 (s1, 24));
+  na = _mm_sub_epi16 (c255, a);
+
+  tr = _mm_and_si128 (d, _mm_set1_epi16 ((gshort) 0xf800));
+  tr = _mm_add_epi16 (_mm_srli_epi16 (tr, 8), _mm_srli_epi16 (tr, 13));
+  tg = _mm_and_si128 (d, _mm_set1_epi16 (0x07e0));
+  tg = _mm_add_epi16 (_mm_srli_epi16 (tg, 3), _mm_srli_epi16 (tg, 9));
+  tb = _mm_and_si128 (d, _mm_set1_epi16 (0x001f));
+  tb = _mm_add_epi16 (_mm_slli_epi16 (tb, 3), _mm_srli_epi16 (tb, 2));
+
+  tr = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (a, r),
+                                     _mm_mullo_epi16 (na, tr)),
+                      c80);
+  tg = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (a, g),
+                                     _mm_mullo_epi16 (na, tg)),
+                      c80);
+  tb = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (a, b),
+                                     _mm_mullo_epi16 (na, tb)),
+                      c80);
+  tr = _mm_add_epi16 (tr, _mm_srli_epi16 (tr, 8));
+  tg = _mm_add_epi16 (tg, _mm_srli_epi16 (tg, 8));
+  tb = _mm_add_epi16 (tb, _mm_srli_epi16 (tb, 8));
+
+  return _mm_or_si128 (_mm_or_si128 (_mm_and_si128 (tr, _mm_set1_epi16 ((gshort) 0xf800)),
+                                     _mm_srli_epi16 (_mm_and_si128 (tg, _mm_set1_epi16 ((gshort) 0xfc00)), 5)),
+                       _mm_srli_epi16 (tb, 11));
+}
+
+static void
+composite_565_sse2 (guchar      *src_buf,
+		    gint         src_rowstride,
+		    guchar      *dest_buf,
+		    gint         dest_rowstride,
+		    GdkByteOrder dest_byte_order,
+		    gint         width,
+		    gint         height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src_buf;
+      guchar *q = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, p += 32, q += 16)
+	{
+	  __m128i s0 = _mm_loadu_si128 ((const __m128i *) p);
+	  __m128i s1 = _mm_loadu_si128 ((const __m128i *) (p + 16));
+	  __m128i d = _mm_loadu_si128 ((const __m128i *) q);
+
+	  _mm_storeu_si128 ((__m128i *) q, blend_565_sse2 (s0, s1, d));
+	}
+
+      if (twidth)
+	composite_565_c (p, 0, q, 0, dest_byte_order, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+/* Reorders the 4 BGRx pixels in @s to RGBA with an opaque alpha */
+static inline __m128i
+convert_0888_sse2 (__m128i s)
+{
+  const __m128i mask8 = _mm_set1_epi32 (0xff);
+
+  return _mm_or_si128 (_mm_or_si128 (_mm_and_si128 (_mm_srli_epi32 (s, 16), mask8),
+                                     _mm_and_si128 (s, _mm_set1_epi32 (0xff00))),
+                       _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (s, mask8), 16),
+                                     _mm_set1_epi32 ((gint) 0xff000000)));
+}
+
+static void
+convert_0888_to_rgba_sse2 (const guchar *src_buf,
+			   gint          src_rowstride,
+			   guchar       *dest_buf,
+			   gint          dest_rowstride,
+			   gint          width,
+			   gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 4; twidth -= 4, s += 16, o += 16)
+	_mm_storeu_si128 ((__m128i *) o,
+			  convert_0888_sse2 (_mm_loadu_si128 ((const __m128i *) s)));
+
+      if (twidth)
+	convert_0888_to_rgba_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+/* Expands the 8 pixels in @d to RGBA; @lo gets the first 4 */
+static inline void
+convert_565_sse2 (__m128i  d,
+                  __m128i *lo,
+                  __m128i *hi)
+{
+  __m128i r, g, b;
+
+  r = _mm_or_si128 (_mm_and_si128 (_mm_srli_epi16 (d, 8), _mm_set1_epi16 (0xf8)),
+                    _mm_srli_epi16 (d, 13));
+  g = _mm_or_si128 (_mm_and_si128 (_mm_srli_epi16 (d, 3), _mm_set1_epi16 (0xfc)),
+                    _mm_and_si128 (_mm_srli_epi16 (d, 9), _mm_set1_epi16 (0x3)));
+  b = _mm_or_si128 (_mm_and_si128 (_mm_slli_epi16 (d, 3), _mm_set1_epi16 (0xf8)),
+                    _mm_and_si128 (_mm_srli_epi16 (d, 2), _mm_set1_epi16 (0x7)));
+
+  r = _mm_or_si128 (r, _mm_slli_epi16 (g, 8));
+  b = _mm_or_si128 (b, _mm_set1_epi16 ((gshort) 0xff00));
+
+  *lo = _mm_unpacklo_epi16 (r, b);
+  *hi = _mm_unpackhi_epi16 (r, b);
+}
+
+static void
+convert_565_to_rgba_sse2 (const guchar *src_buf,
+			  gint          src_rowstride,
+			  guchar       *dest_buf,
+			  gint          dest_rowstride,
+			  gint          width,
+			  gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 16, o += 32)
+	{
+	  __m128i lo, hi;
+
+	  convert_565_sse2 (_mm_loadu_si128 ((const __m128i *) s), &lo, &hi);
+	  _mm_storeu_si128 ((__m128i *) o, lo);
+	  _mm_storeu_si128 ((__m128i *) (o + 16), hi);
+	}
+
+      if (twidth)
+	convert_565_to_rgba_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+#endif /* HAVE_SSE2_KERNELS */
+
+#ifdef HAVE_AVX2_KERNELS
+
+/* The AVX2 kernels are the SSE2 ones on 256-bit registers. Unpacking
+ * and packing both work within 128-bit lanes, so they cancel out for
+ * the 32-bit kernel; the 565 one puts the pixels back in order after
+ * narrowing.
+ */
+static inline AVX2_FUNC __m256i
+blend_0888_avx2 (__m256i  s,
+                 __m256i  d,
+                 gboolean lsb)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i c255 = _mm256_set1_epi16 (255);
+  const __m256i c80 = _mm256_set1_epi16 (0x80);
+  __m256i s_lo = _mm256_unpacklo_epi8 (s, zero);
+  __m256i s_hi = _mm256_unpackhi_epi8 (s, zero);
+  __m256i d_lo = _mm256_unpacklo_epi8 (d, zero);
+  __m256i d_hi = _mm256_unpackhi_epi8 (d, zero);
+  __m256i a_lo, a_hi, na_lo, na_hi, mask;
+  __m256i t_lo, t_hi;
+
+  a_lo = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (s_lo, _MM_SHUFFLE (3, 3, 3, 3)),
+                                 _MM_SHUFFLE (3, 3, 3, 3));
+  a_hi = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (s_hi, _MM_SHUFFLE (3, 3, 3, 3)),
+                                 _MM_SHUFFLE (3, 3, 3, 3));
+
+  if (lsb)
+    {
+      s_lo = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (s_lo, _MM_SHUFFLE (3, 0, 1, 2)),
+                                     _MM_SHUFFLE (3, 0, 1, 2));
+      s_hi = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (s_hi, _MM_SHUFFLE (3, 0, 1, 2)),
+                                     _MM_SHUFFLE (3, 0, 1, 2));
+      mask = _mm256_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1,
+                               0, -1, -1, -1, 0, -1, -1, -1);
+    }
+  else
+    {
+      s_lo = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (s_lo, _MM_SHUFFLE (2, 1, 0, 3)),
+                                     _MM_SHUFFLE (2, 1, 0, 3));
+      s_hi = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (s_hi, _MM_SHUFFLE (2, 1, 0, 3)),
+                                     _MM_SHUFFLE (2, 1, 0, 3));
+      mask = _mm256_set_epi16 (-1, -1, -1, 0, -1, -1, -1, 0,
+                               -1, -1, -1, 0, -1, -1, -1, 0);
+    }
+
+  a_lo = _mm256_and_si256 (a_lo, mask);
+  a_hi = _mm256_and_si256 (a_hi, mask);
+  na_lo = _mm256_sub_epi16 (c255, a_lo);
+  na_hi = _mm256_sub_epi16 (c255, a_hi);
+
+  t_lo = _mm256_add_epi16 (_mm256_add_epi16 (_mm256_mullo_epi16 (a_lo, s_lo),
+                                             _mm256_mullo_epi16 (na_lo, d_lo)),
+                           c80);
+  t_hi = _mm256_add_epi16 (_mm256_add_epi16 (_mm256_mullo_epi16 (a_hi, s_hi),
+                                             _mm256_mullo_epi16 (na_hi, d_hi)),
+                           c80);
+  t_lo = _mm256_srli_epi16 (_mm256_add_epi16 (t_lo, _mm256_srli_epi16 (t_lo, 8)), 8);
+  t_hi = _mm256_srli_epi16 (_mm256_add_epi16 (t_hi, _mm256_srli_epi16 (t_hi, 8)), 8);
+
+  return _mm256_packus_epi16 (t_lo, t_hi);
+}
+
+static AVX2_FUNC void
+composite_0888_avx2 (guchar      *src_buf,
+		     gint         src_rowstride,
+		     guchar      *dest_buf,
+		     gint         dest_rowstride,
+		     GdkByteOrder dest_byte_order,
+		     gint         width,
+		     gint         height)
+{
+  gboolean lsb = dest_byte_order == GDK_LSB_FIRST;
+
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src_buf;
+      guchar *q = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, p += 32, q += 32)
+	{
+	  __m256i s = _mm256_loadu_si256 ((const __m256i *) p);
+	  __m256i d = _mm256_loadu_si256 ((const __m256i *) q);
+
+	  _mm256_storeu_si256 ((__m256i *) q, blend_0888_avx2 (s, d, lsb));
+	}
+
+      if (twidth)
+	composite_0888_c (p, 0, q, 0, dest_byte_order, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+/* Narrows two vectors of 8 32-bit values to 16 16-bit values in order */
+static inline AVX2_FUNC __m256i
+pack_32_to_16_avx2 (__m256i a,
+                    __m256i b)
+{
+  return _mm256_permute4x64_epi64 (_mm256_packs_epi32 (a, b),
+                                   _MM_SHUFFLE (3, 1, 2, 0));
+}
+
+static inline AVX2_FUNC __m256i
+blend_565_avx2 (__m256i s0,
+                __m256i s1,
+                __m256i d)
+{
+  const __m256i mask8 = _mm256_set1_epi32 (0xff);
+  const __m256i c255 = _mm256_set1_epi16 (255);
+  const __m256i c80 = _mm256_set1_epi16 (0x80);
+  __m256i r, g, b, a, na;
+  __m256i tr, tg, tb;
+
+  r = pack_32_to_16_avx2 (_mm256_and_si256 (s0, mask8),
+                          _mm256_and_si256 (s1, mask8));
+  g = pack_32_to_16_avx2 (_mm256_and_si256 (_mm256_srli_epi32 (s0, 8), mask8),
+                          _mm256_and_si256 (_mm256_srli_epi32 (s1, 8), mask8));
+  b = pack_32_to_16_avx2 (_mm256_and_si256 (_mm256_srli_epi32 (s0, 16), mask8),
+                          _mm256_and_si256 (_mm256_srli_epi32 (s1, 16), mask8));
+  a = pack_32_to_16_avx2 (_mm256_srli_epi32 (s0, 24),
+                          _mm256_srli_epi32 (s1, 24));
+  na = _mm256_sub_epi16 (c255, a);
+
+  tr = _mm256_and_si256 (d, _mm256_set1_epi16 ((gshort) 0xf800));
+  tr = _mm256_add_epi16 (_mm256_srli_epi16 (tr, 8), _mm256_srli_epi16 (tr, 13));
+  tg = _mm256_and_si256 (d, _mm256_set1_epi16 (0x07e0));
+  tg = _mm256_add_epi16 (_mm256_srli_epi16 (tg, 3), _mm256_srli_epi16 (tg, 9));
+  tb = _mm256_and_si256 (d, _mm256_set1_epi16 (0x001f));
+  tb = _mm256_add_epi16 (_mm256_slli_epi16 (tb, 3), _mm256_srli_epi16 (tb, 2));
+
+  tr = _mm256_add_epi16 (_mm256_add_epi16 (_mm256_mullo_epi16 (a, r),
+                                           _mm256_mullo_epi16 (na, tr)),
+                         c80);
+  tg = _mm256_add_epi16 (_mm256_add_epi16 (_mm256_mullo_epi16 (a, g),
+                                           _mm256_mullo_epi16 (na, tg)),
+                         c80);
+  tb = _mm256_add_epi16 (_mm256_add_epi16 (_mm256_mullo_epi16 (a, b),
+                                           _mm256_mullo_epi16 (na, tb)),
+                         c80);
+  tr = _mm256_add_epi16 (tr, _mm256_srli_epi16 (tr, 8));
+  tg = _mm256_add_epi16 (tg, _mm256_srli_epi16 (tg, 8));
+  tb = _mm256_add_epi16 (tb, _mm256_srli_epi16 (tb, 8));
+
+  return _mm256_or_si256 (_mm256_or_si256 (_mm256_and_si256 (tr, _mm256_set1_epi16 ((gshort) 0xf800)),
+                                           _mm256_srli_epi16 (_mm256_and_si256 (tg, _mm256_set1_epi16 ((gshort) 0xfc00)), 5)),
+                          _mm256_srli_epi16 (tb, 11));
+}
+
+static AVX2_FUNC void
+composite_565_avx2 (guchar      *src_buf,
+		    gint         src_rowstride,
+		    guchar      *dest_buf,
+		    gint         dest_rowstride,
+		    GdkByteOrder dest_byte_order,
+		    gint         width,
+		    gint         height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src_buf;
+      guchar *q = dest_buf;
+
+      for (; twidth >= 16; twidth -= 16, p += 64, q += 32)
+	{
+	  __m256i s0 = _mm256_loadu_si256 ((const __m256i *) p);
+	  __m256i s1 = _mm256_loadu_si256 ((const __m256i *) (p + 32));
+	  __m256i d = _mm256_loadu_si256 ((const __m256i *) q);
+
+	  _mm256_storeu_si256 ((__m256i *) q, blend_565_avx2 (s0, s1, d));
+	}
+
+      if (twidth)
+	composite_565_c (p, 0, q, 0, dest_byte_order, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static inline AVX2_FUNC __m256i
+convert_0888_avx2 (__m256i s)
+{
+  const __m256i mask8 = _mm256_set1_epi32 (0xff);
+
+  return _mm256_or_si256 (_mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi32 (s, 16), mask8),
+                                           _mm256_and_si256 (s, _mm256_set1_epi32 (0xff00))),
+                          _mm256_or_si256 (_mm256_slli_epi32 (_mm256_and_si256 (s, mask8), 16),
+                                           _mm256_set1_epi32 ((gint) 0xff000000)));
+}
+
+/* Stores the 8 RGBA pixels in @s as 24 bytes of RGB. Each half is
+ * written with a 16-byte store, so 4 bytes past the end of the pixels
+ * get clobbered; callers make sure those belong to later pixels.
+ */
+static inline AVX2_FUNC void
+store_rgb_avx2 (guchar  *o,
+                __m256i  s)
+{
+  const __m256i pack = _mm256_setr_epi8 (0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+  s = _mm256_shuffle_epi8 (s, pack);
+  _mm_storeu_si128 ((__m128i *) o, _mm256_castsi256_si128 (s));
+  _mm_storeu_si128 ((__m128i *) (o + 12), _mm256_extracti128_si256 (s, 1));
+}
+
+static AVX2_FUNC void
+convert_0888_to_rgb_avx2 (const guchar *src_buf,
+			  gint          src_rowstride,
+			  guchar       *dest_buf,
+			  gint          dest_rowstride,
+			  gint          width,
+			  gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      /* Leave at least 2 pixels for the overlapping store */
+      for (; twidth >= 10; twidth -= 8, s += 32, o += 24)
+	store_rgb_avx2 (o, convert_0888_avx2 (_mm256_loadu_si256 ((const __m256i *) s)));
+
+      if (twidth)
+	convert_0888_to_rgb_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static AVX2_FUNC void
+convert_0888_to_rgba_avx2 (const guchar *src_buf,
+			   gint          src_rowstride,
+			   guchar       *dest_buf,
+			   gint          dest_rowstride,
+			   gint          width,
+			   gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 32, o += 32)
+	_mm256_storeu_si256 ((__m256i *) o,
+			     convert_0888_avx2 (_mm256_loadu_si256 ((const __m256i *) s)));
+
+      if (twidth)
+	convert_0888_to_rgba_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+/* Expands the 16 pixels in @d to RGBA; @lo gets the first 8 */
+static inline AVX2_FUNC void
+convert_565_avx2 (__m256i  d,
+                  __m256i *lo,
+                  __m256i *hi)
+{
+  __m256i r, g, b, t0, t1;
+
+  r = _mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi16 (d, 8), _mm256_set1_epi16 (0xf8)),
+                       _mm256_srli_epi16 (d, 13));
+  g = _mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi16 (d, 3), _mm256_set1_epi16 (0xfc)),
+                       _mm256_and_si256 (_mm256_srli_epi16 (d, 9), _mm256_set1_epi16 (0x3)));
+  b = _mm256_or_si256 (_mm256_and_si256 (_mm256_slli_epi16 (d, 3), _mm256_set1_epi16 (0xf8)),
+                       _mm256_and_si256 (_mm256_srli_epi16 (d, 2), _mm256_set1_epi16 (0x7)));
+
+  r = _mm256_or_si256 (r, _mm256_slli_epi16 (g, 8));
+  b = _mm256_or_si256 (b, _mm256_set1_epi16 ((gshort) 0xff00));
+
+  /* The unpacks work within 128-bit lanes, so put the lanes back in
+   * pixel order afterwards.
+   */
+  t0 = _mm256_unpacklo_epi16 (r, b);
+  t1 = _mm256_unpackhi_epi16 (r, b);
+  *lo = _mm256_permute2x128_si256 (t0, t1, 0x20);
+  *hi = _mm256_permute2x128_si256 (t0, t1, 0x31);
+}
+
+static AVX2_FUNC void
+convert_565_to_rgb_avx2 (const guchar *src_buf,
+			 gint          src_rowstride,
+			 guchar       *dest_buf,
+			 gint          dest_rowstride,
+			 gint          width,
+			 gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      /* Leave at least 2 pixels for the overlapping store */
+      for (; twidth >= 18; twidth -= 16, s += 32, o += 48)
+	{
+	  __m256i lo, hi;
+
+	  convert_565_avx2 (_mm256_loadu_si256 ((const __m256i *) s), &lo, &hi);
+	  store_rgb_avx2 (o, lo);
+	  store_rgb_avx2 (o + 24, hi);
+	}
+
+      if (twidth)
+	convert_565_to_rgb_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static AVX2_FUNC void
+convert_565_to_rgba_avx2 (const guchar *src_buf,
+			  gint          src_rowstride,
+			  guchar       *dest_buf,
+			  gint          dest_rowstride,
+			  gint          width,
+			  gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 16; twidth -= 16, s += 32, o += 64)
+	{
+	  __m256i lo, hi;
+
+	  convert_565_avx2 (_mm256_loadu_si256 ((const __m256i *) s), &lo, &hi);
+	  _mm256_storeu_si256 ((__m256i *) o, lo);
+	  _mm256_storeu_si256 ((__m256i *) (o + 32), hi);
+	}
+
+      if (twidth)
+	convert_565_to_rgba_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+/* Loads the 8 RGB pixels at @s into 32-bit lanes, picking their bytes
+ * with @order. The second load reads 4 bytes past the pixels, so
+ * callers make sure those belong to later pixels.
+ */
+static inline AVX2_FUNC __m256i
+load_rgb_avx2 (const guchar *s,
+               __m256i       order)
+{
+  __m256i p;
+
+  p = _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) s));
+  p = _mm256_inserti128_si256 (p, _mm_loadu_si128 ((const __m128i *) (s + 12)), 1);
+
+  return _mm256_shuffle_epi8 (p, order);
+}
+
+static AVX2_FUNC void
+convert_rgb_to_0888_avx2 (const guchar *src_buf,
+			  gint          src_rowstride,
+			  guchar       *dest_buf,
+			  gint          dest_rowstride,
+			  gint          width,
+			  gint          height)
+{
+  const __m256i bgr = _mm256_setr_epi8 (2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                        2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  const __m256i opaque = _mm256_set1_epi32 ((gint) 0xff000000);
+
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      /* Leave at least 2 pixels for the overlapping load */
+      for (; twidth >= 10; twidth -= 8, s += 24, o += 32)
+	_mm256_storeu_si256 ((__m256i *) o,
+			     _mm256_or_si256 (load_rgb_avx2 (s, bgr), opaque));
+
+      if (twidth)
+	convert_rgb_to_0888_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static inline AVX2_FUNC __m256i
+pack_565_avx2 (__m256i p)
+{
+  return _mm256_or_si256 (_mm256_or_si256 (_mm256_slli_epi32 (_mm256_and_si256 (p, _mm256_set1_epi32 (0xf8)), 8),
+                                           _mm256_and_si256 (_mm256_srli_epi32 (p, 5), _mm256_set1_epi32 (0x7e0))),
+                          _mm256_and_si256 (_mm256_srli_epi32 (p, 19), _mm256_set1_epi32 (0x1f)));
+}
+
+static AVX2_FUNC void
+convert_rgb_to_565_avx2 (const guchar *src_buf,
+			 gint          src_rowstride,
+			 guchar       *dest_buf,
+			 gint          dest_rowstride,
+			 gint          width,
+			 gint          height)
+{
+  const __m256i rgb = _mm256_setr_epi8 (0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      /* Leave at least 2 pixels for the overlapping load */
+      for (; twidth >= 18; twidth -= 16, s += 48, o += 32)
+	{
+	  __m256i lo = pack_565_avx2 (load_rgb_avx2 (s, rgb));
+	  __m256i hi = pack_565_avx2 (load_rgb_avx2 (s + 24, rgb));
+
+	  /* The pack works within 128-bit lanes */
+	  _mm256_storeu_si256 ((__m256i *) o,
+			       _mm256_permute4x64_epi64 (_mm256_packus_epi32 (lo, hi),
+							 _MM_SHUFFLE (3, 1, 2, 0)));
+	}
+
+      if (twidth)
+	convert_rgb_to_565_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+#endif /* HAVE_AVX2_KERNELS */
+
+#ifdef HAVE_NEON_KERNELS
+
+static inline uint8x8_t
+blend_u8_neon (uint8x8_t s,
+               uint8x8_t d,
+               uint8x8_t a,
+               uint8x8_t na)
+{
+  uint16x8_t t;
+
+  t = vmlal_u8 (vmull_u8 (a, s), na, d);
+  t = vaddq_u16 (t, vdupq_n_u16 (0x80));
+
+  return vshrn_n_u16 (vaddq_u16 (t, vshrq_n_u16 (t, 8)), 8);
+}
+
+static void
+composite_888_neon (guchar      *src_buf,
+		    gint         src_rowstride,
+		    guchar      *dest_buf,
+		    gint         dest_rowstride,
+		    GdkByteOrder dest_byte_order,
+		    gint         width,
+		    gint         height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src_buf;
+      guchar *q = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, p += 32, q += 24)
+	{
+	  uint8x8x4_t s = vld4_u8 (p);
+	  uint8x8x3_t d = vld3_u8 (q);
+	  uint8x8_t na = vmvn_u8 (s.val[3]);
+
+	  d.val[0] = blend_u8_neon (s.val[0], d.val[0], s.val[3], na);
+	  d.val[1] = blend_u8_neon (s.val[1], d.val[1], s.val[3], na);
+	  d.val[2] = blend_u8_neon (s.val[2], d.val[2], s.val[3], na);
+	  vst3_u8 (q, d);
+	}
+
+      if (twidth)
+	composite_888_c (p, 0, q, 0, dest_byte_order, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+composite_0888_neon (guchar      *src_buf,
+		     gint         src_rowstride,
+		     guchar      *dest_buf,
+		     gint         dest_rowstride,
+		     GdkByteOrder dest_byte_order,
+		     gint         width,
+		     gint         height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src_buf;
+      guchar *q = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, p += 32, q += 32)
+	{
+	  uint8x8x4_t s = vld4_u8 (p);
+	  uint8x8x4_t d = vld4_u8 (q);
+	  uint8x8_t na = vmvn_u8 (s.val[3]);
+
+	  if (dest_byte_order == GDK_LSB_FIRST)
+	    {
+	      d.val[0] = blend_u8_neon (s.val[2], d.val[0], s.val[3], na);
+	      d.val[1] = blend_u8_neon (s.val[1], d.val[1], s.val[3], na);
+	      d.val[2] = blend_u8_neon (s.val[0], d.val[2], s.val[3], na);
+	    }
+	  else
+	    {
+	      d.val[1] = blend_u8_neon (s.val[0], d.val[1], s.val[3], na);
+	      d.val[2] = blend_u8_neon (s.val[1], d.val[2], s.val[3], na);
+	      d.val[3] = blend_u8_neon (s.val[2], d.val[3], s.val[3], na);
+	    }
+	  vst4_u8 (q, d);
+	}
+
+      if (twidth)
+	composite_0888_c (p, 0, q, 0, dest_byte_order, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static inline uint16x8_t
+blend_u16_neon (uint8x8_t  s,
+                uint16x8_t d,
+                uint16x8_t a,
+                uint16x8_t na)
+{
+  uint16x8_t t;
+
+  t = vmlaq_u16 (vmulq_u16 (a, vmovl_u8 (s)), na, d);
+  t = vaddq_u16 (t, vdupq_n_u16 (0x80));
+
+  return vaddq_u16 (t, vshrq_n_u16 (t, 8));
+}
+
+static void
+composite_565_neon (guchar      *src_buf,
+		    gint         src_rowstride,
+		    guchar      *dest_buf,
+		    gint         dest_rowstride,
+		    GdkByteOrder dest_byte_order,
+		    gint         width,
+		    gint         height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      guchar *p = src_buf;
+      guchar *q = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, p += 32, q += 16)
+	{
+	  uint8x8x4_t s = vld4_u8 (p);
+	  uint16x8_t d = vld1q_u16 ((const uint16_t *) q);
+	  uint16x8_t a = vmovl_u8 (s.val[3]);
+	  uint16x8_t na = vmovl_u8 (vmvn_u8 (s.val[3]));
+	  uint16x8_t tr, tg, tb;
+
+	  tr = vandq_u16 (d, vdupq_n_u16 (0xf800));
+	  tr = vaddq_u16 (vshrq_n_u16 (tr, 8), vshrq_n_u16 (tr, 13));
+	  tg = vandq_u16 (d, vdupq_n_u16 (0x07e0));
+	  tg = vaddq_u16 (vshrq_n_u16 (tg, 3), vshrq_n_u16 (tg, 9));
+	  tb = vandq_u16 (d, vdupq_n_u16 (0x001f));
+	  tb = vaddq_u16 (vshlq_n_u16 (tb, 3), vshrq_n_u16 (tb, 2));
+
+	  tr = blend_u16_neon (s.val[0], tr, a, na);
+	  tg = blend_u16_neon (s.val[1], tg, a, na);
+	  tb = blend_u16_neon (s.val[2], tb, a, na);
+
+	  d = vorrq_u16 (vorrq_u16 (vandq_u16 (tr, vdupq_n_u16 (0xf800)),
+				    vshrq_n_u16 (vandq_u16 (tg, vdupq_n_u16 (0xfc00)), 5)),
+			 vshrq_n_u16 (tb, 11));
+	  vst1q_u16 ((uint16_t *) q, d);
+	}
+
+      if (twidth)
+	composite_565_c (p, 0, q, 0, dest_byte_order, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_0888_to_rgb_neon (const guchar *src_buf,
+			  gint          src_rowstride,
+			  guchar       *dest_buf,
+			  gint          dest_rowstride,
+			  gint          width,
+			  gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 32, o += 24)
+	{
+	  uint8x8x4_t p = vld4_u8 (s);
+	  uint8x8x3_t q;
+
+	  q.val[0] = p.val[2];
+	  q.val[1] = p.val[1];
+	  q.val[2] = p.val[0];
+	  vst3_u8 (o, q);
+	}
+
+      if (twidth)
+	convert_0888_to_rgb_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_0888_to_rgba_neon (const guchar *src_buf,
+			   gint          src_rowstride,
+			   guchar       *dest_buf,
+			   gint          dest_rowstride,
+			   gint          width,
+			   gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 32, o += 32)
+	{
+	  uint8x8x4_t p = vld4_u8 (s);
+	  uint8x8x4_t q;
+
+	  q.val[0] = p.val[2];
+	  q.val[1] = p.val[1];
+	  q.val[2] = p.val[0];
+	  q.val[3] = vdup_n_u8 (0xff);
+	  vst4_u8 (o, q);
+	}
+
+      if (twidth)
+	convert_0888_to_rgba_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+/* Expands 8 pixels, given as their low and high bytes, to R, G and B */
+static inline void
+convert_565_neon (uint8x8x2_t  p,
+                  uint8x8_t   *r,
+                  uint8x8_t   *g,
+                  uint8x8_t   *b)
+{
+  uint8x8_t lo = p.val[0];
+  uint8x8_t hi = p.val[1];
+
+  *r = vorr_u8 (vand_u8 (hi, vdup_n_u8 (0xf8)), vshr_n_u8 (hi, 5));
+  *g = vorr_u8 (vand_u8 (vorr_u8 (vshl_n_u8 (hi, 5), vshr_n_u8 (lo, 3)), vdup_n_u8 (0xfc)),
+                vand_u8 (vshr_n_u8 (hi, 1), vdup_n_u8 (0x3)));
+  *b = vorr_u8 (vshl_n_u8 (lo, 3), vand_u8 (vshr_n_u8 (lo, 2), vdup_n_u8 (0x7)));
+}
+
+static void
+convert_565_to_rgb_neon (const guchar *src_buf,
+			 gint          src_rowstride,
+			 guchar       *dest_buf,
+			 gint          dest_rowstride,
+			 gint          width,
+			 gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 16, o += 24)
+	{
+	  uint8x8x3_t q;
+
+	  convert_565_neon (vld2_u8 (s), &q.val[0], &q.val[1], &q.val[2]);
+	  vst3_u8 (o, q);
+	}
+
+      if (twidth)
+	convert_565_to_rgb_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_565_to_rgba_neon (const guchar *src_buf,
+			  gint          src_rowstride,
+			  guchar       *dest_buf,
+			  gint          dest_rowstride,
+			  gint          width,
+			  gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 16, o += 32)
+	{
+	  uint8x8x4_t q;
+
+	  convert_565_neon (vld2_u8 (s), &q.val[0], &q.val[1], &q.val[2]);
+	  q.val[3] = vdup_n_u8 (0xff);
+	  vst4_u8 (o, q);
+	}
+
+      if (twidth)
+	convert_565_to_rgba_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_rgb_to_0888_neon (const guchar *src_buf,
+			  gint          src_rowstride,
+			  guchar       *dest_buf,
+			  gint          dest_rowstride,
+			  gint          width,
+			  gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 24, o += 32)
+	{
+	  uint8x8x3_t p = vld3_u8 (s);
+	  uint8x8x4_t q;
+
+	  q.val[0] = p.val[2];
+	  q.val[1] = p.val[1];
+	  q.val[2] = p.val[0];
+	  q.val[3] = vdup_n_u8 (0xff);
+	  vst4_u8 (o, q);
+	}
+
+      if (twidth)
+	convert_rgb_to_0888_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+static void
+convert_rgb_to_565_neon (const guchar *src_buf,
+			 gint          src_rowstride,
+			 guchar       *dest_buf,
+			 gint          dest_rowstride,
+			 gint          width,
+			 gint          height)
+{
+  while (height--)
+    {
+      gint twidth = width;
+      const guchar *s = src_buf;
+      guchar *o = dest_buf;
+
+      for (; twidth >= 8; twidth -= 8, s += 24, o += 16)
+	{
+	  uint8x8x3_t p = vld3_u8 (s);
+	  uint16x8_t d;
+
+	  d = vshll_n_u8 (vand_u8 (p.val[0], vdup_n_u8 (0xf8)), 8);
+	  d = vorrq_u16 (d, vshll_n_u8 (vand_u8 (p.val[1], vdup_n_u8 (0xfc)), 3));
+	  d = vorrq_u16 (d, vmovl_u8 (vshr_n_u8 (p.val[2], 3)));
+	  vst1q_u16 ((uint16_t *) o, d);
+	}
+
+      if (twidth)
+	convert_rgb_to_565_c (s, 0, o, 0, twidth, 1);
+
+      src_buf += src_rowstride;
+      dest_buf += dest_rowstride;
+    }
+}
+
+#endif /* HAVE_NEON_KERNELS */
+
+static const GdkPixelKernels c_kernels = {
+  "c",
+  TRUE,
+  composite_888_c,
+  composite_0888_c,
+  composite_565_c,
+  convert_0888_to_rgb_c,
+  convert_0888_to_rgba_c,
+  convert_565_to_rgb_c,
+  convert_565_to_rgba_c,
+  convert_rgb_to_0888_c,
+  convert_rgb_to_565_c
+};
+
+#ifdef USE_MEDIALIB
+static const GdkPixelKernels medialib_kernels = {
+  "medialib",
+  FALSE,
+  composite_888_c,
+  composite_0888_medialib,
+  composite_565_c,
+  convert_0888_to_rgb_c,
+  convert_0888_to_rgba_c,
+  convert_565_to_rgb_c,
+  convert_565_to_rgba_c,
+  convert_rgb_to_0888_c,
+  convert_rgb_to_565_c
+};
+#endif
+
+#ifdef HAVE_SSE2_KERNELS
+static const GdkPixelKernels sse2_kernels = {
+  "sse2",
+  TRUE,
+  composite_888_c,
+  composite_0888_sse2,
+  composite_565_sse2,
+  convert_0888_to_rgb_c,
+  convert_0888_to_rgba_sse2,
+  convert_565_to_rgb_c,
+  convert_565_to_rgba_sse2,
+  convert_rgb_to_0888_c,
+  convert_rgb_to_565_c
+};
+#endif
+
+#ifdef HAVE_AVX2_KERNELS
+static const GdkPixelKernels avx2_kernels = {
+  "avx2",
+  TRUE,
+  composite_888_c,
+  composite_0888_avx2,
+  composite_565_avx2,
+  convert_0888_to_rgb_avx2,
+  convert_0888_to_rgba_avx2,
+  convert_565_to_rgb_avx2,
+  convert_565_to_rgba_avx2,
+  convert_rgb_to_0888_avx2,
+  convert_rgb_to_565_avx2
+};
+#endif
+
+#ifdef HAVE_NEON_KERNELS
+static const GdkPixelKernels neon_kernels = {
+  "neon",
+  TRUE,
+  composite_888_neon,
+  composite_0888_neon,
+  composite_565_neon,
+  convert_0888_to_rgb_neon,
+  convert_0888_to_rgba_neon,
+  convert_565_to_rgb_neon,
+  convert_565_to_rgba_neon,
+  convert_rgb_to_0888_neon,
+  convert_rgb_to_565_neon
+};
+#endif
+
+/**
+ * _gdk_pixel_kernels_get_all:
+ *
+ * Returns the kernel sets that the running CPU supports, from the C
+ * kernels to the preferred set.
+ *
+ * Return value: a %NULL-terminated array, owned by GDK
+ **/
+const GdkPixelKernels * const *
+_gdk_pixel_kernels_get_all (void)
+{
+  static const GdkPixelKernels *kernels[5];
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      gint n = 0;
+
+      kernels[n++] = &c_kernels;
+
+#ifdef USE_MEDIALIB
+      if (_gdk_use_medialib ())
+	kernels[n++] = &medialib_kernels;
+#endif
+
+#ifdef HAVE_SSE2_KERNELS
+      kernels[n++] = &sse2_kernels;
+#endif
+
+#ifdef HAVE_AVX2_KERNELS
+      if (__builtin_cpu_supports ("avx2"))
+	kernels[n++] = &avx2_kernels;
+#endif
+
+#ifdef HAVE_NEON_KERNELS
+      kernels[n++] = &neon_kernels;
+#endif
+
+      kernels[n] = NULL;
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return kernels;
+}
+
+/**
+ * _gdk_pixel_kernels_get:
+ *
+ * Returns the kernel set to use for drawing.
+ *
+ * Return value: a #GdkPixelKernels, owned by GDK
+ **/
+const GdkPixelKernels *
+_gdk_pixel_kernels_get (void)
+{
+  static const GdkPixelKernels *preferred = NULL;
+  static gsize initialized = 0;
+
+  /* The converters call this from worker threads too */
+  if (g_once_init_enter (&initialized))
+    {
+      const GdkPixelKernels * const *kernels = _gdk_pixel_kernels_get_all ();
+
+      if (g_getenv ("GDK_DISABLE_SIMD"))
+	preferred = kernels[0];
+      else
+	{
+	  gint n = 0;
+
+	  while (kernels[n + 1])
+	    n++;
+
+	  preferred = kernels[n];
+	}
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return preferred;
+}
+
+#define PARALLEL_MAX_JOBS 8
+
+typedef struct
+{
+  GdkPixelRowsFunc func;
+  gpointer data;
+  GMutex *mutex;
+  GCond *cond;
+  gint pending;
+} ParallelRows;
+
+typedef struct
+{
+  ParallelRows *rows;
+  gint first_row;
+  gint n_rows;
+} ParallelRowsJob;
+
+static void
+parallel_rows_run (gpointer job_data,
+                   gpointer user_data)
+{
+  ParallelRowsJob *job = job_data;
+  ParallelRows *rows = job->rows;
+
+  rows->func (job->first_row, job->n_rows, rows->data);
+
+  g_mutex_lock (rows->mutex);
+  if (--rows->pending == 0)
+    g_cond_signal (rows->cond);
+  g_mutex_unlock (rows->mutex);
+}
+
+static gint
+parallel_rows_get_n_jobs (void)
+{
+  static gint n_jobs = 0;
+
+  if (n_jobs == 0)
+    {
+      glong n_cpus = 1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+      n_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+      n_jobs = CLAMP (n_cpus, 1, PARALLEL_MAX_JOBS);
+    }
+
+  return n_jobs;
+}
+
+static GThreadPool *
+parallel_rows_get_pool (void)
+{
+  static GThreadPool *pool = NULL;
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      gint n_jobs = parallel_rows_get_n_jobs ();
+
+      /* The calling thread does one share of the work itself */
+      if (n_jobs > 1)
+	pool = g_thread_pool_new (parallel_rows_run, NULL,
+				  n_jobs - 1, FALSE, NULL);
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return pool;
+}
+
+/**
+ * _gdk_pixel_rows_split:
+ * @n_rows: the number of rows to process
+ * @func: the function processing a range of rows
+ * @data: user data for @func
+ *
+ * Calls @func over the rows from 0 to @n_rows, splitting them between
+ * as many threads as there are CPUs. @func must not touch anything but
+ * the pixels of its own rows, and must not call into GDK. Returns once
+ * all rows have been processed.
+ **/
+void
+_gdk_pixel_rows_split (gint             n_rows,
+                       GdkPixelRowsFunc func,
+                       gpointer         data)
+{
+  ParallelRowsJob jobs[PARALLEL_MAX_JOBS];
+  ParallelRows rows;
+  GThreadPool *pool = NULL;
+  gint n_jobs, i, first_row;
+
+  if (g_thread_supported ())
+    pool = parallel_rows_get_pool ();
+
+  if (pool == NULL || n_rows < 2)
+    {
+      func (0, n_rows, data);
+      return;
+    }
+
+  n_jobs = MIN (parallel_rows_get_n_jobs (), n_rows);
+
+  rows.func = func;
+  rows.data = data;
+  rows.mutex = g_mutex_new ();
+  rows.cond = g_cond_new ();
+  rows.pending = n_jobs - 1;
+
+  for (i = 0, first_row = 0; i < n_jobs; i++)
+    {
+      jobs[i].rows = &rows;
+      jobs[i].first_row = first_row;
+      jobs[i].n_rows = (n_rows - first_row) / (n_jobs - i);
+      first_row += jobs[i].n_rows;
+    }
+
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (pool, &jobs[i], NULL);
+
+  func (jobs[0].first_row, jobs[0].n_rows, data);
+
+  g_mutex_lock (rows.mutex);
+  while (rows.pending > 0)
+    g_cond_wait (rows.cond, rows.mutex);
+  g_mutex_unlock (rows.mutex);
+
+  g_mutex_free (rows.mutex);
+  g_cond_free (rows.cond);
+}
+
+/**
+ * _gdk_pixel_rows_parallel:
+ * @n_rows: the number of rows to process
+ * @row_width: the number of pixels in a row
+ * @func: the function processing a range of rows
+ * @data: user data for @func
+ *
+ * Like _gdk_pixel_rows_split(), but only splits the rows when the
+ * image is big enough to make that worth it.
+ **/
+void
+_gdk_pixel_rows_parallel (gint             n_rows,
+                          gint             row_width,
+                          GdkPixelRowsFunc func,
+                          gpointer         data)
+{
+  if ((gint64) n_rows * row_width >= GDK_PARALLEL_MIN_PIXELS)
+    _gdk_pixel_rows_split (n_rows, func, data);
+  else
+    func (0, n_rows, data);
+}
+
+#define __GDK_PIXEL_KERNELS_C__
+#include "gdkaliasdef.c"
@@ -0,0 +1,111 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Modified by the GTK+ Team and others 1997-2000.  See the AUTHORS
+ * file for a list of people on the GTK+ Team.  See the ChangeLog
+ * files for a list of changes.  These files are distributed with
+ * GTK+ at ftp://ftp.gtk.org/pub/gtk/.
+ */
+
+#ifndef __GDK_PIXEL_KERNELS_H__
+#define __GDK_PIXEL_KERNELS_H__
+
+#include <gdk/gdktypes.h>
+
+G_BEGIN_DECLS
+
+/* Composites non-premultiplied RGBA @src_buf onto @dest_buf. The
+ * destination byte order is ignored by the 24-bit RGB kernel.
+ */
+typedef void (*GdkCompositeFunc) (guchar       *src_buf,
+                                  gint          src_rowstride,
+                                  guchar       *dest_buf,
+                                  gint          dest_rowstride,
+                                  GdkByteOrder  dest_byte_order,
+                                  gint          width,
+                                  gint          height);
+
+/* Converts LSB-first image data read back from the server into
+ * RGB or RGBA pixbuf data.
+ */
+typedef void (*GdkConvertFunc) (const guchar *src_buf,
+                                gint          src_rowstride,
+                                guchar       *dest_buf,
+                                gint          dest_rowstride,
+                                gint          width,
+                                gint          height);
+
+/* Processes @n_rows rows starting at @first_row */
+typedef void (*GdkPixelRowsFunc) (gint     first_row,
+                                  gint     n_rows,
+                                  gpointer data);
+
+typedef struct _GdkPixelKernels GdkPixelKernels;
+
+/* One implementation of every kernel. The ones without a specialized
+ * version of a kernel use the plain C one. Sets marked @bit_exact
+ * produce the same bytes as the C kernels; mediaLib rounds its blend
+ * differently and is not.
+ */
+struct _GdkPixelKernels
+{
+  const gchar *name;
+  gboolean bit_exact;
+
+  /* RGB, 3 bytes per pixel */
+  GdkCompositeFunc composite_888;
+  /* 0xff0000/0x00ff00/0x0000ff in 32 bits per pixel */
+  GdkCompositeFunc composite_0888;
+  /* 0xf800/0x07e0/0x001f in host byte order */
+  GdkCompositeFunc composite_565;
+
+  /* 0xff0000/0x00ff00/0x0000ff in 32 bits per pixel */
+  GdkConvertFunc convert_0888_to_rgb;
+  GdkConvertFunc convert_0888_to_rgba;
+  /* 0xf800/0x07e0/0x001f in 16 bits per pixel */
+  GdkConvertFunc convert_565_to_rgb;
+  GdkConvertFunc convert_565_to_rgba;
+
+  /* RGB to 0x00ff0000/0x0000ff00/0x000000ff, LSB first, with the
+   * padding byte set to 0xff */
+  GdkConvertFunc convert_rgb_to_0888;
+  /* RGB to 0xf800/0x07e0/0x001f in host byte order */
+  GdkConvertFunc convert_rgb_to_565;
+};
+
+/* Images with fewer pixels than this aren't worth splitting between
+ * threads.
+ */
+#define GDK_PARALLEL_MIN_PIXELS (256 * 1024)
+
+const GdkPixelKernels *        _gdk_pixel_kernels_get     (void);
+const GdkPixelKernels * const *_gdk_pixel_kernels_get_all (void);
+
+void _gdk_pixel_rows_parallel (gint             n_rows,
+                               gint             row_width,
+                               GdkPixelRowsFunc func,
+                               gpointer         data);
+void _gdk_pixel_rows_split    (gint             n_rows,
+                               GdkPixelRowsFunc func,
+                               gpointer         data);
+
+G_END_DECLS
+
+#endif /* __GDK_PIXEL_KERNELS_H__ */
@@ -37,6 +37,7 @@
 #define ENABLE_GRAYSCALE
 
 #include "gdkinternals.h"	/* _gdk_windowing_get_bits_for_depth() */
+#include "gdkpixelkernels.h"
 
 #include "gdkrgb.h"
 #include "gdkscreen.h"
@@ -72,10 +73,6 @@ struct _GdkRgbInfo
   gint cmap_alloced;
   gdouble gamma;
 
-  /* Generally, the stage buffer is used to convert 32bit RGB, gray,
-     and indexed images into 24 bit packed RGB. */
-  guchar *stage_buf;
-
   GdkRgbCmap *gray_cmap;
 
   gboolean dith_default;
@@ -525,8 +522,6 @@ gdk_rgb_free_info (GdkRgbInfo *image_info)
 {
   GSList *tmp_list;
   
-  g_free (image_info->stage_buf);
-  
   if (image_info->gray_cmap)
     gdk_rgb_cmap_free (image_info->gray_cmap);
 
@@ -575,8 +570,6 @@ gdk_rgb_create_info (GdkVisual *visual, GdkColormap *colormap)
   image_info->cmap_alloced = FALSE;
   image_info->gamma = 1.0;
 
-  image_info->stage_buf = NULL;
-
   image_info->own_gc = NULL;
 
   image_info->cmap = colormap;
@@ -1468,144 +1461,29 @@ gdk_rgb_convert_gray8_gray (GdkRgbInfo *image_info, GdkImage *image,
 #define HAIRY_CONVERT_565
 #endif
 
-#ifdef HAIRY_CONVERT_565
-/* Render a 24-bit RGB image in buf into the GdkImage, without dithering.
-   This assumes native byte ordering - what should really be done is to
-   check whether the image byte_order is consistent with the _ENDIAN
-   config flag, and if not, use a different function.
-
-   This one is even faster than the one below - its inner loop loads 3
-   words (i.e. 4 24-bit pixels), does a lot of shifting and masking,
-   then writes 2 words. */
-static void
-gdk_rgb_convert_565 (GdkRgbInfo *image_info, GdkImage *image,
-		     gint x0, gint y0, gint width, gint height,
-		     const guchar *buf, int rowstride,
-		     gint x_align, gint y_align, GdkRgbCmap *cmap)
-{
-  int x, y;
-  guchar *obuf, *obptr;
-  gint bpl;
-  const guchar *bptr, *bp2;
-  guchar r, g, b;
-
-  bptr = buf;
-  bpl = image->bpl;
-  obuf = ((guchar *)image->mem) + y0 * bpl + x0 * 2;
-  for (y = 0; y < height; y++)
-    {
-      bp2 = bptr;
-      obptr = obuf;
-      if (((guintptr)obuf | (guintptr) bp2) & 3)
-	{
-	  for (x = 0; x < width; x++)
-	    {
-	      r = *bp2++;
-	      g = *bp2++;
-	      b = *bp2++;
-	      ((guint16 *)obptr)[0] = ((r & 0xf8) << 8) |
-		((g & 0xfc) << 3) |
-		(b >> 3);
-	      obptr += 2;
-	    }
-	}
-      else
-	{
-	  for (x = 0; x < width - 3; x += 4)
-	    {
-	      guint32 r1b0g0r0;
-	      guint32 g2r2b1g1;
-	      guint32 b3g3r3b2;
-
-	      r1b0g0r0 = ((guint32 *)bp2)[0];
-	      g2r2b1g1 = ((guint32 *)bp2)[1];
-	      b3g3r3b2 = ((guint32 *)bp2)[2];
-	      ((guint32 *)obptr)[0] =
-		((r1b0g0r0 & 0xf8) << 8) |
-		((r1b0g0r0 & 0xfc00) >> 5) |
-		((r1b0g0r0 & 0xf80000) >> 19) |
-		(r1b0g0r0 & 0xf8000000) |
-		((g2r2b1g1 & 0xfc) << 19) |
-		((g2r2b1g1 & 0xf800) << 5);
-	      ((guint32 *)obptr)[1] =
-		((g2r2b1g1 & 0xf80000) >> 8) |
-		((g2r2b1g1 & 0xfc000000) >> 21) |
-		((b3g3r3b2 & 0xf8) >> 3) |
-		((b3g3r3b2 & 0xf800) << 16) |
-		((b3g3r3b2 & 0xfc0000) << 3) |
-		((b3g3r3b2 & 0xf8000000) >> 11);
-	      bp2 += 12;
-	      obptr += 8;
-	    }
-	  for (; x < width; x++)
-	    {
-	      r = *bp2++;
-	      g = *bp2++;
-	      b = *bp2++;
-	      ((guint16 *)obptr)[0] = ((r & 0xf8) << 8) |
-		((g & 0xfc) << 3) |
-		(b >> 3);
-	      obptr += 2;
-	    }
-	}
-      bptr += rowstride;
-      obuf += bpl;
-    }
-}
-#else
 /* Render a 24-bit RGB image in buf into the GdkImage, without dithering.
    This assumes native byte ordering - what should really be done is to
    check whether the image byte_order is consistent with the _ENDIAN
    config flag, and if not, use a different function.
 
-   This routine is faster than the one included with Gtk 1.0 for a number
-   of reasons:
-
-   1. Shifting instead of lookup tables (less memory traffic).
-
-   2. Much less register pressure, especially because shifts are
-   in the code.
-
-   3. A memcpy is avoided (i.e. the transfer function).
-
-   4. On big-endian architectures, byte swapping is avoided.
-
-   That said, it wouldn't be hard to make it even faster - just make an
-   inner loop that reads 3 words (i.e. 4 24-bit pixels), does a lot of
-   shifting and masking, then writes 2 words.
-*/
+   The conversion itself is one of the pixel kernels, so that it can
+   use SIMD instructions where the CPU has them. */
 static void
 gdk_rgb_convert_565 (GdkRgbInfo *image_info, GdkImage *image,
 		     gint x0, gint y0, gint width, gint height,
 		     const guchar *buf, int rowstride,
 		     gint x_align, gint y_align, GdkRgbCmap *cmap)
 {
-  int x, y;
   guchar *obuf;
   gint bpl;
-  const guchar *bptr, *bp2;
-  guchar r, g, b;
 
-  bptr = buf;
   bpl = image->bpl;
   obuf = ((guchar *)image->mem) + y0 * bpl + x0 * 2;
-  for (y = 0; y < height; y++)
-    {
-      bp2 = bptr;
-      for (x = 0; x < width; x++)
-	{
-	  r = *bp2++;
-	  g = *bp2++;
-	  b = *bp2++;
-	  ((unsigned short *)obuf)[x] = ((r & 0xf8) << 8) |
-	    ((g & 0xfc) << 3) |
-	    (b >> 3);
-	}
-      bptr += rowstride;
-      obuf += bpl;
-    }
+
+  _gdk_pixel_kernels_get ()->convert_rgb_to_565 (buf, rowstride,
+						 obuf, bpl,
+						 width, height);
 }
-#endif
 
 #ifdef HAIRY_CONVERT_565
 static void
@@ -2121,38 +1999,21 @@ gdk_rgb_convert_888_lsb (GdkRgbInfo *image_info, GdkImage *image,
 #endif
 
 /* convert 24-bit packed to 32-bit unpacked */
-/* todo: optimize this */
 static void
 gdk_rgb_convert_0888 (GdkRgbInfo *image_info, GdkImage *image,
 		      gint x0, gint y0, gint width, gint height,
 		      const guchar *buf, int rowstride,
 		      gint x_align, gint y_align, GdkRgbCmap *cmap)
 {
-  int y, w;
-  guchar *obuf, *p;
+  guchar *obuf;
   gint bpl;
-  const guchar *bptr, *bp2;
 
-  bptr = buf;
   bpl = image->bpl;
   obuf = ((guchar *)image->mem) + y0 * bpl + x0 * 4;
-  for (y = 0; y < height; y++)
-    {
-      bp2 = bptr;
-      p = obuf;
-      w = width;
-      while (w--)
-	{
-	  p[0] = bp2[2];
-	  p[1] = bp2[1];
-	  p[2] = bp2[0];
-	  p[3] = 0xff;
-	  bp2 += 3;
-	  p += 4;
-	}
-      bptr += rowstride;
-      obuf += bpl;
-    }
+
+  _gdk_pixel_kernels_get ()->convert_rgb_to_0888 (buf, rowstride,
+						  obuf, bpl,
+						  width, height);
 }
 
 #ifdef USE_MEDIALIB25
@@ -2845,13 +2706,23 @@ gdk_rgb_convert_1 (GdkRgbInfo *image_info, GdkImage *image,
     }
 }
 
+/* Generally, the stage buffer is used to convert 32bit RGB, gray,
+   and indexed images into 24 bit packed RGB. Tiles can be converted
+   on several threads at once, so each thread gets its own. */
+static GStaticPrivate gdk_rgb_stage = G_STATIC_PRIVATE_INIT;
+
 /* Returns a pointer to the stage buffer. */
 static guchar *
 gdk_rgb_ensure_stage (GdkRgbInfo *image_info)
 {
-  if (image_info->stage_buf == NULL)
-    image_info->stage_buf = g_malloc (GDK_SCRATCH_IMAGE_HEIGHT * STAGE_ROWSTRIDE);
-  return image_info->stage_buf;
+  guchar *stage_buf = g_static_private_get (&gdk_rgb_stage);
+
+  if (stage_buf == NULL)
+    {
+      stage_buf = g_malloc (GDK_SCRATCH_IMAGE_HEIGHT * STAGE_ROWSTRIDE);
+      g_static_private_set (&gdk_rgb_stage, stage_buf, g_free);
+    }
+  return stage_buf;
 }
 
 /* This is slow. Speed me up, please. */
@@ -2894,7 +2765,7 @@ gdk_rgb_convert_32_generic (GdkRgbInfo *image_info, GdkImage *image,
   gdk_rgb_32_to_stage (image_info, buf, rowstride, width, height);
 
   (*image_info->conv) (image_info, image, x0, y0, width, height,
-		       image_info->stage_buf, STAGE_ROWSTRIDE,
+		       gdk_rgb_ensure_stage (image_info), STAGE_ROWSTRIDE,
 		       x_align, y_align, cmap);
 }
 
@@ -2909,7 +2780,7 @@ gdk_rgb_convert_32_generic_d (GdkRgbInfo *image_info, GdkImage *image,
   gdk_rgb_32_to_stage (image_info, buf, rowstride, width, height);
 
   (*image_info->conv_d) (image_info, image, x0, y0, width, height,
-			 image_info->stage_buf, STAGE_ROWSTRIDE,
+			 gdk_rgb_ensure_stage (image_info), STAGE_ROWSTRIDE,
 			 x_align, y_align, cmap);
 }
 
@@ -2954,7 +2825,7 @@ gdk_rgb_convert_gray_generic (GdkRgbInfo *image_info, GdkImage *image,
   gdk_rgb_gray_to_stage (image_info, buf, rowstride, width, height);
 
   (*image_info->conv) (image_info, image, x0, y0, width, height,
-		       image_info->stage_buf, STAGE_ROWSTRIDE,
+		       gdk_rgb_ensure_stage (image_info), STAGE_ROWSTRIDE,
 		       x_align, y_align, cmap);
 }
 
@@ -2967,7 +2838,7 @@ gdk_rgb_convert_gray_generic_d (GdkRgbInfo *image_info, GdkImage *image,
   gdk_rgb_gray_to_stage (image_info, buf, rowstride, width, height);
 
   (*image_info->conv_d) (image_info, image, x0, y0, width, height,
-			 image_info->stage_buf, STAGE_ROWSTRIDE,
+			 gdk_rgb_ensure_stage (image_info), STAGE_ROWSTRIDE,
 			 x_align, y_align, cmap);
 }
 
@@ -3038,7 +2909,7 @@ gdk_rgb_convert_indexed_generic (GdkRgbInfo *image_info, GdkImage *image,
   gdk_rgb_indexed_to_stage (image_info, buf, rowstride, width, height, cmap);
 
   (*image_info->conv) (image_info, image, x0, y0, width, height,
-		       image_info->stage_buf, STAGE_ROWSTRIDE,
+		       gdk_rgb_ensure_stage (image_info), STAGE_ROWSTRIDE,
 		       x_align, y_align, cmap);
 }
 
@@ -3052,7 +2923,7 @@ gdk_rgb_convert_indexed_generic_d (GdkRgbInfo *image_info, GdkImage *image,
   gdk_rgb_indexed_to_stage (image_info, buf, rowstride, width, height, cmap);
 
   (*image_info->conv_d) (image_info, image, x0, y0, width, height,
-			 image_info->stage_buf, STAGE_ROWSTRIDE,
+			 gdk_rgb_ensure_stage (image_info), STAGE_ROWSTRIDE,
 			 x_align, y_align, cmap);
 }
 
@@ -3288,6 +3159,124 @@ gdk_rgb_select_conv (GdkRgbInfo *image_info)
   image_info->conv_indexed_d = conv_indexed_d;
 }
 
+/* Number of tiles converted at once by gdk_draw_rgb_image_core_parallel().
+ * Each batch is reserved with _gdk_image_reserve_scratch(), so this
+ * must not be more than the number of scratch regions.
+ */
+#define PARALLEL_TILES 4
+
+typedef struct
+{
+  GdkImage *image;
+  gint xs0, ys0;
+  gint x0, y0;
+  gint width, height;
+} GdkRgbTile;
+
+typedef struct
+{
+  GdkRgbInfo *image_info;
+  GdkRgbConvFunc conv;
+  const guchar *buf;
+  gint pixstride;
+  gint rowstride;
+  gint x_align;
+  gint y_align;
+  GdkRgbTile tiles[PARALLEL_TILES];
+} GdkRgbTileJob;
+
+static void
+gdk_rgb_convert_tiles (gint     first_tile,
+		       gint     n_tiles,
+		       gpointer data)
+{
+  GdkRgbTileJob *job = data;
+  gint i;
+
+  for (i = first_tile; i < first_tile + n_tiles; i++)
+    {
+      GdkRgbTile *tile = &job->tiles[i];
+
+      job->conv (job->image_info, tile->image, tile->xs0, tile->ys0,
+		 tile->width, tile->height,
+		 job->buf + tile->y0 * job->rowstride + tile->x0 * job->pixstride,
+		 job->rowstride,
+		 job->x_align + tile->x0, job->y_align + tile->y0, NULL);
+    }
+}
+
+/* Converts up to PARALLEL_TILES tiles at a time on several threads,
+ * then draws them in order. Every tile gets the dither alignment it
+ * would have had when converted on its own, so the result is the
+ * same as gdk_draw_rgb_image_core() gives.
+ */
+static void
+gdk_draw_rgb_image_core_parallel (GdkRgbInfo     *image_info,
+				  GdkDrawable    *drawable,
+				  GdkGC          *gc,
+				  gint            x,
+				  gint            y,
+				  gint            width,
+				  gint            height,
+				  const guchar   *buf,
+				  gint            pixstride,
+				  gint            rowstride,
+				  GdkRgbConvFunc  conv,
+				  gint            xdith,
+				  gint            ydith)
+{
+  GdkScreen *screen = gdk_drawable_get_screen (drawable);
+  GdkRgbTileJob job;
+  gint y0, x0;
+  gint n_tiles, i;
+
+  job.image_info = image_info;
+  job.conv = conv;
+  job.buf = buf;
+  job.pixstride = pixstride;
+  job.rowstride = rowstride;
+  job.x_align = x + xdith;
+  job.y_align = y + ydith;
+
+  n_tiles = 0;
+  for (y0 = 0; y0 < height; y0 += GDK_SCRATCH_IMAGE_HEIGHT)
+    for (x0 = 0; x0 < width; x0 += GDK_SCRATCH_IMAGE_WIDTH)
+      {
+	GdkRgbTile *tile;
+
+	/* All the tiles of a batch are filled in before any is put */
+	if (n_tiles == 0)
+	  _gdk_image_reserve_scratch (screen, image_info->visual->depth,
+				      PARALLEL_TILES);
+
+	tile = &job.tiles[n_tiles++];
+	tile->x0 = x0;
+	tile->y0 = y0;
+	tile->width = MIN (width - x0, GDK_SCRATCH_IMAGE_WIDTH);
+	tile->height = MIN (height - y0, GDK_SCRATCH_IMAGE_HEIGHT);
+	tile->image = _gdk_image_get_scratch (screen,
+					      tile->width, tile->height,
+					      image_info->visual->depth,
+					      &tile->xs0, &tile->ys0);
+
+	if (n_tiles == PARALLEL_TILES ||
+	    (y0 + GDK_SCRATCH_IMAGE_HEIGHT >= height &&
+	     x0 + GDK_SCRATCH_IMAGE_WIDTH >= width))
+	  {
+	    _gdk_pixel_rows_split (n_tiles, gdk_rgb_convert_tiles, &job);
+
+#ifndef DONT_ACTUALLY_DRAW
+	    for (i = 0; i < n_tiles; i++)
+	      gdk_draw_image (drawable, gc, job.tiles[i].image,
+			      job.tiles[i].xs0, job.tiles[i].ys0,
+			      x + job.tiles[i].x0, y + job.tiles[i].y0,
+			      job.tiles[i].width, job.tiles[i].height);
+#endif
+	    n_tiles = 0;
+	  }
+      }
+}
+
 static void
 gdk_draw_rgb_image_core (GdkRgbInfo     *image_info,
 			 GdkDrawable    *drawable,
@@ -3316,6 +3305,20 @@ gdk_draw_rgb_image_core (GdkRgbInfo     *image_info,
 	image_info->own_gc = gdk_gc_new (drawable);
       gc = image_info->own_gc;
     }
+
+  /* Gray and indexed images may set up colormap lookup tables while
+   * they are converted, so only RGB images are split between threads.
+   */
+  if (pixstride != 1 && cmap == NULL &&
+      (gint64) width * height >= GDK_PARALLEL_MIN_PIXELS)
+    {
+      gdk_draw_rgb_image_core_parallel (image_info, drawable, gc,
+					x, y, width, height,
+					buf, pixstride, rowstride, conv,
+					xdith, ydith);
+      return;
+    }
+
   for (y0 = 0; y0 < height; y0 += GDK_SCRATCH_IMAGE_HEIGHT)
     {
       height1 = MIN (height - y0, GDK_SCRATCH_IMAGE_HEIGHT);
@@ -336,6 +336,7 @@ static void do_move_region_bits_on_impl (GdkWindowObject *private,
 					 GdkRegion *region, /* In impl window coords */
 					 int dx, int dy);
 static void gdk_window_invalidate_in_parent (GdkWindowObject *private);
+static void gdk_window_free_child_index (GdkWindowObject *private);
 static void move_native_children        (GdkWindowObject *private);
 static void update_cursor               (GdkDisplay *display);
 static void impl_window_add_update_area (GdkWindowObject *impl_window,
@@ -662,6 +663,8 @@ gdk_window_finalize (GObject *object)
   if (obj->cursor)
     gdk_cursor_unref (obj->cursor);
 
+  gdk_window_free_child_index (obj);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -749,6 +752,452 @@ gdk_window_has_no_impl (GdkWindowObject *window)
   return window->impl_window != window;
 }
 
+/* Spatial index of the children of a window.
+ *
+ * Once a window has CHILD_INDEX_MIN_CHILDREN children, a grid over its
+ * area records which children overlap each cell, so that exposes,
+ * clip recomputation and pointer picking only look at the children
+ * near the area they are interested in instead of walking the whole
+ * children list. The grid is updated as children are added, removed,
+ * moved and resized; restacking only marks the cached stacking
+ * positions stale. Children outside the window area are put in the
+ * border cells.
+ */
+
+#define CHILD_INDEX_MIN_CHILDREN 16
+#define CHILD_INDEX_MIN_CELL_SIZE 32
+#define CHILD_INDEX_MAX_CELLS 32 /* In each direction */
+
+typedef struct _GdkChildIndexEntry GdkChildIndexEntry;
+
+struct _GdkChildIndexEntry
+{
+  GdkWindowObject *child;
+  /* The cells covered by the child, inclusive */
+  gint cell_x0, cell_y0, cell_x1, cell_y1;
+  /* The extents the siblings were last clipped against, relative to
+   * the grid origin. Negative width if unknown. */
+  GdkRectangle clip_rect;
+  guint stack; /* Position in parent->children, 0 is topmost */
+  guint stamp;
+};
+
+struct _GdkChildIndex
+{
+  /* Position of the grid in window coordinates, moved by scrolling */
+  gint origin_x, origin_y;
+  gint cell_width, cell_height;
+  gint n_columns, n_rows;
+  /* Size of the window the grid was laid out for */
+  gint width, height;
+  GPtrArray **cells;
+  GHashTable *entries; /* GdkWindowObject -> GdkChildIndexEntry */
+  guint stamp;
+  guint stack_valid : 1;
+};
+
+static gint
+child_index_cell (gint coord,
+		  gint cell_size,
+		  gint n_cells)
+{
+  if (coord < 0)
+    return 0;
+
+  return MIN (coord / cell_size, n_cells - 1);
+}
+
+static void
+child_index_get_cells (GdkChildIndex      *index,
+		       const GdkRectangle *rect,
+		       gint               *x0,
+		       gint               *y0,
+		       gint               *x1,
+		       gint               *y1)
+{
+  gint x = rect->x - index->origin_x;
+  gint y = rect->y - index->origin_y;
+
+  *x0 = child_index_cell (x, index->cell_width, index->n_columns);
+  *y0 = child_index_cell (y, index->cell_height, index->n_rows);
+  *x1 = child_index_cell (x + rect->width - 1, index->cell_width, index->n_columns);
+  *y1 = child_index_cell (y + rect->height - 1, index->cell_height, index->n_rows);
+}
+
+static void
+child_get_extents (GdkWindowObject *child,
+		   GdkRectangle    *rect)
+{
+  rect->x = child->x;
+  rect->y = child->y;
+  rect->width = child->width;
+  rect->height = child->height;
+}
+
+static void
+child_index_link (GdkChildIndex      *index,
+		  GdkChildIndexEntry *entry)
+{
+  GdkRectangle r;
+  gint x, y;
+
+  child_get_extents (entry->child, &r);
+  child_index_get_cells (index, &r,
+			 &entry->cell_x0, &entry->cell_y0,
+			 &entry->cell_x1, &entry->cell_y1);
+
+  for (y = entry->cell_y0; y <= entry->cell_y1; y++)
+    for (x = entry->cell_x0; x <= entry->cell_x1; x++)
+      {
+	GPtrArray **cell = &index->cells[y * index->n_columns + x];
+
+	if (*cell == NULL)
+	  *cell = g_ptr_array_new ();
+	g_ptr_array_add (*cell, entry);
+      }
+}
+
+static void
+child_index_unlink (GdkChildIndex      *index,
+		    GdkChildIndexEntry *entry)
+{
+  gint x, y;
+
+  for (y = entry->cell_y0; y <= entry->cell_y1; y++)
+    for (x = entry->cell_x0; x <= entry->cell_x1; x++)
+      g_ptr_array_remove_fast (index->cells[y * index->n_columns + x], entry);
+}
+
+static void
+child_index_add (GdkChildIndex   *index,
+		 GdkWindowObject *child)
+{
+  GdkChildIndexEntry *entry;
+
+  entry = g_new0 (GdkChildIndexEntry, 1);
+  entry->child = child;
+  entry->clip_rect.width = -1;
+
+  g_hash_table_insert (index->entries, child, entry);
+  child_index_link (index, entry);
+
+  index->stack_valid = FALSE;
+}
+
+static GdkChildIndex *
+child_index_new (GdkWindowObject *private)
+{
+  GdkChildIndex *index;
+  GList *l;
+
+  index = g_new0 (GdkChildIndex, 1);
+  index->width = private->width;
+  index->height = private->height;
+  index->cell_width = MAX (CHILD_INDEX_MIN_CELL_SIZE,
+			   (private->width + CHILD_INDEX_MAX_CELLS - 1) / CHILD_INDEX_MAX_CELLS);
+  index->cell_height = MAX (CHILD_INDEX_MIN_CELL_SIZE,
+			    (private->height + CHILD_INDEX_MAX_CELLS - 1) / CHILD_INDEX_MAX_CELLS);
+  index->n_columns = (private->width + index->cell_width - 1) / index->cell_width;
+  index->n_rows = (private->height + index->cell_height - 1) / index->cell_height;
+  index->n_columns = MAX (index->n_columns, 1);
+  index->n_rows = MAX (index->n_rows, 1);
+  index->cells = g_new0 (GPtrArray *, index->n_columns * index->n_rows);
+  index->entries = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  for (l = private->children; l != NULL; l = l->next)
+    child_index_add (index, l->data);
+
+  return index;
+}
+
+static void
+gdk_window_free_child_index (GdkWindowObject *private)
+{
+  GdkChildIndex *index = private->child_index;
+  gint i;
+
+  if (index == NULL)
+    return;
+
+  for (i = 0; i < index->n_columns * index->n_rows; i++)
+    if (index->cells[i])
+      g_ptr_array_free (index->cells[i], TRUE);
+
+  g_free (index->cells);
+  g_hash_table_destroy (index->entries);
+  g_free (index);
+
+  private->child_index = NULL;
+}
+
+/* Returns the index of the children of @private, creating it if
+ * there are enough children to make it worthwhile.
+ */
+static GdkChildIndex *
+gdk_window_get_child_index (GdkWindowObject *private)
+{
+  /* The children of the root window don't track their positions
+   * exactly, and neither do those of foreign windows.
+   */
+  if (private->child_index == NULL &&
+      !private->destroyed &&
+      private->window_type != GDK_WINDOW_ROOT &&
+      private->window_type != GDK_WINDOW_FOREIGN &&
+      g_list_nth (private->children, CHILD_INDEX_MIN_CHILDREN - 1) != NULL)
+    private->child_index = child_index_new (private);
+
+  return private->child_index;
+}
+
+static void
+child_index_update_stack (GdkChildIndex   *index,
+			  GdkWindowObject *private)
+{
+  GdkChildIndexEntry *entry;
+  GList *l;
+  guint stack;
+
+  for (l = private->children, stack = 0; l != NULL; l = l->next, stack++)
+    {
+      entry = g_hash_table_lookup (index->entries, l->data);
+      if (entry)
+	entry->stack = stack;
+    }
+
+  index->stack_valid = TRUE;
+}
+
+static gint
+compare_entry_stack (gconstpointer a,
+		     gconstpointer b)
+{
+  const GdkChildIndexEntry *entry_a = *(GdkChildIndexEntry **)a;
+  const GdkChildIndexEntry *entry_b = *(GdkChildIndexEntry **)b;
+
+  return (entry_a->stack > entry_b->stack) - (entry_a->stack < entry_b->stack);
+}
+
+/* Returns the children of @private stacked above @until (all of them
+ * if @until is %NULL or not a child of @private), topmost first. If
+ * there is an index, only the children whose extents intersect @rect
+ * are returned. Free the list with g_list_free().
+ */
+static GList *
+gdk_window_get_children_in_rect (GdkWindowObject    *private,
+				 const GdkRectangle *rect,
+				 GdkWindowObject    *until)
+{
+  GdkChildIndex *index;
+  GdkChildIndexEntry *entry;
+  GPtrArray *found;
+  GList *l, *children;
+  guint until_stack;
+  gint x0, y0, x1, y1, x, y;
+  guint i;
+
+  index = gdk_window_get_child_index (private);
+
+  if (index == NULL)
+    {
+      children = NULL;
+      for (l = private->children; l != NULL && l->data != until; l = l->next)
+	children = g_list_prepend (children, l->data);
+
+      return g_list_reverse (children);
+    }
+
+  if (rect->width <= 0 || rect->height <= 0)
+    return NULL;
+
+  if (!index->stack_valid)
+    child_index_update_stack (index, private);
+
+  until_stack = G_MAXUINT;
+  if (until)
+    {
+      entry = g_hash_table_lookup (index->entries, until);
+      if (entry)
+	until_stack = entry->stack;
+    }
+
+  /* Children spanning several cells are only looked at once */
+  if (++index->stamp == 0)
+    {
+      GHashTableIter iter;
+
+      g_hash_table_iter_init (&iter, index->entries);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&entry))
+	entry->stamp = 0;
+      index->stamp = 1;
+    }
+
+  found = g_ptr_array_new ();
+
+  child_index_get_cells (index, rect, &x0, &y0, &x1, &y1);
+  for (y = y0; y <= y1; y++)
+    for (x = x0; x <= x1; x++)
+      {
+	GPtrArray *cell = index->cells[y * index->n_columns + x];
+
+	if (cell == NULL)
+	  continue;
+
+	for (i = 0; i < cell->len; i++)
+	  {
+	    GdkWindowObject *child;
+
+	    entry = g_ptr_array_index (cell, i);
+	    if (entry->stamp == index->stamp)
+	      continue;
+	    entry->stamp = index->stamp;
+
+	    child = entry->child;
+	    if (entry->stack >= until_stack ||
+		child->x >= rect->x + rect->width ||
+		child->y >= rect->y + rect->height ||
+		child->x + child->width <= rect->x ||
+		child->y + child->height <= rect->y)
+	      continue;
+
+	    g_ptr_array_add (found, entry);
+	  }
+      }
+
+  g_ptr_array_sort (found, compare_entry_stack);
+
+  children = NULL;
+  for (i = found->len; i > 0; i--)
+    {
+      entry = g_ptr_array_index (found, i - 1);
+      children = g_list_prepend (children, entry->child);
+    }
+
+  g_ptr_array_free (found, TRUE);
+
+  return children;
+}
+
+/* Returns the siblings of @private whose clip region may have changed
+ * since the last call, because @private moved, resized, was restacked,
+ * or changed its shape or mapped state. Free the list with g_list_free().
+ */
+static GList *
+gdk_window_get_affected_siblings (GdkWindowObject *private)
+{
+  GdkWindowObject *parent = private->parent;
+  GdkChildIndex *index = parent->child_index;
+  GdkChildIndexEntry *entry;
+  GdkRectangle r, extents;
+
+  entry = index ? g_hash_table_lookup (index->entries, private) : NULL;
+
+  child_get_extents (private, &extents);
+
+  if (entry == NULL || entry->clip_rect.width < 0)
+    {
+      if (entry)
+	{
+	  entry->clip_rect = extents;
+	  entry->clip_rect.x -= index->origin_x;
+	  entry->clip_rect.y -= index->origin_y;
+	}
+
+      return g_list_copy (parent->children);
+    }
+
+  r = entry->clip_rect;
+  r.x += index->origin_x;
+  r.y += index->origin_y;
+  gdk_rectangle_union (&r, &extents, &r);
+
+  entry->clip_rect = extents;
+  entry->clip_rect.x -= index->origin_x;
+  entry->clip_rect.y -= index->origin_y;
+
+  return gdk_window_get_children_in_rect (parent, &r, NULL);
+}
+
+/* Called after @private was added to the children of its parent */
+static void
+gdk_window_child_index_add (GdkWindowObject *private)
+{
+  GdkChildIndex *index = private->parent->child_index;
+
+  if (index)
+    child_index_add (index, private);
+}
+
+/* Called after @private was removed from the children of @parent */
+static void
+gdk_window_child_index_remove (GdkWindowObject *parent,
+			       GdkWindowObject *private)
+{
+  GdkChildIndex *index = parent->child_index;
+  GdkChildIndexEntry *entry;
+
+  if (index == NULL)
+    return;
+
+  entry = g_hash_table_lookup (index->entries, private);
+  if (entry)
+    {
+      child_index_unlink (index, entry);
+      g_hash_table_remove (index->entries, private);
+    }
+
+  index->stack_valid = FALSE;
+}
+
+/* Called after @private was moved or resized in its parent */
+static void
+gdk_window_child_index_move (GdkWindowObject *private)
+{
+  GdkChildIndex *index = private->parent->child_index;
+  GdkChildIndexEntry *entry;
+  GdkRectangle r;
+  gint x0, y0, x1, y1;
+
+  if (index == NULL)
+    return;
+
+  entry = g_hash_table_lookup (index->entries, private);
+  if (entry == NULL)
+    return;
+
+  child_get_extents (private, &r);
+  child_index_get_cells (index, &r, &x0, &y0, &x1, &y1);
+
+  if (x0 != entry->cell_x0 || y0 != entry->cell_y0 ||
+      x1 != entry->cell_x1 || y1 != entry->cell_y1)
+    {
+      child_index_unlink (index, entry);
+      child_index_link (index, entry);
+    }
+}
+
+/* Called after @private was restacked among its siblings */
+static void
+gdk_window_child_index_restack (GdkWindowObject *private)
+{
+  GdkChildIndex *index = private->parent->child_index;
+
+  if (index)
+    index->stack_valid = FALSE;
+}
+
+/**
+ * _gdk_window_children_changed:
+ * @window: a #GdkWindow
+ *
+ * Lets the windowing system backends tell the common code that they
+ * changed the children of @window behind its back.
+ **/
+void
+_gdk_window_children_changed (GdkWindow *window)
+{
+  gdk_window_free_child_index ((GdkWindowObject *)window);
+}
+
 static void
 remove_child_area (GdkWindowObject *private,
 		   GdkWindowObject *until,
@@ -758,16 +1207,16 @@ remove_child_area (GdkWindowObject *private,
   GdkWindowObject *child;
   GdkRegion *child_region;
   GdkRectangle r;
-  GList *l;
+  GList *l, *children;
   GdkRegion *shape;
 
-  for (l = private->children; l; l = l->next)
+  gdk_region_get_clipbox (region, &r);
+  children = gdk_window_get_children_in_rect (private, &r, until);
+
+  for (l = children; l; l = l->next)
     {
       child = l->data;
 
-      if (child == until)
-	break;
-
       /* If region is empty already, no need to do
 	 anything potentially costly */
       if (gdk_region_empty (region))
@@ -828,6 +1277,8 @@ remove_child_area (GdkWindowObject *private,
       gdk_region_destroy (child_region);
 
     }
+
+  g_list_free (children);
 }
 
 static GdkVisibilityState
@@ -950,7 +1401,7 @@ recompute_visible_regions_internal (GdkWindowObject *private,
 				    gboolean recalculate_children)
 {
   GdkRectangle r;
-  GList *l;
+  GList *l, *siblings;
   GdkWindowObject *child;
   GdkRegion *new_clip, *old_clip_region_with_children;
   gboolean clip_region_changed;
@@ -1101,13 +1552,15 @@ recompute_visible_regions_internal (GdkWindowObject *private,
       /* If we moved a child window in parent or changed the stacking order, then we
        * need to recompute the visible area of all the other children in the parent
        */
-      for (l = private->parent->children; l; l = l->next)
+      siblings = gdk_window_get_affected_siblings (private);
+      for (l = siblings; l; l = l->next)
 	{
 	  child = l->data;
 
 	  if (child != private)
 	    recompute_visible_regions_internal (child, TRUE, FALSE, FALSE);
 	}
+      g_list_free (siblings);
 
       /* We also need to recompute the _with_children clip for the parent */
       recompute_visible_regions_internal (private->parent, TRUE, FALSE, FALSE);
@@ -1159,7 +1612,17 @@ recompute_visible_regions (GdkWindowObject *private,
 void
 _gdk_window_update_size (GdkWindow *window)
 {
-  recompute_visible_regions ((GdkWindowObject *)window, TRUE, FALSE);
+  GdkWindowObject *private = (GdkWindowObject *)window;
+
+  /* Toplevels are resized by the backends; a grid over the old size
+   * is dropped and rebuilt on next use.
+   */
+  if (private->child_index &&
+      (private->child_index->width != private->width ||
+       private->child_index->height != private->height))
+    gdk_window_free_child_index (private);
+
+  recompute_visible_regions (private, TRUE, FALSE);
 }
 
 /* Find the native window that would be just above "child"
@@ -1465,7 +1928,10 @@ gdk_window_new (GdkWindow     *parent,
     }
 
   if (private->parent)
-    private->parent->children = g_list_prepend (private->parent->children, window);
+    {
+      private->parent->children = g_list_prepend (private->parent->children, window);
+      gdk_window_child_index_add (private);
+    }
 
   native = _gdk_native_windows; /* Default */
   if (attributes->type_hint == 100)
@@ -1702,13 +2168,17 @@ gdk_window_reparent (GdkWindow *window,
     }
 
   if (old_parent)
-    old_parent->children = g_list_remove (old_parent->children, window);
+    {
+      old_parent->children = g_list_remove (old_parent->children, window);
+      gdk_window_child_index_remove (old_parent, private);
+    }
 
   private->parent = new_parent_private;
   private->x = x;
   private->y = y;
 
   new_parent_private->children = g_list_prepend (new_parent_private->children, window);
+  gdk_window_child_index_add (private);
 
   /* Switch the window type as appropriate */
 
@@ -2112,6 +2582,7 @@ _gdk_window_destroy_hierarchy (GdkWindow *window,
 
 	      if (parent_private->children)
 		parent_private->children = g_list_remove (parent_private->children, window);
+	      gdk_window_child_index_remove (parent_private, private);
 
 	      if (!recursing &&
 		  GDK_WINDOW_IS_MAPPED (window))
@@ -2143,6 +2614,7 @@ _gdk_window_destroy_hierarchy (GdkWindow *window,
 	    {
 	      children = tmp = private->children;
 	      private->children = NULL;
+	      gdk_window_free_child_index (private);
 
 	      while (tmp)
 		{
@@ -2851,9 +3323,7 @@ gdk_window_begin_implicit_paint (GdkWindow *window, GdkRectangle *rect)
   paint->uses_implicit = FALSE;
   paint->flushed = FALSE;
   paint->surface = NULL;
-  paint->pixmap =
-    gdk_pixmap_new (window,
-		    MAX (rect->width, 1), MAX (rect->height, 1), -1);
+  paint->pixmap = _gdk_paint_buffer_acquire (window, rect->width, rect->height);
 
   private->implicit_paint = paint;
 
@@ -2939,7 +3409,7 @@ gdk_window_end_implicit_paint (GdkWindow *window)
   else
     gdk_region_destroy (paint->region);
 
-  g_object_unref (paint->pixmap);
+  _gdk_paint_buffer_release (paint->pixmap);
   g_free (paint);
 }
 
@@ -3071,8 +3541,7 @@ gdk_window_begin_paint_region (GdkWindow       *window,
       paint->x_offset = clip_box.x;
       paint->y_offset = clip_box.y;
       paint->pixmap =
-	gdk_pixmap_new (window,
-			MAX (clip_box.width, 1), MAX (clip_box.height, 1), -1);
+	_gdk_paint_buffer_acquire (window, clip_box.width, clip_box.height);
     }
 
   paint->surface = _gdk_drawable_ref_cairo_surface (paint->pixmap);
@@ -3238,7 +3707,10 @@ gdk_window_end_paint (GdkWindow *window)
   gdk_gc_set_clip_region (tmp_gc, NULL);
 
   cairo_surface_destroy (paint->surface);
-  g_object_unref (paint->pixmap);
+  if (paint->uses_implicit)
+    g_object_unref (paint->pixmap);
+  else
+    _gdk_paint_buffer_release (paint->pixmap);
   gdk_region_destroy (paint->region);
   g_free (paint);
 
@@ -5287,7 +5759,6 @@ gdk_window_set_cairo_clip (GdkDrawable *drawable,
 /* Code for dirty-region queueing
  */
 static GSList *update_windows = NULL;
-static guint update_idle = 0;
 static gboolean debug_updates = FALSE;
 
 static inline gboolean
@@ -5402,14 +5873,6 @@ gdk_window_remove_update_window (GdkWindow *window)
     }
 }
 
-static gboolean
-gdk_window_update_idle (gpointer data)
-{
-  gdk_window_process_all_updates ();
-
-  return FALSE;
-}
-
 static gboolean
 gdk_window_is_toplevel_frozen (GdkWindow *window)
 {
@@ -5428,11 +5891,7 @@ gdk_window_schedule_update (GdkWindow *window)
        gdk_window_is_toplevel_frozen (window)))
     return;
 
-  if (!update_idle)
-    update_idle =
-      gdk_threads_add_idle_full (GDK_PRIORITY_REDRAW,
-				 gdk_window_update_idle,
-				 NULL, NULL);
+  gdk_frame_clock_request_frame ();
 }
 
 void
@@ -5449,7 +5908,8 @@ _gdk_window_process_updates_recurse (GdkWindow *window,
     return;
 
   /* Make this reentrancy safe for expose handlers freeing windows */
-  children = g_list_copy (private->children);
+  gdk_region_get_clipbox (expose_region, &r);
+  children = gdk_window_get_children_in_rect (private, &r, NULL);
   g_list_foreach (children, (GFunc)g_object_ref, NULL);
 
   /* Iterate over children, starting at topmost */
@@ -5749,29 +6209,37 @@ flush_all_displays (void)
  **/
 void
 gdk_window_process_all_updates (void)
+{
+  _gdk_window_process_all_updates (NULL);
+}
+
+/* Paints all windows for a frame, noting the time spent painting and
+ * flushing in @timings if it is not %NULL.
+ */
+void
+_gdk_window_process_all_updates (GdkFrameTimings *timings)
 {
   GSList *old_update_windows = update_windows;
   GSList *tmp_list = update_windows;
   static gboolean in_process_all_updates = FALSE;
   static gboolean got_recursive_update = FALSE;
+  gint64 start = 0;
 
   if (in_process_all_updates)
     {
       /* We can't do this now since that would recurse, so
 	 delay it until after the recursion is done. */
       got_recursive_update = TRUE;
-      update_idle = 0;
       return;
     }
 
   in_process_all_updates = TRUE;
   got_recursive_update = FALSE;
 
-  if (update_idle)
-    g_source_remove (update_idle);
+  if (timings)
+    start = g_get_monotonic_time ();
 
   update_windows = NULL;
-  update_idle = 0;
 
   _gdk_windowing_before_process_all_updates ();
 
@@ -5794,21 +6262,27 @@ gdk_window_process_all_updates (void)
 
   g_slist_free (old_update_windows);
 
+  if (timings)
+    {
+      timings->paint_time = g_get_monotonic_time () - start;
+      start = g_get_monotonic_time ();
+    }
+
   flush_all_displays ();
 
   _gdk_windowing_after_process_all_updates ();
 
+  if (timings)
+    timings->flush_time = g_get_monotonic_time () - start;
+
   in_process_all_updates = FALSE;
 
   /* If we ignored a recursive call, schedule a
      redraw now so that it eventually happens,
      otherwise we could miss an update if nothing
      else schedules an update. */
-  if (got_recursive_update && !update_idle)
-    update_idle =
-      gdk_threads_add_idle_full (GDK_PRIORITY_REDRAW,
-				 gdk_window_update_idle,
-				 NULL, NULL);
+  if (got_recursive_update)
+    gdk_frame_clock_request_frame ();
 }
 
 /**
@@ -6712,6 +7186,7 @@ gdk_window_raise_internal (GdkWindow *window)
     {
       parent->children = g_list_remove (parent->children, window);
       parent->children = g_list_prepend (parent->children, window);
+      gdk_window_child_index_restack (private);
     }
 
   impl_iface = GDK_WINDOW_IMPL_GET_IFACE (private->impl);
@@ -7003,6 +7478,7 @@ gdk_window_lower_internal (GdkWindow *window)
     {
       parent->children = g_list_remove (parent->children, window);
       parent->children = g_list_append (parent->children, window);
+      gdk_window_child_index_restack (private);
     }
 
   impl_iface = GDK_WINDOW_IMPL_GET_IFACE (private->impl);
@@ -7189,6 +7665,7 @@ gdk_window_restack (GdkWindow     *window,
 	parent->children = g_list_insert_before (parent->children,
 						 sibling_link->next,
 						 window);
+      gdk_window_child_index_restack (private);
 
       impl_iface = GDK_WINDOW_IMPL_GET_IFACE (private->impl);
       if (gdk_window_has_impl (private))
@@ -7450,6 +7927,59 @@ gdk_window_get_events (GdkWindow *window)
   return private->event_mask;
 }
 
+/**
+ * gdk_window_set_event_compression:
+ * @window: a #GdkWindow
+ * @flags: the kinds of events to compress
+ *
+ * Lets GDK merge queued events for @window before they are delivered,
+ * so that a slow handler doesn't fall further and further behind.
+ *
+ * With %GDK_EVENT_COMPRESS_MOTION, consecutive motion events with the
+ * same device and modifier state are delivered as the last of them;
+ * add %GDK_EVENT_COMPRESS_MOTION_HISTORY to get the positions of the
+ * others with gdk_event_get_motion_history(). With
+ * %GDK_EVENT_COMPRESS_SCROLL, consecutive smooth scroll events in the
+ * same direction are delivered as one event whose deltas (see
+ * gdk_event_get_scroll_deltas()) add up all of them; discrete wheel
+ * clicks, which have no deltas, are not merged. With
+ * %GDK_EVENT_COMPRESS_CONFIGURE, a configure event is dropped if
+ * another one for @window is already queued.
+ *
+ * Compression only applies to the events of @window itself, not to
+ * those of its children. gdk_display_get_n_compressed_events() tells
+ * how many events were merged.
+ *
+ * Since: 2.24
+ **/
+void
+gdk_window_set_event_compression (GdkWindow             *window,
+				  GdkEventCompressFlags  flags)
+{
+  g_return_if_fail (GDK_IS_WINDOW (window));
+
+  ((GdkWindowObject *) window)->event_compression = flags;
+}
+
+/**
+ * gdk_window_get_event_compression:
+ * @window: a #GdkWindow
+ *
+ * Gets the kinds of events that are compressed for @window. See
+ * gdk_window_set_event_compression().
+ *
+ * Return value: the compression flags of @window
+ *
+ * Since: 2.24
+ **/
+GdkEventCompressFlags
+gdk_window_get_event_compression (GdkWindow *window)
+{
+  g_return_val_if_fail (GDK_IS_WINDOW (window), GDK_EVENT_COMPRESS_NONE);
+
+  return ((GdkWindowObject *) window)->event_compression;
+}
+
 static void
 gdk_window_move_resize_toplevel (GdkWindow *window,
 				 gboolean   with_move,
@@ -7683,12 +8213,19 @@ gdk_window_move_resize_internal (GdkWindow *window,
     {
       if (width < 1)
 	width = 1;
-      private->width = width;
       if (height < 1)
 	height = 1;
+
+      /* The grid over the window has the wrong size now */
+      if (private->width != width || private->height != height)
+	gdk_window_free_child_index (private);
+
+      private->width = width;
       private->height = height;
     }
 
+  gdk_window_child_index_move (private);
+
   dx = private->x - old_x;
   dy = private->y - old_y;
 
@@ -7936,6 +8473,13 @@ gdk_window_scroll (GdkWindow *window,
       tmp_list = tmp_list->next;
     }
 
+  /* All children moved together, so the index only needs to follow */
+  if (private->child_index)
+    {
+      private->child_index->origin_x += dx;
+      private->child_index->origin_y += dy;
+    }
+
   recompute_visible_regions (private, FALSE, TRUE);
 
   new_native_child_region = NULL;
@@ -9733,6 +10277,50 @@ pick_embedded_child (GdkWindowObject *window,
   return res;
 }
 
+/* Returns the topmost mapped child of @private containing @x,@y,
+ * and the point in its coordinates.
+ */
+static GdkWindowObject *
+find_child_at_point (GdkWindowObject *private,
+		     gdouble          x,
+		     gdouble          y,
+		     gdouble         *child_x,
+		     gdouble         *child_y)
+{
+  GdkWindowObject *sub, *found;
+  GdkRectangle r;
+  GList *l, *children;
+
+  r.x = floor (x);
+  r.y = floor (y);
+  r.width = 1;
+  r.height = 1;
+  children = gdk_window_get_children_in_rect (private, &r, NULL);
+
+  found = NULL;
+  /* Children is ordered in reverse stack order, i.e. first is topmost */
+  for (l = children; l != NULL; l = l->next)
+    {
+      sub = l->data;
+
+      if (!GDK_WINDOW_IS_MAPPED (sub))
+	continue;
+
+      gdk_window_coords_from_parent ((GdkWindow *)sub,
+				     x, y,
+				     child_x, child_y);
+      if (point_in_window (sub, *child_x, *child_y))
+	{
+	  found = sub;
+	  break;
+	}
+    }
+
+  g_list_free (children);
+
+  return found;
+}
+
 GdkWindow *
 _gdk_window_find_child_at (GdkWindow *window,
 			   int        x,
@@ -9740,26 +10328,14 @@ _gdk_window_find_child_at (GdkWindow *window,
 {
   GdkWindowObject *private, *sub;
   double child_x, child_y;
-  GList *l;
 
   private = (GdkWindowObject *)window;
 
   if (point_in_window (private, x, y))
     {
-      /* Children is ordered in reverse stack order, i.e. first is topmost */
-      for (l = private->children; l != NULL; l = l->next)
-	{
-	  sub = l->data;
-
-	  if (!GDK_WINDOW_IS_MAPPED (sub))
-	    continue;
-
-	  gdk_window_coords_from_parent ((GdkWindow *)sub,
-                                         x, y,
-                                         &child_x, &child_y);
-	  if (point_in_window (sub, child_x, child_y))
-	    return (GdkWindow *)sub;
-	}
+      sub = find_child_at_point (private, x, y, &child_x, &child_y);
+      if (sub)
+	return (GdkWindow *)sub;
 
       if (private->num_offscreen_children > 0)
 	{
@@ -9782,7 +10358,6 @@ _gdk_window_find_descendant_at (GdkWindow *toplevel,
 {
   GdkWindowObject *private, *sub;
   gdouble child_x, child_y;
-  GList *l;
   gboolean found;
 
   private = (GdkWindowObject *)toplevel;
@@ -9792,25 +10367,13 @@ _gdk_window_find_descendant_at (GdkWindow *toplevel,
       do
 	{
 	  found = FALSE;
-	  /* Children is ordered in reverse stack order, i.e. first is topmost */
-	  for (l = private->children; l != NULL; l = l->next)
+	  sub = find_child_at_point (private, x, y, &child_x, &child_y);
+	  if (sub)
 	    {
-	      sub = l->data;
-
-	      if (!GDK_WINDOW_IS_MAPPED (sub))
-		continue;
-
-	      gdk_window_coords_from_parent ((GdkWindow *)sub,
-                                             x, y,
-                                             &child_x, &child_y);
-	      if (point_in_window (sub, child_x, child_y))
-		{
-		  x = child_x;
-		  y = child_y;
-		  private = sub;
-		  found = TRUE;
-		  break;
-		}
+	      x = child_x;
+	      y = child_y;
+	      private = sub;
+	      found = TRUE;
 	    }
 	  if (!found &&
 	      private->num_offscreen_children > 0)
@@ -605,6 +605,9 @@ GList *       gdk_window_peek_children   (GdkWindow       *window);
 GdkEventMask  gdk_window_get_events	 (GdkWindow	  *window);
 void	      gdk_window_set_events	 (GdkWindow	  *window,
 					  GdkEventMask	   event_mask);
+GdkEventCompressFlags gdk_window_get_event_compression (GdkWindow             *window);
+void                  gdk_window_set_event_compression (GdkWindow             *window,
+                                                        GdkEventCompressFlags  flags);
 
 void          gdk_window_set_icon_list   (GdkWindow       *window,
 					  GList           *pixbufs);
@@ -0,0 +1,262 @@
+/* GDK - The GIMP Drawing Kit
+ * eventcompression.c: Check that queued events are merged as asked
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gdk/gdk.h>
+
+static GdkWindow *
+create_window (void)
+{
+  GdkWindowAttr attributes = { 0, };
+  GdkWindow *window;
+
+  attributes.window_type = GDK_WINDOW_TOPLEVEL;
+  attributes.wclass = GDK_INPUT_OUTPUT;
+  attributes.width = 200;
+  attributes.height = 200;
+  attributes.event_mask = GDK_ALL_EVENTS_MASK & ~GDK_POINTER_MOTION_HINT_MASK;
+
+  window = gdk_window_new (NULL, &attributes, 0);
+  gdk_window_show (window);
+
+  return window;
+}
+
+static void
+drain_events (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkEvent *event;
+
+  gdk_display_sync (display);
+  while ((event = gdk_display_get_event (display)) != NULL)
+    gdk_event_free (event);
+}
+
+/* Returns the queued events of type @type, oldest first */
+static GList *
+get_events (GdkEventType type)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkEvent *event;
+  GList *events = NULL;
+
+  gdk_display_sync (display);
+  while ((event = gdk_display_get_event (display)) != NULL)
+    {
+      if (event->type == type)
+        events = g_list_prepend (events, event);
+      else
+        gdk_event_free (event);
+    }
+
+  return g_list_reverse (events);
+}
+
+static void
+free_events (GList *events)
+{
+  g_list_foreach (events, (GFunc) gdk_event_free, NULL);
+  g_list_free (events);
+}
+
+static void
+put_motions (GdkWindow *window,
+             gint       n_motions)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkEvent *event;
+  gint i;
+
+  for (i = 0; i < n_motions; i++)
+    {
+      event = gdk_event_new (GDK_MOTION_NOTIFY);
+      event->motion.window = g_object_ref (window);
+      event->motion.time = 100 + i;
+      event->motion.x = 10 + i;
+      event->motion.y = 20 + i;
+      event->motion.device = gdk_display_get_core_pointer (display);
+      gdk_display_put_event (display, event);
+      gdk_event_free (event);
+    }
+}
+
+static void
+test_motion (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkWindow *window = create_window ();
+  GdkTimeCoord **history;
+  GList *events;
+  GdkEvent *event;
+  guint n_compressed;
+  gint n_history, i;
+
+  drain_events ();
+
+  /* Nothing is merged unless asked for */
+  put_motions (window, 5);
+  events = get_events (GDK_MOTION_NOTIFY);
+  g_assert_cmpuint (g_list_length (events), ==, 5);
+  free_events (events);
+
+  gdk_window_set_event_compression (window, GDK_EVENT_COMPRESS_MOTION |
+                                            GDK_EVENT_COMPRESS_MOTION_HISTORY);
+  g_assert_cmpuint (gdk_window_get_event_compression (window), ==,
+                    GDK_EVENT_COMPRESS_MOTION | GDK_EVENT_COMPRESS_MOTION_HISTORY);
+
+  n_compressed = gdk_display_get_n_compressed_events (display, GDK_MOTION_NOTIFY);
+  put_motions (window, 5);
+  events = get_events (GDK_MOTION_NOTIFY);
+  g_assert_cmpuint (g_list_length (events), ==, 1);
+  g_assert_cmpuint (gdk_display_get_n_compressed_events (display, GDK_MOTION_NOTIFY),
+                    ==, n_compressed + 4);
+
+  event = events->data;
+  g_assert_cmpfloat (event->motion.x, ==, 14);
+  g_assert_cmpfloat (event->motion.y, ==, 24);
+
+  g_assert (gdk_event_get_motion_history (event, &history, &n_history));
+  g_assert_cmpint (n_history, ==, 4);
+  for (i = 0; i < n_history; i++)
+    {
+      g_assert_cmpuint (history[i]->time, ==, 100 + i);
+      g_assert_cmpfloat (history[i]->axes[0], ==, 10 + i);
+      g_assert_cmpfloat (history[i]->axes[1], ==, 20 + i);
+    }
+  gdk_device_free_history (history, n_history);
+
+  free_events (events);
+  gdk_window_destroy (window);
+}
+
+static void
+test_scroll (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkWindow *window = create_window ();
+  GList *events;
+  GdkEvent *event;
+  gdouble dx, dy;
+  guint n_compressed;
+  gint x, y, i;
+
+  gdk_window_set_event_compression (window, GDK_EVENT_COMPRESS_SCROLL);
+
+  /* Put the pointer in place first, so that simulating the wheel
+   * clicks doesn't generate motion events in between them.
+   */
+  gdk_display_sync (display);
+  gdk_window_get_origin (window, &x, &y);
+  gdk_display_warp_pointer (display, gdk_drawable_get_screen (window),
+                            x + 50, y + 50);
+  drain_events ();
+
+  /* Wheel clicks are steps, not pixels, and are left alone */
+  n_compressed = gdk_display_get_n_compressed_events (display, GDK_SCROLL);
+  for (i = 0; i < 3; i++)
+    g_assert (gdk_test_simulate_button (window, 50, 50, 5, 0, GDK_BUTTON_PRESS));
+
+  events = get_events (GDK_SCROLL);
+  g_assert_cmpuint (g_list_length (events), ==, 3);
+  g_assert_cmpuint (gdk_display_get_n_compressed_events (display, GDK_SCROLL),
+                    ==, n_compressed);
+
+  event = events->data;
+  g_assert_cmpint (event->scroll.direction, ==, GDK_SCROLL_DOWN);
+  g_assert (!gdk_event_get_scroll_deltas (event, &dx, &dy));
+
+  free_events (events);
+
+  /* Smooth scroll events add up their deltas */
+  for (i = 0; i < 3; i++)
+    {
+      event = gdk_event_new (GDK_SCROLL);
+      event->scroll.window = g_object_ref (window);
+      event->scroll.direction = GDK_SCROLL_DOWN;
+      event->scroll.device = gdk_display_get_core_pointer (display);
+      event->scroll.has_deltas = TRUE;
+      event->scroll.delta_x = 0.5;
+      event->scroll.delta_y = 2.5;
+      gdk_display_put_event (display, event);
+      gdk_event_free (event);
+    }
+
+  events = get_events (GDK_SCROLL);
+  g_assert_cmpuint (g_list_length (events), ==, 1);
+  g_assert_cmpuint (gdk_display_get_n_compressed_events (display, GDK_SCROLL),
+                    ==, n_compressed + 2);
+
+  event = events->data;
+  g_assert (gdk_event_get_scroll_deltas (event, &dx, &dy));
+  g_assert_cmpfloat (dx, ==, 1.5);
+  g_assert_cmpfloat (dy, ==, 7.5);
+
+  free_events (events);
+  gdk_window_destroy (window);
+}
+
+static void
+test_configure (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkWindow *window = create_window ();
+  GList *events;
+  GdkEvent *event;
+  guint n_compressed;
+  gint i;
+
+  gdk_window_set_event_compression (window, GDK_EVENT_COMPRESS_CONFIGURE);
+  drain_events ();
+
+  n_compressed = gdk_display_get_n_compressed_events (display, GDK_CONFIGURE);
+  for (i = 0; i < 3; i++)
+    {
+      event = gdk_event_new (GDK_CONFIGURE);
+      event->configure.window = g_object_ref (window);
+      event->configure.width = 100 + i;
+      event->configure.height = 50 + i;
+      gdk_display_put_event (display, event);
+      gdk_event_free (event);
+    }
+
+  events = get_events (GDK_CONFIGURE);
+  g_assert_cmpuint (g_list_length (events), ==, 1);
+  g_assert_cmpuint (gdk_display_get_n_compressed_events (display, GDK_CONFIGURE),
+                    ==, n_compressed + 2);
+
+  event = events->data;
+  g_assert_cmpint (event->configure.width, ==, 102);
+  g_assert_cmpint (event->configure.height, ==, 52);
+
+  free_events (events);
+  gdk_window_destroy (window);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  gdk_init (&argc, &argv);
+
+  g_test_add_func ("/event-compression/motion", test_motion);
+  g_test_add_func ("/event-compression/scroll", test_scroll);
+  g_test_add_func ("/event-compression/configure", test_configure);
+
+  return g_test_run ();
+}
@@ -0,0 +1,161 @@
+/* GDK - The GIMP Drawing Kit
+ * frameclock.c: Check the phases and pacing of frames
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gdk/gdk.h>
+
+static void
+run_frames (guint n_frames)
+{
+  guint64 last = gdk_frame_clock_get_frame_counter () + n_frames;
+
+  while (gdk_frame_clock_get_frame_counter () < last)
+    {
+      gdk_frame_clock_request_frame ();
+      g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+static gboolean
+layout_cb (gint64   frame_time,
+           gpointer data)
+{
+  g_string_append (data, "layout ");
+
+  return FALSE;
+}
+
+static gboolean
+update_cb (gint64   frame_time,
+           gpointer data)
+{
+  g_assert_cmpint (frame_time, ==, gdk_frame_clock_get_frame_time ());
+
+  g_string_append (data, "update ");
+
+  /* Runs in this frame still, since layout comes after update */
+  gdk_frame_clock_add_callback (GDK_FRAME_PHASE_LAYOUT, layout_cb, data, NULL);
+
+  return FALSE;
+}
+
+static void
+test_phases (void)
+{
+  GString *log = g_string_new (NULL);
+  GdkFrameTimings timings;
+  guint64 frame;
+
+  gdk_frame_clock_add_callback (GDK_FRAME_PHASE_UPDATE, update_cb, log, NULL);
+  run_frames (1);
+
+  g_assert_cmpstr (log->str, ==, "update layout ");
+
+  frame = gdk_frame_clock_get_frame_counter ();
+  g_assert (gdk_frame_clock_get_timings (frame, &timings));
+  g_assert_cmpuint (timings.frame_counter, ==, frame);
+  g_assert_cmpint (timings.update_time, >=, 0);
+  g_assert_cmpint (timings.layout_time, >=, 0);
+  g_assert_cmpint (timings.paint_time, >=, 0);
+  g_assert_cmpint (timings.flush_time, >=, 0);
+  g_assert (!gdk_frame_clock_get_timings (frame + 1, &timings));
+
+  g_string_free (log, TRUE);
+}
+
+static gboolean
+count_cb (gint64   frame_time,
+          gpointer data)
+{
+  gint *count = data;
+
+  return --(*count) > 0;
+}
+
+static void
+test_pacing (void)
+{
+  GdkFrameTimings first, last;
+  gint count = 5;
+  guint64 frame;
+
+  gdk_frame_clock_set_rate (20);
+  g_assert_cmpfloat (gdk_frame_clock_get_rate (), ==, 20);
+
+  gdk_frame_clock_add_callback (GDK_FRAME_PHASE_UPDATE, count_cb, &count, NULL);
+  frame = gdk_frame_clock_get_frame_counter () + 1;
+  while (count > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert (gdk_frame_clock_get_timings (frame, &first));
+  g_assert (gdk_frame_clock_get_timings (frame + 4, &last));
+
+  /* Four intervals of 50 ms between the five frames */
+  g_assert_cmpint (last.frame_time - first.frame_time, >=, 4 * 50000);
+
+  gdk_frame_clock_set_rate (60);
+}
+
+static void
+test_unpaced (void)
+{
+  guint64 frame;
+
+  gdk_frame_clock_set_rate (1);
+  run_frames (1);
+  frame = gdk_frame_clock_get_frame_counter ();
+
+  /* Nothing is animating, so the frame isn't held back by the rate
+   * and shows up as pending right away.
+   */
+  gdk_frame_clock_request_frame ();
+  g_assert (g_main_context_pending (NULL));
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+  g_assert_cmpuint (gdk_frame_clock_get_frame_counter (), ==, frame + 1);
+
+  gdk_frame_clock_set_rate (60);
+}
+
+static void
+test_remove (void)
+{
+  gint count = 1000;
+  guint id;
+
+  id = gdk_frame_clock_add_callback (GDK_FRAME_PHASE_UPDATE, count_cb, &count, NULL);
+  run_frames (2);
+  gdk_frame_clock_remove_callback (id);
+  run_frames (2);
+
+  g_assert_cmpint (count, ==, 998);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  gdk_init (&argc, &argv);
+
+  g_test_add_func ("/frame-clock/phases", test_phases);
+  g_test_add_func ("/frame-clock/pacing", test_pacing);
+  g_test_add_func ("/frame-clock/unpaced", test_unpaced);
+  g_test_add_func ("/frame-clock/remove", test_remove);
+
+  return g_test_run ();
+}
@@ -0,0 +1,115 @@
+/* GDK - The GIMP Drawing Kit
+ * keymap.c: Check the lookups between keyvals and keys
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gdk/gdk.h>
+#include <gdk/gdkkeysyms.h>
+
+static const guint keyvals[] = {
+  GDK_a, GDK_A, GDK_z, GDK_1, GDK_exclam, GDK_space,
+  GDK_Return, GDK_Tab, GDK_ISO_Left_Tab, GDK_Escape,
+  GDK_F1, GDK_Shift_L, GDK_Control_L, GDK_KP_Enter
+};
+
+/* Every key found for a keyval must map back to it */
+static void
+test_entries_for_keyval (void)
+{
+  GdkKeymap *keymap = gdk_keymap_get_for_display (gdk_display_get_default ());
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (keyvals); i++)
+    {
+      GdkKeymapKey *keys;
+      gint n_keys, j;
+
+      if (!gdk_keymap_get_entries_for_keyval (keymap, keyvals[i], &keys, &n_keys))
+        {
+          g_assert (keys == NULL);
+          g_assert_cmpint (n_keys, ==, 0);
+          continue;
+        }
+
+      for (j = 0; j < n_keys; j++)
+        {
+          g_assert_cmpuint (gdk_keymap_lookup_key (keymap, &keys[j]), ==, keyvals[i]);
+
+          /* In the order of the keymap */
+          if (j > 0)
+            g_assert_cmpuint (keys[j - 1].keycode, <=, keys[j].keycode);
+        }
+
+      g_free (keys);
+    }
+}
+
+/* The index agrees with what each key generates */
+static void
+test_entries_for_keycode (void)
+{
+  GdkKeymap *keymap = gdk_keymap_get_for_display (gdk_display_get_default ());
+  guint keycode;
+
+  for (keycode = 8; keycode < 256; keycode++)
+    {
+      GdkKeymapKey *keys;
+      guint *keycode_keyvals;
+      gint n_entries, i;
+
+      if (!gdk_keymap_get_entries_for_keycode (keymap, keycode,
+                                               &keys, &keycode_keyvals, &n_entries))
+        continue;
+
+      for (i = 0; i < n_entries; i++)
+        {
+          GdkKeymapKey *found;
+          gint n_found, j;
+          gboolean seen = FALSE;
+
+          if (keycode_keyvals[i] == 0)
+            continue;
+
+          g_assert (gdk_keymap_get_entries_for_keyval (keymap, keycode_keyvals[i],
+                                                       &found, &n_found));
+
+          for (j = 0; j < n_found; j++)
+            if (found[j].keycode == keys[i].keycode &&
+                found[j].group == keys[i].group &&
+                found[j].level == keys[i].level)
+              seen = TRUE;
+
+          g_assert (seen);
+          g_free (found);
+        }
+
+      g_free (keys);
+      g_free (keycode_keyvals);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  gdk_init (&argc, &argv);
+
+  g_test_add_func ("/keymap/entries-for-keyval", test_entries_for_keyval);
+  g_test_add_func ("/keymap/entries-for-keycode", test_entries_for_keycode);
+
+  return g_test_run ();
+}
@@ -0,0 +1,290 @@
+/* GDK - The GIMP Drawing Kit
+ * pixelkernels.c: Check the SIMD pixel kernels against the C ones
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+#include <gdk/gdk.h>
+#include "gdk/gdkpixelkernels.h"
+
+typedef enum
+{
+  KERNEL_888,
+  KERNEL_0888,
+  KERNEL_565
+} KernelType;
+
+static const gchar *kernel_names[] = { "888", "0888", "565" };
+static const gint kernel_bpp[] = { 3, 4, 2 };
+
+static GdkCompositeFunc
+get_kernel (const GdkPixelKernels *kernels,
+            KernelType             type)
+{
+  switch (type)
+    {
+    case KERNEL_888:
+      return kernels->composite_888;
+    case KERNEL_0888:
+      return kernels->composite_0888;
+    case KERNEL_565:
+      return kernels->composite_565;
+    }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+typedef enum
+{
+  CONVERT_0888_TO_RGB,
+  CONVERT_0888_TO_RGBA,
+  CONVERT_565_TO_RGB,
+  CONVERT_565_TO_RGBA,
+  CONVERT_RGB_TO_0888,
+  CONVERT_RGB_TO_565
+} ConvertType;
+
+static const gchar *convert_names[] = {
+  "0888_to_rgb", "0888_to_rgba", "565_to_rgb", "565_to_rgba", "rgb_to_0888", "rgb_to_565"
+};
+static const gint convert_src_bpp[] = { 4, 4, 2, 2, 3, 3 };
+static const gint convert_dest_bpp[] = { 3, 4, 3, 4, 4, 2 };
+
+static GdkConvertFunc
+get_converter (const GdkPixelKernels *kernels,
+               ConvertType            type)
+{
+  switch (type)
+    {
+    case CONVERT_0888_TO_RGB:
+      return kernels->convert_0888_to_rgb;
+    case CONVERT_0888_TO_RGBA:
+      return kernels->convert_0888_to_rgba;
+    case CONVERT_565_TO_RGB:
+      return kernels->convert_565_to_rgb;
+    case CONVERT_565_TO_RGBA:
+      return kernels->convert_565_to_rgba;
+    case CONVERT_RGB_TO_0888:
+      return kernels->convert_rgb_to_0888;
+    case CONVERT_RGB_TO_565:
+      return kernels->convert_rgb_to_565;
+    }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+static guchar *
+random_buffer (GRand *rand,
+               gsize  size)
+{
+  guchar *buf = g_malloc (size);
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    buf[i] = g_rand_int_range (rand, 0, 256);
+
+  return buf;
+}
+
+/* Odd widths, offsets and rowstrides exercise the unaligned loads
+ * and the scalar tails; alpha is forced to 0 and 255 regularly since
+ * those are the values with special results. Sets that aren't
+ * bit_exact, i.e. mediaLib, have no exact result to compare with
+ * and are skipped.
+ */
+static void
+test_kernels_exact (void)
+{
+  const GdkPixelKernels * const *kernels = _gdk_pixel_kernels_get_all ();
+  static const gint widths[] = { 1, 3, 7, 8, 15, 16, 17, 33, 64, 127 };
+  GRand *rand = g_rand_new_with_seed (42);
+  KernelType type;
+  guint i;
+  gint k, order, width;
+
+  for (k = 1; kernels[k]; k++)
+    if (kernels[k]->bit_exact)
+      for (type = KERNEL_888; type <= KERNEL_565; type++)
+        for (order = GDK_LSB_FIRST; order <= GDK_MSB_FIRST; order++)
+          for (i = 0; i < G_N_ELEMENTS (widths); i++)
+            {
+              gint height = 5;
+              gint src_rowstride, dest_rowstride;
+              guchar *src, *expected, *actual;
+              gint n;
+
+              width = widths[i];
+              src_rowstride = width * 4 + 3;
+              dest_rowstride = width * kernel_bpp[type] + 6;
+
+              src = random_buffer (rand, src_rowstride * height + 1);
+              for (n = 0; n < width * height; n += 3)
+                src[1 + (n / width) * src_rowstride + (n % width) * 4 + 3] = (n % 2) ? 0 : 255;
+
+              expected = random_buffer (rand, dest_rowstride * height + 2);
+              actual = g_memdup (expected, dest_rowstride * height + 2);
+
+              get_kernel (kernels[0], type) (src + 1, src_rowstride,
+                                             expected + 2, dest_rowstride,
+                                             order, width, height);
+              get_kernel (kernels[k], type) (src + 1, src_rowstride,
+                                             actual + 2, dest_rowstride,
+                                             order, width, height);
+
+              if (memcmp (expected, actual, dest_rowstride * height + 2) != 0)
+                g_error ("%s composite_%s differs from C for width %d, byte order %d",
+                         kernels[k]->name, kernel_names[type], width, order);
+
+              g_free (src);
+              g_free (expected);
+              g_free (actual);
+            }
+
+  g_rand_free (rand);
+}
+
+/* Every width up to a few vectors, so that the overlapping stores
+ * and the scalar tails all get exercised; anything written outside
+ * the rows shows up as a difference in the padding.
+ */
+static void
+test_converters_exact (void)
+{
+  const GdkPixelKernels * const *kernels = _gdk_pixel_kernels_get_all ();
+  GRand *rand = g_rand_new_with_seed (42);
+  ConvertType type;
+  gint k, width;
+
+  for (k = 1; kernels[k]; k++)
+    if (kernels[k]->bit_exact)
+      for (type = CONVERT_0888_TO_RGB; type <= CONVERT_RGB_TO_565; type++)
+        for (width = 1; width <= 80; width++)
+          {
+            gint height = 3;
+            gint src_rowstride, dest_rowstride;
+            guchar *src, *expected, *actual;
+
+            src_rowstride = width * convert_src_bpp[type] + 3;
+            dest_rowstride = width * convert_dest_bpp[type] + 5;
+
+            src = random_buffer (rand, src_rowstride * height + 1);
+            expected = random_buffer (rand, dest_rowstride * height + 2);
+            actual = g_memdup (expected, dest_rowstride * height + 2);
+
+            get_converter (kernels[0], type) (src + 1, src_rowstride,
+                                              expected + 2, dest_rowstride,
+                                              width, height);
+            get_converter (kernels[k], type) (src + 1, src_rowstride,
+                                              actual + 2, dest_rowstride,
+                                              width, height);
+
+            if (memcmp (expected, actual, dest_rowstride * height + 2) != 0)
+              g_error ("%s convert_%s differs from C for width %d",
+                       kernels[k]->name, convert_names[type], width);
+
+            g_free (src);
+            g_free (expected);
+            g_free (actual);
+          }
+
+  g_rand_free (rand);
+}
+
+static void
+count_rows (gint     first_row,
+            gint     n_rows,
+            gpointer data)
+{
+  gint *counts = data;
+  gint i;
+
+  for (i = first_row; i < first_row + n_rows; i++)
+    g_atomic_int_inc (&counts[i]);
+}
+
+static void
+test_rows_parallel (void)
+{
+  static const gint heights[] = { 1, 2, 7, 100, 1023, 4096 };
+  guint i;
+  gint n;
+
+  for (i = 0; i < G_N_ELEMENTS (heights); i++)
+    {
+      gint *counts = g_new0 (gint, heights[i]);
+
+      _gdk_pixel_rows_parallel (heights[i], 1024, count_rows, counts);
+
+      for (n = 0; n < heights[i]; n++)
+        g_assert_cmpint (counts[n], ==, 1);
+
+      g_free (counts);
+    }
+}
+
+static void
+test_kernels_throughput (void)
+{
+  const GdkPixelKernels * const *kernels = _gdk_pixel_kernels_get_all ();
+  const gint width = 1024, height = 768, runs = 20;
+  GRand *rand = g_rand_new_with_seed (42);
+  guchar *src, *dest;
+  KernelType type;
+  gint k, n;
+
+  src = random_buffer (rand, width * 4 * height);
+  dest = random_buffer (rand, width * 4 * height);
+
+  for (type = KERNEL_888; type <= KERNEL_565; type++)
+    for (k = 0; kernels[k]; k++)
+      {
+        GdkCompositeFunc func = get_kernel (kernels[k], type);
+        gdouble elapsed;
+
+        g_test_timer_start ();
+        for (n = 0; n < runs; n++)
+          func (src, width * 4, dest, width * kernel_bpp[type],
+                GDK_LSB_FIRST, width, height);
+        elapsed = g_test_timer_elapsed ();
+
+        g_test_maximized_result (width * height * runs / elapsed / 1e6,
+                                 "%s composite_%s: %.1f Mpixels/s",
+                                 kernels[k]->name, kernel_names[type],
+                                 width * height * runs / elapsed / 1e6);
+      }
+
+  g_free (src);
+  g_free (dest);
+  g_rand_free (rand);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/pixel-kernels/exact", test_kernels_exact);
+  g_test_add_func ("/pixel-kernels/convert-exact", test_converters_exact);
+  g_test_add_func ("/pixel-kernels/rows-parallel", test_rows_parallel);
+  if (g_test_perf ())
+    g_test_add_func ("/pixel-kernels/throughput", test_kernels_throughput);
+
+  return g_test_run ();
+}
@@ -0,0 +1,88 @@
+/* GDK - The GIMP Drawing Kit
+ * roundtrips.c: Check the counts of X server round trips
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gdk/gdk.h>
+#include <gdk/gdkx.h>
+
+static void
+test_tracing (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+
+  gdk_x11_display_set_roundtrip_tracing (display, TRUE);
+  g_assert (gdk_x11_display_get_roundtrip_tracing (display));
+
+  gdk_x11_display_reset_roundtrips (display);
+  g_assert_cmpuint (gdk_x11_display_get_n_roundtrips (display, NULL), ==, 0);
+
+  gdk_display_sync (display);
+  g_assert_cmpuint (gdk_x11_display_get_n_roundtrips (display, "gdk_display_sync:XSync"), ==, 1);
+  g_assert_cmpuint (gdk_x11_display_get_n_roundtrips (display, NULL), ==, 1);
+
+  gdk_x11_display_set_roundtrip_tracing (display, FALSE);
+  g_assert (!gdk_x11_display_get_roundtrip_tracing (display));
+
+  /* Nothing is counted while tracing is off */
+  gdk_display_sync (display);
+  g_assert_cmpuint (gdk_x11_display_get_n_roundtrips (display, NULL), ==, 0);
+}
+
+/* Atoms are interned with the server once, and cached afterwards */
+static void
+test_atoms (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  const gchar *site = "gdk_x11_atom_to_xatom_for_display:XInternAtom";
+  GdkAtom atom;
+
+  gdk_x11_display_set_roundtrip_tracing (display, TRUE);
+
+  atom = gdk_atom_intern_static_string ("GDK_TEST_ROUNDTRIPS");
+  gdk_x11_atom_to_xatom_for_display (display, atom);
+  g_assert_cmpuint (gdk_x11_display_get_n_roundtrips (display, site), ==, 1);
+
+  gdk_x11_atom_to_xatom_for_display (display, atom);
+  g_assert_cmpuint (gdk_x11_display_get_n_roundtrips (display, site), ==, 1);
+
+  /* The atoms GDK uses itself were all interned when the display was
+   * opened, and map back without asking the server either
+   */
+  gdk_x11_display_reset_roundtrips (display);
+  atom = gdk_atom_intern_static_string ("_NET_WM_WINDOW_TYPE_TOOLTIP");
+  g_assert (gdk_x11_xatom_to_atom_for_display (display,
+                                               gdk_x11_atom_to_xatom_for_display (display, atom)) == atom);
+  g_assert (gdk_x11_xatom_to_atom_for_display (display,
+                                               gdk_x11_get_xatom_by_name_for_display (display, "XdndAware")) ==
+            gdk_atom_intern_static_string ("XdndAware"));
+  g_assert_cmpuint (gdk_x11_display_get_n_roundtrips (display, NULL), ==, 0);
+
+  gdk_x11_display_set_roundtrip_tracing (display, FALSE);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  gdk_init (&argc, &argv);
+
+  g_test_add_func ("/roundtrips/tracing", test_tracing);
+  g_test_add_func ("/roundtrips/atoms", test_atoms);
+
+  return g_test_run ();
+}
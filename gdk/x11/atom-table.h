@@ -0,0 +1,136 @@
+/* atom-table.h: Generated by gen-atom-table.pl from atoms.txt
+ *
+ *  Date: Sun Oct 18 16:20:44 2026
+ *
+ * Do not edit.   
+ */
+static const char known_atoms_string[] =
+  "ATOM_PAIR\0"
+  "CLIPBOARD_MANAGER\0"
+  "COMPOUND_TEXT\0"
+  "DELETE\0"
+  "INCR\0"
+  "MULTIPLE\0"
+  "NULL\0"
+  "SAVE_TARGETS\0"
+  "SM_CLIENT_ID\0"
+  "TARGETS\0"
+  "TEXT\0"
+  "TIMESTAMP\0"
+  "UTF8_STRING\0"
+  "WM_CLIENT_LEADER\0"
+  "WM_DELETE_WINDOW\0"
+  "WM_LOCALE_NAME\0"
+  "WM_PROTOCOLS\0"
+  "WM_STATE\0"
+  "WM_TAKE_FOCUS\0"
+  "WM_WINDOW_ROLE\0"
+  "GDK_SELECTION\0"
+  "GDK_TIMESTAMP_PROP\0"
+  "GTK_NOTEBOOK_TAB\0"
+  "GTK_TEXT_BUFFER_CONTENTS\0"
+  "GTK_TREE_MODEL_ROW\0"
+  "_GTK_LOAD_ICONTHEMES\0"
+  "_GTK_READ_RCFILES\0"
+  "gtk-clist-drag-reorder\0"
+  "_NET_ACTIVE_WINDOW\0"
+  "_NET_CLIENT_LIST\0"
+  "_NET_CLIENT_LIST_STACKING\0"
+  "_NET_CURRENT_DESKTOP\0"
+  "_NET_FRAME_EXTENTS\0"
+  "_NET_STARTUP_ID\0"
+  "_NET_SUPPORTED\0"
+  "_NET_SUPPORTING_WM_CHECK\0"
+  "_NET_VIRTUAL_ROOTS\0"
+  "_NET_WM_CM_S0\0"
+  "_NET_WM_DESKTOP\0"
+  "_NET_WM_ICON\0"
+  "_NET_WM_ICON_NAME\0"
+  "_NET_WM_MOVERESIZE\0"
+  "_NET_WM_NAME\0"
+  "_NET_WM_PID\0"
+  "_NET_WM_PING\0"
+  "_NET_WM_STATE\0"
+  "_NET_WM_STATE_ABOVE\0"
+  "_NET_WM_STATE_BELOW\0"
+  "_NET_WM_STATE_FULLSCREEN\0"
+  "_NET_WM_STATE_HIDDEN\0"
+  "_NET_WM_STATE_MAXIMIZED_HORZ\0"
+  "_NET_WM_STATE_MAXIMIZED_VERT\0"
+  "_NET_WM_STATE_MODAL\0"
+  "_NET_WM_STATE_SKIP_PAGER\0"
+  "_NET_WM_STATE_SKIP_TASKBAR\0"
+  "_NET_WM_STATE_STICKY\0"
+  "_NET_WM_SYNC_REQUEST\0"
+  "_NET_WM_SYNC_REQUEST_COUNTER\0"
+  "_NET_WM_USER_TIME\0"
+  "_NET_WM_USER_TIME_WINDOW\0"
+  "_NET_WM_WINDOW_OPACITY\0"
+  "_NET_WM_WINDOW_TYPE\0"
+  "_NET_WM_WINDOW_TYPE_COMBO\0"
+  "_NET_WM_WINDOW_TYPE_DESKTOP\0"
+  "_NET_WM_WINDOW_TYPE_DIALOG\0"
+  "_NET_WM_WINDOW_TYPE_DND\0"
+  "_NET_WM_WINDOW_TYPE_DOCK\0"
+  "_NET_WM_WINDOW_TYPE_DROPDOWN_MENU\0"
+  "_NET_WM_WINDOW_TYPE_MENU\0"
+  "_NET_WM_WINDOW_TYPE_NORMAL\0"
+  "_NET_WM_WINDOW_TYPE_NOTIFICATION\0"
+  "_NET_WM_WINDOW_TYPE_POPUP_MENU\0"
+  "_NET_WM_WINDOW_TYPE_SPLASH\0"
+  "_NET_WM_WINDOW_TYPE_TOOLBAR\0"
+  "_NET_WM_WINDOW_TYPE_TOOLTIP\0"
+  "_NET_WM_WINDOW_TYPE_UTILITY\0"
+  "ENLIGHTENMENT_DESKTOP\0"
+  "__SWM_VROOT\0"
+  "_XEMBED\0"
+  "_XEMBED_INFO\0"
+  "MANAGER\0"
+  "_XSETTINGS_SETTINGS\0"
+  "XdndActionAsk\0"
+  "XdndActionCopy\0"
+  "XdndActionLink\0"
+  "XdndActionList\0"
+  "XdndActionMove\0"
+  "XdndActionPrivate\0"
+  "XdndAware\0"
+  "XdndDrop\0"
+  "XdndEnter\0"
+  "XdndFinished\0"
+  "XdndLeave\0"
+  "XdndPosition\0"
+  "XdndProxy\0"
+  "XdndSelection\0"
+  "XdndStatus\0"
+  "XdndTypeList\0"
+  "XmTRANSFER_FAILURE\0"
+  "XmTRANSFER_SUCCESS\0"
+  "_MOTIF_DRAG_AND_DROP_MESSAGE\0"
+  "_MOTIF_DRAG_INITIATOR_INFO\0"
+  "_MOTIF_DRAG_RECEIVER_INFO\0"
+  "_MOTIF_DRAG_TARGETS\0"
+  "_MOTIF_DRAG_WINDOW\0"
+  "application/x-color\0"
+  "application/x-rootwin-drop\0"
+  "application/x-rootwindow-drop\0"
+  "image/bmp\0"
+  "image/gif\0"
+  "image/jpeg\0"
+  "image/png\0"
+  "image/tiff\0"
+  "text/plain\0"
+  "text/plain;charset=utf-8\0"
+  "text/uri-list\0";
+
+static const guint16 known_atoms_offset[] = {
+     0,   10,   28,   42,   49,   54,   63,   68,   81,   94,  102,  107,
+   117,  129,  146,  163,  178,  191,  200,  214,  229,  243,  262,  279,
+   304,  323,  344,  362,  385,  404,  421,  447,  468,  487,  503,  518,
+   543,  562,  576,  592,  605,  623,  642,  655,  667,  680,  694,  714,
+   734,  759,  780,  809,  838,  858,  883,  910,  931,  952,  981,  999,
+  1024, 1047, 1067, 1093, 1121, 1148, 1172, 1197, 1231, 1256, 1283, 1316,
+  1347, 1374, 1402, 1430, 1458, 1480, 1492, 1500, 1513, 1521, 1541, 1555,
+  1570, 1585, 1600, 1615, 1633, 1643, 1652, 1662, 1675, 1685, 1698, 1708,
+  1722, 1733, 1746, 1765, 1784, 1813, 1840, 1866, 1886, 1905, 1925, 1952,
+  1982, 1992, 2002, 2013, 2023, 2034, 2045, 2070
+};
@@ -58,6 +58,7 @@ typedef struct _ListChildrenState ListChildrenState;
 typedef struct _SendEventState SendEventState;
 typedef struct _SetInputFocusState SetInputFocusState;
 typedef struct _RoundtripState RoundtripState;
+typedef struct _GetPropertyState GetPropertyState;
 
 typedef enum {
   CHILD_INFO_GET_PROPERTY,
@@ -123,6 +124,21 @@ struct _RoundtripState
   gpointer data;
 };
 
+struct _GetPropertyState
+{
+  Display *dpy;
+  _XAsyncHandler async;
+  gulong get_property_req;
+  GdkDisplay *display;
+  Window window;
+  Atom type;
+  gint format;
+  gulong n_items;
+  guchar *value;
+  GdkGetPropertyCallback callback;
+  gpointer data;
+};
+
 static gboolean
 callback_idle (gpointer data)
 {
@@ -651,6 +667,7 @@ _gdk_x11_get_window_child_info (GdkDisplay       *display,
   state.nchildren = 0;
 
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (dpy, "XQueryTree");
   result = list_children_and_wm_state (dpy, window,
 				       win_has_wm_state ? wm_state_atom : None,
 				       &has_wm_state,
@@ -728,6 +745,7 @@ _gdk_x11_get_window_child_info (GdkDisplay       *display,
 
       /* On error, our async handler will get called
        */
+      GDK_X11_NOTE_ROUNDTRIP (dpy, "XGetGeometry");
       if (_XReply (dpy, (xReply *)&rep, 0, xTrue))
 	handle_get_geometry_reply (dpy, &state, &rep);
 
@@ -841,5 +859,152 @@ _gdk_x11_roundtrip_async (GdkDisplay           *display,
   SyncHandle();
 }
 
+static gboolean
+get_property_callback_idle (gpointer data)
+{
+  GetPropertyState *state = (GetPropertyState *)data;
+
+  state->callback (state->display, state->window,
+		   state->type, state->format, state->n_items, state->value,
+		   state->data);
+
+  g_free (state->value);
+  g_free (state);
+
+  return FALSE;
+}
+
+static Bool
+get_property_handler (Display *dpy,
+		      xReply  *rep,
+		      char    *buf,
+		      int      len,
+		      XPointer data)
+{
+  GetPropertyState *state = (GetPropertyState *)data;
+
+  if (dpy->last_request_read != state->get_property_req)
+    return False;
+
+  if (rep->generic.type != X_Error)
+    {
+      xGetPropertyReply replbuf;
+      xGetPropertyReply *repl;
+      gulong n_bytes = 0;
+      gulong wire_bytes;
+
+      repl = (xGetPropertyReply *)
+	_XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+			(sizeof(xGetPropertyReply) - sizeof(xReply)) >> 2,
+			False);
+
+      wire_bytes = (gulong) repl->length << 2;
+
+      if (repl->propertyType != None &&
+	  (repl->format == 8 || repl->format == 16 || repl->format == 32))
+	n_bytes = repl->nItems * (repl->format / 8);
+
+      if (n_bytes > 0 && n_bytes <= wire_bytes)
+	{
+	  guchar *value = g_malloc (n_bytes + 1);
+
+	  _XGetAsyncData (dpy, (char *)value, buf, len,
+			  SIZEOF (xGetPropertyReply), n_bytes, wire_bytes);
+
+	  /* Hand out the data the way XGetWindowProperty() does: 32 bit
+	   * items as longs, and 8 bit data nul-terminated.
+	   */
+	  if (repl->format == 32)
+	    {
+	      glong *longs = g_new (glong, repl->nItems);
+	      gulong i;
+
+	      for (i = 0; i < repl->nItems; i++)
+		longs[i] = ((CARD32 *)value)[i];
+
+	      g_free (value);
+	      value = (guchar *)longs;
+	    }
+	  else
+	    value[n_bytes] = '\0';
+
+	  state->type = repl->propertyType;
+	  state->format = repl->format;
+	  state->n_items = repl->nItems;
+	  state->value = value;
+	}
+      else if (wire_bytes > 0)
+	_XGetAsyncData (dpy, NULL, buf, len,
+			SIZEOF (xGetPropertyReply), 0, wire_bytes);
+    }
+
+  gdk_threads_add_idle (get_property_callback_idle, state);
+
+  DeqAsyncHandler(state->dpy, &state->async);
+
+  /* A window that is gone is no error, it just has no property */
+  return True;
+}
+
+/**
+ * _gdk_x11_get_property_async:
+ * @display: a #GdkDisplay
+ * @window: the window to get the property of
+ * @property: the property to get
+ * @type: the type to ask for, or %AnyPropertyType
+ * @length: the maximum number of 32 bit units to get
+ * @callback: function to call with the value
+ * @data: data to pass to @callback
+ *
+ * Like XGetWindowProperty(), but without waiting for the reply.
+ * @callback is called from the main loop once it arrives. If the
+ * property doesn't exist or @window is gone, the type passed to
+ * @callback is %None. The value is freed after @callback returns.
+ **/
+void
+_gdk_x11_get_property_async (GdkDisplay            *display,
+			     Window                 window,
+			     Atom                   property,
+			     Atom                   type,
+			     glong                  length,
+			     GdkGetPropertyCallback callback,
+			     gpointer               data)
+{
+  Display *dpy;
+  GetPropertyState *state;
+  xGetPropertyReq *req;
+
+  dpy = GDK_DISPLAY_XDISPLAY (display);
+
+  state = g_new0 (GetPropertyState, 1);
+
+  state->display = display;
+  state->dpy = dpy;
+  state->window = window;
+  state->type = None;
+  state->callback = callback;
+  state->data = data;
+
+  LockDisplay(dpy);
+
+  state->async.next = dpy->async_handlers;
+  state->async.handler = get_property_handler;
+  state->async.data = (XPointer) state;
+  dpy->async_handlers = &state->async;
+
+  GetReq (GetProperty, req);
+  req->window = window;
+  req->property = property;
+  req->type = type;
+  req->delete = False;
+  req->longOffset = 0;
+  req->longLength = length;
+
+  state->get_property_req = dpy->request;
+
+  UnlockDisplay(dpy);
+  SyncHandle();
+}
+
 #define __GDK_ASYNC_C__
 #include "gdkaliasdef.c"
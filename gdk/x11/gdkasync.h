@@ -34,6 +34,13 @@ typedef void (*GdkSendXEventCallback) (Window   window,
 typedef void (*GdkRoundTripCallback)  (GdkDisplay *display,
 				       gpointer data,
 				       gulong serial);
+typedef void (*GdkGetPropertyCallback) (GdkDisplay *display,
+					Window      window,
+					Atom        type,
+					gint        format,
+					gulong      n_items,
+					guchar     *value,
+					gpointer    data);
 
 struct _GdkChildInfoX11
 {
@@ -70,6 +77,14 @@ void _gdk_x11_roundtrip_async           (GdkDisplay           *display,
 					 GdkRoundTripCallback callback,
 					 gpointer              data);
 
+void _gdk_x11_get_property_async        (GdkDisplay            *display,
+					 Window                 window,
+					 Atom                   property,
+					 Atom                   type,
+					 glong                  length,
+					 GdkGetPropertyCallback callback,
+					 gpointer               data);
+
 G_END_DECLS
 
 #endif /* __GDK_ASYNC_H__ */
@@ -188,6 +188,7 @@ gdk_colormap_new (GdkVisual *visual,
 	  for (i = 0; i < n_default_colors; i++)
 	    default_colors[i].pixel = i;
 	  
+	  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryColors");
 	  XQueryColors (xdisplay,
 			DefaultColormapOfScreen (GDK_SCREEN_X11 (private->screen)->xscreen),
 			default_colors, n_default_colors);
@@ -272,6 +273,7 @@ gdk_colormap_sync_palette (GdkColormap *colormap)
 	}
     }
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (private->screen), "XQueryColors");
   XQueryColors (GDK_SCREEN_XDISPLAY (private->screen),
 		private->xcolormap, xpalette, nlookup);
   
@@ -305,6 +307,7 @@ gdk_colormap_sync_direct_color (GdkColormap *colormap)
 	 ((i << visual->blue_shift)  & visual->blue_mask));
     }
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (private->screen), "XQueryColors");
   XQueryColors (GDK_SCREEN_XDISPLAY (private->screen),
 		private->xcolormap, xpalette, colormap->size);
   
@@ -717,6 +720,7 @@ gdk_colormap_alloc1 (GdkColormap    *colormap,
   xcolor.pixel = color->pixel;
   xcolor.flags = DoRed | DoGreen | DoBlue;
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (private->screen), "XAllocColor");
   if (XAllocColor (GDK_SCREEN_XDISPLAY (private->screen), private->xcolormap, &xcolor))
     {
       ret->pixel = xcolor.pixel;
@@ -1127,6 +1131,7 @@ gdk_colormap_alloc_colors (GdkColormap *colormap,
 	  xcolor.pixel = colors[i].pixel;
 	  xcolor.flags = DoRed | DoGreen | DoBlue;
 
+	  GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (private->screen), "XAllocColor");
 	  if (XAllocColor (GDK_SCREEN_XDISPLAY (private->screen), private->xcolormap, &xcolor))
 	    {
 	      colors[i].pixel = xcolor.pixel;
@@ -1188,6 +1193,7 @@ gdk_colormap_query_color (GdkColormap *colormap,
     xcolor.pixel = pixel;
     if (!private->screen->closed)
       {
+	GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (private->screen), "XQueryColor");
 	XQueryColor (GDK_SCREEN_XDISPLAY (private->screen), private->xcolormap, &xcolor);
 	result->red = xcolor.red;
 	result->green = xcolor.green;
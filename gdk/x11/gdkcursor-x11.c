@@ -1085,6 +1085,7 @@ gdk_display_get_maximal_cursor_size (GdkDisplay *display,
   
   screen = gdk_display_get_default_screen (display);
   window = gdk_screen_get_root_window (screen);
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XQueryBestCursor");
   XQueryBestCursor (GDK_DISPLAY_XDISPLAY (display), 
 		    GDK_WINDOW_XWINDOW (window), 
 		    128, 128, width, height);
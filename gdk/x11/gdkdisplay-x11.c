@@ -77,49 +77,6 @@ static void gdk_internal_connection_watch (Display  *display,
 					   XPointer *watch_data);
 #endif /* HAVE_X11R6 */
 
-/* Note that we never *directly* use WM_LOCALE_NAME, WM_PROTOCOLS,
- * but including them here has the side-effect of getting them
- * into the internal Xlib cache
- */
-static const char *const precache_atoms[] = {
-  "UTF8_STRING",
-  "WM_CLIENT_LEADER",
-  "WM_DELETE_WINDOW",
-  "WM_ICON_NAME",
-  "WM_LOCALE_NAME",
-  "WM_NAME",
-  "WM_PROTOCOLS",
-  "WM_TAKE_FOCUS",
-  "WM_WINDOW_ROLE",
-  "_NET_ACTIVE_WINDOW",
-  "_NET_CURRENT_DESKTOP",
-  "_NET_FRAME_EXTENTS",
-  "_NET_STARTUP_ID",
-  "_NET_WM_CM_S0",
-  "_NET_WM_DESKTOP",
-  "_NET_WM_ICON",
-  "_NET_WM_ICON_NAME",
-  "_NET_WM_NAME",
-  "_NET_WM_PID",
-  "_NET_WM_PING",
-  "_NET_WM_STATE",
-  "_NET_WM_STATE_ABOVE",
-  "_NET_WM_STATE_BELOW",
-  "_NET_WM_STATE_FULLSCREEN",
-  "_NET_WM_STATE_MODAL",
-  "_NET_WM_STATE_MAXIMIZED_VERT",
-  "_NET_WM_STATE_MAXIMIZED_HORZ",
-  "_NET_WM_STATE_SKIP_TASKBAR",
-  "_NET_WM_STATE_SKIP_PAGER",
-  "_NET_WM_STATE_STICKY",
-  "_NET_WM_SYNC_REQUEST",
-  "_NET_WM_SYNC_REQUEST_COUNTER",
-  "_NET_WM_WINDOW_TYPE",
-  "_NET_WM_WINDOW_TYPE_NORMAL",
-  "_NET_WM_USER_TIME",
-  "_NET_VIRTUAL_ROOTS"
-};
-
 G_DEFINE_TYPE (GdkDisplayX11, _gdk_display_x11, GDK_TYPE_DISPLAY)
 
 static void
@@ -173,12 +130,14 @@ gdk_display_open (const gchar *display_name)
   display_x11->use_xshm = TRUE;
   display_x11->xdisplay = xdisplay;
 
+  GDK_NOTE (ROUNDTRIPS, gdk_x11_display_set_roundtrip_tracing (display, TRUE));
+
 #ifdef HAVE_X11R6  
   /* Set up handlers for Xlib internal connections */
   XAddConnectionWatch (xdisplay, gdk_internal_connection_watch, NULL);
 #endif /* HAVE_X11R6 */
   
-  _gdk_x11_precache_atoms (display, precache_atoms, G_N_ELEMENTS (precache_atoms));
+  _gdk_x11_precache_known_atoms (display);
 
   /* RandR must be initialized before we initialize the screens */
   display_x11->have_randr13 = FALSE;
@@ -302,6 +261,7 @@ gdk_display_open (const gchar *display_name)
     unsigned int xmask;
 
     gdk_error_trap_push ();
+    GDK_X11_NOTE_ROUNDTRIP (display_x11->xdisplay, "XQueryPointer");
     XQueryPointer (display_x11->xdisplay, 
 		   GDK_SCREEN_X11 (display_x11->default_screen)->xroot_window,
 		   &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
@@ -724,6 +684,7 @@ gdk_display_sync (GdkDisplay *display)
 {
   g_return_if_fail (GDK_IS_DISPLAY (display));
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XSync");
   XSync (GDK_DISPLAY_XDISPLAY (display), False);
 }
 
@@ -850,6 +811,8 @@ gdk_display_x11_finalize (GObject *object)
   if (display_x11->keymap)
     g_object_unref (display_x11->keymap);
 
+  gdk_x11_display_set_roundtrip_tracing (GDK_DISPLAY_OBJECT (display_x11), FALSE);
+
   /* Free motif Dnd */
   if (display_x11->motif_target_lists)
     {
@@ -860,9 +823,14 @@ gdk_display_x11_finalize (GObject *object)
 
   _gdk_x11_cursor_display_finalize (GDK_DISPLAY_OBJECT(display_x11));
 
-  /* Atom Hashtable */
-  g_hash_table_destroy (display_x11->atom_from_virtual);
-  g_hash_table_destroy (display_x11->atom_to_virtual);
+  /* Atom tables */
+  g_free (display_x11->known_xatoms);
+  g_free (display_x11->known_atoms_by_xatom);
+  if (display_x11->atom_from_virtual)
+    {
+      g_hash_table_destroy (display_x11->atom_from_virtual);
+      g_hash_table_destroy (display_x11->atom_to_virtual);
+    }
 
   /* Leader Window */
   XDestroyWindow (display_x11->xdisplay, display_x11->leader_window);
@@ -1325,6 +1293,7 @@ gdk_display_supports_clipboard_persistence (GdkDisplay *display)
 
   /* It might make sense to cache this */
   clipboard_manager = gdk_x11_get_xatom_by_name_for_display (display, "CLIPBOARD_MANAGER");
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_X11 (display)->xdisplay, "XGetSelectionOwner");
   return XGetSelectionOwner (GDK_DISPLAY_X11 (display)->xdisplay, clipboard_manager) != None;
 }
 
@@ -1362,6 +1331,7 @@ gdk_display_store_clipboard (GdkDisplay    *display,
 
   gdk_error_trap_push ();
 
+  GDK_X11_NOTE_ROUNDTRIP (display_x11->xdisplay, "XGetSelectionOwner");
   if (XGetSelectionOwner (display_x11->xdisplay, clipboard_manager) != None)
     {
       Atom property_name = None;
@@ -1486,6 +1456,263 @@ gdk_display_supports_composite (GdkDisplay *display)
 	 x11_display->have_xfixes;
 }
 
+typedef struct _GdkRoundtripSite GdkRoundtripSite;
+
+struct _GdkRoundtripSite
+{
+  gchar *name;
+  guint count;
+  /* Since the last toplevel was mapped */
+  guint period_count;
+  gint64 first_time;
+  gint64 last_time;
+};
+
+static void
+roundtrip_site_free (GdkRoundtripSite *site)
+{
+  g_free (site->name);
+  g_slice_free (GdkRoundtripSite, site);
+}
+
+void
+_gdk_x11_note_roundtrip (Display     *xdisplay,
+                         const gchar *function,
+                         const gchar *request)
+{
+  GdkDisplay *display = gdk_x11_lookup_xdisplay (xdisplay);
+  GdkDisplayX11 *display_x11;
+  GdkRoundtripSite *site;
+  gchar *name;
+  gint64 now;
+
+  if (display == NULL)
+    return;
+
+  display_x11 = GDK_DISPLAY_X11 (display);
+  if (display_x11->roundtrip_sites == NULL)
+    return;
+
+  now = g_get_monotonic_time ();
+
+  name = g_strconcat (function, ":", request, NULL);
+  site = g_hash_table_lookup (display_x11->roundtrip_sites, name);
+  if (site == NULL)
+    {
+      site = g_slice_new0 (GdkRoundtripSite);
+      site->name = name;
+      g_hash_table_insert (display_x11->roundtrip_sites, site->name, site);
+    }
+  else
+    g_free (name);
+
+  if (site->period_count == 0)
+    site->first_time = now;
+  site->last_time = now;
+  site->count++;
+  site->period_count++;
+
+  display_x11->n_roundtrips++;
+  display_x11->n_period_roundtrips++;
+}
+
+static gint
+compare_period_counts (gconstpointer a,
+                       gconstpointer b)
+{
+  const GdkRoundtripSite *site_a = *(const GdkRoundtripSite **) a;
+  const GdkRoundtripSite *site_b = *(const GdkRoundtripSite **) b;
+
+  if (site_a->period_count != site_b->period_count)
+    return site_a->period_count > site_b->period_count ? -1 : 1;
+
+  return strcmp (site_a->name, site_b->name);
+}
+
+#define MAX_DUMPED_SITES 10
+
+/* Prints the sites that waited for the server most often since the
+ * previous toplevel was mapped, and starts counting again.
+ */
+void
+_gdk_x11_display_dump_roundtrips (GdkDisplay *display,
+                                  Window      mapped_window)
+{
+  GdkDisplayX11 *display_x11 = GDK_DISPLAY_X11 (display);
+  GHashTableIter iter;
+  GdkRoundtripSite *site;
+  GPtrArray *sites;
+  gint64 start = display_x11->roundtrip_period_start;
+  guint i;
+
+  if (display_x11->roundtrip_sites == NULL)
+    return;
+
+  sites = g_ptr_array_new ();
+
+  g_hash_table_iter_init (&iter, display_x11->roundtrip_sites);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &site))
+    if (site->period_count > 0)
+      g_ptr_array_add (sites, site);
+
+  g_ptr_array_sort (sites, compare_period_counts);
+
+  GDK_NOTE (ROUNDTRIPS,
+            g_message ("%u round trips by %u call sites before mapping 0x%lx, in %.1f ms",
+                       display_x11->n_period_roundtrips, sites->len, mapped_window,
+                       (g_get_monotonic_time () - start) / 1000.));
+
+  for (i = 0; i < sites->len; i++)
+    {
+      site = g_ptr_array_index (sites, i);
+
+      if (i < MAX_DUMPED_SITES)
+        GDK_NOTE (ROUNDTRIPS,
+                  g_message ("  %5u  %s (first at +%.1f ms, last at +%.1f ms)",
+                             site->period_count, site->name,
+                             (site->first_time - start) / 1000.,
+                             (site->last_time - start) / 1000.));
+
+      site->period_count = 0;
+    }
+
+  g_ptr_array_free (sites, TRUE);
+
+  display_x11->n_period_roundtrips = 0;
+  display_x11->roundtrip_period_start = g_get_monotonic_time ();
+}
+
+/**
+ * gdk_x11_display_set_roundtrip_tracing:
+ * @display: a #GdkDisplay
+ * @enabled: whether to trace round trips
+ *
+ * Turns counting of round trips to the X server on or off. When it
+ * is on, GDK notes every request it makes that waits for a reply from
+ * the server, along with the function that made it, so that the
+ * latency added by a slow connection can be tracked down.
+ *
+ * The counts only depend on what GDK does, not on timing, so they
+ * can be compared between runs, e.g. under Xvfb in tests. Turning
+ * tracing off discards the counts. Setting the
+ * <literal>roundtrips</literal> option in <envar>GDK_DEBUG</envar>
+ * turns tracing on for every display, and prints the sites with the
+ * most round trips whenever a toplevel window is mapped.
+ *
+ * Since: 2.24
+ **/
+void
+gdk_x11_display_set_roundtrip_tracing (GdkDisplay *display,
+                                       gboolean    enabled)
+{
+  GdkDisplayX11 *display_x11;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+
+  display_x11 = GDK_DISPLAY_X11 (display);
+
+  if (enabled == (display_x11->roundtrip_sites != NULL))
+    return;
+
+  if (enabled)
+    {
+      display_x11->roundtrip_sites =
+        g_hash_table_new_full (g_str_hash, g_str_equal,
+                               NULL, (GDestroyNotify) roundtrip_site_free);
+      display_x11->roundtrip_period_start = g_get_monotonic_time ();
+      _gdk_x11_n_roundtrip_tracers++;
+    }
+  else
+    {
+      g_hash_table_destroy (display_x11->roundtrip_sites);
+      display_x11->roundtrip_sites = NULL;
+      display_x11->n_roundtrips = 0;
+      display_x11->n_period_roundtrips = 0;
+      _gdk_x11_n_roundtrip_tracers--;
+    }
+}
+
+/**
+ * gdk_x11_display_get_roundtrip_tracing:
+ * @display: a #GdkDisplay
+ *
+ * Returns whether round trips are counted for @display, see
+ * gdk_x11_display_set_roundtrip_tracing().
+ *
+ * Returns: %TRUE if round trips are traced
+ *
+ * Since: 2.24
+ **/
+gboolean
+gdk_x11_display_get_roundtrip_tracing (GdkDisplay *display)
+{
+  g_return_val_if_fail (GDK_IS_DISPLAY (display), FALSE);
+
+  return GDK_DISPLAY_X11 (display)->roundtrip_sites != NULL;
+}
+
+/**
+ * gdk_x11_display_get_n_roundtrips:
+ * @display: a #GdkDisplay
+ * @site: (allow-none): a call site, or %NULL
+ *
+ * Gets how many round trips to the X server were made since tracing
+ * was turned on or the counts were reset. A call site is named after
+ * the function and the Xlib request, as in
+ * <literal>"gdk_property_get:XGetWindowProperty"</literal>; with a
+ * %NULL @site, the round trips of all call sites are counted.
+ *
+ * Returns: the number of round trips
+ *
+ * Since: 2.24
+ **/
+guint
+gdk_x11_display_get_n_roundtrips (GdkDisplay  *display,
+                                  const gchar *site)
+{
+  GdkDisplayX11 *display_x11;
+  GdkRoundtripSite *roundtrip_site;
+
+  g_return_val_if_fail (GDK_IS_DISPLAY (display), 0);
+
+  display_x11 = GDK_DISPLAY_X11 (display);
+
+  if (display_x11->roundtrip_sites == NULL)
+    return 0;
+
+  if (site == NULL)
+    return display_x11->n_roundtrips;
+
+  roundtrip_site = g_hash_table_lookup (display_x11->roundtrip_sites, site);
+
+  return roundtrip_site ? roundtrip_site->count : 0;
+}
+
+/**
+ * gdk_x11_display_reset_roundtrips:
+ * @display: a #GdkDisplay
+ *
+ * Sets the round trip counts of @display back to zero.
+ *
+ * Since: 2.24
+ **/
+void
+gdk_x11_display_reset_roundtrips (GdkDisplay *display)
+{
+  GdkDisplayX11 *display_x11;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+
+  display_x11 = GDK_DISPLAY_X11 (display);
+
+  if (display_x11->roundtrip_sites == NULL)
+    return;
+
+  g_hash_table_remove_all (display_x11->roundtrip_sites);
+  display_x11->n_roundtrips = 0;
+  display_x11->n_period_roundtrips = 0;
+  display_x11->roundtrip_period_start = g_get_monotonic_time ();
+}
 
 #define __GDK_DISPLAY_X11_C__
 #include "gdkaliasdef.c"
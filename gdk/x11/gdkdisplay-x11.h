@@ -107,6 +107,11 @@ struct _GdkDisplayX11
 
   /* Mapping to/from virtual atoms */
 
+  /* X atoms of the atoms in atom-table.h, interned when the display
+   * is opened, and their indices sorted by X atom */
+  Atom *known_xatoms;
+  guint16 *known_atoms_by_xatom;
+
   GHashTable *atom_from_virtual;
   GHashTable *atom_to_virtual;
 
@@ -155,6 +160,12 @@ struct _GdkDisplayX11
 
   /* The offscreen window that has the pointer in it (if any) */
   GdkWindow *active_offscreen_window;
+
+  /* Round trips by call site, while they are traced */
+  GHashTable *roundtrip_sites;
+  guint n_roundtrips;
+  guint n_period_roundtrips;
+  gint64 roundtrip_period_start;
 };
 
 struct _GdkDisplayX11Class
@@ -537,6 +537,7 @@ gdk_window_cache_new (GdkScreen *screen)
   result->screen = screen;
   result->ref_count = 1;
 
+  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XGetWindowAttributes");
   XGetWindowAttributes (xdisplay, GDK_WINDOW_XWINDOW (root_window), &xwa);
   result->old_event_mask = xwa.your_event_mask;
 
@@ -994,6 +995,7 @@ motif_lookup_drag_window (GdkDisplay *display,
   gint format;
   guchar *data;
 
+  GDK_X11_NOTE_ROUNDTRIP (lookup_xdisplay, "XGetWindowProperty");
   XGetWindowProperty (lookup_xdisplay, RootWindow (lookup_xdisplay, 0),
 		      gdk_x11_get_xatom_by_name_for_display (display, "_MOTIF_DRAG_WINDOW"),
 		      0, 1, FALSE,
@@ -1112,6 +1114,7 @@ motif_read_target_table (GdkDisplay *display)
       gboolean success = FALSE;
 
       gdk_error_trap_push ();
+      GDK_X11_NOTE_ROUNDTRIP (display_x11->xdisplay, "XGetWindowProperty");
       XGetWindowProperty (display_x11->xdisplay, 
 			  display_x11->motif_drag_window, 
 			  motif_drag_targets_atom,
@@ -1129,6 +1132,7 @@ motif_read_target_table (GdkDisplay *display)
       header->total_size = card32_to_host (header->total_size, header->byte_order);
 
       gdk_error_trap_push ();
+      GDK_X11_NOTE_ROUNDTRIP (display_x11->xdisplay, "XGetWindowProperty");
       XGetWindowProperty (display_x11->xdisplay, 
 			  display_x11->motif_drag_window, 
 		          motif_drag_targets_atom,
@@ -1438,6 +1442,7 @@ motif_set_targets (GdkDragContext *context)
       g_snprintf(buf, 20, "_GDK_SELECTION_%d", i);
       
       private->motif_selection = gdk_x11_get_xatom_by_name_for_display (display, buf);
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetSelectionOwner");
       if (!XGetSelectionOwner (GDK_DISPLAY_XDISPLAY (display), private->motif_selection))
 	break;
     }
@@ -1467,6 +1472,7 @@ motif_check_dest (GdkDisplay *display,
   Atom motif_drag_receiver_info_atom = gdk_x11_get_xatom_by_name_for_display (display, "_MOTIF_DRAG_RECEIVER_INFO");
 
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), win, 
 		      motif_drag_receiver_info_atom, 
 		      0, (sizeof(*info)+3)/4, False, AnyPropertyType,
@@ -1667,6 +1673,7 @@ motif_read_initiator_info (GdkDisplay *display,
   GdkDisplayX11 *display_x11 = GDK_DISPLAY_X11 (display);
   
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), source_window, atom,
 		      0, sizeof(*initiator_info), FALSE,
 		      gdk_x11_get_xatom_by_name_for_display (display, "_MOTIF_DRAG_INITIATOR_INFO"),
@@ -2611,6 +2618,7 @@ xdnd_check_dest (GdkDisplay *display,
 
   gdk_error_trap_push ();
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), win, 
 			  xdnd_proxy_atom, 0, 
 			  1, False, AnyPropertyType,
@@ -2633,6 +2641,7 @@ xdnd_check_dest (GdkDisplay *display,
 	  XFree (proxy_data);
 	}
       
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
       if ((XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), proxy ? proxy : win,
 			       xdnd_aware_atom, 0, 
 			       1, False, AnyPropertyType,
@@ -2685,6 +2694,7 @@ xdnd_read_actions (GdkDragContext *context)
       
       gdk_error_trap_push ();
       
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
       if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display),
 			      GDK_DRAWABLE_XID (context->source_window),
 			      gdk_x11_get_xatom_by_name_for_display (display, "XdndActionList"),
@@ -2931,6 +2941,7 @@ xdnd_enter_filter (GdkXEvent *xev,
   if (get_types)
     {
       gdk_error_trap_push ();
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DRAWABLE_XDISPLAY (event->any.window), "XGetWindowProperty");
       XGetWindowProperty (GDK_DRAWABLE_XDISPLAY (event->any.window), 
 			  source_window, 
 			  gdk_x11_get_xatom_by_name_for_display (display, "XdndTypeList"),
@@ -3274,6 +3285,7 @@ _gdk_drag_get_protocol_for_display (GdkDisplay      *display,
       
       if (!rootwin)
 	{
+	  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
 	  if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), xid,
 				  gdk_x11_get_xatom_by_name_for_display (display, "ENLIGHTENMENT_DESKTOP"),
 				  0, 0, False, AnyPropertyType,
@@ -3292,6 +3304,7 @@ _gdk_drag_get_protocol_for_display (GdkDisplay      *display,
 #if 0
       if (!rootwin)
 	{
+	  GDK_X11_NOTE_ROUNDTRIP (gdk_display, "XGetWindowProperty");
 	  if (XGetWindowProperty (gdk_display, win,
 				  gdk_x11_get_xatom_by_name ("__SWM_VROOT"),
 				  0, 0, False, AnyPropertyType,
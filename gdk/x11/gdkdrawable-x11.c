@@ -305,6 +305,7 @@ _gdk_x11_have_render (GdkDisplay *display)
 		    try_pixmap (xdisplay, screen, 8);
 		  if (!has_32)
 		    try_pixmap (xdisplay, screen, 32);
+		  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XSync");
 		  XSync (xdisplay, False);
 		  if (gdk_error_trap_pop () == 0)
 		    {
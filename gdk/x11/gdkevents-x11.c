@@ -532,6 +532,7 @@ gdk_check_wm_desktop_changed (GdkWindow *window)
 
   type = None;
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), 
                       GDK_WINDOW_XID (window),
                       gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_DESKTOP"),
@@ -576,6 +577,7 @@ gdk_check_wm_state_changed (GdkWindow *window)
 
   type = None;
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_WINDOW_XID (window),
 		      gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE"),
 		      0, G_MAXLONG, False, XA_ATOM, &type, &format, &nitems,
@@ -1924,6 +1926,7 @@ gdk_event_translate (GdkDisplay *display,
 	      Window child_window = 0;
 
 	      gdk_error_trap_push ();
+	      GDK_X11_NOTE_ROUNDTRIP (GDK_DRAWABLE_XDISPLAY (window), "XTranslateCoordinates");
 	      if (XTranslateCoordinates (GDK_DRAWABLE_XDISPLAY (window),
 					 GDK_DRAWABLE_XID (window),
 					 screen_x11->xroot_window,
@@ -1986,6 +1989,11 @@ gdk_event_translate (GdkDisplay *display,
 	  if (xevent->xproperty.atom == gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_DESKTOP"))
 	    gdk_check_wm_desktop_changed (window);
 	}
+
+      /* Only the window manager sets this one, so it is never our own change */
+      if (toplevel &&
+	  xevent->xproperty.atom == gdk_x11_get_xatom_by_name_for_display (display, "_NET_FRAME_EXTENTS"))
+	_gdk_x11_window_update_frame_extents (window);
       
       if (window_private->event_mask & GDK_PROPERTY_CHANGE_MASK) 
 	{
@@ -2324,6 +2332,9 @@ gdk_wm_protocols_filter (GdkXEvent *xev,
   return GDK_FILTER_CONTINUE;
 }
 
+/* How many events to read ahead for event compression */
+#define MAX_COMPRESS_LOOKAHEAD 64
+
 void
 _gdk_events_queue (GdkDisplay *display)
 {
@@ -2331,8 +2342,12 @@ _gdk_events_queue (GdkDisplay *display)
   GdkEvent *event;
   XEvent xevent;
   Display *xdisplay = GDK_DISPLAY_XDISPLAY (display);
+  gint lookahead = 0;
 
-  while (!_gdk_event_queue_find_first(display) && XPending (xdisplay))
+  while ((!_gdk_event_queue_find_first(display) ||
+	  (_gdk_event_queue_wants_more (display) &&
+	   lookahead++ < MAX_COMPRESS_LOOKAHEAD)) &&
+	 XPending (xdisplay))
     {
       XNextEvent (xdisplay, &xevent);
 
@@ -2492,6 +2507,7 @@ gdk_event_send_client_message_to_all_recurse (GdkDisplay *display,
   
   gdk_error_trap_push ();
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), xid, 
 			  gdk_x11_get_xatom_by_name_for_display (display, "WM_STATE"),
 			  0, 0, False, AnyPropertyType,
@@ -2506,6 +2522,7 @@ gdk_event_send_client_message_to_all_recurse (GdkDisplay *display,
   else
     {
       /* OK, we're all set, now let's find some windows to send this to */
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XQueryTree");
       if (!XQueryTree (GDK_DISPLAY_XDISPLAY (display), xid,
 		      &ret_root, &ret_parent,
 		      &ret_children, &ret_nchildren))	
@@ -2603,6 +2620,7 @@ gdk_flush (void)
   
   while (tmp_list)
     {
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (tmp_list->data), "XSync");
       XSync (GDK_DISPLAY_XDISPLAY (tmp_list->data), False);
       tmp_list = tmp_list->next;
     }
@@ -2663,19 +2681,69 @@ gdk_x11_get_server_time (GdkWindow *window)
   return xevent.xproperty.time;
 }
 
+static void
+set_net_wm_check_window (GdkScreen *screen,
+			 Window     xwindow)
+{
+  GdkScreenX11 *screen_x11 = GDK_SCREEN_X11 (screen);
+  gint error;
+
+  if (screen_x11->wmspec_check_window == xwindow)
+    return;
+
+  gdk_error_trap_push ();
+
+  /* Find out if this WM goes away, so we can reset everything. */
+  XSelectInput (screen_x11->xdisplay, xwindow, StructureNotifyMask);
+  gdk_display_sync (screen_x11->display);
+
+  error = gdk_error_trap_pop ();
+  if (!error)
+    {
+      screen_x11->wmspec_check_window = xwindow;
+      screen_x11->need_refetch_net_supported = TRUE;
+      screen_x11->need_refetch_wm_name = TRUE;
+
+      /* Careful, reentrancy */
+      _gdk_x11_screen_window_manager_changed (GDK_SCREEN (screen_x11));
+    }
+  else if (error == BadWindow)
+    {
+      /* Leftover property, try again immediately, new wm may be starting up */
+      screen_x11->last_wmspec_check_time = 0;
+    }
+}
+
+static void
+net_wm_check_window_fetched (GdkDisplay *display,
+			     Window      xroot,
+			     Atom        type,
+			     gint        format,
+			     gulong      n_items,
+			     guchar     *value,
+			     gpointer    data)
+{
+  GdkScreen *screen = data;
+
+  if (!display->closed && type == XA_WINDOW && n_items == 1)
+    set_net_wm_check_window (screen, *(Window *)value);
+
+  g_object_unref (screen);
+}
+
 static void
 fetch_net_wm_check_window (GdkScreen *screen)
 {
   GdkScreenX11 *screen_x11;
   GdkDisplay *display;
+  Atom check_atom;
   Atom type;
   gint format;
   gulong n_items;
   gulong bytes_after;
   guchar *data;
-  Window *xwindow;
   GTimeVal tv;
-  gint error;
+  gboolean checked_before;
 
   screen_x11 = GDK_SCREEN_X11 (screen);
   display = screen_x11->display;
@@ -2687,52 +2755,38 @@ fetch_net_wm_check_window (GdkScreen *screen)
   if (ABS  (tv.tv_sec - screen_x11->last_wmspec_check_time) < 15)
     return; /* we've checked recently */
 
+  checked_before = screen_x11->last_wmspec_check_time != 0;
   screen_x11->last_wmspec_check_time = tv.tv_sec;
 
-  data = NULL;
-  XGetWindowProperty (screen_x11->xdisplay, screen_x11->xroot_window,
-		      gdk_x11_get_xatom_by_name_for_display (display, "_NET_SUPPORTING_WM_CHECK"),
-		      0, G_MAXLONG, False, XA_WINDOW, &type, &format,
-		      &n_items, &bytes_after, &data);
-  
-  if (type != XA_WINDOW)
-    {
-      if (data)
-        XFree (data);
-      return;
-    }
-
-  xwindow = (Window *)data;
+  check_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_SUPPORTING_WM_CHECK");
 
-  if (screen_x11->wmspec_check_window == *xwindow)
+  /* Once we know about the window manager, checking whether it
+   * changed doesn't need to hold up the caller: the answer of the
+   * last check is good until the reply arrives. A window manager
+   * that goes away is noticed right away anyway, by the destruction
+   * of its check window.
+   */
+  if (checked_before)
     {
-      XFree (xwindow);
+      _gdk_x11_get_property_async (display, screen_x11->xroot_window,
+				   check_atom, XA_WINDOW, 1,
+				   net_wm_check_window_fetched,
+				   g_object_ref (screen));
       return;
     }
 
-  gdk_error_trap_push ();
-
-  /* Find out if this WM goes away, so we can reset everything. */
-  XSelectInput (screen_x11->xdisplay, *xwindow, StructureNotifyMask);
-  gdk_display_sync (display);
-
-  error = gdk_error_trap_pop ();
-  if (!error)
-    {
-      screen_x11->wmspec_check_window = *xwindow;
-      screen_x11->need_refetch_net_supported = TRUE;
-      screen_x11->need_refetch_wm_name = TRUE;
-
-      /* Careful, reentrancy */
-      _gdk_x11_screen_window_manager_changed (GDK_SCREEN (screen_x11));
-    }
-  else if (error == BadWindow)
-    {
-      /* Leftover property, try again immediately, new wm may be starting up */
-      screen_x11->last_wmspec_check_time = 0;
-    }
+  data = NULL;
+  GDK_X11_NOTE_ROUNDTRIP (screen_x11->xdisplay, "XGetWindowProperty");
+  XGetWindowProperty (screen_x11->xdisplay, screen_x11->xroot_window,
+		      check_atom,
+		      0, G_MAXLONG, False, XA_WINDOW, &type, &format,
+		      &n_items, &bytes_after, &data);
+  
+  if (type == XA_WINDOW)
+    set_net_wm_check_window (screen, *(Window *)data);
 
-  XFree (xwindow);
+  if (data)
+    XFree (data);
 }
 
 /**
@@ -2779,6 +2833,7 @@ gdk_x11_screen_get_window_manager_name (GdkScreen *screen)
 
 	  gdk_error_trap_push ();
           
+          GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (screen_x11->display), "XGetWindowProperty");
           XGetWindowProperty (GDK_DISPLAY_XDISPLAY (screen_x11->display),
                               screen_x11->wmspec_check_window,
                               gdk_x11_get_xatom_by_name_for_display (screen_x11->display,
@@ -2893,6 +2948,7 @@ gdk_x11_screen_supports_net_wm_hint (GdkScreen *screen,
       supported_atoms->atoms = NULL;
       supported_atoms->n_atoms = 0;
       
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
       XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), screen_x11->xroot_window,
                           gdk_x11_get_xatom_by_name_for_display (display, "_NET_SUPPORTED"),
                           0, G_MAXLONG, False, XA_ATOM, &type, &format, 
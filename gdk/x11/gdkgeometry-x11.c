@@ -119,6 +119,7 @@ find_current_serial (Display *xdisplay)
   XEvent xev;
   gulong serial = NextRequest (xdisplay);
   
+  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XSync");
   XSync (xdisplay, False);
 
   XCheckIfEvent (xdisplay, &xev, expose_serial_predicate, (XPointer)&serial);
@@ -35,3 +35,4 @@ gboolean          _gdk_use_xshm = TRUE;  /* used as a cmd line arg */
 Display          *gdk_display = NULL;
 GdkAtom           _gdk_selection_property;
 gboolean          _gdk_synchronize = FALSE;
+gint              _gdk_x11_n_roundtrip_tracers = 0;
@@ -311,6 +311,7 @@ _gdk_image_new_for_depth (GdkScreen    *screen,
 	      gdk_error_trap_push ();
 
 	      XShmAttach (screen_x11->xdisplay, x_shm_info);
+	      GDK_X11_NOTE_ROUNDTRIP (screen_x11->xdisplay, "XSync");
 	      XSync (screen_x11->xdisplay, False);
 
 	      if (gdk_error_trap_pop ())
@@ -430,6 +431,7 @@ get_full_image (GdkDrawable    *drawable,
 
   impl = GDK_DRAWABLE_IMPL_X11 (drawable);
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (impl->screen), "XGetImage");
   ximage = XGetImage (GDK_SCREEN_XDISPLAY (impl->screen),
 		      impl->xid,
 		      src_x, src_y, width, height,
@@ -518,6 +520,7 @@ _gdk_x11_copy_to_image (GdkDrawable    *drawable,
 	  
 	  XCopyArea (xdisplay, impl->xid, shm_pixmap, xgc,
 		     src_x, src_y, width, height, dest_x, dest_y);
+	  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XSync");
 	  XSync (xdisplay, FALSE);
 	  
 	  XFreeGC (xdisplay, xgc);
@@ -539,6 +542,7 @@ _gdk_x11_copy_to_image (GdkDrawable    *drawable,
       gdk_x11_display_grab (display);
 
       /* Translate screen area into window coordinates */
+      GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XTranslateCoordinates");
       XTranslateCoordinates (xdisplay,
 			     GDK_SCREEN_XROOTWIN (impl->screen),
 			     impl->xid,
@@ -81,6 +81,7 @@ _gdk_input_get_root_relative_geometry (GdkWindow *window,
   Window child;
   gint x,y;
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XTranslateCoordinates");
   XTranslateCoordinates (GDK_WINDOW_XDISPLAY (window),
 			 GDK_WINDOW_XWINDOW (window),
 			 GDK_WINDOW_XROOTWIN (window),
@@ -379,6 +380,7 @@ _gdk_input_common_init (GdkDisplay *display,
   /* Init XInput extension */
 
   display_x11->input_devices = NULL;
+  GDK_X11_NOTE_ROUNDTRIP (display_x11->xdisplay, "XQueryExtension");
   if (XQueryExtension (display_x11->xdisplay, "XInputExtension",
 		       &ignore, &event_base, &ignore))
     {
@@ -440,6 +440,7 @@ gdk_device_get_history  (GdkDevice         *device,
     {
       XTimeCoord *xcoords;
 
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DRAWABLE_XDISPLAY (window), "XGetMotionEvents");
       xcoords = XGetMotionEvents (GDK_DRAWABLE_XDISPLAY (window),
 				  GDK_DRAWABLE_XID (impl_window),
 				  start, stop, &tmp_n_events);
@@ -69,6 +69,14 @@ struct _DirectionCacheEntry
   PangoDirection direction;
 };
 
+typedef struct _KeyvalIndexEntry KeyvalIndexEntry;
+
+struct _KeyvalIndexEntry
+{
+  guint keyval;
+  GdkKeymapKey key;
+};
+
 struct _GdkKeymapX11
 {
   GdkKeymap     parent_instance;
@@ -88,6 +96,14 @@ struct _GdkKeymapX11
   guint caps_lock_state : 1;
   guint current_serial;
 
+  /* Every key of the keymap, sorted by the keyval it generates, for
+   * gdk_keymap_get_entries_for_keyval(). Rebuilt when the keymap
+   * changes.
+   */
+  KeyvalIndexEntry *keyval_index;
+  guint n_keyval_index;
+  guint keyval_index_serial;
+
 #ifdef HAVE_XKB
   XkbDescPtr xkb_desc;
   /* We cache the directions */
@@ -167,6 +183,10 @@ gdk_keymap_x11_init (GdkKeymapX11 *keymap)
   keymap->have_direction = FALSE;
   keymap->current_serial = 0;
 
+  keymap->keyval_index = NULL;
+  keymap->n_keyval_index = 0;
+  keymap->keyval_index_serial = G_MAXUINT; /* not built yet */
+
 #ifdef HAVE_XKB
   keymap->xkb_desc = NULL;
   keymap->current_group_atom = 0;
@@ -186,6 +206,8 @@ gdk_keymap_x11_finalize (GObject *object)
   if (keymap_x11->mod_keymap)
     XFreeModifiermap (keymap_x11->mod_keymap);
 
+  g_free (keymap_x11->keyval_index);
+
 #ifdef HAVE_XKB
   if (keymap_x11->xkb_desc)
     XkbFreeKeyboard (keymap_x11->xkb_desc, XkbAllComponentsMask, True);
@@ -223,7 +245,10 @@ update_modmap (Display      *display,
 
   if (!vmods[0].atom)
     for (i = 0; vmods[i].name; i++)
-      vmods[i].atom = XInternAtom (display, vmods[i].name, FALSE);
+      {
+        GDK_X11_NOTE_ROUNDTRIP (display, "XInternAtom");
+        vmods[i].atom = XInternAtom (display, vmods[i].name, FALSE);
+      }
 
   for (i = 0; i < 8; i++)
     keymap_x11->modmap[i] = 1 << i;
@@ -376,6 +401,7 @@ update_keymaps (GdkKeymapX11 *keymap_x11)
       if (keymap_x11->mod_keymap)
         XFreeModifiermap (keymap_x11->mod_keymap);
       
+      GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XGetKeyboardMapping");
       keymap_x11->keymap = XGetKeyboardMapping (xdisplay, keymap_x11->min_keycode,
 						keymap_x11->max_keycode - keymap_x11->min_keycode + 1,
 						&keymap_x11->keysyms_per_keycode);
@@ -838,55 +864,56 @@ gdk_keymap_get_caps_lock_state (GdkKeymap *keymap)
 }
 
 
-/**
- * gdk_keymap_get_entries_for_keyval:
- * @keymap: (allow-none): a #GdkKeymap, or %NULL to use the default keymap
- * @keyval: a keyval, such as %GDK_a, %GDK_Up, %GDK_Return, etc.
- * @keys: (out): return location for an array of #GdkKeymapKey
- * @n_keys: (out): return location for number of elements in returned array
- *
- * Obtains a list of keycode/group/level combinations that will
- * generate @keyval. Groups and levels are two kinds of keyboard mode;
- * in general, the level determines whether the top or bottom symbol
- * on a key is used, and the group determines whether the left or
- * right symbol is used. On US keyboards, the shift key changes the
- * keyboard level, and there are no groups. A group switch key might
- * convert a keyboard between Hebrew to English modes, for example.
- * #GdkEventKey contains a %group field that indicates the active
- * keyboard group. The level is computed from the modifier mask.
- * The returned array should be freed
- * with g_free().
- *
- * Note that passing %NULL for @keymap is deprecated and will stop
- * to work in GTK+ 3.0. Use gdk_keymap_get_for_display() instead.
- *
- * Return value: %TRUE if keys were found and returned
- **/
-gboolean
-gdk_keymap_get_entries_for_keyval (GdkKeymap     *keymap,
-                                   guint          keyval,
-                                   GdkKeymapKey **keys,
-                                   gint          *n_keys)
+static gint
+compare_keyval_index_entries (gconstpointer a,
+                              gconstpointer b)
 {
-  GArray *retval;
-  GdkKeymapX11 *keymap_x11;
+  const KeyvalIndexEntry *entry_a = a;
+  const KeyvalIndexEntry *entry_b = b;
 
-  g_return_val_if_fail (keymap == NULL || GDK_IS_KEYMAP (keymap), FALSE);
-  g_return_val_if_fail (keys != NULL, FALSE);
-  g_return_val_if_fail (n_keys != NULL, FALSE);
-  g_return_val_if_fail (keyval != 0, FALSE);
+  if (entry_a->keyval != entry_b->keyval)
+    return entry_a->keyval < entry_b->keyval ? -1 : 1;
 
-  keymap = GET_EFFECTIVE_KEYMAP (keymap);
-  keymap_x11 = GDK_KEYMAP_X11 (keymap);
-  
-  retval = g_array_new (FALSE, FALSE, sizeof (GdkKeymapKey));
+  /* Keep the order in which the keymap lists the keys */
+  if (entry_a->key.keycode != entry_b->key.keycode)
+    return entry_a->key.keycode < entry_b->key.keycode ? -1 : 1;
+
+  if (entry_a->key.group != entry_b->key.group)
+    return entry_a->key.group < entry_b->key.group ? -1 : 1;
+
+  return entry_a->key.level - entry_b->key.level;
+}
+
+/* Returns the keys of the keymap sorted by keyval, building the index
+ * first if the keymap changed since it was last built.
+ */
+static const KeyvalIndexEntry *
+get_keyval_index (GdkKeymapX11 *keymap_x11,
+                  guint        *n_entries)
+{
+  GArray *entries;
 
 #ifdef HAVE_XKB
-  if (KEYMAP_USE_XKB (keymap))
+  if (KEYMAP_USE_XKB (GDK_KEYMAP (keymap_x11)))
+    get_xkb (keymap_x11);
+  else
+#endif
+    update_keymaps (keymap_x11);
+
+  if (keymap_x11->keyval_index_serial == keymap_x11->current_serial)
+    {
+      *n_entries = keymap_x11->n_keyval_index;
+      return keymap_x11->keyval_index;
+    }
+
+  entries = g_array_new (FALSE, FALSE, sizeof (KeyvalIndexEntry));
+
+#ifdef HAVE_XKB
+  if (KEYMAP_USE_XKB (GDK_KEYMAP (keymap_x11)))
     {
       /* See sec 15.3.4 in XKB docs */
 
-      XkbDescRec *xkb = get_xkb (keymap_x11);
+      XkbDescRec *xkb = keymap_x11->xkb_desc;
       gint keycode;
       
       keycode = keymap_x11->min_keycode;
@@ -911,19 +938,16 @@ gdk_keymap_get_entries_for_keyval (GdkKeymap     *keymap,
               /* check out our cool loop invariant */
               g_assert (i == (group * max_shift_levels + level));
 
-              if (entry[i] == keyval)
+              if (entry[i] != NoSymbol)
                 {
-                  /* Found a match */
-                  GdkKeymapKey key;
+                  KeyvalIndexEntry index_entry;
 
-                  key.keycode = keycode;
-                  key.group = group;
-                  key.level = level;
+                  index_entry.keyval = entry[i];
+                  index_entry.key.keycode = keycode;
+                  index_entry.key.group = group;
+                  index_entry.key.level = level;
 
-                  g_array_append_val (retval, key);
-
-                  g_assert (XkbKeySymEntry (xkb, keycode, level, group) == 
-			    keyval);
+                  g_array_append_val (entries, index_entry);
                 }
 
               ++level;
@@ -943,7 +967,7 @@ gdk_keymap_get_entries_for_keyval (GdkKeymap     *keymap,
   else
 #endif
     {
-      const KeySym *map = get_keymap (keymap_x11);
+      const KeySym *map = keymap_x11->keymap;
       gint keycode;
       
       keycode = keymap_x11->min_keycode;
@@ -954,18 +978,18 @@ gdk_keymap_get_entries_for_keyval (GdkKeymap     *keymap,
 
           while (i < keymap_x11->keysyms_per_keycode)
             {
-              if (syms[i] == keyval)
+              if (syms[i] != NoSymbol)
                 {
-                  /* found a match */
-                  GdkKeymapKey key;
+                  KeyvalIndexEntry index_entry;
 
-                  key.keycode = keycode;
+                  index_entry.keyval = syms[i];
+                  index_entry.key.keycode = keycode;
 
                   /* The "classic" non-XKB keymap has 2 levels per group */
-                  key.group = i / 2;
-                  key.level = i % 2;
+                  index_entry.key.group = i / 2;
+                  index_entry.key.level = i % 2;
 
-                  g_array_append_val (retval, key);
+                  g_array_append_val (entries, index_entry);
                 }
               
               ++i;
@@ -975,18 +999,90 @@ gdk_keymap_get_entries_for_keyval (GdkKeymap     *keymap,
         }
     }
 
-  if (retval->len > 0)
+  g_array_sort (entries, compare_keyval_index_entries);
+
+  g_free (keymap_x11->keyval_index);
+  keymap_x11->n_keyval_index = entries->len;
+  keymap_x11->keyval_index = (KeyvalIndexEntry *) g_array_free (entries, FALSE);
+  keymap_x11->keyval_index_serial = keymap_x11->current_serial;
+
+  *n_entries = keymap_x11->n_keyval_index;
+  return keymap_x11->keyval_index;
+}
+
+/**
+ * gdk_keymap_get_entries_for_keyval:
+ * @keymap: (allow-none): a #GdkKeymap, or %NULL to use the default keymap
+ * @keyval: a keyval, such as %GDK_a, %GDK_Up, %GDK_Return, etc.
+ * @keys: (out): return location for an array of #GdkKeymapKey
+ * @n_keys: (out): return location for number of elements in returned array
+ *
+ * Obtains a list of keycode/group/level combinations that will
+ * generate @keyval. Groups and levels are two kinds of keyboard mode;
+ * in general, the level determines whether the top or bottom symbol
+ * on a key is used, and the group determines whether the left or
+ * right symbol is used. On US keyboards, the shift key changes the
+ * keyboard level, and there are no groups. A group switch key might
+ * convert a keyboard between Hebrew to English modes, for example.
+ * #GdkEventKey contains a %group field that indicates the active
+ * keyboard group. The level is computed from the modifier mask.
+ * The returned array should be freed
+ * with g_free().
+ *
+ * Note that passing %NULL for @keymap is deprecated and will stop
+ * to work in GTK+ 3.0. Use gdk_keymap_get_for_display() instead.
+ *
+ * Return value: %TRUE if keys were found and returned
+ **/
+gboolean
+gdk_keymap_get_entries_for_keyval (GdkKeymap     *keymap,
+                                   guint          keyval,
+                                   GdkKeymapKey **keys,
+                                   gint          *n_keys)
+{
+  GdkKeymapX11 *keymap_x11;
+  const KeyvalIndexEntry *entries;
+  guint n_entries;
+  guint first, last;
+  guint i;
+
+  g_return_val_if_fail (keymap == NULL || GDK_IS_KEYMAP (keymap), FALSE);
+  g_return_val_if_fail (keys != NULL, FALSE);
+  g_return_val_if_fail (n_keys != NULL, FALSE);
+  g_return_val_if_fail (keyval != 0, FALSE);
+
+  keymap = GET_EFFECTIVE_KEYMAP (keymap);
+  keymap_x11 = GDK_KEYMAP_X11 (keymap);
+
+  entries = get_keyval_index (keymap_x11, &n_entries);
+
+  /* Find the first entry for keyval */
+  first = 0;
+  last = n_entries;
+  while (first < last)
     {
-      *keys = (GdkKeymapKey*) retval->data;
-      *n_keys = retval->len;
+      guint middle = (first + last) / 2;
+
+      if (entries[middle].keyval < keyval)
+        first = middle + 1;
+      else
+        last = middle;
     }
-  else
+
+  for (last = first; last < n_entries && entries[last].keyval == keyval; last++)
+    ;
+
+  *n_keys = last - first;
+
+  if (last > first)
     {
-      *keys = NULL;
-      *n_keys = 0;
+      *keys = g_new (GdkKeymapKey, last - first);
+
+      for (i = first; i < last; i++)
+        (*keys)[i - first] = entries[i].key;
     }
-      
-  g_array_free (retval, retval->len > 0 ? FALSE : TRUE);
+  else
+    *keys = NULL;
 
   return *n_keys > 0;
 }
@@ -215,14 +215,17 @@ _gdk_windowing_pointer_grab (GdkWindow *window,
 	    return_val = GrabSuccess;
 	  else
 #endif
-	    return_val = XGrabPointer (GDK_WINDOW_XDISPLAY (native),
-				       xwindow,
-				       owner_events,
-				       xevent_mask,
-				       GrabModeAsync, GrabModeAsync,
-				       xconfine_to,
-				       xcursor,
-				       time);
+	    {
+	      GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (native), "XGrabPointer");
+	      return_val = XGrabPointer (GDK_WINDOW_XDISPLAY (native),
+					 xwindow,
+					 owner_events,
+					 xevent_mask,
+					 GrabModeAsync, GrabModeAsync,
+					 xconfine_to,
+					 xcursor,
+					 time);
+	    }
 	}
       else
 	return_val = AlreadyGrabbed;
@@ -288,11 +291,14 @@ gdk_keyboard_grab (GdkWindow *	   window,
 	return_val = GrabSuccess;
       else
 #endif
-	return_val = XGrabKeyboard (GDK_WINDOW_XDISPLAY (native),
-				    GDK_WINDOW_XID (native),
-				    owner_events,
-				    GrabModeAsync, GrabModeAsync,
-				    time);
+	{
+	  GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (native), "XGrabKeyboard");
+	  return_val = XGrabKeyboard (GDK_WINDOW_XDISPLAY (native),
+				      GDK_WINDOW_XID (native),
+				      owner_events,
+				      GrabModeAsync, GrabModeAsync,
+				      time);
+	}
 	if (G_UNLIKELY (!display_x11->trusted_client && 
 			return_val == AlreadyGrabbed))
 	  /* we can't grab the keyboard, but we can do a GTK-local grab */
@@ -653,6 +659,7 @@ _gdk_send_xevent (GdkDisplay *display,
   gdk_error_trap_push ();
   result = XSendEvent (GDK_DISPLAY_XDISPLAY (display), window, 
 		       propagate, event_mask, event_send);
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XSync");
   XSync (GDK_DISPLAY_XDISPLAY (display), False);
   
   if (gdk_error_trap_pop ())
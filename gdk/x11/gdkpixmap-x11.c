@@ -326,6 +326,7 @@ gdk_pixmap_foreign_new_for_display (GdkDisplay      *display,
   /* set the pixmap to the passed in value */
   xpixmap = anid;
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetGeometry");
   /* get information about the Pixmap to fill in the structure for
      the gdk window */
   if (!XGetGeometry (GDK_DISPLAY_XDISPLAY (display),
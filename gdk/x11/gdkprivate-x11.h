@@ -173,6 +173,7 @@ gboolean _gdk_x11_display_is_root_window (GdkDisplay *display,
 void _gdk_x11_precache_atoms (GdkDisplay          *display,
 			      const gchar * const *atom_names,
 			      gint                 n_atoms);
+void _gdk_x11_precache_known_atoms (GdkDisplay *display);
 
 void _gdk_x11_events_init_screen   (GdkScreen *screen);
 void _gdk_x11_events_uninit_screen (GdkScreen *screen);
@@ -195,12 +196,28 @@ gboolean _gdk_x11_get_xft_setting (GdkScreen   *screen,
 				   const gchar *name,
 				   GValue      *value);
 
+void _gdk_x11_note_roundtrip         (Display     *xdisplay,
+                                      const gchar *function,
+                                      const gchar *request);
+void _gdk_x11_display_dump_roundtrips (GdkDisplay  *display,
+                                      Window       mapped_window);
+
+/* Records that the caller is about to wait for a reply to @request,
+ * if round trips are being traced on any display.
+ */
+#define GDK_X11_NOTE_ROUNDTRIP(xdisplay, request)			\
+  G_STMT_START {							\
+    if (G_UNLIKELY (_gdk_x11_n_roundtrip_tracers > 0))			\
+      _gdk_x11_note_roundtrip ((xdisplay), G_STRFUNC, (request));	\
+  } G_STMT_END
+
 extern GdkDrawableClass  _gdk_x11_drawable_class;
 extern gboolean	         _gdk_use_xshm;
 extern const int         _gdk_nenvent_masks;
 extern const int         _gdk_event_mask_table[];
 extern GdkAtom		 _gdk_selection_property;
 extern gboolean          _gdk_synchronize;
+extern gint              _gdk_x11_n_roundtrip_tracers;
 
 #define GDK_PIXMAP_SCREEN(pix)	      (GDK_DRAWABLE_IMPL_X11 (((GdkPixmapObject *)pix)->impl)->screen)
 #define GDK_PIXMAP_DISPLAY(pix)       (GDK_SCREEN_X11 (GDK_PIXMAP_SCREEN (pix))->display)
@@ -39,9 +39,13 @@
 #include "gdkselection.h"	/* only from predefined atom */
 #include "gdkalias.h"
 
+#include "atom-table.h"
+
 static GPtrArray *virtual_atom_array;
 static GHashTable *virtual_atom_hash;
 
+static void virtual_atom_check_init (void);
+
 static const gchar xatoms_string[] = 
   /* These are all the standard predefined X atoms */
   "\0"  /* leave a space for None, even though it is not a predefined atom */
@@ -130,6 +134,12 @@ static const gint xatoms_offset[] = {
 
 #define N_CUSTOM_PREDEFINED 1
 
+/* The atoms of atom-table.h come right after the predefined ones, so
+ * that their X atoms can be kept in an array for each display.
+ */
+#define FIRST_KNOWN_ATOM G_N_ELEMENTS (xatoms_offset)
+#define N_KNOWN_ATOMS G_N_ELEMENTS (known_atoms_offset)
+
 #define ATOM_TO_INDEX(atom) (GPOINTER_TO_UINT(atom))
 #define INDEX_TO_ATOM(atom) ((GdkAtom)GUINT_TO_POINTER(atom))
 
@@ -159,9 +169,15 @@ lookup_cached_xatom (GdkDisplay *display,
 		     GdkAtom     atom)
 {
   GdkDisplayX11 *display_x11 = GDK_DISPLAY_X11 (display);
+  guint index = ATOM_TO_INDEX (atom);
+
+  if (index < G_N_ELEMENTS (xatoms_offset) - N_CUSTOM_PREDEFINED)
+    return index;
 
-  if (ATOM_TO_INDEX (atom) < G_N_ELEMENTS (xatoms_offset) - N_CUSTOM_PREDEFINED)
-    return ATOM_TO_INDEX (atom);
+  if (index >= FIRST_KNOWN_ATOM && index < FIRST_KNOWN_ATOM + N_KNOWN_ATOMS &&
+      display_x11->known_xatoms &&
+      display_x11->known_xatoms[index - FIRST_KNOWN_ATOM] != None)
+    return display_x11->known_xatoms[index - FIRST_KNOWN_ATOM];
   
   if (display_x11->atom_from_virtual)
     return GPOINTER_TO_UINT (g_hash_table_lookup (display_x11->atom_from_virtual,
@@ -207,6 +223,7 @@ gdk_x11_atom_to_xatom_for_display (GdkDisplay *display,
 
       name = g_ptr_array_index (virtual_atom_array, ATOM_TO_INDEX (atom));
 
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XInternAtom");
       xatom = XInternAtom (GDK_DISPLAY_XDISPLAY (display), name, FALSE);
       insert_atom_pair (display, atom, xatom);
     }
@@ -244,12 +261,16 @@ _gdk_x11_precache_atoms (GdkDisplay          *display,
   if (n_xatoms)
     {
 #ifdef HAVE_XINTERNATOMS
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XInternAtoms");
       XInternAtoms (GDK_DISPLAY_XDISPLAY (display),
 		    (char **)xatom_names, n_xatoms, False, xatoms);
 #else
       for (i = 0; i < n_xatoms; i++)
-	xatoms[i] = XInternAtom (GDK_DISPLAY_XDISPLAY (display),
-				 xatom_names[i], False);
+	{
+	  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XInternAtom");
+	  xatoms[i] = XInternAtom (GDK_DISPLAY_XDISPLAY (display),
+				   xatom_names[i], False);
+	}
 #endif
     }
 
@@ -261,6 +282,89 @@ _gdk_x11_precache_atoms (GdkDisplay          *display,
   g_free (atoms);
 }
 
+static gint
+compare_known_xatoms (gconstpointer a,
+		      gconstpointer b,
+		      gpointer      data)
+{
+  const Atom *known_xatoms = data;
+  Atom xatom_a = known_xatoms[*(const guint16 *)a];
+  Atom xatom_b = known_xatoms[*(const guint16 *)b];
+
+  return xatom_a < xatom_b ? -1 : xatom_a > xatom_b;
+}
+
+/* Interns all the atoms of atom-table.h at once. This is done when
+ * the display is opened, so that they never need a round trip later.
+ */
+void
+_gdk_x11_precache_known_atoms (GdkDisplay *display)
+{
+  GdkDisplayX11 *display_x11 = GDK_DISPLAY_X11 (display);
+  const gchar *names[N_KNOWN_ATOMS];
+  guint16 *sorted;
+  gint i;
+
+  virtual_atom_check_init ();
+
+  for (i = 0; i < N_KNOWN_ATOMS; i++)
+    names[i] = known_atoms_string + known_atoms_offset[i];
+
+  display_x11->known_xatoms = g_new0 (Atom, N_KNOWN_ATOMS);
+
+#ifdef HAVE_XINTERNATOMS
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XInternAtoms");
+  XInternAtoms (GDK_DISPLAY_XDISPLAY (display),
+		(char **)names, N_KNOWN_ATOMS, False,
+		display_x11->known_xatoms);
+#else
+  for (i = 0; i < N_KNOWN_ATOMS; i++)
+    {
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XInternAtom");
+      display_x11->known_xatoms[i] = XInternAtom (GDK_DISPLAY_XDISPLAY (display),
+						  names[i], False);
+    }
+#endif
+
+  sorted = g_new (guint16, N_KNOWN_ATOMS);
+  for (i = 0; i < N_KNOWN_ATOMS; i++)
+    sorted[i] = i;
+
+  g_qsort_with_data (sorted, N_KNOWN_ATOMS, sizeof (guint16),
+		     compare_known_xatoms, display_x11->known_xatoms);
+
+  display_x11->known_atoms_by_xatom = sorted;
+}
+
+static GdkAtom
+lookup_known_atom (GdkDisplayX11 *display_x11,
+		   Atom           xatom)
+{
+  const guint16 *sorted = display_x11->known_atoms_by_xatom;
+  gint lower, upper;
+
+  if (!sorted)
+    return GDK_NONE;
+
+  lower = 0;
+  upper = N_KNOWN_ATOMS - 1;
+
+  while (lower <= upper)
+    {
+      gint middle = (lower + upper) / 2;
+      Atom middle_xatom = display_x11->known_xatoms[sorted[middle]];
+
+      if (xatom < middle_xatom)
+	upper = middle - 1;
+      else if (xatom > middle_xatom)
+	lower = middle + 1;
+      else
+	return INDEX_TO_ATOM (FIRST_KNOWN_ATOM + sorted[middle]);
+    }
+
+  return GDK_NONE;
+}
+
 /**
  * gdk_x11_atom_to_xatom:
  * @atom: A #GdkAtom 
@@ -307,8 +411,10 @@ gdk_x11_xatom_to_atom_for_display (GdkDisplay *display,
   
   if (xatom < G_N_ELEMENTS (xatoms_offset) - N_CUSTOM_PREDEFINED)
     return INDEX_TO_ATOM (xatom);
+
+  virtual_atom = lookup_known_atom (display_x11, xatom);
   
-  if (display_x11->atom_to_virtual)
+  if (!virtual_atom && display_x11->atom_to_virtual)
     virtual_atom = GDK_POINTER_TO_ATOM (g_hash_table_lookup (display_x11->atom_to_virtual,
 							     GUINT_TO_POINTER (xatom)));
   
@@ -319,6 +425,7 @@ gdk_x11_xatom_to_atom_for_display (GdkDisplay *display,
        */
       char *name;
       gdk_error_trap_push ();
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetAtomName");
       name = XGetAtomName (GDK_DISPLAY_XDISPLAY (display), xatom);
       if (gdk_error_trap_pop ())
 	{
@@ -367,6 +474,13 @@ virtual_atom_check_init (void)
 	  g_hash_table_insert (virtual_atom_hash, (gchar *)(xatoms_string + xatoms_offset[i]),
 			       GUINT_TO_POINTER (i));
 	}
+
+      for (i = 0; i < N_KNOWN_ATOMS; i++)
+	{
+	  g_ptr_array_add (virtual_atom_array, (gchar *)(known_atoms_string + known_atoms_offset[i]));
+	  g_hash_table_insert (virtual_atom_hash, (gchar *)(known_atoms_string + known_atoms_offset[i]),
+			       GUINT_TO_POINTER (FIRST_KNOWN_ATOM + i));
+	}
     }
 }
 
@@ -590,6 +704,7 @@ gdk_property_get (GdkWindow   *window,
       return FALSE;
     }
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   res = XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display),
 			    GDK_WINDOW_XWINDOW (window), xproperty,
 			    offset, get_length, pdelete,
@@ -621,6 +621,7 @@ check_is_composited (GdkDisplay *display,
   Atom xselection = gdk_x11_atom_to_xatom_for_display (display, screen_x11->cm_selection_atom);
   Window xwindow;
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetSelectionOwner");
   xwindow = XGetSelectionOwner (GDK_DISPLAY_XDISPLAY (display), xselection);
 
   return xwindow != None;
@@ -1099,6 +1100,7 @@ init_multihead (GdkScreen *screen)
   if (init_randr13 (screen))
     return;
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (screen), "XQueryExtension");
   if (XQueryExtension (GDK_SCREEN_XDISPLAY (screen), "XINERAMA",
 		       &opcode, &firstevent, &firsterror))
     {
@@ -1413,6 +1415,7 @@ gdk_screen_get_active_window (GdkScreen *screen)
 
   screen_x11 = GDK_SCREEN_X11 (screen);
 
+  GDK_X11_NOTE_ROUNDTRIP (screen_x11->xdisplay, "XGetWindowProperty");
   if (XGetWindowProperty (screen_x11->xdisplay, screen_x11->xroot_window,
 	                  gdk_x11_get_xatom_by_name_for_display (screen_x11->display,
 			                                         "_NET_ACTIVE_WINDOW"),
@@ -1484,6 +1487,7 @@ gdk_screen_get_window_stack (GdkScreen *screen)
 
   screen_x11 = GDK_SCREEN_X11 (screen);
 
+  GDK_X11_NOTE_ROUNDTRIP (screen_x11->xdisplay, "XGetWindowProperty");
   if (XGetWindowProperty (screen_x11->xdisplay, screen_x11->xroot_window,
 	                  gdk_x11_get_xatom_by_name_for_display (screen_x11->display,
 			                                         "_NET_CLIENT_LIST_STACKING"),
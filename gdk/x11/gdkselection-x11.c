@@ -181,6 +181,7 @@ gdk_selection_owner_set_for_display (GdkDisplay *display,
 
   XSetSelectionOwner (xdisplay, xselection, xwindow, time);
 
+  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XGetSelectionOwner");
   return (XGetSelectionOwner (xdisplay, xselection) == xwindow);
 }
 
@@ -213,6 +214,7 @@ gdk_selection_owner_get_for_display (GdkDisplay *display,
   if (display->closed)
     return NULL;
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetSelectionOwner");
   xwindow = XGetSelectionOwner (GDK_DISPLAY_XDISPLAY (display),
 				gdk_x11_atom_to_xatom_for_display (display, 
 								   selection));
@@ -290,6 +292,7 @@ gdk_selection_property_get (GdkWindow  *requestor,
 
   t = NULL;
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DRAWABLE_XDISPLAY (requestor), "XGetWindowProperty");
   /* We can't delete the selection here, because it might be the INCR
      protocol, in which case the client has to make sure they'll be
      notified of PropertyChange events _before_ the property is deleted.
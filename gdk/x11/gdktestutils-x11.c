@@ -146,6 +146,7 @@ gdk_test_simulate_key (GdkWindow      *window,
   if (!success)
     return FALSE;
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (xev.display, "XTranslateCoordinates");
   xev.same_screen = XTranslateCoordinates (xev.display, xev.window, xev.root,
                                            xev.x, xev.y, &xev.x_root, &xev.y_root,
                                            &xev.subwindow);
@@ -155,6 +156,7 @@ gdk_test_simulate_key (GdkWindow      *window,
   if (x >= 0 && y >= 0)
     success &= 0 != XWarpPointer (xev.display, None, xev.window, 0, 0, 0, 0, xev.x, xev.y);
   success &= 0 != XSendEvent (xev.display, xev.window, True, key_pressrelease == GDK_KEY_PRESS ? KeyPressMask : KeyReleaseMask, (XEvent*) &xev);
+  GDK_X11_NOTE_ROUNDTRIP (xev.display, "XSync");
   XSync (xev.display, False);
   success &= 0 == gdk_error_trap_pop();
   return success;
@@ -235,6 +237,7 @@ gdk_test_simulate_button (GdkWindow      *window,
   xev.state = modifiers;
   xev.button = button;
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (xev.display, "XTranslateCoordinates");
   xev.same_screen = XTranslateCoordinates (xev.display, xev.window, xev.root,
                                            xev.x, xev.y, &xev.x_root, &xev.y_root,
                                            &xev.subwindow);
@@ -243,6 +246,7 @@ gdk_test_simulate_button (GdkWindow      *window,
   success = xev.same_screen;
   success &= 0 != XWarpPointer (xev.display, None, xev.window, 0, 0, 0, 0, xev.x, xev.y);
   success &= 0 != XSendEvent (xev.display, xev.window, True, button_pressrelease == GDK_BUTTON_PRESS ? ButtonPressMask : ButtonReleaseMask, (XEvent*) &xev);
+  GDK_X11_NOTE_ROUNDTRIP (xev.display, "XSync");
   XSync (xev.display, False);
   success &= 0 == gdk_error_trap_pop();
   return success;
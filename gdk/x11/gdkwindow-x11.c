@@ -373,6 +373,7 @@ gdk_window_impl_x11_get_colormap (GdkDrawable *drawable)
       XWindowAttributes window_attributes;
       GdkVisual *visual;
 
+      GDK_X11_NOTE_ROUNDTRIP (GDK_SCREEN_XDISPLAY (drawable_impl->screen), "XGetWindowAttributes");
       XGetWindowAttributes (GDK_SCREEN_XDISPLAY (drawable_impl->screen),
                             drawable_impl->xid,
                             &window_attributes);
@@ -923,6 +924,7 @@ gdk_x11_window_foreign_new_for_display (GdkDisplay *display,
     return g_object_ref (win);
 
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (display_x11->xdisplay, "XGetWindowAttributes");
   result = XGetWindowAttributes (display_x11->xdisplay, window, &attrs);
   if (gdk_error_trap_pop () || !result)
     return NULL;
@@ -930,6 +932,7 @@ gdk_x11_window_foreign_new_for_display (GdkDisplay *display,
   /* FIXME: This is pretty expensive. Maybe the caller should supply
    *        the parent */
   gdk_error_trap_push ();
+  GDK_X11_NOTE_ROUNDTRIP (display_x11->xdisplay, "XQueryTree");
   result = XQueryTree (display_x11->xdisplay, window, &root, &parent, &children, &nchildren);
   if (gdk_error_trap_pop () || !result)
     return NULL;
@@ -954,6 +957,7 @@ gdk_x11_window_foreign_new_for_display (GdkDisplay *display,
     private->parent = (GdkWindowObject *) gdk_screen_get_root_window (draw_impl->screen);
   
   private->parent->children = g_list_prepend (private->parent->children, win);
+  _gdk_window_children_changed ((GdkWindow *) private->parent);
 
   draw_impl->xid = window;
 
@@ -1389,6 +1393,9 @@ gdk_window_x11_show (GdkWindow *window, gboolean already_mapped)
 	      display_x11->user_time != 0 &&
 	  XSERVER_TIME_IS_LATER (display_x11->user_time, toplevel->user_time))
 	gdk_x11_window_set_user_time (window, display_x11->user_time);
+
+      if (display_x11->roundtrip_sites)
+        _gdk_x11_display_dump_roundtrips (display, xwindow);
     }
   
   unset_bg = !private->input_only &&
@@ -1840,6 +1847,7 @@ move_to_current_desktop (GdkWindow *window)
       
       display = gdk_drawable_get_display (window);
 
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
       /* Get current desktop, then set it; this is a race, but not
        * one that matters much in practice.
        */
@@ -2114,6 +2122,7 @@ gdk_window_get_type_hint (GdkWindow *window)
 
   display = gdk_drawable_get_display (window);
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_WINDOW_XID (window),
                           gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_WINDOW_TYPE"),
                           0, G_MAXLONG, False, XA_ATOM, &type_return,
@@ -2842,6 +2851,7 @@ gdk_window_x11_get_geometry (GdkWindow *window,
   
   if (!GDK_WINDOW_DESTROYED (window))
     {
+      GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XGetGeometry");
       XGetGeometry (GDK_WINDOW_XDISPLAY (window),
 		    GDK_WINDOW_XID (window),
 		    &root, &tx, &ty, &twidth, &theight, &tborder_width, &tdepth);
@@ -2871,6 +2881,7 @@ gdk_window_x11_get_root_coords (GdkWindow *window,
   gint tx;
   gint ty;
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XTranslateCoordinates");
   return_val = XTranslateCoordinates (GDK_WINDOW_XDISPLAY (window),
 				      GDK_WINDOW_XID (window),
 				      GDK_WINDOW_XROOTWIN (window),
@@ -2902,6 +2913,7 @@ gdk_window_x11_get_deskrelative_origin (GdkWindow *window,
 						"ENLIGHTENMENT_DESKTOP");
   win = GDK_WINDOW_XID (window);
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XQueryTree");
   while (XQueryTree (GDK_WINDOW_XDISPLAY (window), win, &root, &parent,
 		     &child, (unsigned int *)&num_children))
     {
@@ -2917,6 +2929,7 @@ gdk_window_x11_get_deskrelative_origin (GdkWindow *window,
 	break;
       
       data_return = NULL;
+      GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XGetWindowProperty");
       XGetWindowProperty (GDK_WINDOW_XDISPLAY (window), win, atom, 0, 0,
 			  False, XA_CARDINAL, &type_return, &format_return,
 			  &number_return, &bytes_after_return, &data_return);
@@ -2926,8 +2939,11 @@ gdk_window_x11_get_deskrelative_origin (GdkWindow *window,
 	  XFree (data_return);
 	  break;
 	}
+
+      GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XQueryTree");
     }
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XTranslateCoordinates");
   return_val = XTranslateCoordinates (GDK_WINDOW_XDISPLAY (window),
 				      GDK_WINDOW_XID (window),
 				      win,
@@ -2963,6 +2979,57 @@ gdk_window_get_root_origin (GdkWindow *window,
     *y = rect.y;
 }
 
+static void
+frame_extents_fetched (GdkDisplay *display,
+		       Window      xwindow,
+		       Atom        type,
+		       gint        format,
+		       gulong      n_items,
+		       guchar     *value,
+		       gpointer    data)
+{
+  GdkWindow *window;
+  GdkToplevelX11 *toplevel;
+
+  window = gdk_window_lookup_for_display (display, xwindow);
+  if (window == NULL || GDK_WINDOW_DESTROYED (window))
+    return;
+
+  toplevel = _gdk_x11_window_get_toplevel (window);
+  if (toplevel == NULL)
+    return;
+
+  if (type == XA_CARDINAL && format == 32 && n_items == 4)
+    {
+      memcpy (toplevel->frame_extents, value, sizeof (toplevel->frame_extents));
+      toplevel->have_frame_extents = TRUE;
+    }
+  else
+    toplevel->have_frame_extents = FALSE;
+}
+
+/**
+ * _gdk_x11_window_update_frame_extents:
+ * @window: a toplevel #GdkWindow
+ *
+ * Called when _NET_FRAME_EXTENTS of @window changes. The new value is
+ * fetched without waiting for it, so that gdk_window_get_frame_extents()
+ * can be answered without a round trip later on.
+ **/
+void
+_gdk_x11_window_update_frame_extents (GdkWindow *window)
+{
+  GdkDisplay *display = GDK_WINDOW_DISPLAY (window);
+
+  /* Deletions are fetched too, so that the replies, which arrive in
+   * order, always end with the current state.
+   */
+  _gdk_x11_get_property_async (display, GDK_WINDOW_XID (window),
+			       gdk_x11_get_xatom_by_name_for_display (display, "_NET_FRAME_EXTENTS"),
+			       XA_CARDINAL, 4,
+			       frame_extents_fetched, NULL);
+}
+
 /**
  * gdk_window_get_frame_extents:
  * @window: a toplevel #GdkWindow
@@ -3020,6 +3087,20 @@ gdk_window_get_frame_extents (GdkWindow    *window,
   if (GDK_WINDOW_DESTROYED (private) || impl->override_redirect)
     return;
 
+  /* Our position is kept up to date by configure events, so with the
+   * extents of the frame known there is nothing to ask the server.
+   */
+  if (impl->toplevel && impl->toplevel->have_frame_extents)
+    {
+      gulong *extents = impl->toplevel->frame_extents;
+
+      rect->x -= extents[0];
+      rect->y -= extents[2];
+      rect->width += extents[0] + extents[1];
+      rect->height += extents[2] + extents[3];
+      return;
+    }
+
   nvroots = 0;
   vroots = NULL;
 
@@ -3029,6 +3110,7 @@ gdk_window_get_frame_extents (GdkWindow    *window,
   xwindow = GDK_WINDOW_XID (window);
 
   /* first try: use _NET_FRAME_EXTENTS */
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), xwindow,
 			  gdk_x11_get_xatom_by_name_for_display (display,
 								 "_NET_FRAME_EXTENTS"),
@@ -3044,15 +3126,26 @@ gdk_window_get_frame_extents (GdkWindow    *window,
 	  got_frame_extents = TRUE;
 
 	  /* try to get the real client window geometry */
+	  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetGeometry");
 	  if (XGetGeometry (GDK_DISPLAY_XDISPLAY (display), xwindow,
-			    &root, &wx, &wy, &ww, &wh, &wb, &wd) &&
-              XTranslateCoordinates (GDK_DISPLAY_XDISPLAY (display),
-	  			     xwindow, root, 0, 0, &wx, &wy, &child))
-            {
-	      rect->x = wx;
-	      rect->y = wy;
-	      rect->width = ww;
-	      rect->height = wh;
+			    &root, &wx, &wy, &ww, &wh, &wb, &wd))
+	    {
+	      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XTranslateCoordinates");
+	      if (XTranslateCoordinates (GDK_DISPLAY_XDISPLAY (display),
+					 xwindow, root, 0, 0, &wx, &wy, &child))
+		{
+		  rect->x = wx;
+		  rect->y = wy;
+		  rect->width = ww;
+		  rect->height = wh;
+		}
+	    }
+
+	  if (impl->toplevel)
+	    {
+	      memcpy (impl->toplevel->frame_extents, ldata,
+		      sizeof (impl->toplevel->frame_extents));
+	      impl->toplevel->have_frame_extents = TRUE;
 	    }
 
 	  /* _NET_FRAME_EXTENTS format is left, right, top, bottom */
@@ -3076,6 +3169,7 @@ gdk_window_get_frame_extents (GdkWindow    *window,
   /* use NETWM_VIRTUAL_ROOTS if available */
   root = GDK_WINDOW_XROOTWIN (window);
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), root,
 			  gdk_x11_get_xatom_by_name_for_display (display, 
 								 "_NET_VIRTUAL_ROOTS"),
@@ -3097,6 +3191,7 @@ gdk_window_get_frame_extents (GdkWindow    *window,
     {
       xwindow = xparent;
 
+      GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XQueryTree");
       if (!XQueryTree (GDK_DISPLAY_XDISPLAY (display), xwindow,
 		       &root, &xparent,
 		       &children, &nchildren))
@@ -3117,6 +3212,7 @@ gdk_window_get_frame_extents (GdkWindow    *window,
     }
   while (xparent != root);
   
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetGeometry");
   if (XGetGeometry (GDK_DISPLAY_XDISPLAY (display), xwindow, 
 		    &root, &wx, &wy, &ww, &wh, &wb, &wd))
     {
@@ -3160,6 +3256,7 @@ _gdk_windowing_get_pointer (GdkDisplay       *display,
   
   if (G_LIKELY (GDK_DISPLAY_X11 (display)->trusted_client)) 
     {
+      GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryPointer");
       XQueryPointer (xdisplay, xwindow,
 		     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
     } 
@@ -3171,6 +3268,7 @@ _gdk_windowing_get_pointer (GdkDisplay       *display,
       w = XCreateWindow (xdisplay, xwindow, 0, 0, 1, 1, 0, 
 			 CopyFromParent, InputOnly, CopyFromParent, 
 			 0, &attributes);
+      GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryPointer");
       XQueryPointer (xdisplay, w, 
 		     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
       XDestroyWindow (xdisplay, w);
@@ -3210,6 +3308,7 @@ gdk_window_x11_get_pointer (GdkWindow       *window,
     {
       if (G_LIKELY (GDK_DISPLAY_X11 (display)->trusted_client))
 	{
+	  GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XQueryPointer");
 	  if (XQueryPointer (GDK_WINDOW_XDISPLAY (window),
 			     GDK_WINDOW_XID (window),
 			     &root, &child, &rootx, &rooty, &winx, &winy, &xmask))
@@ -3304,6 +3403,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
   gdk_x11_display_grab (display);
   if (G_LIKELY (GDK_DISPLAY_X11 (display)->trusted_client)) 
     {
+      GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryPointer");
       XQueryPointer (xdisplay, xwindow,
 		     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
       if (root == xwindow)
@@ -3314,6 +3414,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
       while (xwindow)
 	{
 	  xwindow_last = xwindow;
+	  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryPointer");
 	  XQueryPointer (xdisplay, xwindow,
 			 &root, &xwindow, &rootx, &rooty, &winx, &winy, &xmask);
 	  if (get_toplevel && xwindow_last != root &&
@@ -3340,6 +3441,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
 	  window = GDK_WINDOW (list->data);
 	  xwindow = GDK_WINDOW_XWINDOW (window);
 	  gdk_error_trap_push ();
+	  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryPointer");
 	  XQueryPointer (xdisplay, xwindow,
 			 &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
 	  gdk_flush ();
@@ -3361,6 +3463,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
 				 CopyFromParent, InputOnly, CopyFromParent, 
 				 0, &attributes);
 	      XMapWindow (xdisplay, w);
+	      GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryPointer");
 	      XQueryPointer (xdisplay, xwindow, 
 			     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
 	      XDestroyWindow (xdisplay, w);
@@ -3381,6 +3484,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
 	{
 	  xwindow_last = xwindow;
 	  gdk_error_trap_push ();
+	  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XQueryPointer");
 	  XQueryPointer (xdisplay, xwindow,
 			 &root, &xwindow, &rootx, &rooty, &winx, &winy, &xmask);
 	  gdk_flush ();
@@ -3415,6 +3519,7 @@ gdk_window_x11_get_events (GdkWindow *window)
     return 0;
   else
     {
+      GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XGetWindowAttributes");
       XGetWindowAttributes (GDK_WINDOW_XDISPLAY (window),
 			    GDK_WINDOW_XID (window),
 			    &attrs);
@@ -4486,6 +4591,7 @@ gdk_window_get_mwm_hints (GdkWindow *window)
   
   hints_atom = gdk_x11_get_xatom_by_name_for_display (display, _XA_MOTIF_WM_HINTS);
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_DISPLAY_XDISPLAY (display), "XGetWindowProperty");
   XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_WINDOW_XID (window),
 		      hints_atom, 0, sizeof (MotifWmHints)/sizeof (long),
 		      False, AnyPropertyType, &type, &format, &nitems,
@@ -4517,6 +4623,7 @@ gdk_window_set_mwm_hints (GdkWindow *window,
   
   hints_atom = gdk_x11_get_xatom_by_name_for_display (display, _XA_MOTIF_WM_HINTS);
 
+  GDK_X11_NOTE_ROUNDTRIP (GDK_WINDOW_XDISPLAY (window), "XGetWindowProperty");
   XGetWindowProperty (GDK_WINDOW_XDISPLAY (window), GDK_WINDOW_XID (window),
 		      hints_atom, 0, sizeof (MotifWmHints)/sizeof (long),
 		      False, AnyPropertyType, &type, &format, &nitems,
@@ -4676,6 +4783,7 @@ _xwindow_get_shape (Display *xdisplay,
   shape = NULL;
   rn = 0;
 
+  GDK_X11_NOTE_ROUNDTRIP (xdisplay, "XShapeGetRectangles");
   /* Note that XShapeGetRectangles returns NULL in two situations:
    * - the server doesn't support the SHAPE extension
    * - the shape is empty
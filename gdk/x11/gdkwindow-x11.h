@@ -112,8 +112,12 @@ struct _GdkToplevelX11
   guint have_hidden : 1;	/* _NET_WM_STATE_HIDDEN */
 
   guint is_leader : 1;
+
+  /* Set if frame_extents holds the last _NET_FRAME_EXTENTS of the window */
+  guint have_frame_extents : 1;
   
   gulong map_serial;	/* Serial of last transition from unmapped */
+  gulong frame_extents[4]; /* left, right, top, bottom */
   
   GdkPixmap *icon_pixmap;
   GdkPixmap *icon_mask;
@@ -151,6 +155,7 @@ void            _gdk_x11_window_tmp_reset_bg        (GdkWindow *window,
 						     gboolean   recurse);
 void            _gdk_x11_window_tmp_unset_parent_bg (GdkWindow *window);
 void            _gdk_x11_window_tmp_reset_parent_bg (GdkWindow *window);
+void            _gdk_x11_window_update_frame_extents (GdkWindow *window);
 
 GdkCursor      *_gdk_x11_window_get_cursor    (GdkWindow *window);
 void            _gdk_x11_window_get_offsets   (GdkWindow *window,
@@ -158,6 +158,13 @@ void gdk_x11_display_broadcast_startup_message (GdkDisplay *display,
 						const char *message_type,
 						...) G_GNUC_NULL_TERMINATED;
 
+void     gdk_x11_display_set_roundtrip_tracing (GdkDisplay  *display,
+                                                gboolean     enabled);
+gboolean gdk_x11_display_get_roundtrip_tracing (GdkDisplay  *display);
+guint    gdk_x11_display_get_n_roundtrips      (GdkDisplay  *display,
+                                                const gchar *site);
+void     gdk_x11_display_reset_roundtrips      (GdkDisplay  *display);
+
 /* returns TRUE if we support the given WM spec feature */
 gboolean gdk_x11_screen_supports_net_wm_hint (GdkScreen *screen,
 					      GdkAtom    property);
@@ -0,0 +1,66 @@
+#!/usr/bin/perl -w
+
+if (@ARGV != 1) {
+    die "Usage: gen-atom-table.pl atoms.txt > atom-table.h\n";
+}
+
+open IN, $ARGV[0] || die "Cannot open $ARGV[0]: $!\n";
+
+@atoms = ();
+%seen = ();
+while (defined($_ = <IN>)) {
+    next if /^!/;
+    if (!/^\s*(\S+)\s*$/) {
+	die "Cannot parse line $_";
+    }
+    if (exists $seen{$1}) {
+	die "Atom $1 is listed twice\n";
+    }
+
+    $seen{$1} = 1;
+    push @atoms, $1;
+}
+
+$date = gmtime;
+
+print <<EOT;
+/* atom-table.h: Generated by gen-atom-table.pl from atoms.txt
+ *
+ *  Date: $date
+ *
+ * Do not edit.   
+ */
+static const char known_atoms_string[] =
+EOT
+
+$offset = 0;
+@offsets = ();
+for $name (@atoms) {
+    if ($offset != 0) {
+	print qq(\n);
+    }
+    print qq(  "$name\\0");
+
+    push @offsets, $offset;
+    $offset += length($name) + 1;
+}
+
+print ";\n\n";
+
+print "static const guint16 known_atoms_offset[] = {";
+
+$i = 0;
+for $offset (@offsets) {
+    if ($i % 12 == 0) {
+	print "\n  ";
+    } else {
+	print " ";
+    }
+    printf "%4d", $offset;
+    if ($i != $#offsets) {
+	print ",";
+    }
+    $i++;
+}
+
+print "\n};\n";
@@ -0,0 +1,59 @@
+/* GTK+
+ * buildercompile.c: Compile GtkBuilder UI definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "gtk/gtk.h"
+
+int
+main (int argc, char **argv)
+{
+  GtkBuilder *builder;
+  GError *error = NULL;
+
+  /* Compiling doesn't need a display, but the object types may look
+   * at settings or translations while their classes are initialized.
+   */
+  if (!gtk_parse_args (&argc, &argv))
+    {
+      g_printerr ("%s: could not initialize GTK+\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  if (argc != 3)
+    {
+      g_printerr ("Usage: %s INPUT OUTPUT\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  builder = gtk_builder_new ();
+  if (!gtk_builder_compile_file (builder, argv[1], argv[2], &error))
+    {
+      g_printerr ("%s: %s\n", argv[0], error->message);
+      g_error_free (error);
+      g_object_unref (builder);
+      return EXIT_FAILURE;
+    }
+
+  g_object_unref (builder);
+
+  return EXIT_SUCCESS;
+}
@@ -41,6 +41,8 @@
 
 /* --- defines --- */
 #define	BINDING_MOD_MASK()	(gtk_accelerator_get_default_mod_mask () | GDK_RELEASE_MASK)
+/* Number of keys whose matching entries are kept per widget */
+#define	BINDING_CACHE_SIZE	16
 
 
 /* --- structures --- */
@@ -52,6 +54,22 @@ typedef struct {
   guint         seq_id;
 } PatternSpec;
 
+/* The entries that match a widget for one key, in the order they are
+ * tried, ending with an entry that marks the key unbound if there is
+ * one.
+ */
+typedef struct {
+  GSList       *entries;
+  gboolean      is_release;
+  GSList       *matches;
+} BindingMatch;
+
+typedef struct {
+  guint         binding_serial;
+  guint         path_serial;
+  GSList       *matches;
+} BindingCache;
+
 
 /* --- variables --- */
 static GHashTable	*binding_entry_hash_table = NULL;
@@ -59,6 +77,9 @@ static GSList           *binding_key_hashes = NULL;
 static GSList		*binding_set_list = NULL;
 static const gchar	 key_class_binding_set[] = "gtk-class-binding-set";
 static GQuark		 key_id_class_binding_set = 0;
+static GQuark		 key_id_binding_cache = 0;
+/* Changes whenever the entries or patterns of any binding set change */
+static guint		 binding_serial = 0;
 
 
 /* --- functions --- */
@@ -213,6 +234,8 @@ binding_entry_new (GtkBindingSet  *binding_set,
   entry->set_next = binding_set->entries;
   binding_set->entries = entry;
 
+  binding_serial++;
+
   entry->hash_next = g_hash_table_lookup (binding_entry_hash_table, entry);
   if (entry->hash_next)
     g_hash_table_remove (binding_entry_hash_table, entry->hash_next);
@@ -313,6 +336,7 @@ binding_entry_destroy (GtkBindingEntry *entry)
     }
 
   entry->destroyed = TRUE;
+  binding_serial++;
 
   if (!entry->in_emission)
     binding_entry_free (entry);
@@ -767,6 +791,7 @@ gtk_binding_entry_skip (GtkBindingSet  *binding_set,
 
   entry = binding_entry_new (binding_set, keyval, modifiers);
   entry->marks_unbound = TRUE;
+  binding_serial++;
 }
 
 /**
@@ -1019,6 +1044,7 @@ gtk_binding_set_add_path (GtkBindingSet	     *binding_set,
   g_return_if_fail (priority <= GTK_PATH_PRIO_MASK);
 
   priority &= GTK_PATH_PRIO_MASK;
+  binding_serial++;
   
   switch (path_type)
     {
@@ -1082,18 +1108,19 @@ gtk_binding_set_add_path (GtkBindingSet	     *binding_set,
     }
 }
 
+/* Appends the entries of the binding sets whose patterns match @path
+ * to @matches. Returns %TRUE if one of them marks the key unbound, so
+ * that no further entries are tried.
+ */
 static gboolean
-binding_match_activate (GSList          *pspec_list,
-			GtkObject	*object,
-			guint	         path_length,
-			gchar           *path,
-			gchar           *path_reversed,
-                        gboolean        *unbound)
+binding_match_collect (GSList          *pspec_list,
+		       guint	        path_length,
+		       gchar           *path,
+		       gchar           *path_reversed,
+		       GSList         **matches)
 {
   GSList *slist;
 
-  *unbound = FALSE;
-
   for (slist = pspec_list; slist; slist = slist->next)
     {
       PatternSpec *pspec;
@@ -1115,13 +1142,9 @@ binding_match_activate (GSList          *pspec_list,
 
       if (binding_set)
         {
-          if (binding_set->current->marks_unbound)
-            {
-              *unbound = TRUE;
-              return FALSE;
-            }
+          *matches = g_slist_prepend (*matches, binding_set->current);
 
-          if (gtk_binding_entry_activate (binding_set->current, object))
+          if (binding_set->current->marks_unbound)
             return TRUE;
         }
     }
@@ -1201,85 +1224,201 @@ gtk_binding_entries_sort_patterns (GSList      *entries,
   return patterns;
 }
 
-static gboolean
-gtk_bindings_activate_list (GtkObject *object,
-			    GSList    *entries,
-			    gboolean   is_release)
+/* Finds the entries that match @widget for one key, by widget path,
+ * by class path and by class, in that order.
+ */
+static GSList *
+binding_collect_matches (GtkWidget *widget,
+			 GSList    *entries,
+			 gboolean   is_release)
 {
-  GtkWidget *widget = GTK_WIDGET (object);
-  gboolean handled = FALSE;
-
-  if (!entries)
-    return FALSE;
-
-  if (!handled)
-    {
-      guint path_length;
-      gchar *path, *path_reversed;
-      GSList *patterns;
-      gboolean unbound;
-
-      gtk_widget_path (widget, &path_length, &path, &path_reversed);
-      patterns = gtk_binding_entries_sort_patterns (entries, GTK_PATH_WIDGET, is_release);
-      handled = binding_match_activate (patterns, object, path_length, path, path_reversed, &unbound);
-      g_slist_free (patterns);
-      g_free (path);
-      g_free (path_reversed);
+  GSList *matches = NULL;
+  gboolean unbound;
+  guint path_length;
+  gchar *path, *path_reversed;
+  GSList *patterns;
+  GType class_type;
 
-      if (unbound)
-        return FALSE;
-    }
+  gtk_widget_path (widget, &path_length, &path, &path_reversed);
+  patterns = gtk_binding_entries_sort_patterns (entries, GTK_PATH_WIDGET, is_release);
+  unbound = binding_match_collect (patterns, path_length, path, path_reversed, &matches);
+  g_slist_free (patterns);
+  g_free (path);
+  g_free (path_reversed);
 
-  if (!handled)
+  if (!unbound)
     {
-      guint path_length;
-      gchar *path, *path_reversed;
-      GSList *patterns;
-      gboolean unbound;
-
       gtk_widget_class_path (widget, &path_length, &path, &path_reversed);
       patterns = gtk_binding_entries_sort_patterns (entries, GTK_PATH_WIDGET_CLASS, is_release);
-      handled = binding_match_activate (patterns, object, path_length, path, path_reversed, &unbound);
+      unbound = binding_match_collect (patterns, path_length, path, path_reversed, &matches);
       g_slist_free (patterns);
       g_free (path);
       g_free (path_reversed);
-
-      if (unbound)
-        return FALSE;
     }
 
-  if (!handled)
+  if (!unbound)
     {
-      GSList *patterns;
-      GType class_type;
-      gboolean unbound = FALSE;
-
       patterns = gtk_binding_entries_sort_patterns (entries, GTK_PATH_CLASS, is_release);
-      class_type = G_TYPE_FROM_INSTANCE (object);
-      while (class_type && !handled)
+      class_type = G_TYPE_FROM_INSTANCE (widget);
+      while (class_type && !unbound)
 	{
-	  guint path_length;
-	  gchar *path;
-	  gchar *path_reversed;
-
 	  path = g_strdup (g_type_name (class_type));
 	  path_reversed = g_strdup (path);
 	  g_strreverse (path_reversed);
 	  path_length = strlen (path);
-	  handled = binding_match_activate (patterns, object, path_length, path, path_reversed, &unbound);
+	  unbound = binding_match_collect (patterns, path_length, path, path_reversed, &matches);
 	  g_free (path);
 	  g_free (path_reversed);
 
-          if (unbound)
-            break;
-
 	  class_type = g_type_parent (class_type);
 	}
       g_slist_free (patterns);
+    }
+
+  return g_slist_reverse (matches);
+}
+
+static void
+binding_match_free (BindingMatch *match)
+{
+  g_slist_free (match->entries);
+  g_slist_free (match->matches);
+  g_slice_free (BindingMatch, match);
+}
+
+static void
+binding_cache_clear (BindingCache *cache)
+{
+  g_slist_foreach (cache->matches, (GFunc) binding_match_free, NULL);
+  g_slist_free (cache->matches);
+  cache->matches = NULL;
+}
+
+static void
+binding_cache_free (BindingCache *cache)
+{
+  binding_cache_clear (cache);
+  g_slice_free (BindingCache, cache);
+}
+
+static gboolean
+binding_entries_equal (GSList *a,
+		       GSList *b)
+{
+  while (a && b && a->data == b->data)
+    {
+      a = a->next;
+      b = b->next;
+    }
 
-      if (unbound)
-        return FALSE;
+  return a == NULL && b == NULL;
+}
+
+/* Returns the entries that match @widget for the key that @entries were
+ * found for. Matching the patterns of all binding sets against the
+ * paths of the widget is slow, so the result is kept with the widget
+ * until the bindings or the widget's path change.
+ */
+static GSList *
+binding_cache_lookup (GtkWidget *widget,
+		      GSList    *entries,
+		      gboolean   is_release)
+{
+  BindingCache *cache;
+  BindingMatch *match;
+  GSList *l, *prev;
+  guint path_serial;
+  guint n;
+
+  if (!key_id_binding_cache)
+    key_id_binding_cache = g_quark_from_static_string ("gtk-binding-cache");
+
+  path_serial = _gtk_widget_get_path_serial ();
+
+  cache = g_object_get_qdata (G_OBJECT (widget), key_id_binding_cache);
+  if (!cache)
+    {
+      cache = g_slice_new0 (BindingCache);
+      g_object_set_qdata_full (G_OBJECT (widget), key_id_binding_cache,
+			       cache, (GDestroyNotify) binding_cache_free);
     }
+  else if (cache->binding_serial != binding_serial ||
+	   cache->path_serial != path_serial)
+    binding_cache_clear (cache);
+
+  cache->binding_serial = binding_serial;
+  cache->path_serial = path_serial;
+
+  prev = NULL;
+  n = 0;
+  for (l = cache->matches; l; prev = l, l = l->next, n++)
+    {
+      match = l->data;
+
+      if (match->is_release == is_release &&
+	  binding_entries_equal (match->entries, entries))
+	{
+	  /* Keep the keys in use at the front */
+	  if (prev)
+	    {
+	      prev->next = l->next;
+	      l->next = cache->matches;
+	      cache->matches = l;
+	    }
+
+	  return match->matches;
+	}
+    }
+
+  /* Make room by dropping the key that was used least recently */
+  if (n >= BINDING_CACHE_SIZE)
+    {
+      binding_match_free (prev->data);
+      cache->matches = g_slist_delete_link (cache->matches, prev);
+    }
+
+  match = g_slice_new (BindingMatch);
+  match->entries = g_slist_copy (entries);
+  match->is_release = is_release;
+  match->matches = binding_collect_matches (widget, entries, is_release);
+
+  cache->matches = g_slist_prepend (cache->matches, match);
+
+  return match->matches;
+}
+
+static gboolean
+gtk_bindings_activate_list (GtkObject *object,
+			    GSList    *entries,
+			    gboolean   is_release)
+{
+  GtkWidget *widget = GTK_WIDGET (object);
+  gboolean handled = FALSE;
+  GSList *matches, *l;
+  guint serial;
+
+  if (!entries)
+    return FALSE;
+
+  /* The signals emitted may change the cache, so go through a copy */
+  matches = g_slist_copy (binding_cache_lookup (widget, entries, is_release));
+  serial = binding_serial;
+
+  g_object_ref (object);
+
+  for (l = matches; l && !handled; l = l->next)
+    {
+      GtkBindingEntry *entry = l->data;
+
+      /* The remaining entries may be gone once the bindings changed */
+      if (serial != binding_serial || entry->marks_unbound)
+        break;
+
+      handled = gtk_binding_entry_activate (entry, object);
+    }
+
+  g_object_unref (object);
+  g_slist_free (matches);
 
   return handled;
 }
@@ -1693,6 +1832,7 @@ binding_set_delete (GtkBindingSet *binding_set)
   free_pattern_specs (binding_set->widget_path_pspecs);
   free_pattern_specs (binding_set->widget_class_pspecs);
   free_pattern_specs (binding_set->class_branch_pspecs);
+  binding_serial++;
 
   g_free (binding_set);
 }
@@ -50,6 +50,11 @@ static void gtk_builder_get_property   (GObject         *object,
                                         GParamSpec      *pspec);
 static GType gtk_builder_real_get_type_from_name (GtkBuilder  *builder,
                                                   const gchar *type_name);
+static void free_connect_args (gpointer args);
+static void connect_signal_list (GtkBuilder            *builder,
+                                 GSList                *signals,
+                                 GtkBuilderConnectFunc  func,
+                                 gpointer               user_data);
 
 enum {
   PROP_0,
@@ -63,8 +68,31 @@ struct _GtkBuilderPrivate
   GSList *delayed_properties;
   GSList *signals;
   gchar *filename;
+
+  /* Deferred objects by the ids of all objects they contain */
+  GHashTable *deferred;
+  GSList *deferred_objects;
+
+  /* From the last gtk_builder_connect_signals*() call, for the
+   * signals of deferred objects. connect_data isn't owned,
+   * connect_args is the one gtk_builder_connect_signals() made.
+   */
+  GtkBuilderConnectFunc connect_func;
+  gpointer connect_data;
+  gpointer connect_args;
 };
 
+typedef struct
+{
+  gchar *filename;
+  gchar *base_filename;
+  gchar *domain;
+  gchar *markup;
+  GSList *ids;
+} DeferredObject;
+
+static void free_deferred_object (DeferredObject *deferred);
+
 G_DEFINE_TYPE (GtkBuilder, gtk_builder, G_TYPE_OBJECT)
 
 static void
@@ -128,6 +156,12 @@ gtk_builder_finalize (GObject *object)
 
   g_slist_foreach (priv->signals, (GFunc) _free_signal_info, NULL);
   g_slist_free (priv->signals);
+
+  if (priv->deferred)
+    g_hash_table_destroy (priv->deferred);
+  g_slist_foreach (priv->deferred_objects, (GFunc) free_deferred_object, NULL);
+  g_slist_free (priv->deferred_objects);
+  free_connect_args (priv->connect_args);
   
   G_OBJECT_CLASS (gtk_builder_parent_class)->finalize (object);
 }
@@ -306,6 +340,15 @@ gtk_builder_get_parameters (GtkBuilder  *builder,
               continue;
             }
         }
+      else if (prop->value_type &&
+               strcmp (prop->value_type,
+                       g_type_name (G_PARAM_SPEC_VALUE_TYPE (pspec))) == 0 &&
+               _gtk_builder_value_from_compiled (&parameter.value,
+                                                 G_PARAM_SPEC_VALUE_TYPE (pspec),
+                                                 &prop->value))
+        {
+          /* Converted when the file was compiled */
+        }
       else if (!gtk_builder_value_from_string (builder, pspec,
 					       prop->data, &parameter.value, &error))
         {
@@ -598,7 +641,8 @@ gtk_builder_apply_delayed_properties (GtkBuilder *builder)
         {
           GObject *obj;
 
-          obj = g_hash_table_lookup (builder->priv->objects, property->value);
+          /* May be a deferred object declared later on */
+          obj = gtk_builder_get_object (builder, property->value);
           if (!obj)
             g_warning ("No object called: %s", property->value);
           else
@@ -619,6 +663,117 @@ _gtk_builder_finish (GtkBuilder *builder)
   gtk_builder_apply_delayed_properties (builder);
 }
 
+static void
+free_deferred_object (DeferredObject *deferred)
+{
+  g_free (deferred->filename);
+  g_free (deferred->base_filename);
+  g_free (deferred->domain);
+  g_free (deferred->markup);
+  g_slist_foreach (deferred->ids, (GFunc) g_free, NULL);
+  g_slist_free (deferred->ids);
+  g_slice_free (DeferredObject, deferred);
+}
+
+/* Takes over @markup and @ids */
+void
+_gtk_builder_add_deferred (GtkBuilder  *builder,
+                           const gchar *filename,
+                           const gchar *domain,
+                           gchar       *markup,
+                           GSList      *ids)
+{
+  GtkBuilderPrivate *priv = builder->priv;
+  DeferredObject *deferred;
+  GSList *l;
+
+  deferred = g_slice_new0 (DeferredObject);
+  deferred->filename = g_strdup (filename);
+  deferred->base_filename = g_strdup (priv->filename);
+  deferred->domain = g_strdup (domain);
+  deferred->markup = markup;
+  deferred->ids = ids;
+
+  if (!priv->deferred)
+    priv->deferred = g_hash_table_new (g_str_hash, g_str_equal);
+
+  priv->deferred_objects = g_slist_prepend (priv->deferred_objects, deferred);
+  for (l = ids; l; l = l->next)
+    g_hash_table_replace (priv->deferred, l->data, deferred);
+}
+
+static void
+gtk_builder_build_deferred (GtkBuilder     *builder,
+                            DeferredObject *deferred)
+{
+  GtkBuilderPrivate *priv = builder->priv;
+  GSList *l, *delayed_properties, *signals;
+  gchar *domain, *filename, *buffer;
+  GError *error = NULL;
+
+  /* Deferred objects are built once, even if that fails */
+  for (l = deferred->ids; l; l = l->next)
+    if (g_hash_table_lookup (priv->deferred, l->data) == deferred)
+      g_hash_table_remove (priv->deferred, l->data);
+  priv->deferred_objects = g_slist_remove (priv->deferred_objects, deferred);
+
+  GTK_NOTE (BUILDER,
+            g_print ("building deferred %s\n",
+                     (gchar *) g_slist_last (deferred->ids)->data));
+
+  /* This may happen while another UI definition is being parsed,
+   * when one of its objects refers to a deferred one.
+   */
+  delayed_properties = priv->delayed_properties;
+  signals = priv->signals;
+  priv->delayed_properties = NULL;
+  priv->signals = NULL;
+
+  /* Swapped rather than set, since a parser that is running holds
+   * on to the current domain.
+   */
+  domain = priv->domain;
+  filename = priv->filename;
+  priv->domain = g_strdup (deferred->domain);
+  priv->filename = deferred->base_filename;
+
+  buffer = g_strconcat ("<interface>", deferred->markup, "</interface>", NULL);
+  _gtk_builder_parser_parse_buffer (builder, deferred->filename,
+                                    buffer, strlen (buffer),
+                                    NULL,
+                                    &error);
+  g_free (buffer);
+
+  if (error)
+    {
+      g_warning ("Failed to build deferred object: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_free (priv->domain);
+  priv->domain = domain;
+  priv->filename = filename;
+
+  /* If signals have been connected already, the ones of the deferred
+   * object are connected the same way, otherwise they wait for the
+   * first gtk_builder_connect_signals() call.
+   */
+  if (priv->connect_func && priv->signals)
+    {
+      GSList *deferred_signals = priv->signals;
+
+      priv->signals = NULL;
+      connect_signal_list (builder, deferred_signals,
+                           priv->connect_func, priv->connect_data);
+    }
+
+  priv->delayed_properties = g_slist_concat (priv->delayed_properties,
+                                             delayed_properties);
+  priv->signals = g_slist_concat (priv->signals, signals);
+
+  free_deferred_object (deferred);
+}
+
 /**
  * gtk_builder_new:
  *
@@ -642,6 +797,7 @@ gtk_builder_new (void)
  *
  * Parses a file containing a <link linkend="BUILDER-UI">GtkBuilder 
  * UI definition</link> and merges it with the current contents of @builder. 
+ * The file may also have been compiled with gtk_builder_compile_file().
  * 
  * Upon errors 0 will be returned and @error will be assigned a
  * #GError from the #GTK_BUILDER_ERROR, #G_MARKUP_ERROR or #G_FILE_ERROR 
@@ -863,6 +1019,68 @@ gtk_builder_add_objects_from_string (GtkBuilder   *builder,
   return 1;
 }
 
+/**
+ * gtk_builder_compile_file:
+ * @builder: a #GtkBuilder
+ * @filename: the name of the file to compile
+ * @compiled_filename: the name of the file to write
+ * @error: (allow-none): return location for an error, or %NULL
+ *
+ * Compiles a file containing a <link linkend="BUILDER-UI">GtkBuilder
+ * UI definition</link> into a binary form that loads faster, and
+ * writes it to @compiled_filename. Compiled files are loaded with
+ * gtk_builder_add_from_file() and gtk_builder_add_objects_from_file()
+ * like UI definitions, but without parsing XML; property values of
+ * numeric, boolean, enumeration and flags types are converted ahead of
+ * time where the type of the object can be found with @builder.
+ * Translatable properties are still translated when loading.
+ *
+ * The compiled form depends on the byte order of the machine and on
+ * the GTK+ version that compiled it, and is meant to be generated when
+ * building an application, for instance with the
+ * <command>gtk-builder-compile</command> tool. Only the well-formedness
+ * of the markup is checked when compiling; other errors are reported
+ * when loading the compiled file.
+ *
+ * Returns: %TRUE if the file was compiled
+ *
+ * Since: 2.24
+ **/
+gboolean
+gtk_builder_compile_file (GtkBuilder   *builder,
+                          const gchar  *filename,
+                          const gchar  *compiled_filename,
+                          GError      **error)
+{
+  GByteArray *compiled;
+  gchar *buffer;
+  gsize length;
+  gboolean retval;
+
+  g_return_val_if_fail (GTK_IS_BUILDER (builder), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (compiled_filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (!g_file_get_contents (filename, &buffer, &length, error))
+    return FALSE;
+
+  compiled = _gtk_builder_parser_compile_buffer (builder, filename,
+                                                 buffer, length,
+                                                 error);
+  g_free (buffer);
+
+  if (!compiled)
+    return FALSE;
+
+  retval = g_file_set_contents (compiled_filename,
+                                (const gchar *) compiled->data, compiled->len,
+                                error);
+  g_byte_array_free (compiled, TRUE);
+
+  return retval;
+}
+
 /**
  * gtk_builder_get_object:
  * @builder: a #GtkBuilder
@@ -871,6 +1089,9 @@ gtk_builder_add_objects_from_string (GtkBuilder   *builder,
  * Gets the object named @name. Note that this function does not
  * increment the reference count of the returned object. 
  *
+ * If @name is part of a deferred object that hasn't been built yet,
+ * the deferred object is built first, along with all its children.
+ *
  * Return value: (transfer none): the object named @name or %NULL if
  *    it could not be found in the object tree.
  *
@@ -880,10 +1101,22 @@ GObject *
 gtk_builder_get_object (GtkBuilder  *builder,
                         const gchar *name)
 {
+  GObject *object;
+  DeferredObject *deferred;
+
   g_return_val_if_fail (GTK_IS_BUILDER (builder), NULL);
   g_return_val_if_fail (name != NULL, NULL);
 
-  return g_hash_table_lookup (builder->priv->objects, name);
+  object = g_hash_table_lookup (builder->priv->objects, name);
+
+  if (!object && builder->priv->deferred &&
+      (deferred = g_hash_table_lookup (builder->priv->deferred, name)))
+    {
+      gtk_builder_build_deferred (builder, deferred);
+      object = g_hash_table_lookup (builder->priv->objects, name);
+    }
+
+  return object;
 }
 
 static void
@@ -900,7 +1133,8 @@ object_add_to_list (gchar    *object_id,
  *
  * Gets all objects that have been constructed by @builder. Note that 
  * this function does not increment the reference counts of the returned
- * objects.
+ * objects. Deferred objects that haven't been built yet are not
+ * included.
  *
  * Return value: (element-type GObject) (transfer container): a newly-allocated #GSList containing all the objects
  *   constructed by the #GtkBuilder instance. It should be freed by
@@ -969,6 +1203,18 @@ typedef struct {
   gpointer data;
 } connect_args;
 
+static void
+free_connect_args (gpointer data)
+{
+  connect_args *args = data;
+
+  if (!args)
+    return;
+
+  g_module_close (args->module);
+  g_slice_free (connect_args, args);
+}
+
 static void
 gtk_builder_connect_signals_default (GtkBuilder    *builder,
 				     GObject       *object,
@@ -1014,6 +1260,10 @@ gtk_builder_connect_signals_default (GtkBuilder    *builder,
  * be compiled with the -Wl,--export-dynamic CFLAGS, and linked against
  * gmodule-export-2.0.
  *
+ * Signals of deferred objects are connected the same way when the
+ * objects are built, so @user_data has to stay valid until then, or
+ * until signals are connected again.
+ *
  * Since: 2.12
  **/
 void
@@ -1034,9 +1284,9 @@ gtk_builder_connect_signals (GtkBuilder *builder,
   gtk_builder_connect_signals_full (builder,
                                     gtk_builder_connect_signals_default,
                                     args);
-  g_module_close (args->module);
 
-  g_slice_free (connect_args, args);
+  /* Kept for the signals of deferred objects */
+  builder->priv->connect_args = args;
 }
 
 /**
@@ -1068,6 +1318,11 @@ gtk_builder_connect_signals (GtkBuilder *builder,
  * version of gtk_builder_connect_signals(), except that it does not
  * require GModule to function correctly.
  *
+ * Signals of deferred objects are connected with @func when the
+ * objects are built. @builder doesn't take ownership of @user_data,
+ * it has to stay valid until then, or until this function is called
+ * again, which replaces @func and @user_data.
+ *
  * Since: 2.12
  */
 void
@@ -1075,18 +1330,43 @@ gtk_builder_connect_signals_full (GtkBuilder            *builder,
                                   GtkBuilderConnectFunc  func,
                                   gpointer               user_data)
 {
-  GSList *l;
-  GObject *object;
-  GObject *connect_object;
+  GtkBuilderPrivate *priv;
+  GSList *signals;
   
   g_return_if_fail (GTK_IS_BUILDER (builder));
   g_return_if_fail (func != NULL);
+
+  priv = builder->priv;
+
+  free_connect_args (priv->connect_args);
+  priv->connect_args = NULL;
+  priv->connect_func = func;
+  priv->connect_data = user_data;
   
-  if (!builder->priv->signals)
+  if (!priv->signals)
     return;
 
-  builder->priv->signals = g_slist_reverse (builder->priv->signals);
-  for (l = builder->priv->signals; l; l = l->next)
+  /* Taken over first, since connecting may build deferred objects */
+  signals = priv->signals;
+  priv->signals = NULL;
+  connect_signal_list (builder, signals, func, user_data);
+}
+
+/* Connects @signals, which are kept newest first, in the order they
+ * were parsed, and frees the list.
+ */
+static void
+connect_signal_list (GtkBuilder            *builder,
+                     GSList                *signals,
+                     GtkBuilderConnectFunc  func,
+                     gpointer               user_data)
+{
+  GSList *l;
+  GObject *object;
+  GObject *connect_object;
+
+  signals = g_slist_reverse (signals);
+  for (l = signals; l; l = l->next)
     {
       SignalInfo *signal = (SignalInfo*)l->data;
 
@@ -1101,8 +1381,8 @@ gtk_builder_connect_signals_full (GtkBuilder            *builder,
       
       if (signal->connect_object_name)
 	{
-	  connect_object = g_hash_table_lookup (builder->priv->objects,
-						signal->connect_object_name);
+	  connect_object = gtk_builder_get_object (builder,
+						   signal->connect_object_name);
 	  if (!connect_object)
 	      g_warning ("Could not lookup object %s on signal %s of object %s",
 			 signal->connect_object_name, signal->name,
@@ -1113,9 +1393,8 @@ gtk_builder_connect_signals_full (GtkBuilder            *builder,
 	    connect_object, signal->flags, user_data);
     }
 
-  g_slist_foreach (builder->priv->signals, (GFunc)_free_signal_info, NULL);
-  g_slist_free (builder->priv->signals);
-  builder->priv->signals = NULL;
+  g_slist_foreach (signals, (GFunc)_free_signal_info, NULL);
+  g_slist_free (signals);
 }
 
 /**
@@ -110,6 +110,10 @@ guint        gtk_builder_add_objects_from_string (GtkBuilder    *builder,
                                                   gsize          length,
                                                   gchar        **object_ids,
                                                   GError       **error);
+gboolean     gtk_builder_compile_file            (GtkBuilder    *builder,
+                                                  const gchar   *filename,
+                                                  const gchar   *compiled_filename,
+                                                  GError       **error);
 GObject*     gtk_builder_get_object              (GtkBuilder    *builder,
                                                   const gchar   *name);
 GSList*      gtk_builder_get_objects             (GtkBuilder    *builder);
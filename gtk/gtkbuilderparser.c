@@ -66,6 +66,26 @@ state_pop (ParserData *data)
 #define state_peek_info(data, st) ((st*)state_peek(data))
 #define state_pop_info(data, st) ((st*)state_pop(data))
 
+/* Compiled files are replayed without a parse context, apart from
+ * the markup of custom tags.
+ */
+static void
+get_position (ParserData *data,
+              gint       *line_number,
+              gint       *char_number)
+{
+  if (data->ctx)
+    {
+      g_markup_parse_context_get_position (data->ctx, line_number, char_number);
+      return;
+    }
+
+  if (line_number)
+    *line_number = data->line;
+  if (char_number)
+    *char_number = 0;
+}
+
 static void
 error_missing_attribute (ParserData *data,
                          const gchar *tag,
@@ -74,9 +94,7 @@ error_missing_attribute (ParserData *data,
 {
   gint line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   g_set_error (error,
                GTK_BUILDER_ERROR,
@@ -94,9 +112,7 @@ error_invalid_attribute (ParserData *data,
 {
   gint line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   g_set_error (error,
                GTK_BUILDER_ERROR,
@@ -114,9 +130,7 @@ error_invalid_tag (ParserData *data,
 {
   gint line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   if (expected)
     g_set_error (error,
@@ -239,9 +253,7 @@ parse_requires (ParserData   *data,
   gint          i, version_major = 0, version_minor = 0;
   gint          line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   for (i = 0; names[i] != NULL; i++)
     {
@@ -297,6 +309,104 @@ is_requested_object (const gchar *object,
   return FALSE;
 }
 
+static void
+deferred_append_start (ParserData   *data,
+                       const gchar  *element_name,
+                       const gchar **names,
+                       const gchar **values,
+                       const gchar  *skip)
+{
+  gchar *escaped;
+  gint i;
+
+  g_string_append_printf (data->deferred, "<%s", element_name);
+  for (i = 0; names[i] != NULL; i++)
+    {
+      if (skip && strcmp (names[i], skip) == 0)
+        continue;
+
+      escaped = g_markup_printf_escaped (" %s=\"%s\"", names[i], values[i]);
+      g_string_append (data->deferred, escaped);
+      g_free (escaped);
+    }
+  g_string_append_c (data->deferred, '>');
+}
+
+static void
+deferred_add_id (ParserData   *data,
+                 const gchar  *object_id,
+                 GError      **error)
+{
+  gint line, line2;
+
+  get_position (data, &line, NULL);
+  line2 = GPOINTER_TO_INT (g_hash_table_lookup (data->object_ids, object_id));
+  if (line2 != 0)
+    {
+      g_set_error (error, GTK_BUILDER_ERROR,
+                   GTK_BUILDER_ERROR_DUPLICATE_ID,
+                   _("Duplicate object ID '%s' on line %d (previously on line %d)"),
+                   object_id, line, line2);
+      return;
+    }
+
+  g_hash_table_insert (data->object_ids, g_strdup (object_id), GINT_TO_POINTER (line));
+  data->deferred_ids = g_slist_prepend (data->deferred_ids, g_strdup (object_id));
+}
+
+/* Deferred objects are kept as markup until they are asked for */
+static void
+deferred_start_element (ParserData   *data,
+                        const gchar  *element_name,
+                        const gchar **names,
+                        const gchar **values,
+                        GError      **error)
+{
+  gint i;
+
+  deferred_append_start (data, element_name, names, values, NULL);
+  data->deferred_depth++;
+
+  if (strcmp (element_name, "object") != 0)
+    return;
+
+  for (i = 0; names[i] != NULL; i++)
+    {
+      if (strcmp (names[i], "id") == 0)
+        deferred_add_id (data, values[i], error);
+    }
+}
+
+static void
+deferred_end_element (ParserData  *data,
+                      const gchar *element_name)
+{
+  g_string_append_printf (data->deferred, "</%s>", element_name);
+  if (--data->deferred_depth > 0)
+    return;
+
+  GTK_NOTE (BUILDER, g_print ("deferring %s\n",
+                              (gchar *) g_slist_last (data->deferred_ids)->data));
+
+  _gtk_builder_add_deferred (data->builder, data->filename, data->domain,
+                             g_string_free (data->deferred, FALSE),
+                             data->deferred_ids);
+  data->deferred = NULL;
+  data->deferred_ids = NULL;
+}
+
+static void
+deferred_text (ParserData  *data,
+               const gchar *text,
+               gsize        text_len)
+{
+  gchar *escaped;
+
+  escaped = g_markup_escape_text (text, text_len);
+  g_string_append (data->deferred, escaped);
+  g_free (escaped);
+}
+
 static void
 parse_object (GMarkupParseContext  *context,
               ParserData           *data,
@@ -311,6 +421,7 @@ parse_object (GMarkupParseContext  *context,
   gchar *object_class = NULL;
   gchar *object_id = NULL;
   gchar *constructor = NULL;
+  gboolean deferred = FALSE;
   gint line, line2;
 
   child_info = state_peek_info (data, ChildInfo);
@@ -328,6 +439,11 @@ parse_object (GMarkupParseContext  *context,
         object_id = g_strdup (values[i]);
       else if (strcmp (names[i], "constructor") == 0)
         constructor = g_strdup (values[i]);
+      else if (strcmp (names[i], "deferred") == 0)
+        {
+          if (!_gtk_builder_boolean_from_string (values[i], &deferred, error))
+            return;
+        }
       else if (strcmp (names[i], "type-func") == 0)
         {
 	  /* Call the GType function, and return the name of the GType,
@@ -337,7 +453,7 @@ parse_object (GMarkupParseContext  *context,
           object_class = _get_type_by_symbol (values[i]);
           if (!object_class)
             {
-              g_markup_parse_context_get_position (context, &line, NULL);
+              get_position (data, &line, NULL);
               g_set_error (error, GTK_BUILDER_ERROR,
                            GTK_BUILDER_ERROR_INVALID_TYPE_FUNCTION,
                            _("Invalid type function on line %d: '%s'"),
@@ -364,6 +480,29 @@ parse_object (GMarkupParseContext  *context,
       return;
     }
 
+  /* Only toplevel objects can be deferred */
+  if (deferred && child_info)
+    {
+      error_invalid_attribute (data, element_name, "deferred", error);
+      g_free (object_class);
+      g_free (object_id);
+      g_free (constructor);
+      return;
+    }
+
+  if (deferred &&
+      (!data->requested_objects || is_requested_object (object_id, data)))
+    {
+      data->deferred = g_string_new ("");
+      data->deferred_depth = 1;
+      deferred_append_start (data, element_name, names, values, "deferred");
+      deferred_add_id (data, object_id, error);
+      g_free (object_class);
+      g_free (object_id);
+      g_free (constructor);
+      return;
+    }
+
   ++data->cur_object_level;
 
   /* check if we reached a requested object (if it is specified) */
@@ -398,7 +537,7 @@ parse_object (GMarkupParseContext  *context,
   if (child_info)
     object_info->parent = (CommonInfo*)child_info;
 
-  g_markup_parse_context_get_position (context, &line, NULL);
+  get_position (data, &line, NULL);
   line2 = GPOINTER_TO_INT (g_hash_table_lookup (data->object_ids, object_id));
   if (line2 != 0)
     {
@@ -537,6 +676,8 @@ parse_property (ParserData   *data,
 static void
 free_property_info (PropertyInfo *info)
 {
+  if (G_IS_VALUE (&info->value))
+    g_value_unset (&info->value);
   g_free (info->data);
   g_free (info->name);
   g_slice_free (PropertyInfo, info);
@@ -862,6 +1003,12 @@ start_element (GMarkupParseContext *context,
     }
   data->last_element = element_name;
 
+  if (data->deferred)
+    {
+      deferred_start_element (data, element_name, names, values, error);
+      return;
+    }
+
   if (data->subparser)
     if (!subparser_start (context, element_name, names, values,
 			  data, error))
@@ -925,6 +1072,12 @@ end_element (GMarkupParseContext *context,
 
   GTK_NOTE (BUILDER, g_print ("</%s>\n", element_name));
 
+  if (data->deferred)
+    {
+      deferred_end_element (data, element_name);
+      return;
+    }
+
   if (data->subparser && data->subparser->start)
     {
       subparser_end (context, element_name, data, error);
@@ -1060,6 +1213,12 @@ text (GMarkupParseContext *context,
   ParserData *data = (ParserData*)user_data;
   CommonInfo *info;
 
+  if (data->deferred)
+    {
+      deferred_text (data, text, text_len);
+      return;
+    }
+
   if (data->subparser && data->subparser->start)
     {
       GError *tmp_error = NULL;
@@ -1111,6 +1270,961 @@ static const GMarkupParser parser = {
   NULL
 };
 
+/*
+ * Compiled UI definitions
+ *
+ * gtk_builder_compile_file() turns a UI definition into a table of
+ * the strings it uses followed by the elements that GtkBuilder handles
+ * itself, so that loading it needs no XML parsing. Custom tags are
+ * kept as markup, since only the buildables know what they contain.
+ * Property values of fundamental types are converted when compiling,
+ * as far as the types of the objects are known then.
+ */
+#define COMPILED_MAGIC      "GTKUIC\0\1"
+#define COMPILED_BYTE_ORDER 0x01020304
+#define COMPILED_NONE       G_MAXUINT32
+
+typedef enum
+{
+  COMPILED_OP_START,
+  COMPILED_OP_END,
+  COMPILED_OP_PROPERTY,
+  COMPILED_OP_MARKUP
+} CompiledOp;
+
+typedef enum
+{
+  COMPILED_VALUE_NONE,
+  COMPILED_VALUE_INT64,
+  COMPILED_VALUE_UINT64,
+  COMPILED_VALUE_DOUBLE
+} CompiledValueKind;
+
+typedef union
+{
+  gint64 i;
+  guint64 u;
+  gdouble d;
+} CompiledPayload;
+
+typedef struct
+{
+  GtkBuilder *builder;
+  GHashTable *string_ids;
+  GPtrArray *strings;
+  GByteArray *ops;
+
+  /* The elements that the parser keeps on its stack, innermost first */
+  GSList *stack;
+  /* The types of the enclosing objects, if they are known */
+  GSList *types;
+
+  gchar **property_names;
+  gchar **property_values;
+  GString *property_text;
+  gint property_line;
+
+  GString *markup;
+  gint markup_depth;
+  gint markup_line;
+  /* Lines of the markup up to markup_counted bytes, from 1 */
+  gint markup_lines;
+  gsize markup_counted;
+} CompilerData;
+
+typedef struct
+{
+  const gchar *data;
+  const gchar *end;
+  const gchar **strings;
+  guint32 *lengths;
+  guint32 n_strings;
+} CompiledReader;
+
+static gboolean
+is_stacked_tag (const gchar *element_name)
+{
+  return strcmp (element_name, "requires") == 0 ||
+         strcmp (element_name, "object") == 0 ||
+         strcmp (element_name, "child") == 0 ||
+         strcmp (element_name, "signal") == 0;
+}
+
+static gboolean
+is_builder_tag (const gchar *element_name)
+{
+  return is_stacked_tag (element_name) ||
+         strcmp (element_name, "interface") == 0 ||
+         strcmp (element_name, "placeholder") == 0;
+}
+
+static CompiledValueKind
+compiled_value_kind (GType type)
+{
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_INT:
+    case G_TYPE_LONG:
+    case G_TYPE_INT64:
+    case G_TYPE_ENUM:
+      return COMPILED_VALUE_INT64;
+    case G_TYPE_UCHAR:
+    case G_TYPE_UINT:
+    case G_TYPE_ULONG:
+    case G_TYPE_UINT64:
+    case G_TYPE_FLAGS:
+      return COMPILED_VALUE_UINT64;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      return COMPILED_VALUE_DOUBLE;
+    default:
+      return COMPILED_VALUE_NONE;
+    }
+}
+
+static void
+compiled_payload_from_value (CompiledPayload *payload,
+                             const GValue    *value)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value)))
+    {
+    case G_TYPE_BOOLEAN:
+      payload->i = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      payload->i = g_value_get_char (value);
+      break;
+    case G_TYPE_INT:
+      payload->i = g_value_get_int (value);
+      break;
+    case G_TYPE_LONG:
+      payload->i = g_value_get_long (value);
+      break;
+    case G_TYPE_INT64:
+      payload->i = g_value_get_int64 (value);
+      break;
+    case G_TYPE_ENUM:
+      payload->i = g_value_get_enum (value);
+      break;
+    case G_TYPE_UCHAR:
+      payload->u = g_value_get_uchar (value);
+      break;
+    case G_TYPE_UINT:
+      payload->u = g_value_get_uint (value);
+      break;
+    case G_TYPE_ULONG:
+      payload->u = g_value_get_ulong (value);
+      break;
+    case G_TYPE_UINT64:
+      payload->u = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_FLAGS:
+      payload->u = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      payload->d = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      payload->d = g_value_get_double (value);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+/* Called by GtkBuilder, with a value read from a compiled file */
+gboolean
+_gtk_builder_value_from_compiled (GValue       *value,
+                                  GType         type,
+                                  const GValue *compiled)
+{
+  GType compiled_type;
+
+  switch (compiled_value_kind (type))
+    {
+    case COMPILED_VALUE_INT64:
+      compiled_type = G_TYPE_INT64;
+      break;
+    case COMPILED_VALUE_UINT64:
+      compiled_type = G_TYPE_UINT64;
+      break;
+    case COMPILED_VALUE_DOUBLE:
+      compiled_type = G_TYPE_DOUBLE;
+      break;
+    default:
+      return FALSE;
+    }
+
+  if (!G_VALUE_HOLDS (compiled, compiled_type))
+    return FALSE;
+
+  g_value_init (value, type);
+
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+      g_value_set_boolean (value, g_value_get_int64 (compiled) != 0);
+      break;
+    case G_TYPE_CHAR:
+      g_value_set_char (value, g_value_get_int64 (compiled));
+      break;
+    case G_TYPE_INT:
+      g_value_set_int (value, g_value_get_int64 (compiled));
+      break;
+    case G_TYPE_LONG:
+      g_value_set_long (value, g_value_get_int64 (compiled));
+      break;
+    case G_TYPE_INT64:
+      g_value_set_int64 (value, g_value_get_int64 (compiled));
+      break;
+    case G_TYPE_ENUM:
+      g_value_set_enum (value, g_value_get_int64 (compiled));
+      break;
+    case G_TYPE_UCHAR:
+      g_value_set_uchar (value, g_value_get_uint64 (compiled));
+      break;
+    case G_TYPE_UINT:
+      g_value_set_uint (value, g_value_get_uint64 (compiled));
+      break;
+    case G_TYPE_ULONG:
+      g_value_set_ulong (value, g_value_get_uint64 (compiled));
+      break;
+    case G_TYPE_UINT64:
+      g_value_set_uint64 (value, g_value_get_uint64 (compiled));
+      break;
+    case G_TYPE_FLAGS:
+      g_value_set_flags (value, g_value_get_uint64 (compiled));
+      break;
+    case G_TYPE_FLOAT:
+      g_value_set_float (value, g_value_get_double (compiled));
+      break;
+    case G_TYPE_DOUBLE:
+      g_value_set_double (value, g_value_get_double (compiled));
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  return TRUE;
+}
+
+static void
+compiler_put_uint32 (CompilerData *compiler,
+                     guint32       value)
+{
+  g_byte_array_append (compiler->ops, (guint8 *) &value, sizeof (value));
+}
+
+static guint32
+compiler_intern (CompilerData *compiler,
+                 const gchar  *string)
+{
+  gpointer id;
+  gchar *copy;
+
+  if (!string)
+    return COMPILED_NONE;
+
+  if (g_hash_table_lookup_extended (compiler->string_ids, string, NULL, &id))
+    return GPOINTER_TO_UINT (id);
+
+  copy = g_strdup (string);
+  g_ptr_array_add (compiler->strings, copy);
+  g_hash_table_insert (compiler->string_ids, copy,
+                       GUINT_TO_POINTER (compiler->strings->len - 1));
+
+  return compiler->strings->len - 1;
+}
+
+static void
+compiler_put_string (CompilerData *compiler,
+                     const gchar  *string)
+{
+  compiler_put_uint32 (compiler, compiler_intern (compiler, string));
+}
+
+static void
+compiler_put_attributes (CompilerData  *compiler,
+                         const gchar  **names,
+                         const gchar  **values)
+{
+  guint32 i, n_attributes;
+
+  n_attributes = g_strv_length ((gchar **) names);
+  compiler_put_uint32 (compiler, n_attributes);
+  for (i = 0; i < n_attributes; i++)
+    {
+      compiler_put_string (compiler, names[i]);
+      compiler_put_string (compiler, values[i]);
+    }
+}
+
+static GType
+compiler_get_object_type (CompilerData  *compiler,
+                          const gchar  **names,
+                          const gchar  **values)
+{
+  GType type = G_TYPE_INVALID;
+  gchar *type_name;
+  gint i;
+
+  for (i = 0; names[i] != NULL; i++)
+    {
+      if (strcmp (names[i], "class") == 0)
+        type = gtk_builder_get_type_from_name (compiler->builder, values[i]);
+      else if (strcmp (names[i], "type-func") == 0)
+        {
+          type_name = _get_type_by_symbol (values[i]);
+          if (type_name)
+            type = g_type_from_name (type_name);
+          g_free (type_name);
+        }
+    }
+
+  return type;
+}
+
+/* Converts the value of the property being recorded, if its type is
+ * known and doesn't depend on anything but the text.
+ */
+static CompiledValueKind
+compiler_convert_property (CompilerData     *compiler,
+                           const gchar     **value_type,
+                           CompiledPayload  *payload)
+{
+  CompiledValueKind kind = COMPILED_VALUE_NONE;
+  GType object_type;
+  GObjectClass *oclass;
+  GParamSpec *pspec;
+  GValue value = { 0, };
+  gboolean translatable = FALSE;
+  gchar *name = NULL;
+  gint i;
+
+  if (!compiler->types)
+    return COMPILED_VALUE_NONE;
+
+  object_type = GPOINTER_TO_SIZE (compiler->types->data);
+  if (!G_TYPE_IS_OBJECT (object_type))
+    return COMPILED_VALUE_NONE;
+
+  for (i = 0; compiler->property_names[i] != NULL; i++)
+    {
+      const gchar *attr_value = compiler->property_values[i];
+
+      if (strcmp (compiler->property_names[i], "name") == 0)
+        {
+          g_free (name);
+          name = g_strdelimit (g_strdup (attr_value), "_", '-');
+        }
+      else if (strcmp (compiler->property_names[i], "translatable") == 0 &&
+               !_gtk_builder_boolean_from_string (attr_value, &translatable, NULL))
+        translatable = TRUE;
+    }
+
+  /* Translations are looked up when loading */
+  if (!name || translatable)
+    {
+      g_free (name);
+      return COMPILED_VALUE_NONE;
+    }
+
+  oclass = g_type_class_ref (object_type);
+  pspec = g_object_class_find_property (oclass, name);
+
+  if (pspec &&
+      compiled_value_kind (G_PARAM_SPEC_VALUE_TYPE (pspec)) != COMPILED_VALUE_NONE &&
+      gtk_builder_value_from_string (compiler->builder, pspec,
+                                     compiler->property_text->str,
+                                     &value, NULL))
+    {
+      kind = compiled_value_kind (G_PARAM_SPEC_VALUE_TYPE (pspec));
+      *value_type = g_type_name (G_PARAM_SPEC_VALUE_TYPE (pspec));
+      compiled_payload_from_value (payload, &value);
+      g_value_unset (&value);
+    }
+
+  g_type_class_unref (oclass);
+  g_free (name);
+
+  return kind;
+}
+
+static void
+compiler_end_property (CompilerData *compiler)
+{
+  CompiledValueKind kind;
+  CompiledPayload payload;
+  const gchar *value_type = NULL;
+
+  compiler_put_uint32 (compiler, COMPILED_OP_PROPERTY);
+  compiler_put_uint32 (compiler, compiler->property_line);
+  compiler_put_attributes (compiler,
+                           (const gchar **) compiler->property_names,
+                           (const gchar **) compiler->property_values);
+  compiler_put_string (compiler, compiler->property_text->str);
+
+  kind = compiler_convert_property (compiler, &value_type, &payload);
+  compiler_put_uint32 (compiler, kind);
+  if (kind != COMPILED_VALUE_NONE)
+    {
+      compiler_put_string (compiler, value_type);
+      g_byte_array_append (compiler->ops, (guint8 *) &payload, sizeof (payload));
+    }
+
+  g_strfreev (compiler->property_names);
+  g_strfreev (compiler->property_values);
+  g_string_free (compiler->property_text, TRUE);
+  compiler->property_names = NULL;
+  compiler->property_values = NULL;
+  compiler->property_text = NULL;
+}
+
+/* @line is the line the start tag ends on in the source. The tag is
+ * padded with newlines so that it ends on the same line, relative to
+ * markup_line, in the markup.
+ */
+static void
+compiler_markup_start (CompilerData  *compiler,
+                       const gchar   *element_name,
+                       const gchar  **names,
+                       const gchar  **values,
+                       gint           line)
+{
+  gchar *escaped;
+  const gchar *p;
+  gint i;
+
+  g_string_append_printf (compiler->markup, "<%s", element_name);
+  for (i = 0; names[i] != NULL; i++)
+    {
+      escaped = g_markup_printf_escaped (" %s=\"%s\"", names[i], values[i]);
+      g_string_append (compiler->markup, escaped);
+      g_free (escaped);
+    }
+
+  for (p = compiler->markup->str + compiler->markup_counted; *p; p++)
+    if (*p == '\n')
+      compiler->markup_lines++;
+  compiler->markup_counted = compiler->markup->len;
+
+  for (; compiler->markup_lines < line - compiler->markup_line + 1; compiler->markup_lines++)
+    g_string_append_c (compiler->markup, '\n');
+  compiler->markup_counted = compiler->markup->len;
+
+  g_string_append_c (compiler->markup, '>');
+
+  compiler->markup_depth++;
+}
+
+static void
+compile_start_element (GMarkupParseContext  *context,
+                       const gchar          *element_name,
+                       const gchar         **names,
+                       const gchar         **values,
+                       gpointer              user_data,
+                       GError              **error)
+{
+  CompilerData *compiler = user_data;
+  const gchar *parent;
+  gint line;
+
+  g_markup_parse_context_get_position (context, &line, NULL);
+
+  if (compiler->markup)
+    {
+      compiler_markup_start (compiler, element_name, names, values, line);
+      return;
+    }
+
+  if (compiler->property_text)
+    {
+      g_set_error (error, GTK_BUILDER_ERROR,
+                   GTK_BUILDER_ERROR_UNHANDLED_TAG,
+                   _("Unhandled tag: '%s'"),
+                   element_name);
+      return;
+    }
+
+  parent = compiler->stack ? compiler->stack->data : NULL;
+
+  if (strcmp (element_name, "property") == 0 &&
+      parent && strcmp (parent, "object") == 0)
+    {
+      compiler->property_names = g_strdupv ((gchar **) names);
+      compiler->property_values = g_strdupv ((gchar **) values);
+      compiler->property_text = g_string_new ("");
+      compiler->property_line = line;
+    }
+  else if (is_builder_tag (element_name) ||
+           strcmp (element_name, "property") == 0)
+    {
+      compiler_put_uint32 (compiler, COMPILED_OP_START);
+      compiler_put_uint32 (compiler, line);
+      compiler_put_string (compiler, element_name);
+      compiler_put_attributes (compiler, names, values);
+
+      if (is_stacked_tag (element_name))
+        compiler->stack = g_slist_prepend (compiler->stack,
+                                           g_strdup (element_name));
+      if (strcmp (element_name, "object") == 0)
+        {
+          GType type = compiler_get_object_type (compiler, names, values);
+
+          compiler->types = g_slist_prepend (compiler->types,
+                                             GSIZE_TO_POINTER (type));
+        }
+    }
+  else
+    {
+      compiler->markup = g_string_new ("");
+      compiler->markup_line = line;
+      compiler->markup_lines = 1;
+      compiler->markup_counted = 0;
+      compiler_markup_start (compiler, element_name, names, values, line);
+    }
+}
+
+static void
+compile_end_element (GMarkupParseContext  *context,
+                     const gchar          *element_name,
+                     gpointer              user_data,
+                     GError              **error)
+{
+  CompilerData *compiler = user_data;
+  gchar *tag;
+
+  if (compiler->markup)
+    {
+      g_string_append_printf (compiler->markup, "</%s>", element_name);
+      if (--compiler->markup_depth > 0)
+        return;
+
+      compiler_put_uint32 (compiler, COMPILED_OP_MARKUP);
+      compiler_put_uint32 (compiler, compiler->markup_line);
+      compiler_put_string (compiler, compiler->markup->str);
+      g_string_free (compiler->markup, TRUE);
+      compiler->markup = NULL;
+      return;
+    }
+
+  if (compiler->property_text)
+    {
+      compiler_end_property (compiler);
+      return;
+    }
+
+  compiler_put_uint32 (compiler, COMPILED_OP_END);
+  compiler_put_uint32 (compiler, 0);
+  compiler_put_string (compiler, element_name);
+
+  if (is_stacked_tag (element_name))
+    {
+      tag = compiler->stack->data;
+      compiler->stack = g_slist_delete_link (compiler->stack, compiler->stack);
+      g_free (tag);
+    }
+  if (strcmp (element_name, "object") == 0)
+    compiler->types = g_slist_delete_link (compiler->types, compiler->types);
+}
+
+static void
+compile_text (GMarkupParseContext  *context,
+              const gchar          *text,
+              gsize                 text_len,
+              gpointer              user_data,
+              GError              **error)
+{
+  CompilerData *compiler = user_data;
+  gchar *escaped;
+
+  if (compiler->markup)
+    {
+      escaped = g_markup_escape_text (text, text_len);
+      g_string_append (compiler->markup, escaped);
+      g_free (escaped);
+    }
+  else if (compiler->property_text)
+    g_string_append_len (compiler->property_text, text, text_len);
+}
+
+static const GMarkupParser compile_parser = {
+  compile_start_element,
+  compile_end_element,
+  compile_text,
+  NULL,
+  NULL
+};
+
+/* Only checks that the markup is well-formed; everything else is
+ * checked when loading the compiled data.
+ */
+GByteArray *
+_gtk_builder_parser_compile_buffer (GtkBuilder   *builder,
+                                    const gchar  *filename,
+                                    const gchar  *buffer,
+                                    gsize         length,
+                                    GError      **error)
+{
+  GMarkupParseContext *context;
+  CompilerData compiler = { NULL, };
+  GByteArray *compiled = NULL;
+  guint32 byte_order = COMPILED_BYTE_ORDER;
+  guint32 n_strings, string_length, i;
+
+  compiler.builder = builder;
+  compiler.string_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  compiler.strings = g_ptr_array_new_with_free_func (g_free);
+  compiler.ops = g_byte_array_new ();
+
+  context = g_markup_parse_context_new (&compile_parser,
+                                        G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                        &compiler, NULL);
+
+  if (!g_markup_parse_context_parse (context, buffer, length, error) ||
+      !g_markup_parse_context_end_parse (context, error))
+    goto out;
+
+  n_strings = compiler.strings->len;
+
+  compiled = g_byte_array_new ();
+  g_byte_array_append (compiled, (guint8 *) COMPILED_MAGIC, 8);
+  g_byte_array_append (compiled, (guint8 *) &byte_order, sizeof (guint32));
+  g_byte_array_append (compiled, (guint8 *) &n_strings, sizeof (guint32));
+  for (i = 0; i < n_strings; i++)
+    {
+      const gchar *string = g_ptr_array_index (compiler.strings, i);
+
+      string_length = strlen (string);
+      g_byte_array_append (compiled, (guint8 *) &string_length, sizeof (guint32));
+      g_byte_array_append (compiled, (guint8 *) string, string_length + 1);
+    }
+  g_byte_array_append (compiled, compiler.ops->data, compiler.ops->len);
+
+  GTK_NOTE (BUILDER,
+            g_print ("compiled %s: %u strings, %u bytes\n",
+                     filename, n_strings, compiled->len));
+
+ out:
+  g_markup_parse_context_free (context);
+  g_slist_foreach (compiler.stack, (GFunc) g_free, NULL);
+  g_slist_free (compiler.stack);
+  g_slist_free (compiler.types);
+  g_strfreev (compiler.property_names);
+  g_strfreev (compiler.property_values);
+  if (compiler.property_text)
+    g_string_free (compiler.property_text, TRUE);
+  if (compiler.markup)
+    g_string_free (compiler.markup, TRUE);
+  g_byte_array_free (compiler.ops, TRUE);
+  g_ptr_array_free (compiler.strings, TRUE);
+  g_hash_table_destroy (compiler.string_ids);
+
+  return compiled;
+}
+
+static gboolean
+compiled_get_data (CompiledReader *reader,
+                   gpointer        data,
+                   gsize           size)
+{
+  if ((gsize) (reader->end - reader->data) < size)
+    return FALSE;
+
+  memcpy (data, reader->data, size);
+  reader->data += size;
+
+  return TRUE;
+}
+
+static gboolean
+compiled_get_uint32 (CompiledReader *reader,
+                     guint32        *value)
+{
+  return compiled_get_data (reader, value, sizeof (guint32));
+}
+
+static gboolean
+compiled_get_string (CompiledReader  *reader,
+                     const gchar    **string,
+                     gsize           *length)
+{
+  guint32 id;
+
+  if (!compiled_get_uint32 (reader, &id))
+    return FALSE;
+
+  if (id == COMPILED_NONE)
+    {
+      *string = NULL;
+      if (length)
+        *length = 0;
+      return TRUE;
+    }
+
+  if (id >= reader->n_strings)
+    return FALSE;
+
+  *string = reader->strings[id];
+  if (length)
+    *length = reader->lengths[id];
+
+  return TRUE;
+}
+
+static gboolean
+compiled_read_strings (CompiledReader *reader)
+{
+  guint32 byte_order, i;
+
+  if ((gsize) (reader->end - reader->data) < 8 ||
+      memcmp (reader->data, COMPILED_MAGIC, 8) != 0)
+    return FALSE;
+  reader->data += 8;
+
+  if (!compiled_get_uint32 (reader, &byte_order) ||
+      byte_order != COMPILED_BYTE_ORDER ||
+      !compiled_get_uint32 (reader, &reader->n_strings) ||
+      reader->n_strings > (gsize) (reader->end - reader->data) / 5)
+    return FALSE;
+
+  reader->strings = g_new (const gchar *, reader->n_strings);
+  reader->lengths = g_new (guint32, reader->n_strings);
+
+  for (i = 0; i < reader->n_strings; i++)
+    {
+      if (!compiled_get_uint32 (reader, &reader->lengths[i]) ||
+          (gsize) (reader->end - reader->data) <= reader->lengths[i] ||
+          reader->data[reader->lengths[i]] != '\0')
+        return FALSE;
+
+      reader->strings[i] = reader->data;
+      reader->data += reader->lengths[i] + 1;
+    }
+
+  return TRUE;
+}
+
+/* Anything else is replayed as markup */
+static gboolean
+compiled_is_builder_tag (const gchar *element_name)
+{
+  return element_name &&
+         (is_builder_tag (element_name) ||
+          strcmp (element_name, "property") == 0);
+}
+
+static gboolean
+compiled_get_attributes (CompiledReader   *reader,
+                         const gchar    ***names,
+                         const gchar    ***values)
+{
+  guint32 i, n_attributes;
+
+  if (!compiled_get_uint32 (reader, &n_attributes) ||
+      n_attributes > (gsize) (reader->end - reader->data) / 8)
+    return FALSE;
+
+  *names = g_new0 (const gchar *, n_attributes + 1);
+  *values = g_new0 (const gchar *, n_attributes + 1);
+
+  for (i = 0; i < n_attributes; i++)
+    {
+      if (!compiled_get_string (reader, &(*names)[i], NULL) ||
+          !compiled_get_string (reader, &(*values)[i], NULL) ||
+          !(*names)[i] || !(*values)[i])
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+replay_property (ParserData      *data,
+                 CompiledReader  *reader,
+                 const gchar    **names,
+                 const gchar    **values,
+                 GError         **error)
+{
+  PropertyInfo *prop_info;
+  const gchar *text, *value_type = NULL;
+  gsize text_length;
+  guint32 kind;
+  CompiledPayload payload;
+
+  if (!compiled_get_string (reader, &text, &text_length) || !text ||
+      !compiled_get_uint32 (reader, &kind) ||
+      kind > COMPILED_VALUE_DOUBLE)
+    return FALSE;
+
+  if (kind != COMPILED_VALUE_NONE &&
+      (!compiled_get_string (reader, &value_type, NULL) || !value_type ||
+       !compiled_get_data (reader, &payload, sizeof (payload))))
+    return FALSE;
+
+  start_element (NULL, "property", names, values, data, error);
+  if (*error)
+    return TRUE;
+
+  if (data->deferred)
+    {
+      deferred_text (data, text, text_length);
+      end_element (NULL, "property", data, error);
+      return TRUE;
+    }
+
+  /* Properties outside of the requested objects are skipped */
+  prop_info = state_peek_info (data, PropertyInfo);
+  if (!prop_info || strcmp (prop_info->tag.name, "property") != 0)
+    return TRUE;
+
+  g_string_append_len (prop_info->text, text, text_length);
+
+  if (kind != COMPILED_VALUE_NONE)
+    {
+      prop_info->value_type = value_type;
+      switch (kind)
+        {
+        case COMPILED_VALUE_INT64:
+          g_value_init (&prop_info->value, G_TYPE_INT64);
+          g_value_set_int64 (&prop_info->value, payload.i);
+          break;
+        case COMPILED_VALUE_UINT64:
+          g_value_init (&prop_info->value, G_TYPE_UINT64);
+          g_value_set_uint64 (&prop_info->value, payload.u);
+          break;
+        case COMPILED_VALUE_DOUBLE:
+          g_value_init (&prop_info->value, G_TYPE_DOUBLE);
+          g_value_set_double (&prop_info->value, payload.d);
+          break;
+        }
+    }
+
+  end_element (NULL, "property", data, error);
+
+  return TRUE;
+}
+
+static gboolean
+replay_markup (ParserData      *data,
+               CompiledReader  *reader,
+               GError         **error)
+{
+  static const gchar newlines[] =
+    "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n";
+  const gchar *markup;
+  gsize length;
+  gboolean parsed = TRUE;
+  gint line, n;
+
+  if (!compiled_get_string (reader, &markup, &length) || !markup)
+    return FALSE;
+
+  data->ctx = g_markup_parse_context_new (&parser,
+                                          G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                          data, NULL);
+
+  /* Start the markup on the line it came from, so that the positions
+   * that the builder and custom tag parsers report are those in the
+   * source file.
+   */
+  for (line = 1; parsed && line < data->line; line += n)
+    {
+      n = MIN (data->line - line, (gint) sizeof (newlines) - 1);
+      parsed = g_markup_parse_context_parse (data->ctx, newlines, n, error);
+    }
+
+  if (parsed &&
+      g_markup_parse_context_parse (data->ctx, markup, length, error))
+    g_markup_parse_context_end_parse (data->ctx, error);
+
+  g_markup_parse_context_free (data->ctx);
+  data->ctx = NULL;
+
+  return TRUE;
+}
+
+static void
+parse_compiled (ParserData   *data,
+                const gchar  *buffer,
+                gsize         length,
+                GError      **error)
+{
+  CompiledReader reader = { NULL, };
+  const gchar **names = NULL, **values = NULL;
+  const gchar *element_name;
+  GError *tmp_error = NULL;
+  guint32 op, line;
+  gboolean valid;
+
+  reader.data = buffer;
+  reader.end = buffer + length;
+
+  valid = compiled_read_strings (&reader);
+
+  while (valid && !tmp_error && reader.data < reader.end)
+    {
+      if (!compiled_get_uint32 (&reader, &op) ||
+          !compiled_get_uint32 (&reader, &line))
+        {
+          valid = FALSE;
+          break;
+        }
+
+      if (line)
+        data->line = line;
+
+      switch (op)
+        {
+        case COMPILED_OP_START:
+          valid = compiled_get_string (&reader, &element_name, NULL) &&
+                  compiled_is_builder_tag (element_name) &&
+                  compiled_get_attributes (&reader, &names, &values);
+          if (valid)
+            start_element (NULL, element_name, names, values, data, &tmp_error);
+          break;
+
+        case COMPILED_OP_END:
+          valid = compiled_get_string (&reader, &element_name, NULL) &&
+                  compiled_is_builder_tag (element_name);
+          if (valid)
+            end_element (NULL, element_name, data, &tmp_error);
+          break;
+
+        case COMPILED_OP_PROPERTY:
+          valid = compiled_get_attributes (&reader, &names, &values) &&
+                  replay_property (data, &reader, names, values, &tmp_error);
+          break;
+
+        case COMPILED_OP_MARKUP:
+          valid = replay_markup (data, &reader, &tmp_error);
+          break;
+
+        default:
+          valid = FALSE;
+          break;
+        }
+
+      g_free (names);
+      g_free (values);
+      names = values = NULL;
+    }
+
+  if (tmp_error)
+    g_propagate_error (error, tmp_error);
+  else if (!valid)
+    g_set_error (error,
+                 GTK_BUILDER_ERROR,
+                 GTK_BUILDER_ERROR_INVALID_VALUE,
+                 "%s: invalid compiled UI definition",
+                 data->filename);
+
+  g_free (reader.strings);
+  g_free (reader.lengths);
+}
+
 void
 _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
                                   const gchar  *filename,
@@ -1155,12 +2269,27 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
       data->inside_requested_object = TRUE;
     }
 
-  data->ctx = g_markup_parse_context_new (&parser, 
-                                          G_MARKUP_TREAT_CDATA_AS_TEXT, 
-                                          data, NULL);
+  if (length != (gsize) -1 && length >= 8 &&
+      memcmp (buffer, COMPILED_MAGIC, 8) == 0)
+    {
+      GError *tmp_error = NULL;
 
-  if (!g_markup_parse_context_parse (data->ctx, buffer, length, error))
-    goto out;
+      parse_compiled (data, buffer, length, &tmp_error);
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
+          goto out;
+        }
+    }
+  else
+    {
+      data->ctx = g_markup_parse_context_new (&parser, 
+                                              G_MARKUP_TREAT_CDATA_AS_TEXT, 
+                                              data, NULL);
+
+      if (!g_markup_parse_context_parse (data->ctx, buffer, length, error))
+        goto out;
+    }
 
   _gtk_builder_finish (builder);
 
@@ -1194,9 +2323,14 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
   g_slist_free (data->finalizers);
   g_slist_foreach (data->requested_objects, (GFunc) g_free, NULL);
   g_slist_free (data->requested_objects);
+  if (data->deferred)
+    g_string_free (data->deferred, TRUE);
+  g_slist_foreach (data->deferred_ids, (GFunc) g_free, NULL);
+  g_slist_free (data->deferred_ids);
   g_free (data->domain);
   g_hash_table_destroy (data->object_ids);
-  g_markup_parse_context_free (data->ctx);
+  if (data->ctx)
+    g_markup_parse_context_free (data->ctx);
   g_free (data);
 
   /* restore the original domain */
@@ -59,6 +59,9 @@ typedef struct {
   gchar *data;
   gboolean translatable;
   gchar *context;
+  /* Converted by gtk_builder_compile_file() already */
+  const gchar *value_type;
+  GValue value;
 } PropertyInfo;
 
 typedef struct {
@@ -103,6 +106,14 @@ typedef struct {
   gint cur_object_level;
 
   GHashTable *object_ids;
+
+  /* Line of the operation being replayed from a compiled file */
+  gint line;
+
+  /* Markup and ids of the deferred object being recorded */
+  GString *deferred;
+  gint deferred_depth;
+  GSList *deferred_ids;
 } ParserData;
 
 typedef GType (*GTypeGetFunc) (void);
@@ -114,6 +125,14 @@ void _gtk_builder_parser_parse_buffer (GtkBuilder *builder,
                                        gsize length,
                                        gchar **requested_objs,
                                        GError **error);
+GByteArray * _gtk_builder_parser_compile_buffer (GtkBuilder  *builder,
+                                                 const gchar *filename,
+                                                 const gchar *buffer,
+                                                 gsize        length,
+                                                 GError     **error);
+gboolean  _gtk_builder_value_from_compiled (GValue       *value,
+                                            GType         type,
+                                            const GValue *compiled);
 GObject * _gtk_builder_construct (GtkBuilder *builder,
                                   ObjectInfo *info,
 				  GError    **error);
@@ -122,6 +141,11 @@ void      _gtk_builder_add (GtkBuilder *builder,
 void      _gtk_builder_add_signals (GtkBuilder *builder,
 				    GSList     *signals);
 void      _gtk_builder_finish (GtkBuilder *builder);
+void      _gtk_builder_add_deferred (GtkBuilder  *builder,
+                                     const gchar *filename,
+                                     const gchar *domain,
+                                     gchar       *markup,
+                                     GSList      *ids);
 void _free_signal_info (SignalInfo *info,
                         gpointer user_data);
 
@@ -64,7 +64,8 @@ enum {
   PROP_FOLLOW_STATE,
   PROP_ICON_NAME,
   PROP_GICON,
-  PROP_ICON_SET
+  PROP_ICON_SET,
+  PROP_LOAD_ASYNC
 };
 
 
@@ -81,6 +82,7 @@ struct _GtkCellRendererPixbufPrivate
   GIcon *gicon;
   GtkIconSet *icon_set;
   gdouble render_scale;
+  gboolean load_async;
 };
 
 G_DEFINE_TYPE (GtkCellRendererPixbuf, gtk_cell_renderer_pixbuf, GTK_TYPE_CELL_RENDERER)
@@ -218,6 +220,24 @@ gtk_cell_renderer_pixbuf_class_init (GtkCellRendererPixbufClass *class)
                                                         G_TYPE_ICON,
                                                         GTK_PARAM_READWRITE));
 
+  /**
+   * GtkCellRendererPixbuf:load-async:
+   *
+   * Whether themed icons that aren't loaded yet are loaded in the
+   * background, see gtk_icon_info_load_icon_async(). Until an icon
+   * is loaded, the cell is left empty, and the widget is redrawn
+   * once it is. This keeps views with many different icons
+   * responsive while they are first shown.
+   *
+   * Since: 2.24
+   */
+  g_object_class_install_property (object_class,
+				   PROP_LOAD_ASYNC,
+				   g_param_spec_boolean ("load-async",
+ 							 P_("Load asynchronously"),
+ 							 P_("Whether themed icons are loaded in the background"),
+ 							 FALSE,
+ 							 GTK_PARAM_READWRITE));
 
 
   g_type_class_add_private (object_class, sizeof (GtkCellRendererPixbufPrivate));
@@ -291,6 +311,9 @@ gtk_cell_renderer_pixbuf_get_property (GObject        *object,
     case PROP_ICON_SET:
       g_value_set_boxed (value, priv->icon_set);
       break;
+    case PROP_LOAD_ASYNC:
+      g_value_set_boolean (value, priv->load_async);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
       break;
@@ -425,6 +448,9 @@ gtk_cell_renderer_pixbuf_set_property (GObject      *object,
     case PROP_FOLLOW_STATE:
       priv->follow_state = g_value_get_boolean (value);
       break;
+    case PROP_LOAD_ASYNC:
+      priv->load_async = g_value_get_boolean (value);
+      break;
     case PROP_GICON:
       if (priv->gicon)
 	{
@@ -550,6 +576,63 @@ gtk_cell_renderer_pixbuf_create_stock_pixbuf (GtkCellRendererPixbuf *cellpixbuf,
   g_object_notify (G_OBJECT (cellpixbuf), "pixbuf");
 }
 
+typedef struct
+{
+  GtkCellRendererPixbuf *cellpixbuf;
+  GtkWidget *widget;
+  GdkPixbuf *placeholder;
+} ThemedPixbufLoad;
+
+static void
+themed_pixbuf_loaded (GObject      *source,
+		      GAsyncResult *result,
+		      gpointer      data)
+{
+  ThemedPixbufLoad *load = data;
+  GtkCellRendererPixbuf *cellpixbuf = load->cellpixbuf;
+
+  /* Placeholders are only ever handed out as such, so if the cell
+   * still has this one, it is waiting for an icon. That need not be
+   * the icon that was loaded here, since the cell may have moved on
+   * to another row; dropping the placeholder makes the cell look its
+   * icon up again, and find it loaded.
+   */
+  if (cellpixbuf->pixbuf == load->placeholder)
+    {
+      g_object_unref (cellpixbuf->pixbuf);
+      cellpixbuf->pixbuf = NULL;
+      g_object_notify (G_OBJECT (cellpixbuf), "pixbuf");
+    }
+
+  gtk_widget_queue_draw (load->widget);
+
+  g_object_unref (load->cellpixbuf);
+  g_object_unref (load->widget);
+  g_object_unref (load->placeholder);
+  g_slice_free (ThemedPixbufLoad, load);
+}
+
+static GdkPixbuf *
+load_themed_pixbuf_async (GtkCellRendererPixbuf *cellpixbuf,
+			  GtkIconInfo           *info,
+			  GtkWidget             *widget,
+			  gint                   size)
+{
+  ThemedPixbufLoad *load;
+
+  if (_gtk_icon_info_is_loaded (info))
+    return gtk_icon_info_load_icon (info, NULL);
+
+  load = g_slice_new (ThemedPixbufLoad);
+  load->cellpixbuf = g_object_ref (cellpixbuf);
+  load->widget = g_object_ref (widget);
+  load->placeholder = _gtk_icon_info_get_placeholder (size);
+
+  gtk_icon_info_load_icon_async (info, NULL, themed_pixbuf_loaded, load);
+
+  return g_object_ref (load->placeholder);
+}
+
 static void 
 gtk_cell_renderer_pixbuf_create_themed_pixbuf (GtkCellRendererPixbuf *cellpixbuf,
 					       GtkWidget             *widget)
@@ -589,6 +672,21 @@ gtk_cell_renderer_pixbuf_create_themed_pixbuf (GtkCellRendererPixbuf *cellpixbuf
                                        gtk_widget_get_state (widget),
                                        priv->stock_size, widget,
                                        NULL, &priv->render_scale);
+  else if (priv->icon_name && priv->load_async)
+    {
+      GtkIconInfo *info;
+
+      info = gtk_icon_theme_lookup_icon (icon_theme,
+                                         priv->icon_name,
+                                         MIN (width, height),
+                                         GTK_ICON_LOOKUP_USE_BUILTIN);
+      if (info)
+        {
+          cellpixbuf->pixbuf = load_themed_pixbuf_async (cellpixbuf, info, widget,
+                                                         MIN (width, height));
+          gtk_icon_info_free (info);
+        }
+    }
   else if (priv->icon_name)
     cellpixbuf->pixbuf = gtk_icon_theme_load_icon (icon_theme,
 			                           priv->icon_name,
@@ -605,7 +703,11 @@ gtk_cell_renderer_pixbuf_create_themed_pixbuf (GtkCellRendererPixbuf *cellpixbuf
                                              GTK_ICON_LOOKUP_USE_BUILTIN);
       if (info)
         {
-          cellpixbuf->pixbuf = gtk_icon_info_load_icon (info, NULL);
+          if (priv->load_async)
+            cellpixbuf->pixbuf = load_themed_pixbuf_async (cellpixbuf, info, widget,
+                                                           MIN (width, height));
+          else
+            cellpixbuf->pixbuf = gtk_icon_info_load_icon (info, NULL);
           gtk_icon_info_free (info);
         }
     }
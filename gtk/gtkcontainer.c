@@ -1334,11 +1334,15 @@ gtk_container_get_resize_container (GtkContainer *container)
   return GTK_IS_RESIZE_CONTAINER (widget) ? (GtkContainer*) widget : NULL;
 }
 
+/* Runs in the layout phase of the frame, right before the frame
+ * paints what the new allocations invalidated.
+ */
 static gboolean
-gtk_container_idle_sizer (gpointer data)
+gtk_container_idle_sizer (gint64   frame_time,
+                          gpointer data)
 {
   /* we may be invoked with a container_resize_queue of NULL, because
-   * queue_resize could have been adding an extra idle function while
+   * queue_resize could have been adding an extra frame callback while
    * the queue still got processed. we better just ignore such case
    * than trying to explicitely work around them with some extra flags,
    * since it doesn't cause any actual harm.
@@ -1357,8 +1361,6 @@ gtk_container_idle_sizer (gpointer data)
       gtk_container_check_resize (GTK_CONTAINER (widget));
     }
 
-  gdk_window_process_all_updates ();
-
   return FALSE;
 }
 
@@ -1397,9 +1399,9 @@ _gtk_container_queue_resize (GtkContainer *container)
 		{
 		  GTK_PRIVATE_SET_FLAG (resize_container, GTK_RESIZE_PENDING);
 		  if (container_resize_queue == NULL)
-		    gdk_threads_add_idle_full (GTK_PRIORITY_RESIZE,
-				     gtk_container_idle_sizer,
-				     NULL, NULL);
+		    gdk_frame_clock_add_callback (GDK_FRAME_PHASE_LAYOUT,
+						  gtk_container_idle_sizer,
+						  NULL, NULL);
 		  container_resize_queue = g_slist_prepend (container_resize_queue, resize_container);
 		}
 	      break;
@@ -51,12 +51,22 @@
 #define GET_UINT16(cache, offset) (GUINT16_FROM_BE (*(guint16 *)((cache) + (offset))))
 #define GET_UINT32(cache, offset) (GUINT32_FROM_BE (*(guint32 *)((cache) + (offset))))
 
+/* Image flags, as written by gtk-update-icon-cache */
+#define HAS_SUFFIX_XPM (1 << 0)
+#define HAS_SUFFIX_SVG (1 << 1)
+#define HAS_SUFFIX_PNG (1 << 2)
+#define HAS_ICON_FILE  (1 << 3)
+
+/* Directory stamp of a per-user cache for a directory that doesn't exist */
+#define MISSING_DIRECTORY 0xffffffff
 
 struct _GtkIconCache {
   gint ref_count;
 
   GMappedFile *map;
   gchar *buffer;
+  /* Per-user caches that were just built are kept in memory */
+  gchar *data;
 
   guint32 last_chain_offset;
 };
@@ -80,6 +90,7 @@ _gtk_icon_cache_unref (GtkIconCache *cache)
 
       if (cache->map)
 	g_mapped_file_unref (cache->map);
+      g_free (cache->data);
       g_free (cache);
     }
 }
@@ -568,3 +579,387 @@ _gtk_icon_cache_get_icon_data  (GtkIconCache *cache,
   return data;
 }
 
+
+/* Per-user caches
+ *
+ * Directories that have no icon-theme.cache get one in the user's
+ * cache directory when they are first scanned. It has the layout that
+ * gtk-update-icon-cache writes, without image data. The mtimes of the
+ * scanned directories follow the offsets of the directory list, so
+ * that the cache can be checked without reading the directories.
+ */
+
+typedef struct
+{
+  guint16 directory_index;
+  guint16 flags;
+} UserCacheImage;
+
+static gchar *
+user_cache_filename (const gchar *path)
+{
+  gchar *checksum;
+  gchar *basename;
+  gchar *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, path, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  filename = g_build_filename (g_get_user_cache_dir (),
+			       "gtk-2.0", "icon-theme", basename, NULL);
+  g_free (basename);
+  g_free (checksum);
+
+  return filename;
+}
+
+static guint32 *
+get_directory_stamps (const gchar  *path,
+		      const gchar **subdirs,
+		      gint          n_subdirs)
+{
+  guint32 *stamps;
+  struct stat st;
+  gchar *dir;
+  gint i;
+
+  stamps = g_new (guint32, n_subdirs);
+
+  for (i = 0; i < n_subdirs; i++)
+    {
+      dir = g_build_filename (path, subdirs[i], NULL);
+
+      if (g_stat (dir, &st) == 0 && S_ISDIR (st.st_mode))
+	stamps[i] = st.st_mtime;
+      else
+	stamps[i] = MISSING_DIRECTORY;
+
+      g_free (dir);
+    }
+
+  return stamps;
+}
+
+static gboolean
+user_cache_is_valid (const gchar    *buffer,
+		     gsize           size,
+		     const gchar   **subdirs,
+		     const guint32  *stamps,
+		     gint            n_subdirs)
+{
+  CacheInfo info;
+  guint32 dir_list_offset;
+  gint i;
+
+  info.cache = buffer;
+  info.cache_size = size;
+  info.n_directories = 0;
+  info.flags = CHECK_OFFSETS|CHECK_STRINGS;
+
+  if (!_gtk_icon_cache_validate (&info) ||
+      info.n_directories != n_subdirs)
+    return FALSE;
+
+  dir_list_offset = GET_UINT32 (buffer, 8);
+  if (dir_list_offset + 4 + 8 * n_subdirs > size)
+    return FALSE;
+
+  for (i = 0; i < n_subdirs; i++)
+    {
+      guint32 name_offset = GET_UINT32 (buffer, dir_list_offset + 4 + 4 * i);
+
+      if (strcmp (buffer + name_offset, subdirs[i]) != 0 ||
+	  GET_UINT32 (buffer, dir_list_offset + 4 + 4 * (n_subdirs + i)) != stamps[i])
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+free_images (GArray *images)
+{
+  g_array_free (images, TRUE);
+}
+
+/* Returns the images in the directories by icon name */
+static GHashTable *
+scan_directories (const gchar    *path,
+		  const gchar   **subdirs,
+		  const guint32  *stamps,
+		  gint            n_subdirs)
+{
+  GHashTable *icons;
+  GHashTable *dir_icons;
+  GHashTableIter iter;
+  gpointer key, value;
+  GDir *gdir;
+  const gchar *name;
+  gchar *dir;
+  gint i;
+
+  icons = g_hash_table_new_full (g_str_hash, g_str_equal,
+				 g_free, (GDestroyNotify)free_images);
+  dir_icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (i = 0; i < n_subdirs; i++)
+    {
+      if (stamps[i] == MISSING_DIRECTORY)
+	continue;
+
+      dir = g_build_filename (path, subdirs[i], NULL);
+      gdir = g_dir_open (dir, 0, NULL);
+      g_free (dir);
+
+      if (gdir == NULL)
+	continue;
+
+      GTK_NOTE (ICONTHEME,
+		g_print ("scanning %s/%s for the user cache\n", path, subdirs[i]));
+
+      while ((name = g_dir_read_name (gdir)))
+	{
+	  guint flags;
+
+	  if (g_str_has_suffix (name, ".png"))
+	    flags = HAS_SUFFIX_PNG;
+	  else if (g_str_has_suffix (name, ".svg"))
+	    flags = HAS_SUFFIX_SVG;
+	  else if (g_str_has_suffix (name, ".xpm"))
+	    flags = HAS_SUFFIX_XPM;
+	  else if (g_str_has_suffix (name, ".icon"))
+	    flags = HAS_ICON_FILE;
+	  else
+	    continue;
+
+	  key = g_strndup (name, strrchr (name, '.') - name);
+	  flags |= GPOINTER_TO_UINT (g_hash_table_lookup (dir_icons, key));
+	  g_hash_table_replace (dir_icons, key, GUINT_TO_POINTER (flags));
+	}
+
+      g_dir_close (gdir);
+
+      g_hash_table_iter_init (&iter, dir_icons);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+	  UserCacheImage image;
+	  GArray *images;
+
+	  /* .icon files without an image aren't icons */
+	  if (GPOINTER_TO_UINT (value) == HAS_ICON_FILE)
+	    continue;
+
+	  images = g_hash_table_lookup (icons, key);
+	  if (images == NULL)
+	    {
+	      images = g_array_new (FALSE, FALSE, sizeof (UserCacheImage));
+	      g_hash_table_insert (icons, g_strdup (key), images);
+	    }
+
+	  image.directory_index = i;
+	  image.flags = GPOINTER_TO_UINT (value);
+	  g_array_append_val (images, image);
+	}
+
+      g_hash_table_remove_all (dir_icons);
+    }
+
+  g_hash_table_destroy (dir_icons);
+
+  return icons;
+}
+
+static void
+append_uint16 (GByteArray *data,
+	       guint16     value)
+{
+  value = GUINT16_TO_BE (value);
+  g_byte_array_append (data, (guint8 *)&value, 2);
+}
+
+static void
+append_uint32 (GByteArray *data,
+	       guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  g_byte_array_append (data, (guint8 *)&value, 4);
+}
+
+static void
+set_uint32 (GByteArray *data,
+	    guint32     offset,
+	    guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  memcpy (data->data + offset, &value, 4);
+}
+
+static void
+append_string (GByteArray  *data,
+	       const gchar *string)
+{
+  static const guint8 padding[4] = { 0, };
+
+  g_byte_array_append (data, (guint8 *)string, strlen (string) + 1);
+  g_byte_array_append (data, padding, (4 - data->len % 4) % 4);
+}
+
+static GByteArray *
+build_user_cache (GHashTable     *icons,
+		  const gchar   **subdirs,
+		  const guint32  *stamps,
+		  gint            n_subdirs)
+{
+  GByteArray *data;
+  GHashTableIter iter;
+  gpointer key, value;
+  guint32 hash_offset, dir_list_offset;
+  guint32 n_buckets;
+  gint i;
+
+  data = g_byte_array_new ();
+
+  append_uint16 (data, MAJOR_VERSION);
+  append_uint16 (data, MINOR_VERSION);
+  append_uint32 (data, 0);
+  append_uint32 (data, 0);
+
+  hash_offset = data->len;
+  set_uint32 (data, 4, hash_offset);
+
+  n_buckets = g_spaced_primes_closest (g_hash_table_size (icons) / 3);
+  append_uint32 (data, n_buckets);
+  for (i = 0; i < n_buckets; i++)
+    append_uint32 (data, 0xffffffff);
+
+  g_hash_table_iter_init (&iter, icons);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GArray *images = value;
+      guint32 bucket_offset, chain_offset;
+
+      bucket_offset = hash_offset + 4 + 4 * (icon_name_hash (key) % n_buckets);
+      chain_offset = data->len;
+
+      /* Chain entries are prepended to the bucket */
+      append_uint32 (data, GET_UINT32 (data->data, bucket_offset));
+      append_uint32 (data, chain_offset + 12);
+      append_uint32 (data, 0);
+      set_uint32 (data, bucket_offset, chain_offset);
+
+      append_string (data, key);
+
+      set_uint32 (data, chain_offset + 8, data->len);
+      append_uint32 (data, images->len);
+      for (i = 0; i < images->len; i++)
+	{
+	  UserCacheImage *image = &g_array_index (images, UserCacheImage, i);
+
+	  append_uint16 (data, image->directory_index);
+	  append_uint16 (data, image->flags);
+	  append_uint32 (data, 0);
+	}
+    }
+
+  dir_list_offset = data->len;
+  set_uint32 (data, 8, dir_list_offset);
+
+  append_uint32 (data, n_subdirs);
+  for (i = 0; i < n_subdirs; i++)
+    append_uint32 (data, 0);
+  for (i = 0; i < n_subdirs; i++)
+    append_uint32 (data, stamps[i]);
+  for (i = 0; i < n_subdirs; i++)
+    {
+      set_uint32 (data, dir_list_offset + 4 + 4 * i, data->len);
+      append_string (data, subdirs[i]);
+    }
+
+  return data;
+}
+
+/* Gets a cache of the icons in @subdirs of @path, for a directory
+ * that has no icon-theme.cache. The directory indices of the cache
+ * are the positions in @subdirs. The cache is rebuilt when the mtime
+ * of any of the subdirectories changes.
+ */
+GtkIconCache *
+_gtk_icon_cache_new_for_user (const gchar  *path,
+			      const gchar **subdirs)
+{
+  GtkIconCache *cache;
+  GMappedFile *map;
+  GHashTable *icons;
+  GByteArray *data;
+  guint32 *stamps;
+  gchar *filename;
+  gchar *dirname;
+  GTimeVal now;
+  gint n_subdirs, i;
+
+  n_subdirs = g_strv_length ((gchar **)subdirs);
+  if (n_subdirs == 0)
+    return NULL;
+
+  stamps = get_directory_stamps (path, subdirs, n_subdirs);
+  filename = user_cache_filename (path);
+
+  cache = g_new0 (GtkIconCache, 1);
+  cache->ref_count = 1;
+
+  map = g_mapped_file_new (filename, FALSE, NULL);
+  if (map)
+    {
+      if (user_cache_is_valid (g_mapped_file_get_contents (map),
+			       g_mapped_file_get_length (map),
+			       subdirs, stamps, n_subdirs))
+	{
+	  GTK_NOTE (ICONTHEME,
+		    g_print ("found user cache for %s\n", path));
+
+	  cache->map = map;
+	  cache->buffer = g_mapped_file_get_contents (map);
+
+	  goto done;
+	}
+
+      GTK_NOTE (ICONTHEME,
+		g_print ("user cache for %s outdated\n", path));
+
+      g_mapped_file_unref (map);
+    }
+
+  icons = scan_directories (path, subdirs, stamps, n_subdirs);
+  data = build_user_cache (icons, subdirs, stamps, n_subdirs);
+  g_hash_table_destroy (icons);
+
+  /* A directory that changed within this second can change again
+   * without its mtime changing, so it is scanned again next time.
+   * Not being able to write the cache only costs the next start, too.
+   */
+  g_get_current_time (&now);
+  for (i = 0; i < n_subdirs; i++)
+    if (stamps[i] != MISSING_DIRECTORY && stamps[i] >= now.tv_sec)
+      break;
+
+  if (i < n_subdirs)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("not writing user cache for %s, it just changed\n", path));
+    }
+  else
+    {
+      dirname = g_path_get_dirname (filename);
+      if (g_mkdir_with_parents (dirname, 0700) == 0)
+	g_file_set_contents (filename, (gchar *)data->data, data->len, NULL);
+      g_free (dirname);
+    }
+
+  cache->data = (gchar *)g_byte_array_free (data, FALSE);
+  cache->buffer = cache->data;
+
+ done:
+  g_free (filename);
+  g_free (stamps);
+
+  return cache;
+}
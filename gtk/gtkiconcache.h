@@ -38,6 +38,8 @@ struct _GtkIconData
 
 GtkIconCache *_gtk_icon_cache_new            (const gchar  *data);
 GtkIconCache *_gtk_icon_cache_new_for_path   (const gchar  *path);
+GtkIconCache *_gtk_icon_cache_new_for_user   (const gchar  *path,
+					      const gchar **subdirs);
 gint          _gtk_icon_cache_get_directory_index  (GtkIconCache *cache,
 					            const gchar  *directory);
 gboolean      _gtk_icon_cache_has_icon       (GtkIconCache *cache,
@@ -1118,6 +1118,7 @@ static void       attach_to_style   (GtkIconSet       *icon_set,
 static void       detach_from_style (GtkIconSet       *icon_set,
                                      GtkStyle         *style);
 static void       style_dnotify     (gpointer          data);
+static void       shrink_cached_icons (void);
 
 struct _GtkIconSet
 {
@@ -1125,7 +1126,7 @@ struct _GtkIconSet
 
   GSList *sources;
 
-  /* Cache of the last few rendered versions of the icon. */
+  /* Cache of the recently rendered versions of the icon. */
   GSList *cache;
 
   guint cache_size;
@@ -1291,6 +1292,7 @@ gtk_icon_set_copy (GtkIconSet *icon_set)
   copy->cache = copy_cache (icon_set, copy);
   copy->cache_size = icon_set->cache_size;
   copy->cache_serial = icon_set->cache_serial;
+  shrink_cached_icons ();
 
   return copy;
 }
@@ -2544,7 +2546,11 @@ gtk_icon_source_get_scale (const GtkIconSource *source)
   return source->scale;
 }
 
-#define NUM_CACHED_ICONS 8
+/* The rendered icons of all icon sets share one budget, so that sets
+ * that are drawn in many states and sizes keep them all, as long as
+ * the least recently used icons of other sets can make room.
+ */
+#define CACHED_ICONS_MAX_SIZE (2 * 1024 * 1024)
 
 typedef struct _CachedIcon CachedIcon;
 
@@ -2560,8 +2566,16 @@ struct _CachedIcon
   gdouble scale;
 
   GdkPixbuf *pixbuf;
+
+  /* In cached_icons, most recently used first */
+  GtkIconSet *icon_set;
+  GList link;
+  gsize n_bytes;
 };
 
+static GQueue cached_icons = G_QUEUE_INIT;
+static gsize cached_icons_size = 0;
+
 static void
 ensure_cache_up_to_date (GtkIconSet *icon_set)
 {
@@ -2572,9 +2586,31 @@ ensure_cache_up_to_date (GtkIconSet *icon_set)
     }
 }
 
+static CachedIcon *
+cached_icon_new (GtkIconSet *icon_set,
+                 GdkPixbuf  *pixbuf)
+{
+  CachedIcon *icon;
+
+  icon = g_new0 (CachedIcon, 1);
+  icon->icon_set = icon_set;
+  icon->pixbuf = g_object_ref (pixbuf);
+  icon->n_bytes = sizeof (CachedIcon) +
+    gdk_pixbuf_get_rowstride (pixbuf) * gdk_pixbuf_get_height (pixbuf);
+  icon->link.data = icon;
+
+  g_queue_push_head_link (&cached_icons, &icon->link);
+  cached_icons_size += icon->n_bytes;
+
+  return icon;
+}
+
 static void
 cached_icon_free (CachedIcon *icon)
 {
+  g_queue_unlink (&cached_icons, &icon->link);
+  cached_icons_size -= icon->n_bytes;
+
   g_object_unref (icon->pixbuf);
 
   if (icon->style)
@@ -2583,6 +2619,25 @@ cached_icon_free (CachedIcon *icon)
   g_free (icon);
 }
 
+/* Drops the least recently used icons of any set, but never the
+ * newest one.
+ */
+static void
+shrink_cached_icons (void)
+{
+  while (cached_icons_size > CACHED_ICONS_MAX_SIZE &&
+         cached_icons.length > 1)
+    {
+      CachedIcon *icon = cached_icons.tail->data;
+      GtkIconSet *icon_set = icon->icon_set;
+
+      icon_set->cache = g_slist_remove (icon_set->cache, icon);
+      icon_set->cache_size--;
+
+      cached_icon_free (icon);
+    }
+}
+
 static GdkPixbuf *
 find_in_cache (GtkIconSet      *icon_set,
                GtkStyle        *style,
@@ -2617,6 +2672,9 @@ find_in_cache (GtkIconSet      *icon_set,
               icon_set->cache = tmp_list;
             }
 
+          g_queue_unlink (&cached_icons, &icon->link);
+          g_queue_push_head_link (&cached_icons, &icon->link);
+
           return icon->pixbuf;
         }
 
@@ -2640,8 +2698,6 @@ add_to_cache (GtkIconSet      *icon_set,
 
   ensure_cache_up_to_date (icon_set);
 
-  g_object_ref (pixbuf);
-
   /* We have to ref the style, since if the style was finalized
    * its address could be reused by another style, creating a
    * really weird bug
@@ -2650,7 +2706,7 @@ add_to_cache (GtkIconSet      *icon_set,
   if (style)
     g_object_ref (style);
 
-  icon = g_new (CachedIcon, 1);
+  icon = cached_icon_new (icon_set, pixbuf);
   icon_set->cache = g_slist_prepend (icon_set->cache, icon);
   icon_set->cache_size++;
 
@@ -2659,35 +2715,11 @@ add_to_cache (GtkIconSet      *icon_set,
   icon->state = state;
   icon->size = size;
   icon->scale = scale;
-  icon->pixbuf = pixbuf;
 
   if (icon->style)
     attach_to_style (icon_set, icon->style);
 
-  if (icon_set->cache_size >= NUM_CACHED_ICONS)
-    {
-      /* Remove oldest item in the cache */
-      GSList *tmp_list;
-
-      tmp_list = icon_set->cache;
-
-      /* Find next-to-last link */
-      g_assert (NUM_CACHED_ICONS > 2);
-      while (tmp_list->next->next)
-        tmp_list = tmp_list->next;
-
-      g_assert (tmp_list != NULL);
-      g_assert (tmp_list->next != NULL);
-      g_assert (tmp_list->next->next == NULL);
-
-      /* Free the last icon */
-      icon = tmp_list->next->data;
-
-      g_slist_free (tmp_list->next);
-      tmp_list->next = NULL;
-
-      cached_icon_free (icon);
-    }
+  shrink_cached_icons ();
 }
 
 static void
@@ -2740,9 +2772,13 @@ copy_cache (GtkIconSet *icon_set,
   while (tmp_list != NULL)
     {
       CachedIcon *icon = tmp_list->data;
-      CachedIcon *icon_copy = g_new (CachedIcon, 1);
+      CachedIcon *icon_copy = cached_icon_new (copy_recipient, icon->pixbuf);
 
-      *icon_copy = *icon;
+      icon_copy->style = icon->style;
+      icon_copy->direction = icon->direction;
+      icon_copy->state = icon->state;
+      icon_copy->size = icon->size;
+      icon_copy->scale = icon->scale;
 
       if (icon_copy->style)
 	{
@@ -2750,10 +2786,6 @@ copy_cache (GtkIconSet *icon_set,
 	  g_object_ref (icon_copy->style);
 	}
 
-      g_object_ref (icon_copy->pixbuf);
-
-      icon_copy->size = icon->size;
-
       copy = g_slist_prepend (copy, icon_copy);
 
       tmp_list = g_slist_next (tmp_list);
@@ -103,6 +103,12 @@ struct _GtkIconThemePrivate
   GList *dir_mtimes;
 
   gulong reset_styles_idle;
+
+  /* Recent results of choose_icon(), keyed by lookup_cache_key() */
+  GHashTable *lookup_cache;
+  /* The cached results, most recently used first */
+  GQueue lookup_lru;
+  GtkIconLookupStats lookup_stats;
 };
 
 struct _GtkIconInfo
@@ -148,6 +154,40 @@ struct _GtkIconInfo
   guint ref_count;
 };
 
+/* Number of lookup results kept per icon theme. Icons loaded
+ * with gtk_icon_info_load_icon_async() are found again through
+ * this cache, so it should hold everything visible at once.
+ */
+#define LOOKUP_CACHE_SIZE 256
+
+/* Icons loaded asynchronously are decoded in this many threads */
+#define MAX_LOAD_THREADS 4
+
+/* An icon being loaded by gtk_icon_info_load_icon_async() */
+typedef struct
+{
+  GtkIconInfo *icon_info;
+  /* Private copy of icon_info that the loading thread works on,
+   * or NULL if icon_info was loaded already.
+   */
+  GtkIconInfo *work;
+  /* IconLoadRequests waiting for the icon */
+  GSList *requests;
+} IconLoad;
+
+typedef struct
+{
+  GSimpleAsyncResult *result;
+  GCancellable *cancellable;
+} IconLoadRequest;
+
+typedef struct
+{
+  GList link;         /* in lookup_lru */
+  gchar *key;
+  GtkIconInfo *info;  /* NULL if no icon was found */
+} LookupCacheEntry;
+
 typedef struct
 {
   char *name;
@@ -224,6 +264,7 @@ static void         do_theme_change   (GtkIconTheme     *icon_theme);
 
 static void     blow_themes               (GtkIconTheme    *icon_themes);
 static gboolean rescan_themes             (GtkIconTheme    *icon_themes);
+static void     lookup_cache_clear        (GtkIconTheme    *icon_theme);
 
 static void  icon_data_free            (GtkIconData     *icon_data);
 static void load_icon_data             (IconThemeDir    *dir,
@@ -237,8 +278,10 @@ static IconSuffix theme_dir_get_icon_suffix (IconThemeDir *dir,
 
 static GtkIconInfo *icon_info_new             (void);
 static GtkIconInfo *icon_info_new_builtin     (BuiltinIcon *icon);
+static GtkIconInfo *icon_info_dup             (GtkIconInfo *icon_info);
 
 static IconSuffix suffix_from_name (const char *name);
+static const char *string_from_suffix (IconSuffix suffix);
 
 static BuiltinIcon *find_builtin_icon (const gchar *icon_name,
 				       gint        size,
@@ -249,6 +292,13 @@ static guint signal_changed = 0;
 
 static GHashTable *icon_theme_builtin_icons;
 
+/* All GtkIconTheme instances, whose lookup caches have to go when
+ * a builtin icon is added */
+static GSList *icon_themes = NULL;
+
+/* The IconLoads in progress, by GtkIconInfo */
+static GHashTable *icon_loads = NULL;
+
 /* also used in gtkiconfactory.c */
 GtkIconCache *_builtin_cache = NULL;
 static GList *builtin_dirs = NULL;
@@ -569,6 +619,8 @@ gtk_icon_theme_init (GtkIconTheme *icon_theme)
 
   priv->custom_theme = FALSE;
 
+  icon_themes = g_slist_prepend (icon_themes, icon_theme);
+
   xdg_data_dirs = g_get_system_data_dirs ();
   for (i = 0; xdg_data_dirs[i]; i++) ;
 
@@ -647,6 +699,9 @@ static void
 blow_themes (GtkIconTheme *icon_theme)
 {
   GtkIconThemePrivate *priv = icon_theme->priv;
+
+  /* Cached lookups point into the themes */
+  lookup_cache_clear (icon_theme);
   
   if (priv->themes_valid)
     {
@@ -674,6 +729,8 @@ gtk_icon_theme_finalize (GObject *object)
   icon_theme = GTK_ICON_THEME (object);
   priv = icon_theme->priv;
 
+  icon_themes = g_slist_remove (icon_themes, icon_theme);
+
   if (priv->reset_styles_idle)
     {
       g_source_remove (priv->reset_styles_idle);
@@ -904,6 +961,7 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
   GKeyFile *theme_file;
   GError *error = NULL;
   IconThemeDirMtime *dir_mtime;
+  GList *theme_dir_mtimes = NULL;
   struct stat stat_buf;
   
   priv = icon_theme->priv;
@@ -935,6 +993,7 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 	}
 
       priv->dir_mtimes = g_list_prepend (priv->dir_mtimes, dir_mtime);
+      theme_dir_mtimes = g_list_prepend (theme_dir_mtimes, dir_mtime);
     }
   priv->dir_mtimes = g_list_reverse (priv->dir_mtimes);
 
@@ -969,7 +1028,10 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
     }
 
   if (theme_file == NULL)
-    return;
+    {
+      g_list_free (theme_dir_mtimes);
+      return;
+    }
 
   theme->display_name = 
     g_key_file_get_locale_string (theme_file, "Icon Theme", "Name", NULL, NULL);
@@ -985,6 +1047,7 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
       g_free (theme->display_name);
       g_free (theme);
       g_key_file_free (theme_file);
+      g_list_free (theme_dir_mtimes);
       return;
     }
   
@@ -997,6 +1060,23 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 			   "Icon Theme", "Example",
 			   NULL);
 
+  /* The directories of this theme that have no icon-theme.cache are
+   * indexed in the user's cache, instead of being scanned every time.
+   */
+  for (l = theme_dir_mtimes; l != NULL; l = l->next)
+    {
+      dir_mtime = l->data;
+
+      if (!dir_mtime->exists || dir_mtime->cache != NULL)
+	continue;
+
+      dir_mtime->cache = _gtk_icon_cache_new_for_path (dir_mtime->dir);
+      if (dir_mtime->cache == NULL)
+	dir_mtime->cache = _gtk_icon_cache_new_for_user (dir_mtime->dir,
+							 (const gchar **)dirs);
+    }
+  g_list_free (theme_dir_mtimes);
+
   theme->dirs = NULL;
   for (i = 0; dirs[i] != NULL; i++)
     theme_subdir_load (icon_theme, theme, theme_file, dirs[i]);
@@ -1042,16 +1122,111 @@ strip_suffix (const char *filename)
   return g_strndup (filename, dot - filename);
 }
 
+static void
+add_unthemed_icon (GtkIconThemePrivate *priv,
+		   const char          *dir,
+		   const char          *file)
+{
+  UnthemedIcon *unthemed_icon;
+  IconSuffix old_suffix, new_suffix;
+  char *abs_file;
+  char *base_name;
+
+  new_suffix = suffix_from_name (file);
+  if (new_suffix == ICON_SUFFIX_NONE)
+    return;
+
+  abs_file = g_build_filename (dir, file, NULL);
+  base_name = strip_suffix (file);
+
+  if ((unthemed_icon = g_hash_table_lookup (priv->unthemed_icons,
+					    base_name)))
+    {
+      if (new_suffix == ICON_SUFFIX_SVG)
+	{
+	  if (unthemed_icon->svg_filename)
+	    g_free (abs_file);
+	  else
+	    unthemed_icon->svg_filename = abs_file;
+	}
+      else
+	{
+	  if (unthemed_icon->no_svg_filename)
+	    {
+	      old_suffix = suffix_from_name (unthemed_icon->no_svg_filename);
+	      if (new_suffix > old_suffix)
+		{
+		  g_free (unthemed_icon->no_svg_filename);
+		  unthemed_icon->no_svg_filename = abs_file;
+		}
+	      else
+		g_free (abs_file);
+	    }
+	  else
+	    unthemed_icon->no_svg_filename = abs_file;
+	}
+
+      g_free (base_name);
+    }
+  else
+    {
+      unthemed_icon = g_slice_new0 (UnthemedIcon);
+
+      if (new_suffix == ICON_SUFFIX_SVG)
+	unthemed_icon->svg_filename = abs_file;
+      else
+	unthemed_icon->no_svg_filename = abs_file;
+
+      g_hash_table_insert (priv->unthemed_icons,
+			   base_name,
+			   unthemed_icon);
+      g_hash_table_insert (priv->all_icons,
+			   base_name, NULL);
+    }
+}
+
+/* Adds the unthemed icons of @dir, which are indexed in @cache */
+static void
+add_unthemed_icons_from_cache (GtkIconThemePrivate *priv,
+			       const char          *dir,
+			       GtkIconCache        *cache)
+{
+  static const IconSuffix suffixes[] = {
+    ICON_SUFFIX_XPM, ICON_SUFFIX_SVG, ICON_SUFFIX_PNG
+  };
+  GHashTable *names;
+  GHashTableIter iter;
+  gpointer name;
+  gint flags, i;
+  char *file;
+
+  names = g_hash_table_new (g_str_hash, g_str_equal);
+  _gtk_icon_cache_add_icons (cache, ".", names);
+
+  g_hash_table_iter_init (&iter, names);
+  while (g_hash_table_iter_next (&iter, &name, NULL))
+    {
+      flags = _gtk_icon_cache_get_icon_flags (cache, name, 0);
+
+      for (i = 0; i < G_N_ELEMENTS (suffixes); i++)
+	if (flags & suffixes[i])
+	  {
+	    file = g_strconcat (name, string_from_suffix (suffixes[i]), NULL);
+	    add_unthemed_icon (priv, dir, file);
+	    g_free (file);
+	  }
+    }
+
+  g_hash_table_destroy (names);
+}
+
 static void
 load_themes (GtkIconTheme *icon_theme)
 {
+  static const gchar *unthemed_subdirs[] = { ".", NULL };
   GtkIconThemePrivate *priv;
-  GDir *gdir;
   int base;
   char *dir;
-  const char *file;
-  UnthemedIcon *unthemed_icon;
-  IconSuffix old_suffix, new_suffix;
   GTimeVal tv;
   IconThemeDirMtime *dir_mtime;
   struct stat stat_buf;
@@ -1094,69 +1269,8 @@ load_themes (GtkIconTheme *icon_theme)
       if (dir_mtime->cache != NULL)
 	continue;
 
-      gdir = g_dir_open (dir, 0, NULL);
-      if (gdir == NULL)
-	continue;
-
-      while ((file = g_dir_read_name (gdir)))
-	{
-	  new_suffix = suffix_from_name (file);
-	  
-	  if (new_suffix != ICON_SUFFIX_NONE)
-	    {
-	      char *abs_file;
-	      char *base_name;
-
-	      abs_file = g_build_filename (dir, file, NULL);
-	      base_name = strip_suffix (file);
-
-	      if ((unthemed_icon = g_hash_table_lookup (priv->unthemed_icons,
-							base_name)))
-		{
-		  if (new_suffix == ICON_SUFFIX_SVG)
-		    {
-		      if (unthemed_icon->svg_filename)
-			g_free (abs_file);
-		      else
-			unthemed_icon->svg_filename = abs_file;
-		    }
-		  else
-		    {
-		      if (unthemed_icon->no_svg_filename)
-			{
-			  old_suffix = suffix_from_name (unthemed_icon->no_svg_filename);
-			  if (new_suffix > old_suffix)
-			    {
-			      g_free (unthemed_icon->no_svg_filename);
-			      unthemed_icon->no_svg_filename = abs_file;			      
-			    }
-			  else
-			    g_free (abs_file);
-			}
-		      else
-			unthemed_icon->no_svg_filename = abs_file;			      
-		    }
-
-		  g_free (base_name);
-		}
-	      else
-		{
-		  unthemed_icon = g_slice_new0 (UnthemedIcon);
-		  
-		  if (new_suffix == ICON_SUFFIX_SVG)
-		    unthemed_icon->svg_filename = abs_file;
-		  else
-		    unthemed_icon->no_svg_filename = abs_file;
-
-		  g_hash_table_insert (priv->unthemed_icons,
-				       base_name,
-				       unthemed_icon);
-		  g_hash_table_insert (priv->all_icons,
-				       base_name, NULL);
-		}
-	    }
-	}
-      g_dir_close (gdir);
+      dir_mtime->cache = _gtk_icon_cache_new_for_user (dir, unthemed_subdirs);
+      add_unthemed_icons_from_cache (priv, dir, dir_mtime->cache);
     }
 
   priv->themes_valid = TRUE;
@@ -1249,12 +1363,120 @@ ensure_valid_themes (GtkIconTheme *icon_theme)
   priv->loading_themes = FALSE;
 }
 
+static gchar *
+lookup_cache_key (const gchar        *icon_names[],
+		  gint                size,
+		  gdouble             scale,
+		  GtkIconLookupFlags  flags)
+{
+  GString *key;
+  gint i;
+
+  key = g_string_new (NULL);
+  g_string_printf (key, "%d %g %x", size, scale, flags);
+  for (i = 0; icon_names[i]; i++)
+    {
+      g_string_append_c (key, '\n');
+      g_string_append (key, icon_names[i]);
+    }
+
+  return g_string_free (key, FALSE);
+}
+
+static void
+lookup_cache_remove (GtkIconTheme     *icon_theme,
+		     LookupCacheEntry *entry)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+
+  g_hash_table_remove (priv->lookup_cache, entry->key);
+  g_queue_unlink (&priv->lookup_lru, &entry->link);
+
+  g_free (entry->key);
+  if (entry->info)
+    gtk_icon_info_free (entry->info);
+  g_slice_free (LookupCacheEntry, entry);
+}
+
+static void
+lookup_cache_clear (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+
+  if (!priv->lookup_cache)
+    return;
+
+  GTK_NOTE (ICONTHEME,
+	    g_print ("dropping %u cached icon lookups (%u hits, %u misses)\n",
+		     priv->lookup_lru.length,
+		     priv->lookup_stats.hits, priv->lookup_stats.misses));
+
+  while (priv->lookup_lru.head)
+    lookup_cache_remove (icon_theme, priv->lookup_lru.head->data);
+
+  g_hash_table_destroy (priv->lookup_cache);
+  priv->lookup_cache = NULL;
+}
+
+static LookupCacheEntry *
+lookup_cache_get (GtkIconTheme *icon_theme,
+		  const gchar  *key)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  LookupCacheEntry *entry;
+
+  if (!priv->lookup_cache)
+    return NULL;
+
+  entry = g_hash_table_lookup (priv->lookup_cache, key);
+  if (!entry)
+    return NULL;
+
+  /* The raw coordinates setting of a shared info would leak
+   * to the other users, so give them a fresh one.
+   */
+  if (entry->info && entry->info->raw_coordinates)
+    {
+      lookup_cache_remove (icon_theme, entry);
+      return NULL;
+    }
+
+  g_queue_unlink (&priv->lookup_lru, &entry->link);
+  g_queue_push_head_link (&priv->lookup_lru, &entry->link);
+
+  return entry;
+}
+
+static void
+lookup_cache_add (GtkIconTheme *icon_theme,
+		  gchar        *key,
+		  GtkIconInfo  *icon_info)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  LookupCacheEntry *entry;
+
+  if (!priv->lookup_cache)
+    priv->lookup_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+  entry = g_slice_new0 (LookupCacheEntry);
+  entry->link.data = entry;
+  entry->key = key;
+  if (icon_info)
+    entry->info = gtk_icon_info_copy (icon_info);
+
+  g_hash_table_insert (priv->lookup_cache, entry->key, entry);
+  g_queue_push_head_link (&priv->lookup_lru, &entry->link);
+
+  if (priv->lookup_lru.length > LOOKUP_CACHE_SIZE)
+    lookup_cache_remove (icon_theme, priv->lookup_lru.tail->data);
+}
+
 static GtkIconInfo *
-choose_icon (GtkIconTheme       *icon_theme,
-	     const gchar        *icon_names[],
-	     gint                size,
-             gdouble             scale,
-	     GtkIconLookupFlags  flags)
+real_choose_icon (GtkIconTheme       *icon_theme,
+		  const gchar        *icon_names[],
+		  gint                size,
+		  gdouble             scale,
+		  GtkIconLookupFlags  flags)
 {
   GtkIconThemePrivate *priv;
   GList *l;
@@ -1274,8 +1496,6 @@ choose_icon (GtkIconTheme       *icon_theme,
     allow_svg = priv->pixbuf_supports_svg;
 
   use_builtin = flags & GTK_ICON_LOOKUP_USE_BUILTIN;
-  
-  ensure_valid_themes (icon_theme);
 
   for (l = priv->themes; l; l = l->next)
     {
@@ -1386,6 +1606,44 @@ choose_icon (GtkIconTheme       *icon_theme,
   return icon_info;
 }
 
+/* Looks up the icon, or returns a reference to the result of the
+ * same lookup done recently. Sharing the GtkIconInfo means that the
+ * icon is also only loaded and scaled once.
+ */
+static GtkIconInfo *
+choose_icon (GtkIconTheme       *icon_theme,
+	     const gchar        *icon_names[],
+	     gint                size,
+             gdouble             scale,
+	     GtkIconLookupFlags  flags)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  LookupCacheEntry *entry;
+  GtkIconInfo *icon_info;
+  gchar *key;
+
+  /* This drops the cache if the themes changed on disk */
+  ensure_valid_themes (icon_theme);
+
+  key = lookup_cache_key (icon_names, size, scale, flags);
+
+  entry = lookup_cache_get (icon_theme, key);
+  if (entry)
+    {
+      priv->lookup_stats.hits++;
+      g_free (key);
+
+      return entry->info ? gtk_icon_info_copy (entry->info) : NULL;
+    }
+
+  priv->lookup_stats.misses++;
+
+  icon_info = real_choose_icon (icon_theme, icon_names, size, scale, flags);
+  lookup_cache_add (icon_theme, key, icon_info);
+
+  return icon_info;
+}
+
 
 /**
  * gtk_icon_theme_lookup_icon:
@@ -1566,6 +1824,75 @@ gtk_icon_theme_choose_icon_for_scale (GtkIconTheme       *icon_theme,
 }
 
 
+/**
+ * _gtk_icon_theme_get_lookup_stats:
+ * @icon_theme: a #GtkIconTheme
+ * @stats: return location for the counters
+ *
+ * Reports how often lookups in @icon_theme were answered from
+ * its cache of recent results.
+ **/
+void
+_gtk_icon_theme_get_lookup_stats (GtkIconTheme       *icon_theme,
+				  GtkIconLookupStats *stats)
+{
+  GtkIconThemePrivate *priv;
+
+  g_return_if_fail (GTK_IS_ICON_THEME (icon_theme));
+  g_return_if_fail (stats != NULL);
+
+  priv = icon_theme->priv;
+
+  *stats = priv->lookup_stats;
+  stats->n_entries = priv->lookup_lru.length;
+}
+
+/**
+ * gtk_icon_theme_preload_icons:
+ * @icon_theme: a #GtkIconTheme
+ * @icon_names: (array zero-terminated=1): %NULL-terminated array of
+ *     icon names to load
+ * @size: desired icon size
+ * @flags: flags modifying the behavior of the icon lookup
+ *
+ * Starts loading a batch of icons in the background, as with
+ * gtk_icon_info_load_icon_async(). When the icons are then looked
+ * up with gtk_icon_theme_lookup_icon() with the same @size and
+ * @flags, they are either loaded already or will be shortly. This
+ * is useful before showing a view with many different icons, such
+ * as a folder full of files of different types.
+ *
+ * Only a limited number of recently looked up icons is kept,
+ * so this is best done right before the icons are needed.
+ *
+ * Since: 2.24
+ **/
+void
+gtk_icon_theme_preload_icons (GtkIconTheme        *icon_theme,
+                              const gchar         *icon_names[],
+                              gint                 size,
+                              GtkIconLookupFlags   flags)
+{
+  GtkIconInfo *info;
+  gint i;
+
+  g_return_if_fail (GTK_IS_ICON_THEME (icon_theme));
+  g_return_if_fail (icon_names != NULL);
+  g_return_if_fail ((flags & GTK_ICON_LOOKUP_NO_SVG) == 0 ||
+                    (flags & GTK_ICON_LOOKUP_FORCE_SVG) == 0);
+
+  for (i = 0; icon_names[i]; i++)
+    {
+      info = gtk_icon_theme_lookup_icon_for_scale (icon_theme, icon_names[i],
+                                                   size, 1, flags);
+      if (info)
+        {
+          icon_load_start (info, NULL);
+          gtk_icon_info_free (info);
+        }
+    }
+}
+
 /* Error quark */
 GQuark
 gtk_icon_theme_error_quark (void)
@@ -2781,6 +3108,40 @@ icon_info_new_builtin (BuiltinIcon *icon)
   return icon_info;
 }
 
+/* Lookup results may be shared, see choose_icon(). This makes
+ * a private copy for callers that need to change one.
+ */
+static GtkIconInfo *
+icon_info_dup (GtkIconInfo *icon_info)
+{
+  GtkIconInfo *dup;
+  GSList *l;
+
+  dup = icon_info_new ();
+
+  dup->filename = g_strdup (icon_info->filename);
+#if defined (G_OS_WIN32) && !defined (_WIN64)
+  dup->cp_filename = g_strdup (icon_info->cp_filename);
+#endif
+  if (icon_info->loadable)
+    dup->loadable = g_object_ref (icon_info->loadable);
+  for (l = icon_info->emblem_infos; l; l = l->next)
+    dup->emblem_infos = g_slist_append (dup->emblem_infos,
+					gtk_icon_info_copy (l->data));
+  if (icon_info->cache_pixbuf)
+    dup->cache_pixbuf = g_object_ref (icon_info->cache_pixbuf);
+
+  dup->data = icon_info->data;
+  dup->dir_type = icon_info->dir_type;
+  dup->dir_size = icon_info->dir_size;
+  dup->threshold = icon_info->threshold;
+  dup->desired_size = icon_info->desired_size;
+  dup->raw_coordinates = icon_info->raw_coordinates;
+  dup->forced_size = icon_info->forced_size;
+
+  return dup;
+}
+
 /**
  * gtk_icon_info_copy:
  * @icon_info: a #GtkIconInfo
@@ -2831,6 +3192,8 @@ gtk_icon_info_free (GtkIconInfo *icon_info)
     g_object_unref (icon_info->pixbuf);
   if (icon_info->cache_pixbuf)
     g_object_unref (icon_info->cache_pixbuf);
+  if (icon_info->load_error)
+    g_error_free (icon_info->load_error);
 
   g_slice_free (GtkIconInfo, icon_info);
 }
@@ -3226,7 +3589,7 @@ gtk_icon_info_load_icon (GtkIconInfo *icon_info,
   if (!icon_info_ensure_scale_and_pixbuf (icon_info, FALSE))
     {
       if (icon_info->load_error)
-        g_propagate_error (error, icon_info->load_error);
+        g_propagate_error (error, g_error_copy (icon_info->load_error));
       else
         g_set_error_literal (error,  
                              GTK_ICON_THEME_ERROR,  
@@ -3239,6 +3602,289 @@ gtk_icon_info_load_icon (GtkIconInfo *icon_info,
   return g_object_ref (icon_info->pixbuf);
 }
 
+static void icon_load_thread (gpointer data,
+                              gpointer user_data);
+
+static GThreadPool *
+icon_load_get_pool (void)
+{
+  static GThreadPool *pool = NULL;
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      pool = g_thread_pool_new (icon_load_thread, NULL,
+                                MAX_LOAD_THREADS, FALSE, NULL);
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return pool;
+}
+
+static void
+icon_load_request_complete (IconLoadRequest *request,
+                            GtkIconInfo     *icon_info)
+{
+  GSimpleAsyncResult *result = request->result;
+  GError *error = NULL;
+
+  if (g_cancellable_set_error_if_cancelled (request->cancellable, &error))
+    {
+      g_simple_async_result_set_from_error (result, error);
+      g_error_free (error);
+    }
+  else if (icon_info->pixbuf)
+    g_simple_async_result_set_op_res_gpointer (result,
+                                               g_object_ref (icon_info->pixbuf),
+                                               g_object_unref);
+  else if (icon_info->load_error)
+    g_simple_async_result_set_from_error (result, icon_info->load_error);
+  else
+    g_simple_async_result_set_error (result,
+                                     GTK_ICON_THEME_ERROR,
+                                     GTK_ICON_THEME_NOT_FOUND,
+                                     _("Failed to load icon"));
+
+  g_simple_async_result_complete (result);
+
+  g_object_unref (result);
+  if (request->cancellable)
+    g_object_unref (request->cancellable);
+  g_slice_free (IconLoadRequest, request);
+}
+
+static gboolean
+icon_load_done (gpointer data)
+{
+  IconLoad *load = data;
+  GtkIconInfo *icon_info = load->icon_info;
+  GtkIconInfo *work = load->work;
+  GSList *l;
+
+  if (work)
+    {
+      g_hash_table_remove (icon_loads, icon_info);
+
+      /* Unless gtk_icon_info_load_icon() got there first */
+      if (!icon_info->pixbuf && !icon_info->load_error)
+        {
+          if (work->pixbuf)
+            icon_info->pixbuf = g_object_ref (work->pixbuf);
+          if (work->load_error)
+            icon_info->load_error = g_error_copy (work->load_error);
+          icon_info->scale = work->scale;
+          icon_info->emblems_applied = work->emblems_applied;
+        }
+
+      gtk_icon_info_free (work);
+    }
+
+  for (l = load->requests; l; l = l->next)
+    icon_load_request_complete (l->data, icon_info);
+  g_slist_free (load->requests);
+
+  gtk_icon_info_free (icon_info);
+  g_slice_free (IconLoad, load);
+
+  return FALSE;
+}
+
+static void
+icon_load_thread (gpointer data,
+                  gpointer user_data)
+{
+  IconLoad *load = data;
+
+  icon_info_ensure_scale_and_pixbuf (load->work, FALSE);
+
+  gdk_threads_add_idle (icon_load_done, load);
+}
+
+static gboolean
+icon_load_idle (gpointer data)
+{
+  IconLoad *load = data;
+
+  icon_info_ensure_scale_and_pixbuf (load->work, FALSE);
+
+  return icon_load_done (load);
+}
+
+/* Starts loading @icon_info, unless that is already under way.
+ * @request, if not %NULL, is completed when the icon is loaded.
+ */
+static void
+icon_load_start (GtkIconInfo     *icon_info,
+                 IconLoadRequest *request)
+{
+  IconLoad *load;
+  GThreadPool *pool = NULL;
+
+  if (icon_loads == NULL)
+    icon_loads = g_hash_table_new (NULL, NULL);
+
+  load = g_hash_table_lookup (icon_loads, icon_info);
+  if (load)
+    {
+      if (request)
+        load->requests = g_slist_append (load->requests, request);
+      return;
+    }
+
+  if (!request && (icon_info->pixbuf || icon_info->load_error))
+    return;
+
+  load = g_slice_new0 (IconLoad);
+  load->icon_info = gtk_icon_info_copy (icon_info);
+  if (request)
+    load->requests = g_slist_prepend (NULL, request);
+
+  if (icon_info->pixbuf || icon_info->load_error)
+    {
+      gdk_threads_add_idle (icon_load_done, load);
+      return;
+    }
+
+  load->work = icon_info_dup (icon_info);
+  g_hash_table_insert (icon_loads, icon_info, load);
+
+  /* Emblems are loaded through infos that others may be using,
+   * which can't be done from another thread.
+   */
+  if (g_thread_supported () && icon_info->emblem_infos == NULL)
+    pool = icon_load_get_pool ();
+
+  if (pool)
+    g_thread_pool_push (pool, load, NULL);
+  else
+    gdk_threads_add_idle (icon_load_idle, load);
+}
+
+/**
+ * gtk_icon_info_load_icon_async:
+ * @icon_info: a #GtkIconInfo structure from gtk_icon_theme_lookup_icon()
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     icon is loaded
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Asynchronously renders an icon previously looked up in an icon theme
+ * using gtk_icon_theme_lookup_icon(). The icon is decoded and scaled in
+ * a separate thread, so that the user interface stays responsive while
+ * many icons are loaded. Loads of the same #GtkIconInfo are only done
+ * once, and since gtk_icon_theme_lookup_icon() returns the same
+ * #GtkIconInfo for the same lookup while it is still cached, so are
+ * loads of the same icon.
+ *
+ * When the icon is loaded, @callback is called from the main loop,
+ * and can get the result with gtk_icon_info_load_icon_finish().
+ *
+ * Since: 2.24
+ **/
+void
+gtk_icon_info_load_icon_async (GtkIconInfo         *icon_info,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  IconLoadRequest *request;
+
+  g_return_if_fail (icon_info != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  request = g_slice_new0 (IconLoadRequest);
+  request->result = g_simple_async_result_new (NULL, callback, user_data,
+                                               gtk_icon_info_load_icon_async);
+  if (cancellable)
+    request->cancellable = g_object_ref (cancellable);
+
+  icon_load_start (icon_info, request);
+}
+
+/**
+ * gtk_icon_info_load_icon_finish:
+ * @icon_info: a #GtkIconInfo structure from gtk_icon_theme_lookup_icon()
+ * @result: a #GAsyncResult
+ * @error: (allow-none): location to store error information on failure,
+ *     or %NULL.
+ *
+ * Finishes an asynchronous icon load, see gtk_icon_info_load_icon_async().
+ *
+ * Return value: (transfer full): the rendered icon; this may be a newly
+ *     created icon or a new reference to an internal icon, so you must
+ *     not modify the icon. Use g_object_unref() to release your reference
+ *     to the icon.
+ *
+ * Since: 2.24
+ **/
+GdkPixbuf *
+gtk_icon_info_load_icon_finish (GtkIconInfo   *icon_info,
+                                GAsyncResult  *result,
+                                GError       **error)
+{
+  GSimpleAsyncResult *simple;
+
+  g_return_val_if_fail (icon_info != NULL, NULL);
+  g_return_val_if_fail (g_simple_async_result_is_valid (result, NULL,
+                                                        gtk_icon_info_load_icon_async),
+                        NULL);
+
+  simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_propagate_error (simple, error))
+    return NULL;
+
+  return g_object_ref (g_simple_async_result_get_op_res_gpointer (simple));
+}
+
+/**
+ * _gtk_icon_info_is_loaded:
+ * @icon_info: a #GtkIconInfo
+ *
+ * Checks whether gtk_icon_info_load_icon() would return without
+ * loading anything, because the icon was loaded already or failed
+ * to load.
+ *
+ * Return value: %TRUE if loading @icon_info is done
+ **/
+gboolean
+_gtk_icon_info_is_loaded (GtkIconInfo *icon_info)
+{
+  return icon_info->pixbuf != NULL || icon_info->load_error != NULL;
+}
+
+/**
+ * _gtk_icon_info_get_placeholder:
+ * @size: the size of the icon that is being loaded
+ *
+ * Gets a transparent pixbuf for widgets to show while they wait for
+ * gtk_icon_info_load_icon_async().
+ *
+ * Return value: a new reference to a @size by @size pixbuf
+ **/
+GdkPixbuf *
+_gtk_icon_info_get_placeholder (gint size)
+{
+  static GHashTable *placeholders = NULL;
+  GdkPixbuf *pixbuf;
+
+  size = MAX (size, 1);
+
+  if (placeholders == NULL)
+    placeholders = g_hash_table_new (NULL, NULL);
+
+  pixbuf = g_hash_table_lookup (placeholders, GINT_TO_POINTER (size));
+  if (pixbuf == NULL)
+    {
+      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, size, size);
+      gdk_pixbuf_fill (pixbuf, 0);
+      g_hash_table_insert (placeholders, GINT_TO_POINTER (size), pixbuf);
+    }
+
+  return g_object_ref (pixbuf);
+}
+
 /**
  * gtk_icon_info_set_raw_coordinates:
  * @icon_info: a #GtkIconInfo
@@ -3487,6 +4133,9 @@ gtk_icon_theme_add_builtin_icon (const gchar *icon_name,
   /* Replaces value, leaves key untouched
    */
   g_hash_table_insert (icon_theme_builtin_icons, key, icons);
+
+  /* Earlier lookups may have found another icon */
+  g_slist_foreach (icon_themes, (GFunc) lookup_cache_clear, NULL);
 }
 
 /* Look up a builtin icon; the min_difference_p and
@@ -3648,6 +4297,15 @@ gtk_icon_theme_lookup_by_gicon (GtkIconTheme       *icon_theme,
       info = gtk_icon_theme_lookup_by_gicon (icon_theme, base, size, flags);
       if (info)
         {
+          /* Don't add the emblems to a shared lookup result */
+          if (info->ref_count > 1)
+            {
+              GtkIconInfo *base_info = info;
+
+              info = icon_info_dup (base_info);
+              gtk_icon_info_free (base_info);
+            }
+
           list = g_emblemed_icon_get_emblems (G_EMBLEMED_ICON (icon));
           for (l = list; l; l = l->next)
             {
@@ -171,6 +171,11 @@ GtkIconInfo * gtk_icon_theme_lookup_by_gicon       (GtkIconTheme
                                                     gint                         size,
                                                     GtkIconLookupFlags           flags);
 
+void          gtk_icon_theme_preload_icons         (GtkIconTheme                *icon_theme,
+						    const gchar                 *icon_names[],
+						    gint                         size,
+						    GtkIconLookupFlags           flags);
+
 GList *       gtk_icon_theme_list_icons            (GtkIconTheme                *icon_theme,
 						    const gchar                 *context);
 GList *       gtk_icon_theme_list_contexts         (GtkIconTheme                *icon_theme);
@@ -194,6 +199,13 @@ const gchar *         gtk_icon_info_get_filename       (GtkIconInfo   *icon_info
 GdkPixbuf *           gtk_icon_info_get_builtin_pixbuf (GtkIconInfo   *icon_info);
 GdkPixbuf *           gtk_icon_info_load_icon          (GtkIconInfo   *icon_info,
 							GError       **error);
+void                  gtk_icon_info_load_icon_async    (GtkIconInfo          *icon_info,
+							GCancellable         *cancellable,
+							GAsyncReadyCallback   callback,
+							gpointer              user_data);
+GdkPixbuf *           gtk_icon_info_load_icon_finish   (GtkIconInfo          *icon_info,
+							GAsyncResult         *result,
+							GError              **error);
 void                  gtk_icon_info_set_raw_coordinates (GtkIconInfo  *icon_info,
 							 gboolean      raw_coordinates);
 
@@ -205,8 +217,21 @@ gboolean              gtk_icon_info_get_attach_points (GtkIconInfo    *icon_info
 const gchar *         gtk_icon_info_get_display_name  (GtkIconInfo    *icon_info);
 
 /* Non-public methods */
+typedef struct _GtkIconLookupStats GtkIconLookupStats;
+
+struct _GtkIconLookupStats
+{
+  guint hits;
+  guint misses;
+  guint n_entries;  /* lookup results currently cached */
+};
+
 void _gtk_icon_theme_check_reload                     (GdkDisplay *display);
 void _gtk_icon_theme_ensure_builtin_cache             (void);
+void _gtk_icon_theme_get_lookup_stats                 (GtkIconTheme       *icon_theme,
+							GtkIconLookupStats *stats);
+gboolean   _gtk_icon_info_is_loaded                   (GtkIconInfo *icon_info);
+GdkPixbuf *_gtk_icon_info_get_placeholder             (gint         size);
 
 G_END_DECLS
 
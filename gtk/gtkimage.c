@@ -138,6 +138,10 @@ struct _GtkImagePrivate
 
   gint pixel_size;
   guint need_calc_size : 1;
+  guint load_async     : 1;
+
+  /* Cancels the icon being loaded for ICON_NAME or GICON */
+  GCancellable *load_cancellable;
 };
 
 #define GTK_IMAGE_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_IMAGE, GtkImagePrivate))
@@ -188,7 +192,8 @@ enum
   PROP_PIXBUF_ANIMATION,
   PROP_ICON_NAME,
   PROP_STORAGE_TYPE,
-  PROP_GICON
+  PROP_GICON,
+  PROP_LOAD_ASYNC
 };
 
 G_DEFINE_TYPE (GtkImage, gtk_image, GTK_TYPE_MISC)
@@ -351,6 +356,23 @@ gtk_image_class_init (GtkImageClass *class)
                                                       GTK_IMAGE_EMPTY,
                                                       GTK_PARAM_READABLE));
 
+  /**
+   * GtkImage:load-async:
+   *
+   * Whether named icons and #GIcon<!-- -->s are loaded in the
+   * background, see gtk_icon_info_load_icon_async(). Until the icon
+   * is loaded, the image shows nothing, at the size of the icon.
+   *
+   * Since: 2.24
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_LOAD_ASYNC,
+                                   g_param_spec_boolean ("load-async",
+                                                         P_("Load asynchronously"),
+                                                         P_("Whether themed icons are loaded in the background"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE));
+
   g_type_class_add_private (object_class, sizeof (GtkImagePrivate));
 }
 
@@ -476,6 +498,9 @@ gtk_image_set_property (GObject      *object,
       gtk_image_set_from_gicon (image, g_value_get_object (value),
 				image->icon_size);
       break;
+    case PROP_LOAD_ASYNC:
+      GTK_IMAGE_GET_PRIVATE (image)->load_async = g_value_get_boolean (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -574,6 +599,9 @@ gtk_image_get_property (GObject     *object,
     case PROP_STORAGE_TYPE:
       g_value_set_enum (value, image->storage_type);
       break;
+    case PROP_LOAD_ASYNC:
+      g_value_set_boolean (value, priv->load_async);
+      break;
       
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1627,9 +1655,24 @@ animation_timeout (gpointer data)
   return FALSE;
 }
 
+static void
+gtk_image_cancel_icon_load (GtkImage *image)
+{
+  GtkImagePrivate *priv = GTK_IMAGE_GET_PRIVATE (image);
+
+  if (priv->load_cancellable)
+    {
+      g_cancellable_cancel (priv->load_cancellable);
+      g_object_unref (priv->load_cancellable);
+      priv->load_cancellable = NULL;
+    }
+}
+
 static void
 icon_theme_changed (GtkImage *image)
 {
+  gtk_image_cancel_icon_load (image);
+
   if (image->storage_type == GTK_IMAGE_ICON_NAME) 
     {
       if (image->data.name.pixbuf)
@@ -1648,6 +1691,87 @@ icon_theme_changed (GtkImage *image)
     }
 }
 
+typedef struct
+{
+  GtkImage *image;
+  GtkIconInfo *info;
+  GCancellable *cancellable;
+} ImageIconLoad;
+
+static void
+icon_loaded (GObject      *source,
+             GAsyncResult *result,
+             gpointer      data)
+{
+  ImageIconLoad *load = data;
+  GtkImage *image = load->image;
+  GtkImagePrivate *priv = GTK_IMAGE_GET_PRIVATE (image);
+  GdkPixbuf **pixbuf_p;
+  GdkPixbuf *pixbuf;
+
+  pixbuf = gtk_icon_info_load_icon_finish (load->info, result, NULL);
+
+  /* Otherwise the image changed since */
+  if (!g_cancellable_is_cancelled (load->cancellable))
+    {
+      if (image->storage_type == GTK_IMAGE_ICON_NAME)
+        pixbuf_p = &image->data.name.pixbuf;
+      else
+        pixbuf_p = &image->data.gicon.pixbuf;
+
+      if (*pixbuf_p)
+        g_object_unref (*pixbuf_p);
+
+      if (pixbuf)
+        *pixbuf_p = g_object_ref (pixbuf);
+      else
+        *pixbuf_p = gtk_widget_render_icon (GTK_WIDGET (image),
+                                            GTK_STOCK_MISSING_IMAGE,
+                                            image->icon_size,
+                                            NULL);
+
+      g_object_unref (priv->load_cancellable);
+      priv->load_cancellable = NULL;
+
+      gtk_widget_queue_resize (GTK_WIDGET (image));
+    }
+
+  if (pixbuf)
+    g_object_unref (pixbuf);
+
+  g_object_unref (load->image);
+  gtk_icon_info_free (load->info);
+  g_object_unref (load->cancellable);
+  g_slice_free (ImageIconLoad, load);
+}
+
+/* Starts loading @info in the background and returns a placeholder
+ * of @size, or returns %NULL if @info is better loaded right away.
+ */
+static GdkPixbuf *
+load_icon_async (GtkImage    *image,
+                 GtkIconInfo *info,
+                 gint         size)
+{
+  GtkImagePrivate *priv = GTK_IMAGE_GET_PRIVATE (image);
+  ImageIconLoad *load;
+
+  if (!priv->load_async || _gtk_icon_info_is_loaded (info))
+    return NULL;
+
+  gtk_image_cancel_icon_load (image);
+  priv->load_cancellable = g_cancellable_new ();
+
+  load = g_slice_new (ImageIconLoad);
+  load->image = g_object_ref (image);
+  load->info = gtk_icon_info_copy (info);
+  load->cancellable = g_object_ref (priv->load_cancellable);
+
+  gtk_icon_info_load_icon_async (info, load->cancellable, icon_loaded, load);
+
+  return _gtk_icon_info_get_placeholder (size);
+}
+
 static void
 ensure_pixbuf_for_icon_name (GtkImage *image)
 {
@@ -1716,15 +1840,34 @@ ensure_pixbuf_for_icon_name (GtkImage *image)
 	      width = height = 24;
 	    }
 	}
-      image->data.name.pixbuf =
-	gtk_icon_theme_load_icon_for_scale (icon_theme,
-                                            image->data.name.icon_name,
-                                            MIN (width, height),
-                                            gtk_widget_get_scale_factor (GTK_WIDGET (image)),
-                                            flags, &error);
+      if (priv->load_async)
+        {
+          gdouble scale = gtk_widget_get_scale_factor (GTK_WIDGET (image));
+          GtkIconInfo *info;
+
+          info = gtk_icon_theme_lookup_icon_for_scale (icon_theme,
+                                                       image->data.name.icon_name,
+                                                       MIN (width, height),
+                                                       scale, flags);
+          if (info)
+            {
+              image->data.name.pixbuf =
+                load_icon_async (image, info, MIN (width, height) * scale);
+              if (image->data.name.pixbuf == NULL)
+                image->data.name.pixbuf = gtk_icon_info_load_icon (info, NULL);
+              gtk_icon_info_free (info);
+            }
+        }
+      else
+        image->data.name.pixbuf =
+          gtk_icon_theme_load_icon_for_scale (icon_theme,
+                                              image->data.name.icon_name,
+                                              MIN (width, height),
+                                              gtk_widget_get_scale_factor (GTK_WIDGET (image)),
+                                              flags, &error);
       if (image->data.name.pixbuf == NULL)
 	{
-	  g_error_free (error);
+	  g_clear_error (&error);
 	  image->data.name.pixbuf =
 	    gtk_widget_render_icon (GTK_WIDGET (image),
 				    GTK_STOCK_MISSING_IMAGE,
@@ -1778,7 +1921,9 @@ ensure_pixbuf_for_gicon (GtkImage *image)
 					     MIN (width, height), flags);
       if (info)
         {
-          image->data.gicon.pixbuf = gtk_icon_info_load_icon (info, NULL);
+          image->data.gicon.pixbuf = load_icon_async (image, info, MIN (width, height));
+          if (image->data.gicon.pixbuf == NULL)
+            image->data.gicon.pixbuf = gtk_icon_info_load_icon (info, NULL);
           gtk_icon_info_free (info);
         }
 
@@ -2174,6 +2319,8 @@ gtk_image_reset (GtkImage *image)
 
   priv = GTK_IMAGE_GET_PRIVATE (image);
 
+  gtk_image_cancel_icon_load (image);
+
   g_object_freeze_notify (G_OBJECT (image));
   
   if (image->storage_type != GTK_IMAGE_EMPTY)
@@ -2455,6 +2602,8 @@ gtk_image_set_pixel_size (GtkImage *image,
   if (priv->pixel_size != pixel_size)
     {
       priv->pixel_size = pixel_size;
+
+      gtk_image_cancel_icon_load (image);
       
       if (image->storage_type == GTK_IMAGE_ICON_NAME)
 	{
@@ -140,6 +140,66 @@ struct _GtkRcStylePrivate
   GSList *color_hashes;
 };
 
+/* Compiled gtkrc files
+ *
+ * While a gtkrc file is parsed, what its statements did is recorded
+ * as a list of operations. The list is saved in the user's cache
+ * directory and run instead of parsing the file, as long as the file
+ * keeps its size and mtime. Statements whose outcome depends on more
+ * than the file itself (includes, engines, bindings, stock icons,
+ * symbolic colors, ...) are kept as text, and parsed again when the
+ * operations are run.
+ */
+typedef enum
+{
+  RC_OP_TEXT,             /* string: statements to parse */
+  RC_OP_STYLE,            /* string name, uint32 has_parent, string parent */
+  RC_OP_STYLE_TEXT,       /* string: style statements to parse */
+  RC_OP_STYLE_COLOR,      /* uint32 flag, uint32 state, uint32 red, green, blue */
+  RC_OP_STYLE_XTHICKNESS, /* uint32 */
+  RC_OP_STYLE_YTHICKNESS, /* uint32 */
+  RC_OP_STYLE_FONT_NAME,  /* string */
+  RC_OP_STYLE_PROPERTY,   /* string type, string property, string origin, value */
+  RC_OP_STYLE_END,
+  RC_OP_RC_SET,           /* uint32 path type, uint32 priority or G_MAXUINT32,
+                           * string pattern, string style */
+  RC_OP_SETTING           /* string name, string origin, value */
+} GtkRcOp;
+
+typedef enum
+{
+  RC_VALUE_LONG,          /* int64 */
+  RC_VALUE_DOUBLE,        /* double */
+  RC_VALUE_STRING,        /* string */
+  RC_VALUE_GSTRING        /* string */
+} GtkRcValueType;
+
+typedef struct _GtkRcCompiler GtkRcCompiler;
+typedef struct _GtkRcSegment GtkRcSegment;
+typedef struct _GtkRcCacheReader GtkRcCacheReader;
+
+/* Set as the user data of the scanner of a file being compiled */
+struct _GtkRcCompiler
+{
+  GByteArray *ops;
+  GScannerMsgFunc msg_handler;
+  guint failed : 1;
+};
+
+/* The statements parsed since the last known position in the text */
+struct _GtkRcSegment
+{
+  const gchar *start;
+  guint mark;
+  guint dirty : 1;
+};
+
+struct _GtkRcCacheReader
+{
+  const gchar *data;
+  const gchar *end;
+};
+
 static GtkRcContext *gtk_rc_context_get              (GtkSettings     *settings);
 
 static guint       gtk_rc_style_hash                 (const gchar     *name);
@@ -169,12 +229,30 @@ static void        gtk_rc_context_parse_file         (GtkRcContext    *context,
                                                       gboolean         reload);
 static void        gtk_rc_parse_any                  (GtkRcContext    *context,
 						      const gchar     *input_name,
-                                                      gint             input_fd,
                                                       const gchar     *input_string);
+static GScanner*   gtk_rc_parser_new                 (const gchar     *input_name);
+static void        gtk_rc_parse_statements           (GtkRcContext    *context,
+						      GScanner        *scanner);
 static guint       gtk_rc_parse_statement            (GtkRcContext    *context,
 						      GScanner        *scanner);
 static guint       gtk_rc_parse_style                (GtkRcContext    *context,
 						      GScanner        *scanner);
+static GtkRcStyle* gtk_rc_style_begin                (GtkRcContext    *context,
+						      const gchar     *name,
+						      const gchar     *parent_name,
+						      GtkRcStyle     **orig_style);
+static void        gtk_rc_style_end                  (GtkRcContext    *context,
+						      GtkRcStyle      *rc_style,
+						      GtkRcStyle      *orig_style,
+						      gboolean         success);
+static guint       gtk_rc_parse_style_statement      (GtkRcContext    *context,
+						      GScanner        *scanner,
+						      GtkRcStyle     **rc_style);
+static void        gtk_rc_add_rc_set                 (GtkRcContext    *context,
+						      GtkPathType      path_type,
+						      const gchar     *pattern,
+						      GtkRcStyle      *rc_style,
+						      GtkPathPriorityType priority);
 static guint       gtk_rc_parse_assignment           (GScanner        *scanner,
                                                       GtkRcStyle      *style,
 						      GtkRcProperty   *prop);
@@ -920,7 +998,7 @@ static void
 gtk_rc_context_parse_string (GtkRcContext *context,
 			     const gchar  *rc_string)
 {
-  gtk_rc_parse_any (context, "-", -1, rc_string);
+  gtk_rc_parse_any (context, "-", rc_string);
 }
 
 void
@@ -976,6 +1054,778 @@ add_to_rc_file_list (GSList     **rc_file_list,
   return rc_file;
 }
 
+#define RC_CACHE_MAGIC       "GTKRCC\0\1"
+#define RC_CACHE_BYTE_ORDER  0x01020304
+#define RC_CACHE_HAS_ORIGINS (1 << 0)
+
+static guint32
+rc_cache_flags (void)
+{
+  /* Properties and settings only know where they come from
+   * when debugging.
+   */
+  return g_getenv ("GTK_DEBUG") ? RC_CACHE_HAS_ORIGINS : 0;
+}
+
+static gchar *
+rc_cache_filename (const gchar *filename)
+{
+  gchar *checksum, *basename, *path;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, filename, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  path = g_build_filename (g_get_user_cache_dir (), "gtk-2.0", "rc", basename, NULL);
+
+  g_free (basename);
+  g_free (checksum);
+
+  return path;
+}
+
+static void
+rc_cache_put_uint32 (GByteArray *data,
+                     guint32     value)
+{
+  g_byte_array_append (data, (guint8 *) &value, sizeof (value));
+}
+
+static void
+rc_cache_put_int64 (GByteArray *data,
+                    gint64      value)
+{
+  g_byte_array_append (data, (guint8 *) &value, sizeof (value));
+}
+
+static void
+rc_cache_put_text (GByteArray  *data,
+                   const gchar *text,
+                   gsize        length)
+{
+  rc_cache_put_uint32 (data, length);
+  if (length)
+    g_byte_array_append (data, (guint8 *) text, length);
+  g_byte_array_append (data, (guint8 *) "", 1);
+}
+
+static void
+rc_cache_put_string (GByteArray  *data,
+                     const gchar *string)
+{
+  rc_cache_put_text (data, string, string ? strlen (string) : 0);
+}
+
+static gboolean
+rc_cache_put_value (GByteArray   *data,
+                    const GValue *value)
+{
+  if (G_VALUE_HOLDS_LONG (value))
+    {
+      rc_cache_put_uint32 (data, RC_VALUE_LONG);
+      rc_cache_put_int64 (data, g_value_get_long (value));
+    }
+  else if (G_VALUE_HOLDS_DOUBLE (value))
+    {
+      gdouble d = g_value_get_double (value);
+
+      rc_cache_put_uint32 (data, RC_VALUE_DOUBLE);
+      g_byte_array_append (data, (guint8 *) &d, sizeof (d));
+    }
+  else if (G_VALUE_HOLDS_STRING (value))
+    {
+      rc_cache_put_uint32 (data, RC_VALUE_STRING);
+      rc_cache_put_string (data, g_value_get_string (value));
+    }
+  else if (G_VALUE_HOLDS (value, G_TYPE_GSTRING))
+    {
+      GString *gstring = g_value_get_boxed (value);
+
+      rc_cache_put_uint32 (data, RC_VALUE_GSTRING);
+      rc_cache_put_text (data, gstring->str, gstring->len);
+    }
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+rc_cache_get_data (GtkRcCacheReader *reader,
+                   gpointer          data,
+                   gsize             size)
+{
+  if ((gsize) (reader->end - reader->data) < size)
+    return FALSE;
+
+  memcpy (data, reader->data, size);
+  reader->data += size;
+
+  return TRUE;
+}
+
+static gboolean
+rc_cache_get_uint32 (GtkRcCacheReader *reader,
+                     guint32          *value)
+{
+  return rc_cache_get_data (reader, value, sizeof (guint32));
+}
+
+static gboolean
+rc_cache_get_int64 (GtkRcCacheReader *reader,
+                    gint64           *value)
+{
+  return rc_cache_get_data (reader, value, sizeof (gint64));
+}
+
+static gboolean
+rc_cache_get_string (GtkRcCacheReader *reader,
+                     const gchar     **string,
+                     gsize            *length)
+{
+  guint32 n;
+
+  if (!rc_cache_get_uint32 (reader, &n) ||
+      (gsize) (reader->end - reader->data) <= n ||
+      reader->data[n] != '\0')
+    return FALSE;
+
+  *string = reader->data;
+  if (length)
+    *length = n;
+  reader->data += n + 1;
+
+  return TRUE;
+}
+
+static gboolean
+rc_cache_get_value (GtkRcCacheReader *reader,
+                    GValue           *value)
+{
+  guint32 type;
+  gint64 l;
+  gdouble d;
+  const gchar *string;
+  gsize length;
+
+  if (!rc_cache_get_uint32 (reader, &type))
+    return FALSE;
+
+  switch (type)
+    {
+    case RC_VALUE_LONG:
+      if (!rc_cache_get_int64 (reader, &l))
+        return FALSE;
+      g_value_init (value, G_TYPE_LONG);
+      g_value_set_long (value, l);
+      return TRUE;
+
+    case RC_VALUE_DOUBLE:
+      if (!rc_cache_get_data (reader, &d, sizeof (d)))
+        return FALSE;
+      g_value_init (value, G_TYPE_DOUBLE);
+      g_value_set_double (value, d);
+      return TRUE;
+
+    case RC_VALUE_STRING:
+      if (!rc_cache_get_string (reader, &string, NULL))
+        return FALSE;
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, string);
+      return TRUE;
+
+    case RC_VALUE_GSTRING:
+      if (!rc_cache_get_string (reader, &string, &length))
+        return FALSE;
+      g_value_init (value, G_TYPE_GSTRING);
+      g_value_take_boxed (value, g_string_new_len (string, length));
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static void
+rc_compiler_msg_handler (GScanner *scanner,
+                         gchar    *message,
+                         gboolean  error)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  /* Files with problems aren't compiled, so that the warnings
+   * show up every time.
+   */
+  compiler->failed = TRUE;
+  compiler->msg_handler (scanner, message, error);
+}
+
+static void
+rc_compiler_add_op (GScanner *scanner,
+                    GtkRcOp   op)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    rc_cache_put_uint32 (compiler->ops, op);
+}
+
+static void
+rc_compiler_add_uint32 (GScanner *scanner,
+                        GtkRcOp   op,
+                        guint32   value)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      rc_cache_put_uint32 (compiler->ops, op);
+      rc_cache_put_uint32 (compiler->ops, value);
+    }
+}
+
+static void
+rc_compiler_add_string (GScanner    *scanner,
+                        GtkRcOp      op,
+                        const gchar *string)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      rc_cache_put_uint32 (compiler->ops, op);
+      rc_cache_put_string (compiler->ops, string);
+    }
+}
+
+static void
+rc_compiler_add_style (GScanner    *scanner,
+                       const gchar *name,
+                       const gchar *parent_name)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      rc_cache_put_uint32 (compiler->ops, RC_OP_STYLE);
+      rc_cache_put_string (compiler->ops, name);
+      rc_cache_put_uint32 (compiler->ops, parent_name != NULL);
+      rc_cache_put_string (compiler->ops, parent_name);
+    }
+}
+
+static void
+rc_compiler_add_color (GScanner       *scanner,
+                       GtkRcFlags      flag,
+                       GtkStateType    state,
+                       const GdkColor *color)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      rc_cache_put_uint32 (compiler->ops, RC_OP_STYLE_COLOR);
+      rc_cache_put_uint32 (compiler->ops, flag);
+      rc_cache_put_uint32 (compiler->ops, state);
+      rc_cache_put_uint32 (compiler->ops, color->red);
+      rc_cache_put_uint32 (compiler->ops, color->green);
+      rc_cache_put_uint32 (compiler->ops, color->blue);
+    }
+}
+
+static void
+rc_compiler_add_property (GScanner            *scanner,
+                          const GtkRcProperty *prop)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      rc_cache_put_uint32 (compiler->ops, RC_OP_STYLE_PROPERTY);
+      rc_cache_put_string (compiler->ops, g_quark_to_string (prop->type_name));
+      rc_cache_put_string (compiler->ops, g_quark_to_string (prop->property_name));
+      rc_cache_put_string (compiler->ops, prop->origin);
+      if (!rc_cache_put_value (compiler->ops, &prop->value))
+        compiler->failed = TRUE;
+    }
+}
+
+static void
+rc_compiler_add_rc_set (GScanner    *scanner,
+                        GtkPathType  path_type,
+                        guint32      priority,
+                        const gchar *pattern,
+                        const gchar *style_name)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      rc_cache_put_uint32 (compiler->ops, RC_OP_RC_SET);
+      rc_cache_put_uint32 (compiler->ops, path_type);
+      rc_cache_put_uint32 (compiler->ops, priority);
+      rc_cache_put_string (compiler->ops, pattern);
+      rc_cache_put_string (compiler->ops, style_name);
+    }
+}
+
+static void
+rc_compiler_add_setting (GScanner               *scanner,
+                         const gchar            *name,
+                         const GtkSettingsValue *svalue)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      rc_cache_put_uint32 (compiler->ops, RC_OP_SETTING);
+      rc_cache_put_string (compiler->ops, name);
+      rc_cache_put_string (compiler->ops, svalue->origin);
+      if (!rc_cache_put_value (compiler->ops, &svalue->value))
+        compiler->failed = TRUE;
+    }
+}
+
+static void
+rc_segment_begin (GtkRcSegment *segment,
+                  GScanner     *scanner)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler)
+    {
+      segment->start = scanner->text;
+      segment->mark = compiler->ops->len;
+      segment->dirty = FALSE;
+    }
+}
+
+static void
+rc_segment_add_text (GtkRcSegment *segment,
+                     GScanner     *scanner,
+                     GtkRcOp       text_op)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  g_byte_array_set_size (compiler->ops, segment->mark);
+  rc_cache_put_uint32 (compiler->ops, text_op);
+  rc_cache_put_text (compiler->ops, segment->start, scanner->text - segment->start);
+}
+
+/* Called after each statement that was parsed without errors. A
+ * statement that didn't record any operations is kept as text;
+ * within styles, so are statements that use symbolic colors, since
+ * those can change without the file changing.
+ */
+static void
+rc_segment_end_statement (GtkRcSegment *segment,
+                          GScanner     *scanner,
+                          GtkRcOp       text_op)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (!compiler)
+    return;
+
+  /* A statement that peeked at the next token doesn't end at a known
+   * position in the text, so it goes into the text of the next one.
+   */
+  if (scanner->next_token != G_TOKEN_NONE)
+    {
+      segment->dirty = TRUE;
+      return;
+    }
+
+  if (segment->dirty ||
+      compiler->ops->len == segment->mark ||
+      (text_op == RC_OP_STYLE_TEXT &&
+       memchr (segment->start, '@', scanner->text - segment->start)))
+    rc_segment_add_text (segment, scanner, text_op);
+
+  rc_segment_begin (segment, scanner);
+}
+
+/* Called once the token ending the statements has been peeked; text
+ * that is left over includes that token, which ends the parsing of
+ * the text again.
+ */
+static void
+rc_segment_end (GtkRcSegment *segment,
+                GScanner     *scanner,
+                GtkRcOp       text_op)
+{
+  GtkRcCompiler *compiler = scanner->user_data;
+
+  if (compiler && segment->dirty)
+    rc_segment_add_text (segment, scanner, text_op);
+}
+
+static gboolean
+rc_cache_check_header (GtkRcCacheReader  *reader,
+                       const gchar       *filename,
+                       const struct stat *statbuf)
+{
+  guint32 byte_order, flags;
+  gint64 mtime, size;
+  const gchar *name;
+
+  if ((gsize) (reader->end - reader->data) < 8 ||
+      memcmp (reader->data, RC_CACHE_MAGIC, 8) != 0)
+    return FALSE;
+
+  reader->data += 8;
+
+  return rc_cache_get_uint32 (reader, &byte_order) &&
+         byte_order == RC_CACHE_BYTE_ORDER &&
+         rc_cache_get_uint32 (reader, &flags) &&
+         flags == rc_cache_flags () &&
+         rc_cache_get_int64 (reader, &mtime) &&
+         mtime == statbuf->st_mtime &&
+         rc_cache_get_int64 (reader, &size) &&
+         size == statbuf->st_size &&
+         rc_cache_get_string (reader, &name, NULL) &&
+         strcmp (name, filename) == 0;
+}
+
+static void
+rc_cache_parse_text (GtkRcContext *context,
+                     GScanner     *scanner,
+                     const gchar  *text,
+                     gsize         length,
+                     GtkRcStyle  **rc_style)
+{
+  guint token;
+
+  g_scanner_input_text (scanner, text, length);
+
+  if (!rc_style)
+    {
+      gtk_rc_parse_statements (context, scanner);
+      return;
+    }
+
+  token = g_scanner_peek_next_token (scanner);
+  while (token != G_TOKEN_RIGHT_CURLY && token != G_TOKEN_EOF)
+    {
+      token = gtk_rc_parse_style_statement (context, scanner, rc_style);
+      if (token != G_TOKEN_NONE)
+        {
+          g_scanner_unexp_token (scanner, token, NULL, "keyword",
+                                 NULL, NULL, TRUE);
+          break;
+        }
+
+      token = g_scanner_peek_next_token (scanner);
+    }
+}
+
+/* Runs the operations of a compiled file. Without a context, the
+ * operations are only checked, so that a damaged cache is never
+ * partially applied.
+ */
+static gboolean
+rc_cache_run (GtkRcContext     *context,
+              GtkRcCacheReader *reader,
+              const gchar      *input_name)
+{
+  GScanner *scanner = NULL;
+  GtkRcStyle *rc_style = NULL;
+  GtkRcStyle *orig_style = NULL;
+  gboolean in_style = FALSE;
+  gboolean result = FALSE;
+
+  while (reader->data < reader->end)
+    {
+      guint32 op, a, b, rgb[3];
+      const gchar *s1, *s2;
+      gsize length;
+      GdkColor *colors;
+
+      if (!rc_cache_get_uint32 (reader, &op))
+        goto out;
+
+      if ((op >= RC_OP_STYLE_TEXT && op <= RC_OP_STYLE_END) != in_style)
+        goto out;
+
+      switch (op)
+        {
+        case RC_OP_TEXT:
+        case RC_OP_STYLE_TEXT:
+          if (!rc_cache_get_string (reader, &s1, &length))
+            goto out;
+          if (context)
+            {
+              if (!scanner)
+                scanner = gtk_rc_parser_new (input_name);
+              rc_cache_parse_text (context, scanner, s1, length,
+                                   op == RC_OP_STYLE_TEXT ? &rc_style : NULL);
+            }
+          break;
+
+        case RC_OP_STYLE:
+          if (!rc_cache_get_string (reader, &s1, NULL) ||
+              !rc_cache_get_uint32 (reader, &a) ||
+              !rc_cache_get_string (reader, &s2, NULL))
+            goto out;
+          if (context)
+            rc_style = gtk_rc_style_begin (context, s1, a ? s2 : NULL, &orig_style);
+          in_style = TRUE;
+          break;
+
+        case RC_OP_STYLE_COLOR:
+          if (!rc_cache_get_uint32 (reader, &a) ||
+              !rc_cache_get_uint32 (reader, &b) ||
+              !rc_cache_get_data (reader, rgb, sizeof (rgb)) ||
+              b > GTK_STATE_INSENSITIVE)
+            goto out;
+          if (a != GTK_RC_FG && a != GTK_RC_BG &&
+              a != GTK_RC_TEXT && a != GTK_RC_BASE)
+            goto out;
+          if (context)
+            {
+              if (a == GTK_RC_FG)
+                colors = rc_style->fg;
+              else if (a == GTK_RC_BG)
+                colors = rc_style->bg;
+              else if (a == GTK_RC_TEXT)
+                colors = rc_style->text;
+              else
+                colors = rc_style->base;
+
+              rc_style->color_flags[b] |= a;
+              colors[b].red = rgb[0];
+              colors[b].green = rgb[1];
+              colors[b].blue = rgb[2];
+            }
+          break;
+
+        case RC_OP_STYLE_XTHICKNESS:
+        case RC_OP_STYLE_YTHICKNESS:
+          if (!rc_cache_get_uint32 (reader, &a))
+            goto out;
+          if (context)
+            {
+              if (op == RC_OP_STYLE_XTHICKNESS)
+                rc_style->xthickness = (gint) a;
+              else
+                rc_style->ythickness = (gint) a;
+            }
+          break;
+
+        case RC_OP_STYLE_FONT_NAME:
+          if (!rc_cache_get_string (reader, &s1, NULL))
+            goto out;
+          if (context)
+            {
+              if (rc_style->font_desc)
+                pango_font_description_free (rc_style->font_desc);
+              rc_style->font_desc = pango_font_description_from_string (s1);
+            }
+          break;
+
+        case RC_OP_STYLE_PROPERTY:
+          {
+            GtkRcProperty prop = { 0, 0, NULL, { 0, }, };
+            const gchar *origin;
+
+            if (!rc_cache_get_string (reader, &s1, NULL) ||
+                !rc_cache_get_string (reader, &s2, NULL) ||
+                !rc_cache_get_string (reader, &origin, NULL))
+              goto out;
+
+            if (!rc_cache_get_value (reader, &prop.value))
+              goto out;
+            if (context)
+              {
+                prop.type_name = g_quark_from_string (s1);
+                prop.property_name = g_quark_from_string (s2);
+                prop.origin = origin[0] ? (gchar *) origin : NULL;
+                insert_rc_property (rc_style, &prop, TRUE);
+              }
+            g_value_unset (&prop.value);
+          }
+          break;
+
+        case RC_OP_STYLE_END:
+          if (context)
+            gtk_rc_style_end (context, rc_style, orig_style, TRUE);
+          rc_style = orig_style = NULL;
+          in_style = FALSE;
+          break;
+
+        case RC_OP_RC_SET:
+          if (!rc_cache_get_uint32 (reader, &a) ||
+              !rc_cache_get_uint32 (reader, &b) ||
+              !rc_cache_get_string (reader, &s1, NULL) ||
+              !rc_cache_get_string (reader, &s2, NULL) ||
+              a > GTK_PATH_CLASS)
+            goto out;
+          if (context)
+            {
+              GtkRcStyle *set_style = gtk_rc_style_find (context, s2);
+
+              if (set_style)
+                gtk_rc_add_rc_set (context, a, s1, set_style,
+                                   b == G_MAXUINT32 ? context->default_priority : b);
+            }
+          break;
+
+        case RC_OP_SETTING:
+          {
+            GtkSettingsValue svalue = { NULL, { 0, }, };
+            const gchar *origin;
+
+            if (!rc_cache_get_string (reader, &s1, NULL) ||
+                !rc_cache_get_string (reader, &origin, NULL))
+              goto out;
+
+            if (!rc_cache_get_value (reader, &svalue.value))
+              goto out;
+            if (context)
+              {
+                svalue.origin = origin[0] ? (gchar *) origin : NULL;
+                _gtk_settings_set_property_value_from_rc (context->settings,
+                                                          s1, &svalue);
+              }
+            g_value_unset (&svalue.value);
+          }
+          break;
+
+        default:
+          goto out;
+        }
+    }
+
+  result = !in_style;
+
+ out:
+  if (rc_style)
+    gtk_rc_style_end (context, rc_style, orig_style, FALSE);
+  if (scanner)
+    g_scanner_destroy (scanner);
+
+  return result;
+}
+
+/* Runs the compiled form of @rc_file if there is an up to date one,
+ * and returns whether it did.
+ */
+static gboolean
+gtk_rc_cache_load (GtkRcContext *context,
+                   GtkRcFile    *rc_file,
+                   const gchar  *input_name)
+{
+  struct stat statbuf;
+  GMappedFile *map;
+  GtkRcCacheReader reader, ops;
+  gchar *cache_file;
+  gboolean result = FALSE;
+
+  if (g_stat (rc_file->canonical_name, &statbuf) < 0)
+    return FALSE;
+
+  cache_file = rc_cache_filename (rc_file->canonical_name);
+  map = g_mapped_file_new (cache_file, FALSE, NULL);
+  g_free (cache_file);
+
+  if (!map)
+    return FALSE;
+
+  reader.data = g_mapped_file_get_contents (map);
+  reader.end = reader.data + g_mapped_file_get_length (map);
+
+  if (reader.data &&
+      rc_cache_check_header (&reader, rc_file->canonical_name, &statbuf))
+    {
+      ops = reader;
+      if (rc_cache_run (NULL, &ops, input_name))
+        {
+          GTK_NOTE (MISC, g_message ("Using compiled %s", rc_file->canonical_name));
+          rc_cache_run (context, &reader, input_name);
+          result = TRUE;
+        }
+      else
+        GTK_NOTE (MISC, g_message ("Compiled %s is damaged", rc_file->canonical_name));
+    }
+
+  g_mapped_file_unref (map);
+
+  return result;
+}
+
+static void
+rc_cache_save (const gchar       *filename,
+               const struct stat *statbuf,
+               GByteArray        *ops)
+{
+  GByteArray *data;
+  gchar *cache_file, *dir;
+  gboolean saved = FALSE;
+
+  data = g_byte_array_sized_new (ops->len + 256);
+  g_byte_array_append (data, (guint8 *) RC_CACHE_MAGIC, 8);
+  rc_cache_put_uint32 (data, RC_CACHE_BYTE_ORDER);
+  rc_cache_put_uint32 (data, rc_cache_flags ());
+  rc_cache_put_int64 (data, statbuf->st_mtime);
+  rc_cache_put_int64 (data, statbuf->st_size);
+  rc_cache_put_string (data, filename);
+  g_byte_array_append (data, ops->data, ops->len);
+
+  cache_file = rc_cache_filename (filename);
+  dir = g_path_get_dirname (cache_file);
+
+  if (g_mkdir_with_parents (dir, 0700) == 0)
+    saved = g_file_set_contents (cache_file, (gchar *) data->data, data->len, NULL);
+
+  GTK_NOTE (MISC, g_message ("%s %s to %s",
+                             saved ? "Compiled" : "Failed to compile",
+                             filename, cache_file));
+
+  g_free (dir);
+  g_free (cache_file);
+  g_byte_array_free (data, TRUE);
+}
+
+/* Parses @rc_file, and saves what it did for gtk_rc_cache_load() */
+static void
+gtk_rc_compile_file (GtkRcContext *context,
+                     GtkRcFile    *rc_file,
+                     const gchar  *input_name)
+{
+  GtkRcCompiler compiler;
+  GScanner *scanner;
+  struct stat statbuf;
+  GTimeVal now;
+  gchar *contents;
+  gsize length;
+
+  /* Stat first, so that changes made while parsing get a newer mtime */
+  if (g_stat (rc_file->canonical_name, &statbuf) < 0 ||
+      !g_file_get_contents (rc_file->canonical_name, &contents, &length, NULL))
+    return;
+
+  compiler.ops = g_byte_array_new ();
+  compiler.failed = FALSE;
+
+  scanner = gtk_rc_parser_new (input_name);
+  g_scanner_input_text (scanner, contents, length);
+  compiler.msg_handler = scanner->msg_handler;
+  scanner->msg_handler = rc_compiler_msg_handler;
+  scanner->user_data = &compiler;
+
+  gtk_rc_parse_statements (context, scanner);
+
+  g_scanner_destroy (scanner);
+
+  /* A file changed within the current second may change again
+   * without getting a new mtime.
+   */
+  g_get_current_time (&now);
+  if (!compiler.failed && statbuf.st_mtime < now.tv_sec)
+    rc_cache_save (rc_file->canonical_name, &statbuf, compiler.ops);
+
+  g_byte_array_free (compiler.ops, TRUE);
+  g_free (contents);
+}
+
 static void
 gtk_rc_context_parse_one_file (GtkRcContext *context,
 			       const gchar  *filename,
@@ -1018,26 +1868,18 @@ gtk_rc_context_parse_one_file (GtkRcContext *context,
 
   if (!g_lstat (rc_file->canonical_name, &statbuf))
     {
-      gint fd;
-      
       rc_file->mtime = statbuf.st_mtime;
 
-      fd = g_open (rc_file->canonical_name, O_RDONLY, 0);
-      if (fd < 0)
-	goto out;
-
       /* Temporarily push information for this file on
        * a stack of current files while parsing it.
        */
       current_files_stack = g_slist_prepend (current_files_stack, rc_file);
-      gtk_rc_parse_any (context, filename, fd, NULL);
+      if (!gtk_rc_cache_load (context, rc_file, filename))
+        gtk_rc_compile_file (context, rc_file, filename);
       current_files_stack = g_slist_delete_link (current_files_stack,
 						 current_files_stack);
-
-      close (fd);
     }
 
- out:
   context->default_priority = saved_priority;
 }
 
@@ -2235,34 +3077,46 @@ gtk_rc_scanner_new (void)
   return g_scanner_new (&gtk_rc_scanner_config);
 }
 
+static GScanner *
+gtk_rc_parser_new (const gchar *input_name)
+{
+  GScanner *scanner;
+  guint i;
+
+  scanner = gtk_rc_scanner_new ();
+  scanner->input_name = input_name;
+
+  for (i = 0; i < G_N_ELEMENTS (symbols); i++)
+    g_scanner_scope_add_symbol (scanner, 0, symbol_names + symbols[i].name_offset, GINT_TO_POINTER (symbols[i].token));
+
+  return scanner;
+}
+
+static void
+gtk_rc_parse_any (GtkRcContext *context,
+		  const gchar  *input_name,
+		  const gchar  *input_string)
+{
+  GScanner *scanner;
+
+  scanner = gtk_rc_parser_new (input_name);
+  g_scanner_input_text (scanner, input_string, strlen (input_string));
+
+  gtk_rc_parse_statements (context, scanner);
+
+  g_scanner_destroy (scanner);
+}
+
 static void
-gtk_rc_parse_any (GtkRcContext *context,
-		  const gchar  *input_name,
-		  gint		input_fd,
-		  const gchar  *input_string)
+gtk_rc_parse_statements (GtkRcContext *context,
+			 GScanner     *scanner)
 {
-  GScanner *scanner;
+  GtkRcSegment segment;
   guint	   i;
   gboolean done;
 
-  scanner = gtk_rc_scanner_new ();
-  
-  if (input_fd >= 0)
-    {
-      g_assert (input_string == NULL);
-      
-      g_scanner_input_file (scanner, input_fd);
-    }
-  else
-    {
-      g_assert (input_string != NULL);
-      
-      g_scanner_input_text (scanner, input_string, strlen (input_string));
-    }
-  scanner->input_name = input_name;
+  rc_segment_begin (&segment, scanner);
 
-  for (i = 0; i < G_N_ELEMENTS (symbols); i++)
-    g_scanner_scope_add_symbol (scanner, 0, symbol_names + symbols[i].name_offset, GINT_TO_POINTER (symbols[i].token));
   done = FALSE;
   while (!done)
     {
@@ -2274,7 +3128,9 @@ gtk_rc_parse_any (GtkRcContext *context,
 	  
 	  expected_token = gtk_rc_parse_statement (context, scanner);
 
-	  if (expected_token != G_TOKEN_NONE)
+	  if (expected_token == G_TOKEN_NONE)
+	    rc_segment_end_statement (&segment, scanner, RC_OP_TEXT);
+	  else
 	    {
 	      const gchar *symbol_name = NULL;
 	      gchar *msg = NULL;
@@ -2321,8 +3177,8 @@ gtk_rc_parse_any (GtkRcContext *context,
 	    }
 	}
     }
-  
-  g_scanner_destroy (scanner);
+
+  rc_segment_end (&segment, scanner, RC_OP_TEXT);
 }
 
 static guint	   
@@ -2966,6 +3822,7 @@ gtk_rc_parse_statement (GtkRcContext *context,
 	      _gtk_settings_set_property_value_from_rc (context->settings,
 							name,
 							&svalue);
+	      rc_compiler_add_setting (scanner, name, &svalue);
 	    }
 	  g_free (prop.origin);
 	  if (G_VALUE_TYPE (&prop.value))
@@ -3015,12 +3872,10 @@ gtk_rc_parse_style (GtkRcContext *context,
 {
   GtkRcStyle *rc_style;
   GtkRcStyle *orig_style;
-  GtkRcStyle *parent_style = NULL;
-  GtkRcStylePrivate *rc_priv = NULL;
+  GtkRcSegment segment;
+  gchar *name;
+  gchar *parent_name = NULL;
   guint token;
-  gint i;
-  GtkIconFactory *our_factory = NULL;
-  GHashTable *our_hash = NULL;
 
   token = g_scanner_get_next_token (scanner);
   if (token != GTK_RC_TOKEN_STYLE)
@@ -3029,35 +3884,9 @@ gtk_rc_parse_style (GtkRcContext *context,
   token = g_scanner_get_next_token (scanner);
   if (token != G_TOKEN_STRING)
     return G_TOKEN_STRING;
-  
-  rc_style = gtk_rc_style_find (context, scanner->value.v_string);
-  if (rc_style)
-    orig_style = g_object_ref (rc_style);
-  else
-    orig_style = NULL;
-
-  if (!rc_style)
-    {
-      rc_style = gtk_rc_style_new ();
-      rc_style->name = g_strdup (scanner->value.v_string);
-      
-      for (i = 0; i < 5; i++)
-	rc_style->bg_pixmap_name[i] = NULL;
-
-      for (i = 0; i < 5; i++)
-	rc_style->color_flags[i] = 0;
-    }
-
-  rc_priv = GTK_RC_STYLE_GET_PRIVATE (rc_style);
-
-  /* If there's a list, its first member is always the factory belonging
-   * to this RcStyle
-   */
-  if (rc_style->icon_factories)
-    our_factory = rc_style->icon_factories->data;
-  if (rc_priv->color_hashes)
-    our_hash = rc_priv->color_hashes->data;
 
+  name = g_strdup (scanner->value.v_string);
+  
   token = g_scanner_peek_next_token (scanner);
   if (token == G_TOKEN_EQUAL_SIGN)
     {
@@ -3066,60 +3895,18 @@ gtk_rc_parse_style (GtkRcContext *context,
       token = g_scanner_get_next_token (scanner);
       if (token != G_TOKEN_STRING)
 	{
-	  token = G_TOKEN_STRING;
-	  goto err;
+	  g_free (name);
+	  return G_TOKEN_STRING;
 	}
-      
-      parent_style = gtk_rc_style_find (context, scanner->value.v_string);
-      if (parent_style)
-	{
-	  for (i = 0; i < 5; i++)
-	    {
-	      rc_style->color_flags[i] = parent_style->color_flags[i];
-	      rc_style->fg[i] = parent_style->fg[i];
-	      rc_style->bg[i] = parent_style->bg[i];
-	      rc_style->text[i] = parent_style->text[i];
-	      rc_style->base[i] = parent_style->base[i];
-	    }
-
-	  rc_style->xthickness = parent_style->xthickness;
-	  rc_style->ythickness = parent_style->ythickness;
-	  
-	  if (parent_style->font_desc)
-	    {
-	      if (rc_style->font_desc)
-		pango_font_description_free (rc_style->font_desc);
-	      rc_style->font_desc = pango_font_description_copy (parent_style->font_desc);
-	    }
-
-	  if (parent_style->rc_properties)
-	    {
-	      guint i;
 
-	      for (i = 0; i < parent_style->rc_properties->len; i++)
-		insert_rc_property (rc_style,
-				    &g_array_index (parent_style->rc_properties, GtkRcProperty, i),
-				    TRUE);
-	    }
-	  
-	  for (i = 0; i < 5; i++)
-	    {
-	      g_free (rc_style->bg_pixmap_name[i]);
-	      rc_style->bg_pixmap_name[i] = g_strdup (parent_style->bg_pixmap_name[i]);
-	    }
-	}
+      parent_name = g_strdup (scanner->value.v_string);
     }
 
-  /*  get icon_factories and color_hashes from the parent style;
-   *  if the parent_style doesn't have color_hashes, initializes
-   *  the color_hashes with the settings' color scheme (if it exists)
-   */
-  gtk_rc_style_copy_icons_and_colors (rc_style, parent_style, context);
+  rc_style = gtk_rc_style_begin (context, name, parent_name, &orig_style);
+  rc_compiler_add_style (scanner, name, parent_name);
 
-  if (rc_style->icon_factories)
-    our_factory = rc_style->icon_factories->data;
-  if (rc_priv->color_hashes)
-    our_hash = rc_priv->color_hashes->data;
+  g_free (name);
+  g_free (parent_name);
 
   token = g_scanner_get_next_token (scanner);
   if (token != G_TOKEN_LEFT_CURLY)
@@ -3127,114 +3914,22 @@ gtk_rc_parse_style (GtkRcContext *context,
       token = G_TOKEN_LEFT_CURLY;
       goto err;
     }
+
+  rc_segment_begin (&segment, scanner);
   
   token = g_scanner_peek_next_token (scanner);
   while (token != G_TOKEN_RIGHT_CURLY)
     {
-      switch (token)
-	{
-	case GTK_RC_TOKEN_BG:
-	  token = gtk_rc_parse_bg (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_FG:
-	  token = gtk_rc_parse_fg (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_TEXT:
-	  token = gtk_rc_parse_text (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_BASE:
-	  token = gtk_rc_parse_base (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_XTHICKNESS:
-	  token = gtk_rc_parse_xthickness (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_YTHICKNESS:
-	  token = gtk_rc_parse_ythickness (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_BG_PIXMAP:
-	  token = gtk_rc_parse_bg_pixmap (context, scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_FONT:
-	  token = gtk_rc_parse_font (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_FONTSET:
-	  token = gtk_rc_parse_fontset (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_FONT_NAME:
-	  token = gtk_rc_parse_font_name (scanner, rc_style);
-	  break;
-	case GTK_RC_TOKEN_ENGINE:
-	  token = gtk_rc_parse_engine (context, scanner, &rc_style);
-	  break;
-        case GTK_RC_TOKEN_STOCK:
-          if (our_factory == NULL)
-            gtk_rc_style_prepend_empty_icon_factory (rc_style);
-          our_factory = rc_style->icon_factories->data;
-          token = gtk_rc_parse_stock (context, scanner, rc_style, our_factory);
-          break;
-        case GTK_RC_TOKEN_COLOR:
-          if (our_hash == NULL)
-            {
-              gtk_rc_style_prepend_empty_color_hash (rc_style);
-              our_hash = rc_priv->color_hashes->data;
-            }
-          token = gtk_rc_parse_logical_color (scanner, rc_style, our_hash);
-          break;
-	case G_TOKEN_IDENTIFIER:
-	  if (is_c_identifier (scanner->next_value.v_identifier))
-	    {
-	      GtkRcProperty prop = { 0, 0, NULL, { 0, }, };
-	      gchar *name;
-
-	      g_scanner_get_next_token (scanner); /* eat type name */
-	      prop.type_name = g_quark_from_string (scanner->value.v_identifier);
-	      if (g_scanner_get_next_token (scanner) != ':' ||
-		  g_scanner_get_next_token (scanner) != ':')
-		{
-		  token = ':';
-		  break;
-		}
-	      if (g_scanner_get_next_token (scanner) != G_TOKEN_IDENTIFIER ||
-		  !is_c_identifier (scanner->value.v_identifier))
-		{
-		  token = G_TOKEN_IDENTIFIER;
-		  break;
-		}
-
-	      /* it's important that we do the same canonification as GParamSpecPool here */
-	      name = g_strdup (scanner->value.v_identifier);
-	      g_strcanon (name, G_CSET_DIGITS "-" G_CSET_a_2_z G_CSET_A_2_Z, '-');
-	      prop.property_name = g_quark_from_string (name);
-	      g_free (name);
-
-	      token = gtk_rc_parse_assignment (scanner, rc_style, &prop);
-	      if (token == G_TOKEN_NONE)
-		{
-		  g_return_val_if_fail (G_VALUE_TYPE (&prop.value) != 0, G_TOKEN_ERROR);
-		  insert_rc_property (rc_style, &prop, TRUE);
-		}
-	      
-	      g_free (prop.origin);
-	      if (G_VALUE_TYPE (&prop.value))
-		g_value_unset (&prop.value);
-	    }
-	  else
-	    {
-	      g_scanner_get_next_token (scanner);
-	      token = G_TOKEN_IDENTIFIER;
-	    }
-	  break;
-	default:
-	  g_scanner_get_next_token (scanner);
-	  token = G_TOKEN_RIGHT_CURLY;
-	  break;
-	}
-
+      token = gtk_rc_parse_style_statement (context, scanner, &rc_style);
       if (token != G_TOKEN_NONE)
 	goto err;
 
+      rc_segment_end_statement (&segment, scanner, RC_OP_STYLE_TEXT);
+
       token = g_scanner_peek_next_token (scanner);
     } /* while (token != G_TOKEN_RIGHT_CURLY) */
+
+  rc_segment_end (&segment, scanner, RC_OP_STYLE_TEXT);
   
   token = g_scanner_get_next_token (scanner);
   if (token != G_TOKEN_RIGHT_CURLY)
@@ -3242,8 +3937,114 @@ gtk_rc_parse_style (GtkRcContext *context,
       token = G_TOKEN_RIGHT_CURLY;
       goto err;
     }
+
+  rc_compiler_add_op (scanner, RC_OP_STYLE_END);
+  gtk_rc_style_end (context, rc_style, orig_style, TRUE);
+  
+  return G_TOKEN_NONE;
+
+ err:
+  gtk_rc_style_end (context, rc_style, orig_style, FALSE);
   
-  if (rc_style != orig_style)
+  return token;
+}
+
+/* Finds or creates the style @name to parse it again, as a copy of
+ * @parent_name if given.
+ */
+static GtkRcStyle *
+gtk_rc_style_begin (GtkRcContext *context,
+		    const gchar  *name,
+		    const gchar  *parent_name,
+		    GtkRcStyle  **orig_style)
+{
+  GtkRcStyle *rc_style;
+  GtkRcStyle *parent_style = NULL;
+  gint i;
+
+  rc_style = gtk_rc_style_find (context, name);
+  if (rc_style)
+    *orig_style = g_object_ref (rc_style);
+  else
+    *orig_style = NULL;
+
+  if (!rc_style)
+    {
+      rc_style = gtk_rc_style_new ();
+      rc_style->name = g_strdup (name);
+      
+      for (i = 0; i < 5; i++)
+	rc_style->bg_pixmap_name[i] = NULL;
+
+      for (i = 0; i < 5; i++)
+	rc_style->color_flags[i] = 0;
+    }
+
+  if (parent_name)
+    parent_style = gtk_rc_style_find (context, parent_name);
+
+  if (parent_style)
+    {
+      for (i = 0; i < 5; i++)
+	{
+	  rc_style->color_flags[i] = parent_style->color_flags[i];
+	  rc_style->fg[i] = parent_style->fg[i];
+	  rc_style->bg[i] = parent_style->bg[i];
+	  rc_style->text[i] = parent_style->text[i];
+	  rc_style->base[i] = parent_style->base[i];
+	}
+
+      rc_style->xthickness = parent_style->xthickness;
+      rc_style->ythickness = parent_style->ythickness;
+      
+      if (parent_style->font_desc)
+	{
+	  if (rc_style->font_desc)
+	    pango_font_description_free (rc_style->font_desc);
+	  rc_style->font_desc = pango_font_description_copy (parent_style->font_desc);
+	}
+
+      if (parent_style->rc_properties)
+	{
+	  guint i;
+
+	  for (i = 0; i < parent_style->rc_properties->len; i++)
+	    insert_rc_property (rc_style,
+				&g_array_index (parent_style->rc_properties, GtkRcProperty, i),
+				TRUE);
+	}
+      
+      for (i = 0; i < 5; i++)
+	{
+	  g_free (rc_style->bg_pixmap_name[i]);
+	  rc_style->bg_pixmap_name[i] = g_strdup (parent_style->bg_pixmap_name[i]);
+	}
+    }
+
+  /*  get icon_factories and color_hashes from the parent style;
+   *  if the parent_style doesn't have color_hashes, initializes
+   *  the color_hashes with the settings' color scheme (if it exists)
+   */
+  gtk_rc_style_copy_icons_and_colors (rc_style, parent_style, context);
+
+  return rc_style;
+}
+
+/* Makes the style parsed after gtk_rc_style_begin() known by its
+ * name, or drops it if parsing it failed.
+ */
+static void
+gtk_rc_style_end (GtkRcContext *context,
+		  GtkRcStyle   *rc_style,
+		  GtkRcStyle   *orig_style,
+		  gboolean      success)
+{
+  if (!success)
+    {
+      if (rc_style != orig_style)
+	g_object_unref (rc_style);
+    }
+  else if (rc_style != orig_style)
     {
       if (!context->rc_style_ht)
 	context->rc_style_ht = g_hash_table_new ((GHashFunc) gtk_rc_style_hash,
@@ -3260,17 +4061,98 @@ gtk_rc_parse_style (GtkRcContext *context,
 
   if (orig_style)
     g_object_unref (orig_style);
-  
-  return G_TOKEN_NONE;
+}
 
- err:
-  if (rc_style != orig_style)
-    g_object_unref (rc_style);
+static guint
+gtk_rc_parse_style_statement (GtkRcContext *context,
+			      GScanner     *scanner,
+			      GtkRcStyle  **rc_style)
+{
+  GtkRcStylePrivate *rc_priv = GTK_RC_STYLE_GET_PRIVATE (*rc_style);
+  guint token;
 
-  if (orig_style)
-    g_object_unref (orig_style);
-  
-  return token;
+  token = g_scanner_peek_next_token (scanner);
+  switch (token)
+    {
+    case GTK_RC_TOKEN_BG:
+      return gtk_rc_parse_bg (scanner, *rc_style);
+    case GTK_RC_TOKEN_FG:
+      return gtk_rc_parse_fg (scanner, *rc_style);
+    case GTK_RC_TOKEN_TEXT:
+      return gtk_rc_parse_text (scanner, *rc_style);
+    case GTK_RC_TOKEN_BASE:
+      return gtk_rc_parse_base (scanner, *rc_style);
+    case GTK_RC_TOKEN_XTHICKNESS:
+      return gtk_rc_parse_xthickness (scanner, *rc_style);
+    case GTK_RC_TOKEN_YTHICKNESS:
+      return gtk_rc_parse_ythickness (scanner, *rc_style);
+    case GTK_RC_TOKEN_BG_PIXMAP:
+      return gtk_rc_parse_bg_pixmap (context, scanner, *rc_style);
+    case GTK_RC_TOKEN_FONT:
+      return gtk_rc_parse_font (scanner, *rc_style);
+    case GTK_RC_TOKEN_FONTSET:
+      return gtk_rc_parse_fontset (scanner, *rc_style);
+    case GTK_RC_TOKEN_FONT_NAME:
+      return gtk_rc_parse_font_name (scanner, *rc_style);
+    case GTK_RC_TOKEN_ENGINE:
+      return gtk_rc_parse_engine (context, scanner, rc_style);
+    case GTK_RC_TOKEN_STOCK:
+      /* If there's a list, its first member is always the factory
+       * belonging to this RcStyle; the same goes for color hashes.
+       */
+      if ((*rc_style)->icon_factories == NULL)
+        gtk_rc_style_prepend_empty_icon_factory (*rc_style);
+      return gtk_rc_parse_stock (context, scanner, *rc_style,
+                                 (*rc_style)->icon_factories->data);
+    case GTK_RC_TOKEN_COLOR:
+      if (rc_priv->color_hashes == NULL)
+        gtk_rc_style_prepend_empty_color_hash (*rc_style);
+      return gtk_rc_parse_logical_color (scanner, *rc_style,
+                                         rc_priv->color_hashes->data);
+    case G_TOKEN_IDENTIFIER:
+      if (is_c_identifier (scanner->next_value.v_identifier))
+	{
+	  GtkRcProperty prop = { 0, 0, NULL, { 0, }, };
+	  gchar *name;
+
+	  g_scanner_get_next_token (scanner); /* eat type name */
+	  prop.type_name = g_quark_from_string (scanner->value.v_identifier);
+	  if (g_scanner_get_next_token (scanner) != ':' ||
+	      g_scanner_get_next_token (scanner) != ':')
+	    return ':';
+	  if (g_scanner_get_next_token (scanner) != G_TOKEN_IDENTIFIER ||
+	      !is_c_identifier (scanner->value.v_identifier))
+	    return G_TOKEN_IDENTIFIER;
+
+	  /* it's important that we do the same canonification as GParamSpecPool here */
+	  name = g_strdup (scanner->value.v_identifier);
+	  g_strcanon (name, G_CSET_DIGITS "-" G_CSET_a_2_z G_CSET_A_2_Z, '-');
+	  prop.property_name = g_quark_from_string (name);
+	  g_free (name);
+
+	  token = gtk_rc_parse_assignment (scanner, *rc_style, &prop);
+	  if (token == G_TOKEN_NONE)
+	    {
+	      g_return_val_if_fail (G_VALUE_TYPE (&prop.value) != 0, G_TOKEN_ERROR);
+	      insert_rc_property (*rc_style, &prop, TRUE);
+	      rc_compiler_add_property (scanner, &prop);
+	    }
+	  
+	  g_free (prop.origin);
+	  if (G_VALUE_TYPE (&prop.value))
+	    g_value_unset (&prop.value);
+
+	  return token;
+	}
+      else
+	{
+	  g_scanner_get_next_token (scanner);
+	  return G_TOKEN_IDENTIFIER;
+	}
+    default:
+      g_scanner_get_next_token (scanner);
+      return G_TOKEN_RIGHT_CURLY;
+    }
 }
 
 const GtkRcProperty*
@@ -3317,7 +4199,11 @@ gtk_rc_parse_bg (GScanner   *scanner,
     return G_TOKEN_EQUAL_SIGN;
 
   style->color_flags[state] |= GTK_RC_BG;
-  return gtk_rc_parse_color_full (scanner, style, &style->bg[state]);
+  token = gtk_rc_parse_color_full (scanner, style, &style->bg[state]);
+  if (token == G_TOKEN_NONE)
+    rc_compiler_add_color (scanner, GTK_RC_BG, state, &style->bg[state]);
+
+  return token;
 }
 
 static guint
@@ -3340,7 +4226,11 @@ gtk_rc_parse_fg (GScanner   *scanner,
     return G_TOKEN_EQUAL_SIGN;
   
   style->color_flags[state] |= GTK_RC_FG;
-  return gtk_rc_parse_color_full (scanner, style, &style->fg[state]);
+  token = gtk_rc_parse_color_full (scanner, style, &style->fg[state]);
+  if (token == G_TOKEN_NONE)
+    rc_compiler_add_color (scanner, GTK_RC_FG, state, &style->fg[state]);
+
+  return token;
 }
 
 static guint
@@ -3363,7 +4253,11 @@ gtk_rc_parse_text (GScanner   *scanner,
     return G_TOKEN_EQUAL_SIGN;
   
   style->color_flags[state] |= GTK_RC_TEXT;
-  return gtk_rc_parse_color_full (scanner, style, &style->text[state]);
+  token = gtk_rc_parse_color_full (scanner, style, &style->text[state]);
+  if (token == G_TOKEN_NONE)
+    rc_compiler_add_color (scanner, GTK_RC_TEXT, state, &style->text[state]);
+
+  return token;
 }
 
 static guint
@@ -3386,7 +4280,11 @@ gtk_rc_parse_base (GScanner   *scanner,
     return G_TOKEN_EQUAL_SIGN;
 
   style->color_flags[state] |= GTK_RC_BASE;
-  return gtk_rc_parse_color_full (scanner, style, &style->base[state]);
+  token = gtk_rc_parse_color_full (scanner, style, &style->base[state]);
+  if (token == G_TOKEN_NONE)
+    rc_compiler_add_color (scanner, GTK_RC_BASE, state, &style->base[state]);
+
+  return token;
 }
 
 static guint
@@ -3403,6 +4301,7 @@ gtk_rc_parse_xthickness (GScanner   *scanner,
     return G_TOKEN_INT;
 
   style->xthickness = scanner->value.v_int;
+  rc_compiler_add_uint32 (scanner, RC_OP_STYLE_XTHICKNESS, style->xthickness);
 
   return G_TOKEN_NONE;
 }
@@ -3421,6 +4320,7 @@ gtk_rc_parse_ythickness (GScanner   *scanner,
     return G_TOKEN_INT;
 
   style->ythickness = scanner->value.v_int;
+  rc_compiler_add_uint32 (scanner, RC_OP_STYLE_YTHICKNESS, style->ythickness);
 
   return G_TOKEN_NONE;
 }
@@ -3621,6 +4521,7 @@ gtk_rc_parse_font_name (GScanner   *scanner,
 
   rc_style->font_desc = 
     pango_font_description_from_string (scanner->value.v_string);
+  rc_compiler_add_string (scanner, RC_OP_STYLE_FONT_NAME, scanner->value.v_string);
   
   return G_TOKEN_NONE;
 }
@@ -4176,6 +5077,7 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
   GtkPathType path_type;
   gchar *pattern;
   gboolean is_binding;
+  gboolean explicit_priority = FALSE;
   GtkPathPriorityType priority = context->default_priority;
   
   token = g_scanner_get_next_token (scanner);
@@ -4219,6 +5121,7 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
 	  g_free (pattern);
 	  return token;
 	}
+      explicit_priority = TRUE;
     }
   
   token = g_scanner_get_next_token (scanner);
@@ -4243,7 +5146,6 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
   else
     {
       GtkRcStyle *rc_style;
-      GtkRcSet *rc_set;
 
       rc_style = gtk_rc_style_find (context, scanner->value.v_string);
       
@@ -4253,35 +5155,50 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
 	  return G_TOKEN_STRING;
 	}
 
-      rc_set = g_new (GtkRcSet, 1);
-      rc_set->type = path_type;
-      
-      if (path_type == GTK_PATH_WIDGET_CLASS)
-        {
-          rc_set->pspec = NULL;
-          rc_set->path = _gtk_rc_parse_widget_class_path (pattern);
-        }
-      else
-        {
-          rc_set->pspec = g_pattern_spec_new (pattern);
-          rc_set->path = NULL;
-        }
-      
-      rc_set->rc_style = rc_style;
-      rc_set->priority = priority;
-
-      if (path_type == GTK_PATH_WIDGET)
-	context->rc_sets_widget = g_slist_prepend (context->rc_sets_widget, rc_set);
-      else if (path_type == GTK_PATH_WIDGET_CLASS)
-	context->rc_sets_widget_class = g_slist_prepend (context->rc_sets_widget_class, rc_set);
-      else
-	context->rc_sets_class = g_slist_prepend (context->rc_sets_class, rc_set);
+      gtk_rc_add_rc_set (context, path_type, pattern, rc_style, priority);
+      rc_compiler_add_rc_set (scanner, path_type,
+			      explicit_priority ? priority : G_MAXUINT32,
+			      pattern, scanner->value.v_string);
     }
 
   g_free (pattern);
   return G_TOKEN_NONE;
 }
 
+static void
+gtk_rc_add_rc_set (GtkRcContext        *context,
+		   GtkPathType          path_type,
+		   const gchar         *pattern,
+		   GtkRcStyle          *rc_style,
+		   GtkPathPriorityType  priority)
+{
+  GtkRcSet *rc_set;
+
+  rc_set = g_new (GtkRcSet, 1);
+  rc_set->type = path_type;
+  
+  if (path_type == GTK_PATH_WIDGET_CLASS)
+    {
+      rc_set->pspec = NULL;
+      rc_set->path = _gtk_rc_parse_widget_class_path (pattern);
+    }
+  else
+    {
+      rc_set->pspec = g_pattern_spec_new (pattern);
+      rc_set->path = NULL;
+    }
+  
+  rc_set->rc_style = rc_style;
+  rc_set->priority = priority;
+
+  if (path_type == GTK_PATH_WIDGET)
+    context->rc_sets_widget = g_slist_prepend (context->rc_sets_widget, rc_set);
+  else if (path_type == GTK_PATH_WIDGET_CLASS)
+    context->rc_sets_widget_class = g_slist_prepend (context->rc_sets_widget_class, rc_set);
+  else
+    context->rc_sets_class = g_slist_prepend (context->rc_sets_class, rc_set);
+}
+
 static guint
 gtk_rc_parse_hash_key (GScanner  *scanner,
                        gchar    **hash_key)
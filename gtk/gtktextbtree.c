@@ -592,11 +592,11 @@ gtk_text_btree_resolve_bidi (GtkTextIter *start,
       
       while (seg)
         {
-          if (seg->type == &gtk_text_char_type && seg->byte_count > 0)
+          if (_GTK_TEXT_SEGMENT_IS_CHARS (seg) && seg->byte_count > 0)
             {
 	      PangoDirection pango_dir;
 
-              pango_dir = pango_find_base_dir (seg->body.chars,
+              pango_dir = pango_find_base_dir (_GTK_TEXT_SEGMENT_CHARS (seg),
 					       seg->byte_count);
 	      
               if (pango_dir != PANGO_DIRECTION_NEUTRAL)
@@ -1086,10 +1086,11 @@ _gtk_text_btree_delete (GtkTextIter *start,
   gtk_text_btree_resolve_bidi (start, end);
 }
 
-void
-_gtk_text_btree_insert (GtkTextIter *iter,
-                        const gchar *text,
-                        gint         len)
+static void
+btree_insert_text (GtkTextIter *iter,
+                   const gchar *text,
+                   gint         len,
+                   GMappedFile *mapped)
 {
   GtkTextLineSegment *prev_seg;     /* The segment just before the first
                                      * new segment (NULL means new segment
@@ -1174,7 +1175,10 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       chunk_len = eol - sol;
 
       g_assert (g_utf8_validate (&text[sol], chunk_len, NULL));
-      seg = _gtk_char_segment_new (&text[sol], chunk_len);
+      if (mapped)
+        seg = _gtk_mapped_char_segment_new (mapped, &text[sol], chunk_len);
+      else
+        seg = _gtk_char_segment_new (&text[sol], chunk_len);
 
       char_count_delta += seg->char_count;
 
@@ -1254,6 +1258,29 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   }
 }
 
+void
+_gtk_text_btree_insert (GtkTextIter *iter,
+                        const gchar *text,
+                        gint         len)
+{
+  btree_insert_text (iter, text, len, NULL);
+}
+
+/* Like _gtk_text_btree_insert(), but the new character segments
+ * reference @text inside @file instead of copying it. @text must
+ * be valid UTF-8 and stay mapped for as long as @file is alive.
+ */
+void
+_gtk_text_btree_insert_mapped (GtkTextIter *iter,
+                               GMappedFile *file,
+                               const gchar *text,
+                               gint         len)
+{
+  g_return_if_fail (file != NULL);
+
+  btree_insert_text (iter, text, len, file);
+}
+
 static void
 insert_pixbuf_or_widget_segment (GtkTextIter        *iter,
                                  GtkTextLineSegment *seg)
@@ -2331,7 +2358,7 @@ copy_segment (GString *string,
   seg = _gtk_text_iter_get_indexable_segment (start);
   end_seg = _gtk_text_iter_get_indexable_segment (end);
 
-  if (seg->type == &gtk_text_char_type)
+  if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
     {
       gboolean copy = TRUE;
       gint copy_bytes = 0;
@@ -2366,7 +2393,7 @@ copy_segment (GString *string,
           g_assert ((copy_start + copy_bytes) <= seg->byte_count);
 
           g_string_append_len (string,
-                               seg->body.chars + copy_start,
+                               _GTK_TEXT_SEGMENT_CHARS (seg) + copy_start,
                                copy_bytes);
         }
 
@@ -3946,8 +3973,8 @@ _gtk_text_line_byte_to_char (GtkTextLine *line,
     return char_offset + byte_offset;
   else
     {
-      if (seg->type == &gtk_text_char_type)
-        return char_offset + g_utf8_strlen (seg->body.chars, byte_offset);
+      if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
+        return char_offset + g_utf8_strlen (_GTK_TEXT_SEGMENT_CHARS (seg), byte_offset);
       else
         {
           g_assert (seg->char_count == 1);
@@ -4152,9 +4179,9 @@ _gtk_text_line_byte_to_char_offsets (GtkTextLine *line,
    * want to go. Count chars into the current segment.
    */
 
-  if (seg->type == &gtk_text_char_type)
+  if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
     {
-      *seg_char_offset = g_utf8_strlen (seg->body.chars, offset);
+      *seg_char_offset = g_utf8_strlen (_GTK_TEXT_SEGMENT_CHARS (seg), offset);
 
       g_assert (*seg_char_offset < seg->char_count);
 
@@ -4197,18 +4224,18 @@ _gtk_text_line_char_to_byte_offsets (GtkTextLine *line,
   /* offset is now the number of chars into the current segment we
      want to go. Count bytes into the current segment. */
 
-  if (seg->type == &gtk_text_char_type)
+  if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
     {
       const char *p;
 
       /* if in the last fourth of the segment walk backwards */
       if (seg->char_count - offset < seg->char_count / 4)
-        p = g_utf8_offset_to_pointer (seg->body.chars + seg->byte_count, 
+        p = g_utf8_offset_to_pointer (_GTK_TEXT_SEGMENT_CHARS (seg) + seg->byte_count, 
                                       offset - seg->char_count);
       else
-        p = g_utf8_offset_to_pointer (seg->body.chars, offset);
+        p = g_utf8_offset_to_pointer (_GTK_TEXT_SEGMENT_CHARS (seg), offset);
 
-      *seg_byte_offset = p - seg->body.chars;
+      *seg_byte_offset = p - _GTK_TEXT_SEGMENT_CHARS (seg);
 
       g_assert (*seg_byte_offset < seg->byte_count);
 
@@ -5429,6 +5456,66 @@ _gtk_text_btree_validate_line (GtkTextBTree     *tree,
     }
 }
 
+/**
+ * _gtk_text_btree_estimate_lines:
+ * @tree: a #GtkTextBTree
+ * @start_line: first line of the range
+ * @end_line: last line of the range
+ * @view_id: view ID for the view
+ * @height: estimated height of a line
+ *
+ * Gives the lines in the range that were never wrapped for the view
+ * invalid line data claiming @height pixels, so that the y coordinates
+ * and total height of the tree approximate the real ones until these
+ * lines get validated.
+ **/
+void
+_gtk_text_btree_estimate_lines (GtkTextBTree     *tree,
+                                GtkTextLine      *start_line,
+                                GtkTextLine      *end_line,
+                                gpointer          view_id,
+                                gint              height)
+{
+  GtkTextBTreeNode *parent = NULL;
+  GtkTextLine *line;
+  BTreeView *view;
+
+  g_return_if_fail (tree != NULL);
+  g_return_if_fail (start_line != NULL);
+
+  view = gtk_text_btree_get_view (tree, view_id);
+  g_return_if_fail (view != NULL);
+
+  line = start_line;
+  while (line != NULL)
+    {
+      if (_gtk_text_line_get_data (line, view_id) == NULL)
+        {
+          GtkTextLineData *ld;
+
+          ld = _gtk_text_line_data_new (view->layout, line);
+          ld->height = height;
+          _gtk_text_line_add_data (line, ld);
+
+          /* Recompute the aggregates once per leaf node */
+          if (line->parent != parent)
+            {
+              if (parent)
+                gtk_text_btree_node_check_valid_upward (parent, view_id);
+              parent = line->parent;
+            }
+        }
+
+      if (line == end_line)
+        break;
+
+      line = _gtk_text_line_next_excluding_last (line);
+    }
+
+  if (parent)
+    gtk_text_btree_node_check_valid_upward (parent, view_id);
+}
+
 static void
 gtk_text_btree_node_remove_view (BTreeView *view, GtkTextBTreeNode *node, gpointer view_id)
 {
@@ -6759,7 +6846,7 @@ gtk_text_btree_node_check_consistency (GtkTextBTree     *tree,
                   g_error ("gtk_text_btree_node_check_consistency: wrong segment order for gravity");
                 }
               if ((segPtr->next == NULL)
-                  && (segPtr->type != &gtk_text_char_type))
+                  && (!_GTK_TEXT_SEGMENT_IS_CHARS (segPtr)))
                 {
                   g_error ("gtk_text_btree_node_check_consistency: line ended with wrong type");
                 }
@@ -7151,9 +7238,9 @@ _gtk_text_btree_spew_line_short (GtkTextLine *line, int indent)
   seg = line->segments;
   while (seg != NULL)
     {
-      if (seg->type == &gtk_text_char_type)
+      if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
         {
-          gchar* str = g_strndup (seg->body.chars, MIN (seg->byte_count, 10));
+          gchar* str = g_strndup (_GTK_TEXT_SEGMENT_CHARS (seg), MIN (seg->byte_count, 10));
           gchar* s;
           s = str;
           while (*s)
@@ -7261,9 +7348,9 @@ _gtk_text_btree_spew_segment (GtkTextBTree* tree, GtkTextLineSegment * seg)
   printf ("     segment: %p type: %s bytes: %d chars: %d\n",
           seg, seg->type->name, seg->byte_count, seg->char_count);
 
-  if (seg->type == &gtk_text_char_type)
+  if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
     {
-      gchar* str = g_strndup (seg->body.chars, seg->byte_count);
+      gchar* str = g_strndup (_GTK_TEXT_SEGMENT_CHARS (seg), seg->byte_count);
       printf ("       `%s'\n", str);
       g_free (str);
     }
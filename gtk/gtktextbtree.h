@@ -70,6 +70,10 @@ void _gtk_text_btree_delete        (GtkTextIter *start,
 void _gtk_text_btree_insert        (GtkTextIter *iter,
                                     const gchar *text,
                                     gint         len);
+void _gtk_text_btree_insert_mapped (GtkTextIter *iter,
+                                    GMappedFile *file,
+                                    const gchar *text,
+                                    gint         len);
 void _gtk_text_btree_insert_pixbuf (GtkTextIter *iter,
                                     GdkPixbuf   *pixbuf);
 
@@ -109,6 +113,11 @@ gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
 void         _gtk_text_btree_validate_line     (GtkTextBTree      *tree,
                                                 GtkTextLine       *line,
                                                 gpointer           view_id);
+void         _gtk_text_btree_estimate_lines    (GtkTextBTree      *tree,
+                                                GtkTextLine       *start_line,
+                                                GtkTextLine       *end_line,
+                                                gpointer           view_id,
+                                                gint               height);
 
 /* Tag */
 
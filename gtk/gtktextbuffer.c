@@ -56,8 +56,20 @@ struct _GtkTextBufferPrivate
   GtkTargetList  *paste_target_list;
   GtkTargetEntry *paste_target_entries;
   gint            n_paste_target_entries;
+
+  /* Read-only file whose contents are being loaded, see
+   * gtk_text_buffer_set_mapped_file()
+   */
+  GMappedFile    *mapped_file;
+  gsize           mapped_offset;
+  guint           mapped_scan_id;
+  /* Where the rest of the file goes, left gravity */
+  GtkTextMark    *mapped_end;
 };
 
+/* Bytes of a mapped file appended to the buffer per idle iteration */
+#define MAPPED_SCAN_CHUNK (256 * 1024)
+
 
 typedef struct _ClipboardRequest ClipboardRequest;
 
@@ -138,6 +150,9 @@ static void update_selection_clipboards           (GtkTextBuffer *buffer);
 static GtkTextBuffer *create_clipboard_contents_buffer (GtkTextBuffer *buffer);
 
 static void gtk_text_buffer_free_target_lists     (GtkTextBuffer *buffer);
+static void gtk_text_buffer_stop_mapped_scan      (GtkTextBuffer *buffer);
+static void gtk_text_buffer_check_mapped_scan     (GtkTextBuffer     *buffer,
+                                                   const GtkTextIter *iter);
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
@@ -780,6 +795,10 @@ gtk_text_buffer_finalize (GObject *object)
 
   gtk_text_buffer_free_target_lists (buffer);
 
+  /* The mark went away with the btree */
+  GTK_TEXT_BUFFER_GET_PRIVATE (buffer)->mapped_end = NULL;
+  gtk_text_buffer_stop_mapped_scan (buffer);
+
   G_OBJECT_CLASS (gtk_text_buffer_parent_class)->finalize (object);
 }
 
@@ -837,6 +856,8 @@ gtk_text_buffer_set_text (GtkTextBuffer *buffer,
   if (len < 0)
     len = strlen (text);
 
+  gtk_text_buffer_stop_mapped_scan (buffer);
+
   gtk_text_buffer_get_bounds (buffer, &start, &end);
 
   gtk_text_buffer_delete (buffer, &start, &end);
@@ -852,6 +873,230 @@ gtk_text_buffer_set_text (GtkTextBuffer *buffer,
 
  
 
+static void
+gtk_text_buffer_stop_mapped_scan (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  if (priv->mapped_scan_id != 0)
+    {
+      g_source_remove (priv->mapped_scan_id);
+      priv->mapped_scan_id = 0;
+    }
+
+  if (priv->mapped_end)
+    {
+      gtk_text_buffer_delete_mark (buffer, priv->mapped_end);
+      priv->mapped_end = NULL;
+    }
+
+  if (priv->mapped_file)
+    {
+      g_mapped_file_unref (priv->mapped_file);
+      priv->mapped_file = NULL;
+    }
+
+  priv->mapped_offset = 0;
+}
+
+/* Edits to the part of a mapped file that has been loaded already
+ * stop loading the rest, since it would no longer follow what is
+ * before it. Text added after that part stays after it.
+ */
+static void
+gtk_text_buffer_check_mapped_scan (GtkTextBuffer     *buffer,
+                                   const GtkTextIter *iter)
+{
+  GtkTextBufferPrivate *priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+  GtkTextIter loaded_end;
+
+  if (priv->mapped_scan_id == 0)
+    return;
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &loaded_end, priv->mapped_end);
+  if (gtk_text_iter_compare (iter, &loaded_end) < 0)
+    gtk_text_buffer_stop_mapped_scan (buffer);
+}
+
+/* Adds the next slice of the mapped file after the loaded part.
+ * Slices end after a newline where possible, so line boundaries are
+ * discovered incrementally; valid UTF-8 goes into segments referencing
+ * the mapping, invalid bytes are replaced by U+FFFD.
+ */
+static gboolean
+mapped_scan_step (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+  const gchar *contents;
+  const gchar *p, *stop, *newline;
+  gsize length;
+  GtkTextIter end;
+
+  contents = g_mapped_file_get_contents (priv->mapped_file);
+  length = g_mapped_file_get_length (priv->mapped_file);
+
+  p = contents + priv->mapped_offset;
+
+  if (length - priv->mapped_offset <= 2 * MAPPED_SCAN_CHUNK)
+    stop = contents + length;
+  else
+    {
+      newline = memchr (p + MAPPED_SCAN_CHUNK, '\n', MAPPED_SCAN_CHUNK);
+      if (newline)
+        stop = newline + 1;
+      else
+        {
+          /* A very long line; cut it at a character boundary that
+           * doesn't separate a \r\n pair.
+           */
+          stop = p + 2 * MAPPED_SCAN_CHUNK;
+          while (stop > p && (*stop & 0xc0) == 0x80)
+            stop--;
+          if (stop > p && stop[-1] == '\r')
+            stop--;
+          if (stop == p)
+            stop = p + 2 * MAPPED_SCAN_CHUNK;
+        }
+    }
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &end, priv->mapped_end);
+
+  while (p < stop)
+    {
+      const gchar *valid_end;
+
+      g_utf8_validate (p, stop - p, &valid_end);
+
+      if (valid_end > p)
+        _gtk_text_btree_insert_mapped (&end, priv->mapped_file,
+                                       p, valid_end - p);
+
+      if (valid_end < stop)
+        {
+          _gtk_text_btree_insert (&end, "\357\277\275", 3);
+          valid_end++;
+        }
+
+      p = valid_end;
+    }
+
+  priv->mapped_offset = stop - contents;
+  gtk_text_buffer_move_mark (buffer, priv->mapped_end, &end);
+
+  g_signal_emit (buffer, signals[CHANGED], 0);
+
+  return priv->mapped_offset < length;
+}
+
+static gboolean
+mapped_scan_idle (gpointer data)
+{
+  GtkTextBuffer *buffer = data;
+  GtkTextBufferPrivate *priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  if (mapped_scan_step (buffer))
+    return TRUE;
+
+  priv->mapped_scan_id = 0;
+  gtk_text_buffer_stop_mapped_scan (buffer);
+
+  return FALSE;
+}
+
+/**
+ * gtk_text_buffer_set_mapped_file:
+ * @buffer: a #GtkTextBuffer
+ * @file: a #GMappedFile containing UTF-8 text
+ *
+ * Deletes current contents of @buffer, and replaces them with the
+ * contents of @file. Unlike gtk_text_buffer_set_text(), the text is
+ * not copied; the buffer keeps a reference on @file and its text
+ * segments point into the mapping, so very large read-only files can
+ * be displayed with little memory overhead.
+ *
+ * The beginning of the file is loaded right away, the rest is added
+ * to the buffer from an idle handler, which emits #GtkTextBuffer::changed
+ * as lines become available. Marks, tags and iterators work on the
+ * loaded text as usual. Bytes that are not valid UTF-8 are shown as
+ * U+FFFD.
+ *
+ * The #GtkTextBuffer::insert-text signal is not emitted for the
+ * contents of @file, so handlers of that signal, like undo managers,
+ * don't see them; they should start after loading is done, when
+ * gtk_text_buffer_get_mapped_file() returns %NULL.
+ *
+ * Editing the buffer is allowed; only the edited ranges stop
+ * referencing @file. Text inserted at the end of the buffer while
+ * loading stays after the contents of @file, but editing or deleting
+ * text that has been loaded already, or calling
+ * gtk_text_buffer_set_text(), stops loading.
+ *
+ * The contents of @file must not change while it is in use.
+ *
+ * Since: 2.24
+ **/
+void
+gtk_text_buffer_set_mapped_file (GtkTextBuffer *buffer,
+                                 GMappedFile   *file)
+{
+  GtkTextBufferPrivate *priv;
+  GtkTextIter start, end;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (file != NULL);
+
+  priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  g_mapped_file_ref (file);
+  gtk_text_buffer_stop_mapped_scan (buffer);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+
+  priv->mapped_file = file;
+  priv->mapped_offset = 0;
+  priv->mapped_end = gtk_text_buffer_create_mark (buffer, NULL, &start, TRUE);
+
+  if (g_mapped_file_get_length (file) > 0 &&
+      mapped_scan_step (buffer))
+    priv->mapped_scan_id =
+      gdk_threads_add_idle_full (G_PRIORITY_LOW, mapped_scan_idle,
+                                 buffer, NULL);
+  else
+    gtk_text_buffer_stop_mapped_scan (buffer);
+
+  g_object_notify (G_OBJECT (buffer), "text");
+}
+
+/**
+ * gtk_text_buffer_get_mapped_file:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Returns the file set with gtk_text_buffer_set_mapped_file() while
+ * its contents are still being loaded into @buffer.
+ *
+ * Note that the text loaded from the file keeps referencing it after
+ * loading is done or has been stopped, so the mapping may stay around
+ * longer than this function returns it.
+ *
+ * Return value: (transfer none): the #GMappedFile being loaded, or
+ *   %NULL once the whole file has been added to the buffer, or
+ *   loading was stopped
+ *
+ * Since: 2.24
+ **/
+GMappedFile *
+gtk_text_buffer_get_mapped_file (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+
+  priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  return priv->mapped_file;
+}
+
 /*
  * Insertion
  */
@@ -888,6 +1133,8 @@ gtk_text_buffer_emit_insert (GtkTextBuffer *buffer,
   
   if (len > 0)
     {
+      gtk_text_buffer_check_mapped_scan (buffer, iter);
+
       g_signal_emit (buffer, signals[INSERT_TEXT], 0,
                      iter, text, len);
     }
@@ -1610,6 +1857,8 @@ gtk_text_buffer_emit_delete (GtkTextBuffer *buffer,
 
   gtk_text_iter_order (start, end);
 
+  gtk_text_buffer_check_mapped_scan (buffer, start);
+
   g_signal_emit (buffer,
                  signals[DELETE_RANGE],
                  0,
@@ -1899,6 +2148,8 @@ gtk_text_buffer_insert_pixbuf (GtkTextBuffer *buffer,
   g_return_if_fail (iter != NULL);
   g_return_if_fail (GDK_IS_PIXBUF (pixbuf));
   g_return_if_fail (gtk_text_iter_get_buffer (iter) == buffer);
+
+  gtk_text_buffer_check_mapped_scan (buffer, iter);
   
   g_signal_emit (buffer, signals[INSERT_PIXBUF], 0,
                  iter, pixbuf);
@@ -1946,6 +2197,8 @@ gtk_text_buffer_insert_child_anchor (GtkTextBuffer      *buffer,
   g_return_if_fail (iter != NULL);
   g_return_if_fail (GTK_IS_TEXT_CHILD_ANCHOR (anchor));
   g_return_if_fail (gtk_text_iter_get_buffer (iter) == buffer);
+
+  gtk_text_buffer_check_mapped_scan (buffer, iter);
   
   g_signal_emit (buffer, signals[INSERT_CHILD_ANCHOR], 0,
                  iter, anchor);
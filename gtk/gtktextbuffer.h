@@ -171,6 +171,11 @@ void gtk_text_buffer_set_text          (GtkTextBuffer *buffer,
                                         const gchar   *text,
                                         gint           len);
 
+/* Delete whole buffer, then reference the contents of a mapped file */
+void         gtk_text_buffer_set_mapped_file (GtkTextBuffer *buffer,
+                                              GMappedFile   *file);
+GMappedFile *gtk_text_buffer_get_mapped_file (GtkTextBuffer *buffer);
+
 /* Insert into the buffer */
 void gtk_text_buffer_insert            (GtkTextBuffer *buffer,
                                         GtkTextIter   *iter,
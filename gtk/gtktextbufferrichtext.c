@@ -25,6 +25,7 @@
 
 #include "gtktextbufferrichtext.h"
 #include "gtktextbufferserialize.h"
+#include "gtkversion.h"
 #include "gtkintl.h"
 #include "gtkalias.h"
 
@@ -54,6 +55,19 @@ static void      free_format       (GtkRichTextFormat *format);
 static void      free_format_list  (GList             *formats);
 static GQuark    serialize_quark   (void);
 static GQuark    deserialize_quark (void);
+static gchar   * binary_mime_type  (const gchar       *tagset_name);
+static GdkAtom   binary_format_for (GList             *formats,
+                                    GdkAtom            atom,
+                                    gpointer           function);
+static gboolean  deserialize_binary_rich_text
+                                   (GtkTextBuffer     *register_buffer,
+                                    GtkTextBuffer     *content_buffer,
+                                    GtkTextIter       *iter,
+                                    const guint8      *data,
+                                    gsize              length,
+                                    gboolean           create_tags,
+                                    gpointer           user_data,
+                                    GError           **error);
 
 
 /**
@@ -124,6 +138,13 @@ gtk_text_buffer_register_serialize_format (GtkTextBuffer              *buffer,
  * identifier != %NULL here, since the %NULL tagset requires the
  * receiving buffer to deal with with pasting of arbitrary tags.
  *
+ * Since 2.24, a compact binary encoding of the same contents is
+ * registered alongside, using the mime type
+ * "application/x-gtk-text-buffer-binary-rich-text-2.24" (with the same
+ * optional ";format=@tagset_name" suffix). It carries the GTK+ version
+ * and is only exchanged between identical versions; receivers prefer
+ * it over the XML format when both are offered.
+ *
  * Return value: (transfer none): the #GdkAtom that corresponds to the
  *               newly registered format's mime-type.
  *
@@ -151,6 +172,12 @@ gtk_text_buffer_register_serialize_tagset (GtkTextBuffer *buffer,
   if (tagset_name)
     g_free (mime_type);
 
+  mime_type = binary_mime_type (tagset_name);
+  gtk_text_buffer_register_serialize_format (buffer, mime_type,
+                                             _gtk_text_buffer_serialize_binary_rich_text,
+                                             NULL, NULL);
+  g_free (mime_type);
+
   return format;
 }
 
@@ -208,6 +235,10 @@ gtk_text_buffer_register_deserialize_format (GtkTextBuffer                *buffe
  * format with the passed @buffer. See
  * gtk_text_buffer_register_serialize_tagset() for details.
  *
+ * The binary variant of the format is registered first, so that it is
+ * preferred when pasting. It honours the can-create-tags setting of the
+ * returned XML format.
+ *
  * Return value: (transfer none): the #GdkAtom that corresponds to the
  *               newly registered format's mime-type.
  *
@@ -218,6 +249,7 @@ gtk_text_buffer_register_deserialize_tagset (GtkTextBuffer *buffer,
                                              const gchar   *tagset_name)
 {
   gchar   *mime_type = "application/x-gtk-text-buffer-rich-text";
+  gchar   *binary_type;
   GdkAtom  format;
 
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), GDK_NONE);
@@ -228,6 +260,16 @@ gtk_text_buffer_register_deserialize_tagset (GtkTextBuffer *buffer,
       g_strdup_printf ("application/x-gtk-text-buffer-rich-text;format=%s",
                        tagset_name);
 
+  /* Registered first so gtk_clipboard_request_rich_text() asks for it
+   * before the XML format; it finds the XML format through @user_data.
+   */
+  binary_type = binary_mime_type (tagset_name);
+  gtk_text_buffer_register_deserialize_format (buffer, binary_type,
+                                               deserialize_binary_rich_text,
+                                               GDK_ATOM_TO_POINTER (gdk_atom_intern (mime_type, FALSE)),
+                                               NULL);
+  g_free (binary_type);
+
   format = gtk_text_buffer_register_deserialize_format (buffer, mime_type,
                                                         _gtk_text_buffer_deserialize_rich_text,
                                                         NULL, NULL);
@@ -247,19 +289,29 @@ gtk_text_buffer_register_deserialize_tagset (GtkTextBuffer *buffer,
  * registered using gtk_text_buffer_register_serialize_format() or
  * gtk_text_buffer_register_serialize_tagset()
  *
+ * Since 2.24, unregistering a format returned by
+ * gtk_text_buffer_register_serialize_tagset() also unregisters the
+ * binary format that was registered with it.
+ *
  * Since: 2.10
  **/
 void
 gtk_text_buffer_unregister_serialize_format (GtkTextBuffer *buffer,
                                              GdkAtom        format)
 {
-  GList *formats;
+  GList   *formats;
+  GdkAtom  binary_format;
 
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (format != GDK_NONE);
 
   formats = g_object_steal_qdata (G_OBJECT (buffer), serialize_quark ());
 
+  binary_format = binary_format_for (formats, format,
+                                     (gpointer) _gtk_text_buffer_serialize_rich_text);
+  if (binary_format != GDK_NONE)
+    formats = unregister_format (formats, binary_format);
+
   formats = unregister_format (formats, format);
 
   g_object_set_qdata_full (G_OBJECT (buffer), serialize_quark (),
@@ -277,19 +329,29 @@ gtk_text_buffer_unregister_serialize_format (GtkTextBuffer *buffer,
  * registered using gtk_text_buffer_register_deserialize_format() or
  * gtk_text_buffer_register_deserialize_tagset().
  *
+ * Since 2.24, unregistering a format returned by
+ * gtk_text_buffer_register_deserialize_tagset() also unregisters the
+ * binary format that was registered with it.
+ *
  * Since: 2.10
  **/
 void
 gtk_text_buffer_unregister_deserialize_format (GtkTextBuffer *buffer,
                                                GdkAtom        format)
 {
-  GList *formats;
+  GList   *formats;
+  GdkAtom  binary_format;
 
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (format != GDK_NONE);
 
   formats = g_object_steal_qdata (G_OBJECT (buffer), deserialize_quark ());
 
+  binary_format = binary_format_for (formats, format,
+                                     (gpointer) _gtk_text_buffer_deserialize_rich_text);
+  if (binary_format != GDK_NONE)
+    formats = unregister_format (formats, binary_format);
+
   formats = unregister_format (formats, format);
 
   g_object_set_qdata_full (G_OBJECT (buffer), deserialize_quark (),
@@ -717,6 +779,92 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
 
 /*  private functions  */
 
+static gchar *
+binary_mime_type (const gchar *tagset_name)
+{
+  if (tagset_name)
+    return g_strdup_printf ("application/x-gtk-text-buffer-binary-rich-text-%d.%d;format=%s",
+                            GTK_MAJOR_VERSION, GTK_MINOR_VERSION, tagset_name);
+
+  return g_strdup_printf ("application/x-gtk-text-buffer-binary-rich-text-%d.%d",
+                          GTK_MAJOR_VERSION, GTK_MINOR_VERSION);
+}
+
+/* Returns the binary format registered together with @atom, if @atom
+ * is a tagset format registered with the XML @function.
+ */
+static GdkAtom
+binary_format_for (GList    *formats,
+                   GdkAtom   atom,
+                   gpointer  function)
+{
+  static const gchar prefix[] = "application/x-gtk-text-buffer-rich-text";
+  GList *list;
+
+  for (list = formats; list; list = g_list_next (list))
+    {
+      GtkRichTextFormat *format = list->data;
+
+      if (format->atom == atom)
+        {
+          GdkAtom  binary_atom;
+          gchar   *mime_type;
+
+          if (format->function != function ||
+              !g_str_has_prefix (format->mime_type, prefix))
+            return GDK_NONE;
+
+          if (format->mime_type[strlen (prefix)] == '\0')
+            mime_type = binary_mime_type (NULL);
+          else if (g_str_has_prefix (format->mime_type + strlen (prefix), ";format="))
+            mime_type = binary_mime_type (format->mime_type + strlen (prefix) +
+                                          strlen (";format="));
+          else
+            return GDK_NONE;
+
+          binary_atom = gdk_atom_intern (mime_type, FALSE);
+          g_free (mime_type);
+
+          return binary_atom;
+        }
+    }
+
+  return GDK_NONE;
+}
+
+static gboolean
+deserialize_binary_rich_text (GtkTextBuffer  *register_buffer,
+                              GtkTextBuffer  *content_buffer,
+                              GtkTextIter    *iter,
+                              const guint8   *data,
+                              gsize           length,
+                              gboolean        create_tags,
+                              gpointer        user_data,
+                              GError        **error)
+{
+  GdkAtom xml_atom = GDK_POINTER_TO_ATOM (user_data);
+  GList *list;
+
+  for (list = g_object_get_qdata (G_OBJECT (register_buffer), deserialize_quark ());
+       list;
+       list = g_list_next (list))
+    {
+      GtkRichTextFormat *fmt = list->data;
+
+      if (fmt->atom == xml_atom)
+        {
+          create_tags |= fmt->can_create_tags;
+          break;
+        }
+    }
+
+  return _gtk_text_buffer_deserialize_binary_rich_text (register_buffer,
+                                                        content_buffer,
+                                                        iter, data, length,
+                                                        create_tags,
+                                                        NULL, error);
+}
+
 static GList *
 register_format (GList          *formats,
                  const gchar    *mime_type,
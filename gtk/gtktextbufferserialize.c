@@ -49,6 +49,9 @@ typedef struct
   GHashTable *tag_id_tags;
 } SerializationContext;
 
+/* Returns the unescaped string form of @value, shared by the XML and
+ * the binary format.
+ */
 static gchar *
 serialize_value (GValue *value)
 {
@@ -60,7 +63,7 @@ serialize_value (GValue *value)
       g_value_init (&text_value, G_TYPE_STRING);
       g_value_transform (value, &text_value);
 
-      tmp = g_markup_escape_text (g_value_get_string (&text_value), -1);
+      tmp = g_value_dup_string (&text_value);
       g_value_unset (&text_value);
 
       return tmp;
@@ -321,7 +324,9 @@ serialize_tag (gpointer key,
 	continue;
 
       /* Now serialize the attr */
-      tmp2 = serialize_value (&value);
+      tmp = serialize_value (&value);
+      tmp2 = tmp ? g_markup_escape_text (tmp, -1) : NULL;
+      g_free (tmp);
 
       if (tmp2)
 	{
@@ -584,12 +589,12 @@ serialize_text (GtkTextBuffer        *buffer,
 }
 
 static void
-serialize_pixbufs (SerializationContext *context,
-		   GString              *text)
+serialize_pixbufs (GList   *pixbufs,
+		   GString *text)
 {
   GList *list;
 
-  for (list = context->pixbufs; list != NULL; list = list->next)
+  for (list = pixbufs; list != NULL; list = list->next)
     {
       GdkPixbuf *pixbuf = list->data;
       GdkPixdata pixdata;
@@ -639,7 +644,7 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   g_string_append_len (text, context.text_str->str, context.text_str->len);
 
   context.pixbufs = g_list_reverse (context.pixbufs);
-  serialize_pixbufs (&context, text);
+  serialize_pixbufs (context.pixbufs, text);
 
   g_hash_table_destroy (context.tags);
   g_list_free (context.pixbufs);
@@ -652,6 +657,284 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   return (guint8 *) g_string_free (text, FALSE);
 }
 
+/*
+ * Binary format
+ *
+ * A GTKTEXTBUFFERBINCONTS-0001 section holds the same information as
+ * the XML in GTKTEXTBUFFERCONTENTS-0001, followed by the same pixbuf
+ * sections. All integers are unsigned LEB128 varints, strings are a
+ * varint byte length followed by the bytes:
+ *
+ *   version (1)
+ *   n_tags, then per tag:
+ *     flags (bit 0: named), name or anonymous id, priority,
+ *     n_attrs, then per attr: name, type name, value
+ *   n_runs, then per run:
+ *     kind (0: text, 1: pixbuf), n_tags, tag indices,
+ *     text or pixbuf index
+ */
+
+#define BINARY_FORMAT_VERSION 1
+
+enum {
+  BINARY_TAG_NAMED = 1 << 0
+};
+
+enum {
+  BINARY_RUN_TEXT,
+  BINARY_RUN_PIXBUF
+};
+
+typedef struct
+{
+  GString *runs_str;
+  GPtrArray *tags;
+  GHashTable *tag_indices;
+  gint n_runs;
+
+  gint n_pixbufs;
+  GList *pixbufs;
+} BinarySerializationContext;
+
+static void
+append_varint (GString *str,
+               guint    value)
+{
+  while (value >= 0x80)
+    {
+      g_string_append_c (str, (value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+
+  g_string_append_c (str, value);
+}
+
+static void
+append_binary_string (GString     *str,
+                      const gchar *text,
+                      gsize        len)
+{
+  append_varint (str, len);
+  g_string_append_len (str, text, len);
+}
+
+static guint
+binary_tag_index (BinarySerializationContext *context,
+                  GtkTextTag                 *tag)
+{
+  gpointer index;
+
+  if (!g_hash_table_lookup_extended (context->tag_indices, tag, NULL, &index))
+    {
+      index = GUINT_TO_POINTER (context->tags->len);
+      g_hash_table_insert (context->tag_indices, tag, index);
+      g_ptr_array_add (context->tags, tag);
+    }
+
+  return GPOINTER_TO_UINT (index);
+}
+
+static void
+append_binary_run_start (BinarySerializationContext *context,
+                         guint                       kind,
+                         const GtkTextIter          *iter)
+{
+  GSList *tags, *l;
+
+  tags = gtk_text_iter_get_tags (iter);
+
+  append_varint (context->runs_str, kind);
+  append_varint (context->runs_str, g_slist_length (tags));
+
+  for (l = tags; l; l = l->next)
+    append_varint (context->runs_str, binary_tag_index (context, l->data));
+
+  g_slist_free (tags);
+
+  context->n_runs++;
+}
+
+static void
+serialize_binary_text (BinarySerializationContext *context,
+                       const GtkTextIter          *start,
+                       const GtkTextIter          *end)
+{
+  GtkTextIter iter, next;
+
+  iter = *start;
+
+  while (gtk_text_iter_compare (&iter, end) < 0)
+    {
+      GdkPixbuf *pixbuf;
+      gchar *text, *p;
+
+      pixbuf = gtk_text_iter_get_pixbuf (&iter);
+      if (pixbuf)
+        {
+          append_binary_run_start (context, BINARY_RUN_PIXBUF, &iter);
+          append_varint (context->runs_str, context->n_pixbufs);
+
+          context->n_pixbufs++;
+          context->pixbufs = g_list_prepend (context->pixbufs, pixbuf);
+
+          gtk_text_iter_forward_char (&iter);
+          continue;
+        }
+
+      /* A run extends to the next tag toggle or pixbuf */
+      next = iter;
+      gtk_text_iter_forward_to_tag_toggle (&next, NULL);
+      if (gtk_text_iter_compare (&next, end) > 0)
+        next = *end;
+
+      text = gtk_text_iter_get_slice (&iter, &next);
+
+      p = text;
+      while ((p = strstr (p, "\357\277\274")) != NULL)
+        {
+          GtkTextIter pixbuf_iter = iter;
+
+          gtk_text_iter_forward_chars (&pixbuf_iter,
+                                       g_utf8_pointer_to_offset (text, p));
+          if (gtk_text_iter_get_pixbuf (&pixbuf_iter))
+            {
+              next = pixbuf_iter;
+              break;
+            }
+
+          p += 3;
+        }
+
+      append_binary_run_start (context, BINARY_RUN_TEXT, &iter);
+      append_binary_string (context->runs_str, text,
+                            p ? (gsize) (p - text) : strlen (text));
+      g_free (text);
+
+      iter = next;
+    }
+}
+
+static void
+serialize_binary_tag (GString    *str,
+                      GtkTextTag *tag,
+                      GHashTable *tag_ids)
+{
+  GString *attrs_str;
+  GParamSpec **pspecs;
+  guint n_pspecs;
+  guint n_attrs;
+  guint i;
+
+  if (tag->name)
+    {
+      append_varint (str, BINARY_TAG_NAMED);
+      append_binary_string (str, tag->name, strlen (tag->name));
+    }
+  else
+    {
+      append_varint (str, 0);
+      append_varint (str, g_hash_table_size (tag_ids));
+      g_hash_table_insert (tag_ids, tag, tag);
+    }
+
+  append_varint (str, tag->priority);
+
+  /* Same properties as serialize_tag() */
+  attrs_str = g_string_new (NULL);
+  n_attrs = 0;
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (tag), &n_pspecs);
+
+  for (i = 0; i < n_pspecs; i++)
+    {
+      GValue value = { 0 };
+      const gchar *type_name;
+      gchar *tmp;
+
+      if (!(pspecs[i]->flags & G_PARAM_READABLE) ||
+	  !(pspecs[i]->flags & G_PARAM_WRITABLE))
+	continue;
+
+      if (!is_param_set (G_OBJECT (tag), pspecs[i], &value))
+	continue;
+
+      tmp = serialize_value (&value);
+
+      if (tmp)
+        {
+          type_name = g_type_name (pspecs[i]->value_type);
+
+          append_binary_string (attrs_str, pspecs[i]->name, strlen (pspecs[i]->name));
+          append_binary_string (attrs_str, type_name, strlen (type_name));
+          append_binary_string (attrs_str, tmp, strlen (tmp));
+          n_attrs++;
+
+          g_free (tmp);
+        }
+
+      g_value_unset (&value);
+    }
+
+  g_free (pspecs);
+
+  append_varint (str, n_attrs);
+  g_string_append_len (str, attrs_str->str, attrs_str->len);
+  g_string_free (attrs_str, TRUE);
+}
+
+guint8 *
+_gtk_text_buffer_serialize_binary_rich_text (GtkTextBuffer     *register_buffer,
+                                             GtkTextBuffer     *content_buffer,
+                                             const GtkTextIter *start,
+                                             const GtkTextIter *end,
+                                             gsize             *length,
+                                             gpointer           user_data)
+{
+  BinarySerializationContext context;
+  GString *contents;
+  GString *text;
+  GHashTable *tag_ids;
+  guint i;
+
+  context.runs_str = g_string_new (NULL);
+  context.tags = g_ptr_array_new ();
+  context.tag_indices = g_hash_table_new (NULL, NULL);
+  context.n_runs = 0;
+  context.n_pixbufs = 0;
+  context.pixbufs = NULL;
+
+  serialize_binary_text (&context, start, end);
+
+  contents = g_string_new (NULL);
+  append_varint (contents, BINARY_FORMAT_VERSION);
+
+  tag_ids = g_hash_table_new (NULL, NULL);
+  append_varint (contents, context.tags->len);
+  for (i = 0; i < context.tags->len; i++)
+    serialize_binary_tag (contents, g_ptr_array_index (context.tags, i), tag_ids);
+  g_hash_table_destroy (tag_ids);
+
+  append_varint (contents, context.n_runs);
+  g_string_append_len (contents, context.runs_str->str, context.runs_str->len);
+
+  text = g_string_new (NULL);
+  serialize_section_header (text, "GTKTEXTBUFFERBINCONTS-0001", contents->len);
+  g_string_append_len (text, contents->str, contents->len);
+
+  context.pixbufs = g_list_reverse (context.pixbufs);
+  serialize_pixbufs (context.pixbufs, text);
+
+  g_list_free (context.pixbufs);
+  g_string_free (contents, TRUE);
+  g_string_free (context.runs_str, TRUE);
+  g_ptr_array_free (context.tags, TRUE);
+  g_hash_table_destroy (context.tag_indices);
+
+  *length = text->len;
+
+  return (guint8 *) g_string_free (text, FALSE);
+}
+
 typedef enum
 {
   STATE_START,
@@ -1748,6 +2031,7 @@ read_headers (const gchar *start,
 	goto error;
 
       if (strncmp (start + i, "GTKTEXTBUFFERCONTENTS-0001", 26) == 0 ||
+	  strncmp (start + i, "GTKTEXTBUFFERBINCONTS-0001", 26) == 0 ||
 	  strncmp (start + i, "GTKTEXTBUFFERPIXBDATA-0001", 26) == 0)
 	{
 	  section_len = read_int ((const guchar *) start + i + 26);
@@ -1871,3 +2155,394 @@ _gtk_text_buffer_deserialize_rich_text (GtkTextBuffer *register_buffer,
 
   return retval;
 }
+
+typedef struct
+{
+  const guchar *p;
+  const guchar *end;
+} BinaryReader;
+
+static gboolean
+read_varint (BinaryReader *reader,
+             guint        *value)
+{
+  guint result = 0;
+  gint shift = 0;
+
+  while (reader->p < reader->end && shift < 32)
+    {
+      guchar byte = *reader->p++;
+
+      result |= (guint) (byte & 0x7f) << shift;
+
+      if (!(byte & 0x80))
+        {
+          *value = result;
+          return TRUE;
+        }
+
+      shift += 7;
+    }
+
+  return FALSE;
+}
+
+static gchar *
+read_binary_string (BinaryReader *reader)
+{
+  guint len;
+  gchar *str;
+
+  if (!read_varint (reader, &len) ||
+      len > (guint) (reader->end - reader->p))
+    return NULL;
+
+  str = g_strndup ((const gchar *) reader->p, len);
+  reader->p += len;
+
+  return str;
+}
+
+static gboolean
+read_binary_attrs (BinaryReader  *reader,
+                   GtkTextTag    *tag,
+                   GError       **error)
+{
+  guint n_attrs, i;
+
+  if (!read_varint (reader, &n_attrs))
+    goto malformed;
+
+  for (i = 0; i < n_attrs; i++)
+    {
+      gchar *name, *type, *value;
+      GType gtype;
+      GValue gvalue = { 0 };
+      GParamSpec *pspec;
+      gboolean ok = FALSE;
+
+      name = read_binary_string (reader);
+      type = read_binary_string (reader);
+      value = read_binary_string (reader);
+
+      if (!name || !type || !value)
+        {
+          g_free (name);
+          g_free (type);
+          g_free (value);
+          goto malformed;
+        }
+
+      gtype = g_type_from_name (type);
+
+      if (gtype == G_TYPE_INVALID)
+        g_set_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                     _("\"%s\" is not a valid attribute type"), type);
+      else if (!(pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (tag), name)))
+        g_set_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                     _("\"%s\" is not a valid attribute name"), name);
+      else
+        {
+          g_value_init (&gvalue, gtype);
+
+          if (!deserialize_value (value, &gvalue))
+            g_set_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                         _("\"%s\" could not be converted to a value of type \"%s\" for attribute \"%s\""),
+                         value, type, name);
+          else if (g_param_value_validate (pspec, &gvalue))
+            g_set_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                         _("\"%s\" is not a valid value for attribute \"%s\""),
+                         value, name);
+          else
+            {
+              g_object_set_property (G_OBJECT (tag), name, &gvalue);
+              ok = TRUE;
+            }
+
+          g_value_unset (&gvalue);
+        }
+
+      g_free (name);
+      g_free (type);
+      g_free (value);
+
+      if (!ok)
+        return FALSE;
+    }
+
+  return TRUE;
+
+ malformed:
+  g_set_error_literal (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                       _("Serialized data is malformed"));
+  return FALSE;
+}
+
+/* Creates or looks up the tags of the tag table section, following
+ * the same rules as the XML parser.
+ */
+static gboolean
+read_binary_tags (BinaryReader  *reader,
+                  ParseInfo     *info,
+                  GtkTextTag   **tags,
+                  guint          n_tags,
+                  GError       **error)
+{
+  GList *list;
+  guint i;
+
+  for (i = 0; i < n_tags; i++)
+    {
+      guint flags, id, prio;
+      gchar *name = NULL;
+      GtkTextTag *tag;
+
+      if (!read_varint (reader, &flags))
+        goto malformed;
+
+      if (flags & BINARY_TAG_NAMED)
+        {
+          name = read_binary_string (reader);
+          if (!name)
+            goto malformed;
+
+          if (g_hash_table_lookup (info->defined_tags, name) != NULL)
+            {
+              g_set_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                           _("Tag \"%s\" already defined"), name);
+              g_free (name);
+              return FALSE;
+            }
+        }
+      else if (!read_varint (reader, &id))
+        goto malformed;
+
+      if (!read_varint (reader, &prio))
+        {
+          g_free (name);
+          goto malformed;
+        }
+
+      if (name)
+        {
+          gchar *tag_name = get_tag_name (info, name);
+          tag = gtk_text_tag_new (tag_name);
+          g_free (tag_name);
+
+          g_hash_table_insert (info->defined_tags, name, name);
+        }
+      else
+        tag = gtk_text_tag_new (NULL);
+
+      if (!read_binary_attrs (reader, tag, error))
+        {
+          g_object_unref (tag);
+          return FALSE;
+        }
+
+      if (info->create_tags)
+        {
+          TextTagPrio *tag_prio;
+
+          tag_prio = g_new0 (TextTagPrio, 1);
+          tag_prio->prio = prio;
+          tag_prio->tag = tag;
+
+          info->tag_priorities = g_list_prepend (info->tag_priorities, tag_prio);
+          tags[i] = tag;
+        }
+      else
+        {
+          if (!name)
+            {
+              g_set_error_literal (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                                   _("Anonymous tag found and tags can not be created."));
+              g_object_unref (tag);
+              return FALSE;
+            }
+
+          tags[i] = gtk_text_tag_table_lookup (info->buffer->tag_table, name);
+          g_object_unref (tag);
+
+          if (!tags[i])
+            {
+              g_set_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                           _("Tag \"%s\" does not exist in buffer and tags can not be created."),
+                           name);
+              return FALSE;
+            }
+        }
+    }
+
+  /* Sort list and add the tags */
+  info->tag_priorities = g_list_sort (info->tag_priorities,
+                                      (GCompareFunc)sort_tag_prio);
+  for (list = info->tag_priorities; list; list = list->next)
+    {
+      TextTagPrio *tag_prio = list->data;
+
+      gtk_text_tag_table_add (info->buffer->tag_table, tag_prio->tag);
+
+      g_object_unref (tag_prio->tag);
+      tag_prio->tag = NULL;
+    }
+
+  return TRUE;
+
+ malformed:
+  g_set_error_literal (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                       _("Serialized data is malformed"));
+  return FALSE;
+}
+
+static gboolean
+read_binary_runs (BinaryReader  *reader,
+                  ParseInfo     *info,
+                  GtkTextTag   **tags,
+                  guint          n_tags,
+                  GError       **error)
+{
+  guint n_runs, i, j;
+
+  if (!read_varint (reader, &n_runs))
+    goto malformed;
+
+  for (i = 0; i < n_runs; i++)
+    {
+      guint kind, n_run_tags, index;
+      TextSpan *span;
+
+      if (!read_varint (reader, &kind) ||
+          !read_varint (reader, &n_run_tags))
+        goto malformed;
+
+      span = g_new0 (TextSpan, 1);
+      info->spans = g_list_prepend (info->spans, span);
+
+      for (j = 0; j < n_run_tags; j++)
+        {
+          if (!read_varint (reader, &index) || index >= n_tags)
+            goto malformed;
+
+          span->tags = g_slist_prepend (span->tags, tags[index]);
+        }
+
+      if (kind == BINARY_RUN_TEXT)
+        {
+          span->text = read_binary_string (reader);
+
+          if (!span->text || !g_utf8_validate (span->text, -1, NULL))
+            goto malformed;
+        }
+      else if (kind == BINARY_RUN_PIXBUF)
+        {
+          if (!read_varint (reader, &index))
+            goto malformed;
+
+          span->pixbuf = get_pixbuf_from_headers (info->headers, index, error);
+
+          if (!span->pixbuf)
+            {
+              if (error && !*error)
+                goto malformed;
+              return FALSE;
+            }
+        }
+      else
+        goto malformed;
+    }
+
+  info->spans = g_list_reverse (info->spans);
+
+  return TRUE;
+
+ malformed:
+  g_set_error_literal (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE,
+                       _("Serialized data is malformed"));
+  return FALSE;
+}
+
+gboolean
+_gtk_text_buffer_deserialize_binary_rich_text (GtkTextBuffer *register_buffer,
+                                               GtkTextBuffer *content_buffer,
+                                               GtkTextIter   *iter,
+                                               const guint8  *text,
+                                               gsize          length,
+                                               gboolean       create_tags,
+                                               gpointer       user_data,
+                                               GError       **error)
+{
+  GList *headers;
+  Header *header;
+  ParseInfo info;
+  BinaryReader reader;
+  GtkTextTag **tags = NULL;
+  guint version, n_tags;
+  gboolean retval = FALSE;
+
+  headers = read_headers ((gchar *) text, length, error);
+
+  if (!headers)
+    return FALSE;
+
+  header = headers->data;
+  if (!header_is (header, "GTKTEXTBUFFERBINCONTS-0001"))
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed. First section isn't GTKTEXTBUFFERBINCONTS-0001"));
+      goto out;
+    }
+
+  parse_info_init (&info, content_buffer, create_tags, headers->next);
+
+  reader.p = (const guchar *) header->start;
+  reader.end = reader.p + header->length;
+
+  if (!read_varint (&reader, &version) ||
+      version != BINARY_FORMAT_VERSION ||
+      !read_varint (&reader, &n_tags) ||
+      n_tags > (guint) header->length)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed"));
+      goto free_info;
+    }
+
+  tags = g_new0 (GtkTextTag *, n_tags);
+
+  if (read_binary_tags (&reader, &info, tags, n_tags, error) &&
+      read_binary_runs (&reader, &info, tags, n_tags, error))
+    {
+      insert_text (&info, iter);
+      retval = TRUE;
+    }
+  else
+    {
+      /* Pixbufs of spans that weren't inserted */
+      GList *list;
+
+      for (list = info.spans; list; list = list->next)
+        {
+          TextSpan *span = list->data;
+
+          if (span->pixbuf)
+            g_object_unref (span->pixbuf);
+        }
+    }
+
+  g_free (tags);
+
+ free_info:
+  g_hash_table_destroy (info.anonymous_tags);
+  parse_info_free (&info);
+
+ out:
+  g_list_foreach (headers, (GFunc)g_free, NULL);
+  g_list_free (headers);
+
+  return retval;
+}
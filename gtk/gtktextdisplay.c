@@ -459,6 +459,9 @@ render_para (GtkTextRenderer    *text_renderer,
              /* Top-left corner of paragraph including all margins */
              int                 x,
              int                 y,
+             /* Vertical extent of the area being drawn */
+             int                 clip_top,
+             int                 clip_bottom,
              int                 selection_start_index,
              int                 selection_end_index)
 {
@@ -528,6 +531,18 @@ render_para (GtkTextRenderer    *text_renderer,
       
       first = FALSE;
 
+      /* A long paragraph wraps to many more lines than fit on
+       * screen; only draw the ones inside the exposed area.
+       */
+      if (selection_y >= clip_bottom)
+        break;
+
+      if (selection_y + selection_height <= clip_top)
+        {
+          byte_offset += line->length;
+          continue;
+        }
+
       if (selection_start_index < byte_offset &&
           selection_end_index > line->length + byte_offset) /* All selected */
         {
@@ -852,6 +867,7 @@ gtk_text_layout_draw (GtkTextLayout *layout,
           render_para (text_renderer, line_display,
                        - x_offset,
                        current_y,
+                       clip.y, clip.y + clip.height,
                        selection_start_index, selection_end_index);
 
           /* We paint the cursors last, because they overlap another chunk
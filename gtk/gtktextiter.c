@@ -273,8 +273,8 @@ iter_init_from_byte_offset (GtkTextIter *iter,
 
   iter_set_from_byte_offset (real, line, line_byte_offset);
 
-  if (real->segment->type == &gtk_text_char_type &&
-      (real->segment->body.chars[real->segment_byte_offset] & 0xc0) == 0x80)
+  if (_GTK_TEXT_SEGMENT_IS_CHARS (real->segment) &&
+      (_GTK_TEXT_SEGMENT_CHARS (real->segment)[real->segment_byte_offset] & 0xc0) == 0x80)
     g_warning ("Incorrect line byte index %d falls in the middle of a UTF-8 "
                "character; this will crash the text buffer. "
                "Byte indexes must refer to the start of a character.",
@@ -847,11 +847,11 @@ gtk_text_iter_get_char (const GtkTextIter *iter)
 
   if (gtk_text_iter_is_end (iter))
     return 0;
-  else if (real->segment->type == &gtk_text_char_type)
+  else if (_GTK_TEXT_SEGMENT_IS_CHARS (real->segment))
     {
       ensure_byte_offsets (real);
       
-      return g_utf8_get_char (real->segment->body.chars +
+      return g_utf8_get_char (_GTK_TEXT_SEGMENT_CHARS (real->segment) +
                               real->segment_byte_offset);
     }
   else
@@ -1878,13 +1878,13 @@ forward_char (GtkTextRealIter *real)
       /* Just moving within a segment. Keep byte count
          up-to-date, if it was already up-to-date. */
 
-      g_assert (real->segment->type == &gtk_text_char_type);
+      g_assert (_GTK_TEXT_SEGMENT_IS_CHARS (real->segment));
 
       if (real->line_byte_offset >= 0)
         {
           gint bytes;
           const char * start =
-            real->segment->body.chars + real->segment_byte_offset;
+            _GTK_TEXT_SEGMENT_CHARS (real->segment) + real->segment_byte_offset;
 
           bytes = g_utf8_next_char (start) - start;
 
@@ -2356,7 +2356,7 @@ gtk_text_iter_backward_chars (GtkTextIter *iter, gint count)
     {
       /* Optimize the within-segment case */
       g_assert (real->segment->char_count > 0);
-      g_assert (real->segment->type == &gtk_text_char_type);
+      g_assert (_GTK_TEXT_SEGMENT_IS_CHARS (real->segment));
 
       if (real->line_byte_offset >= 0)
         {
@@ -2365,13 +2365,13 @@ gtk_text_iter_backward_chars (GtkTextIter *iter, gint count)
 
           /* if in the last fourth of the segment walk backwards */
           if (count < real->segment_char_offset / 4)
-            p = g_utf8_offset_to_pointer (real->segment->body.chars + real->segment_byte_offset, 
+            p = g_utf8_offset_to_pointer (_GTK_TEXT_SEGMENT_CHARS (real->segment) + real->segment_byte_offset, 
                                           -count);
           else
-            p = g_utf8_offset_to_pointer (real->segment->body.chars,
+            p = g_utf8_offset_to_pointer (_GTK_TEXT_SEGMENT_CHARS (real->segment),
                                           real->segment_char_offset - count);
 
-          new_byte_offset = p - real->segment->body.chars;
+          new_byte_offset = p - _GTK_TEXT_SEGMENT_CHARS (real->segment);
           real->line_byte_offset -= (real->segment_byte_offset - new_byte_offset);
           real->segment_byte_offset = new_byte_offset;
         }
@@ -3812,8 +3812,8 @@ gtk_text_iter_set_line_index (GtkTextIter *iter,
   else
     gtk_text_iter_forward_line (iter);
 
-  if (real->segment->type == &gtk_text_char_type &&
-      (real->segment->body.chars[real->segment_byte_offset] & 0xc0) == 0x80)
+  if (_GTK_TEXT_SEGMENT_IS_CHARS (real->segment) &&
+      (_GTK_TEXT_SEGMENT_CHARS (real->segment)[real->segment_byte_offset] & 0xc0) == 0x80)
     g_warning ("%s: Incorrect byte offset %d falls in the middle of a UTF-8 "
                "character; this will crash the text buffer. "
                "Byte indexes must refer to the start of a character.",
@@ -5467,10 +5467,10 @@ _gtk_text_iter_check (const GtkTextIter *iter)
           if (seg_byte_offset != real->segment_byte_offset)
             g_error ("wrong segment byte offset was stored in iterator");
 
-          if (byte_segment->type == &gtk_text_char_type)
+          if (_GTK_TEXT_SEGMENT_IS_CHARS (byte_segment))
             {
               const gchar *p;
-              p = byte_segment->body.chars + seg_byte_offset;
+              p = _GTK_TEXT_SEGMENT_CHARS (byte_segment) + seg_byte_offset;
               
               if (!gtk_text_byte_begins_utf8_char (p))
                 g_error ("broken iterator byte index pointed into the middle of a character");
@@ -5498,10 +5498,10 @@ _gtk_text_iter_check (const GtkTextIter *iter)
           if (seg_char_offset != real->segment_char_offset)
             g_error ("wrong segment char offset was stored in iterator");
 
-          if (char_segment->type == &gtk_text_char_type)
+          if (_GTK_TEXT_SEGMENT_IS_CHARS (char_segment))
             {
               const gchar *p;
-              p = g_utf8_offset_to_pointer (char_segment->body.chars,
+              p = g_utf8_offset_to_pointer (_GTK_TEXT_SEGMENT_CHARS (char_segment),
                                             seg_char_offset);
 
               /* hmm, not likely to happen eh */
@@ -5521,13 +5521,13 @@ _gtk_text_iter_check (const GtkTextIter *iter)
 
       /* Make sure the segment offsets are equivalent, if it's a char
          segment. */
-      if (char_segment->type == &gtk_text_char_type)
+      if (_GTK_TEXT_SEGMENT_IS_CHARS (char_segment))
         {
           gint byte_offset = 0;
           gint char_offset = 0;
           while (char_offset < seg_char_offset)
             {
-              const char * start = char_segment->body.chars + byte_offset;
+              const char * start = _GTK_TEXT_SEGMENT_CHARS (char_segment) + byte_offset;
               byte_offset += g_utf8_next_char (start) - start;
               char_offset += 1;
             }
@@ -5536,12 +5536,12 @@ _gtk_text_iter_check (const GtkTextIter *iter)
             g_error ("byte offset did not correspond to char offset");
 
           char_offset =
-            g_utf8_strlen (char_segment->body.chars, seg_byte_offset);
+            g_utf8_strlen (_GTK_TEXT_SEGMENT_CHARS (char_segment), seg_byte_offset);
 
           if (char_offset != seg_char_offset)
             g_error ("char offset did not correspond to byte offset");
 
-          if (!gtk_text_byte_begins_utf8_char (char_segment->body.chars + seg_byte_offset))
+          if (!gtk_text_byte_begins_utf8_char (_GTK_TEXT_SEGMENT_CHARS (char_segment) + seg_byte_offset))
             g_error ("byte index for iterator does not index the start of a character");
         }
     }
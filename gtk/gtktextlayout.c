@@ -99,14 +99,54 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* Displays of very long paragraphs that were pushed out of
+   * one_display_cache, most recently used first.
+   */
+  GSList *long_line_displays;
+
+  /* Resolved attributes of the tag sets seen so far, keyed by
+   * the ordered tag array (StyleKey).
+   */
+  GHashTable *style_cache;
+
+  /* Running sums of the heights of recently wrapped lines, used to
+   * estimate the height of lines that were never wrapped.
+   */
+  gint wrapped_height;
+  gint n_wrapped_lines;
+  gint font_line_height;
 };
 
+typedef struct
+{
+  guint n_tags;
+  GtkTextTag *tags[1];
+} StyleKey;
+
+/* Paragraphs of at least this many bytes are expensive enough to shape
+ * that we keep their displays around instead of rebuilding them after
+ * every other line goes through one_display_cache.
+ */
+#define LONG_LINE_BYTES      32768
+#define LONG_LINE_CACHE_SIZE 4
+
+/* Syntax highlighting uses a few dozen distinct tag combinations;
+ * this only guards against unbounded growth.
+ */
+#define STYLE_CACHE_SIZE 512
+
+/* Number of wrapped lines the height estimate averages over */
+#define HEIGHT_ESTIMATE_LINES 256
+
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
                                                    GtkTextLine *line,
                                                    /* may be NULL */
                                                    GtkTextLineData *line_data);
 
 static void gtk_text_layout_invalidated     (GtkTextLayout     *layout);
+static void gtk_text_layout_free_long_line_displays (GtkTextLayout *layout);
+static void gtk_text_layout_clear_style_cache (GtkTextLayout *layout);
 
 static void gtk_text_layout_real_invalidate        (GtkTextLayout     *layout,
 						    const GtkTextIter *start,
@@ -252,15 +292,74 @@ free_style_cache (GtkTextLayout *text_layout)
     }
 }
 
+static guint
+style_key_hash (gconstpointer key)
+{
+  const StyleKey *style_key = key;
+  guint hash = style_key->n_tags;
+  guint i;
+
+  for (i = 0; i < style_key->n_tags; i++)
+    hash = (hash * 31) + GPOINTER_TO_UINT (style_key->tags[i]);
+
+  return hash;
+}
+
+static gboolean
+style_key_equal (gconstpointer a,
+                 gconstpointer b)
+{
+  const StyleKey *key_a = a;
+  const StyleKey *key_b = b;
+
+  return key_a->n_tags == key_b->n_tags &&
+    memcmp (key_a->tags, key_b->tags, key_a->n_tags * sizeof (GtkTextTag *)) == 0;
+}
+
+static void
+gtk_text_layout_clear_style_cache (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (priv->style_cache)
+    g_hash_table_remove_all (priv->style_cache);
+}
+
+static void
+gtk_text_layout_tag_changed (GtkTextTagTable *table,
+                             GtkTextTag      *tag,
+                             gboolean         size_changed,
+                             GtkTextLayout   *layout)
+{
+  gtk_text_layout_clear_style_cache (layout);
+}
+
+static void
+gtk_text_layout_tag_removed (GtkTextTagTable *table,
+                             GtkTextTag      *tag,
+                             GtkTextLayout   *layout)
+{
+  /* The cache keys don't hold references on their tags */
+  gtk_text_layout_clear_style_cache (layout);
+}
+
 static void
 gtk_text_layout_finalize (GObject *object)
 {
   GtkTextLayout *layout;
+  GtkTextLayoutPrivate *priv;
 
   layout = GTK_TEXT_LAYOUT (object);
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
 
   gtk_text_layout_set_buffer (layout, NULL);
 
+  if (priv->style_cache)
+    {
+      g_hash_table_destroy (priv->style_cache);
+      priv->style_cache = NULL;
+    }
+
   if (layout->default_style)
     gtk_text_attributes_unref (layout->default_style);
   layout->default_style = NULL;
@@ -283,6 +382,8 @@ gtk_text_layout_finalize (GObject *object)
       gtk_text_layout_free_line_display (layout, tmp_display);
     }
 
+  gtk_text_layout_free_long_line_displays (layout);
+
   if (layout->preedit_string)
     {
       g_free (layout->preedit_string);
@@ -314,12 +415,23 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  gtk_text_layout_clear_style_cache (layout);
+  gtk_text_layout_free_long_line_displays (layout);
 
   if (layout->buffer)
     {
+      GtkTextTagTable *table = gtk_text_buffer_get_tag_table (layout->buffer);
+
       _gtk_text_btree_remove_view (_gtk_text_buffer_get_btree (layout->buffer),
                                   layout);
 
+      g_signal_handlers_disconnect_by_func (table,
+                                            G_CALLBACK (gtk_text_layout_tag_changed),
+                                            layout);
+      g_signal_handlers_disconnect_by_func (table,
+                                            G_CALLBACK (gtk_text_layout_tag_removed),
+                                            layout);
+
       g_signal_handlers_disconnect_by_func (layout->buffer, 
                                             G_CALLBACK (gtk_text_layout_mark_set_handler), 
                                             layout);
@@ -350,6 +462,11 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
       g_signal_connect_after (layout->buffer, "delete-range",
                               G_CALLBACK (gtk_text_layout_buffer_delete_range), layout);
 
+      g_signal_connect (gtk_text_buffer_get_tag_table (buffer), "tag-changed",
+                        G_CALLBACK (gtk_text_layout_tag_changed), layout);
+      g_signal_connect (gtk_text_buffer_get_tag_table (buffer), "tag-removed",
+                        G_CALLBACK (gtk_text_layout_tag_removed), layout);
+
       gtk_text_layout_update_cursor_line (layout);
     }
 }
@@ -642,17 +759,27 @@ text_layout_changed (GtkTextLayout *layout,
   /* Check if the range intersects our cached line display,
    * and invalidate the cached line if so.
    */
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GSList *displays, *l;
+
+  displays = g_slist_copy (priv->long_line_displays);
   if (layout->one_display_cache)
+    displays = g_slist_prepend (displays, layout->one_display_cache);
+
+  for (l = displays; l; l = l->next)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLineDisplay *display = l->data;
+      GtkTextLine *line = display->line;
       gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
 						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+      gint cache_height = display->height;
 
       if (cache_y + cache_height > y && cache_y < y + old_height)
 	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
     }
 
+  g_slist_free (displays);
+
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
 }
 
@@ -809,6 +936,16 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   GtkTextIter start;
   GtkTextIter end;
 
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  /* Default style or context changes affect every resolved style,
+   * and the line heights we measured so far.
+   */
+  gtk_text_layout_clear_style_cache (layout);
+  priv->wrapped_height = 0;
+  priv->n_wrapped_lines = 0;
+  priv->font_line_height = 0;
+
   if (layout->buffer == NULL)
     return;
 
@@ -817,29 +954,103 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   gtk_text_layout_invalidate (layout, &start, &end);
 }
 
+static void
+invalidate_display_cursors (GtkTextLineDisplay *display)
+{
+  g_slist_foreach (display->cursors, (GFunc)g_free, NULL);
+  g_slist_free (display->cursors);
+  display->cursors = NULL;
+  display->cursors_invalid = TRUE;
+  display->has_block_cursor = FALSE;
+}
+
 static void
 gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GSList *l;
+
   if (layout->one_display_cache && line == layout->one_display_cache->line)
     {
       GtkTextLineDisplay *display = layout->one_display_cache;
 
       if (cursors_only)
-	{
-	  g_slist_foreach (display->cursors, (GFunc)g_free, NULL);
-	  g_slist_free (display->cursors);
-	  display->cursors = NULL;
-	  display->cursors_invalid = TRUE;
-	  display->has_block_cursor = FALSE;
-	}
+        invalidate_display_cursors (display);
       else
 	{
 	  layout->one_display_cache = NULL;
 	  gtk_text_layout_free_line_display (layout, display);
 	}
     }
+
+  l = priv->long_line_displays;
+  while (l)
+    {
+      GtkTextLineDisplay *display = l->data;
+      GSList *next = l->next;
+
+      if (display->line == line)
+        {
+          if (cursors_only)
+            invalidate_display_cursors (display);
+          else
+            {
+              priv->long_line_displays =
+                g_slist_delete_link (priv->long_line_displays, l);
+              gtk_text_layout_free_line_display (layout, display);
+            }
+        }
+
+      l = next;
+    }
+}
+
+static void
+gtk_text_layout_free_long_line_displays (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->long_line_displays)
+    {
+      GtkTextLineDisplay *display = priv->long_line_displays->data;
+
+      priv->long_line_displays =
+        g_slist_delete_link (priv->long_line_displays,
+                             priv->long_line_displays);
+      gtk_text_layout_free_line_display (layout, display);
+    }
+}
+
+/* Called when @display leaves one_display_cache; long paragraphs
+ * are kept so that the next lookup doesn't have to shape them again.
+ */
+static void
+gtk_text_layout_release_display_cache (GtkTextLayout      *layout,
+                                       GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GSList *last;
+
+  if (display->layout == NULL ||
+      _gtk_text_line_byte_count (display->line) < LONG_LINE_BYTES)
+    {
+      gtk_text_layout_free_line_display (layout, display);
+      return;
+    }
+
+  priv->long_line_displays = g_slist_prepend (priv->long_line_displays,
+                                              display);
+
+  if (g_slist_length (priv->long_line_displays) > LONG_LINE_CACHE_SIZE)
+    {
+      last = g_slist_last (priv->long_line_displays);
+      display = last->data;
+      priv->long_line_displays =
+        g_slist_delete_link (priv->long_line_displays, last);
+      gtk_text_layout_free_line_display (layout, display);
+    }
 }
 
 /* Now invalidate the paragraph containing the cursor
@@ -881,6 +1092,35 @@ gtk_text_layout_update_cursor_line(GtkTextLayout *layout)
   priv->cursor_line = _gtk_text_iter_get_text_line (&iter);
 }
 
+static gint
+gtk_text_layout_estimate_line_height (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (priv->n_wrapped_lines > 0)
+    return priv->wrapped_height / priv->n_wrapped_lines;
+
+  /* Nothing wrapped yet, go by the default font */
+  if (priv->font_line_height == 0 &&
+      layout->ltr_context && layout->default_style &&
+      layout->default_style->font)
+    {
+      PangoFontMetrics *metrics;
+
+      metrics = pango_context_get_metrics (layout->ltr_context,
+                                           layout->default_style->font,
+                                           NULL);
+      priv->font_line_height =
+        PANGO_PIXELS (pango_font_metrics_get_ascent (metrics) +
+                      pango_font_metrics_get_descent (metrics)) +
+        layout->default_style->pixels_above_lines +
+        layout->default_style->pixels_below_lines;
+      pango_font_metrics_unref (metrics);
+    }
+
+  return priv->font_line_height;
+}
+
 static void
 gtk_text_layout_real_invalidate (GtkTextLayout *layout,
                                  const GtkTextIter *start,
@@ -888,6 +1128,7 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
 {
   GtkTextLine *line;
   GtkTextLine *last_line;
+  gboolean unwrapped_lines = FALSE;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (layout->wrap_loop_count == 0);
@@ -915,6 +1156,8 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
       
       if (line_data)
         _gtk_text_line_invalidate_wrap (line, line_data);
+      else
+        unwrapped_lines = TRUE;
 
       if (line == last_line)
         break;
@@ -922,6 +1165,22 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
       line = _gtk_text_line_next_excluding_last (line);
     }
 
+  /* Lines that were just inserted don't count towards the height
+   * of the layout until they get validated. Give them an estimated
+   * height instead, so that scrolling into a large paste lands on
+   * the right lines and the scrollbar doesn't jump while the rest of
+   * the buffer is validated.
+   */
+  if (unwrapped_lines)
+    {
+      gint height = gtk_text_layout_estimate_line_height (layout);
+
+      if (height > 0)
+        _gtk_text_btree_estimate_lines (_gtk_text_buffer_get_btree (layout->buffer),
+                                        _gtk_text_iter_get_text_line (start),
+                                        last_line, layout, height);
+    }
+
   gtk_text_layout_invalidated (layout);
 }
 
@@ -930,13 +1189,28 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GSList *displays, *l;
+
+  if (gtk_text_iter_compare (start, end) > 0)
+    {
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
+  displays = g_slist_copy (priv->long_line_displays);
   if (layout->one_display_cache)
+    displays = g_slist_prepend (displays, layout->one_display_cache);
+
+  for (l = displays; l; l = l->next)
     {
+      GtkTextLineDisplay *display = l->data;
       GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLine *line = display->line;
 
       _gtk_text_btree_get_iter_at_line (_gtk_text_buffer_get_btree (layout->buffer),
                                         &line_start, line, 0);
@@ -944,13 +1218,6 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
       if (!gtk_text_iter_ends_line (&line_end))
 	gtk_text_iter_forward_to_line_end (&line_end);
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
-
       if (gtk_text_iter_compare (&line_start, end) <= 0 &&
 	  gtk_text_iter_compare (start, &line_end) <= 0)
 	{
@@ -958,6 +1225,8 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 	}
     }
 
+  g_slist_free (displays);
+
   gtk_text_layout_invalidated (layout);
 }
 
@@ -1153,6 +1422,7 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
                            /* may be NULL */
                            GtkTextLineData *line_data)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
 
   g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), NULL);
@@ -1170,6 +1440,14 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
   line_data->valid = TRUE;
   gtk_text_layout_free_line_display (layout, display);
 
+  priv->wrapped_height += line_data->height;
+  priv->n_wrapped_lines++;
+  if (priv->n_wrapped_lines >= 2 * HEIGHT_ESTIMATE_LINES)
+    {
+      priv->wrapped_height /= 2;
+      priv->n_wrapped_lines /= 2;
+    }
+
   return line_data;
 }
 
@@ -1183,7 +1461,9 @@ static GtkTextAttributes*
 get_style (GtkTextLayout *layout,
 	   GPtrArray     *tags)
 {
+  GtkTextLayoutPrivate *priv;
   GtkTextAttributes *style;
+  StyleKey *key;
 
   /* If we have the one-style cache, then it means
      that we haven't seen a toggle since we filled in the
@@ -1209,16 +1489,44 @@ get_style (GtkTextLayout *layout,
       return layout->default_style;
     }
 
-  style = gtk_text_attributes_new ();
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
 
-  gtk_text_attributes_copy_values (layout->default_style,
-                                   style);
+  key = g_malloc (sizeof (StyleKey) + (tags->len - 1) * sizeof (GtkTextTag *));
+  key->n_tags = tags->len;
+  memcpy (key->tags, tags->pdata, tags->len * sizeof (GtkTextTag *));
 
-  _gtk_text_attributes_fill_from_tags (style,
-                                       (GtkTextTag**) tags->pdata,
-                                       tags->len);
+  if (priv->style_cache == NULL)
+    priv->style_cache = g_hash_table_new_full (style_key_hash, style_key_equal,
+                                               g_free,
+                                               (GDestroyNotify) gtk_text_attributes_unref);
 
-  g_assert (style->refcount == 1);
+  style = g_hash_table_lookup (priv->style_cache, key);
+
+  if (style)
+    {
+      g_free (key);
+      gtk_text_attributes_ref (style);
+    }
+  else
+    {
+      style = gtk_text_attributes_new ();
+
+      gtk_text_attributes_copy_values (layout->default_style,
+                                       style);
+
+      _gtk_text_attributes_fill_from_tags (style,
+                                           (GtkTextTag**) tags->pdata,
+                                           tags->len);
+
+      g_assert (style->refcount == 1);
+
+      if (g_hash_table_size (priv->style_cache) >= STYLE_CACHE_SIZE)
+        g_hash_table_remove_all (priv->style_cache);
+
+      /* ref held by priv->style_cache */
+      g_hash_table_insert (priv->style_cache, key,
+                           gtk_text_attributes_ref (style));
+    }
 
   /* Leave this style as the last one seen */
   g_assert (layout->one_style_cache == NULL);
@@ -2015,7 +2323,7 @@ update_text_display_cursors (GtkTextLayout      *layout,
   while (seg != NULL)
     {
       /* Displayable segments */
-      if (seg->type == &gtk_text_char_type ||
+      if (_GTK_TEXT_SEGMENT_IS_CHARS (seg) ||
           seg->type == &gtk_text_pixbuf_type ||
           seg->type == &gtk_text_child_type)
         {
@@ -2175,7 +2483,30 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
         {
           GtkTextLineDisplay *tmp_display = layout->one_display_cache;
           layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
+          gtk_text_layout_release_display_cache (layout, tmp_display);
+        }
+    }
+
+  for (tmp_list1 = priv->long_line_displays; tmp_list1; tmp_list1 = tmp_list1->next)
+    {
+      display = tmp_list1->data;
+
+      if (line == display->line)
+        {
+          priv->long_line_displays =
+            g_slist_delete_link (priv->long_line_displays, tmp_list1);
+
+          if (!size_only && display->size_only)
+            {
+              gtk_text_layout_free_line_display (layout, display);
+              break;
+            }
+
+          layout->one_display_cache = display;
+
+          if (!size_only)
+            update_text_display_cursors (layout, line, display);
+          return display;
         }
     }
 
@@ -2232,7 +2563,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   while (seg != NULL)
     {
       /* Displayable segments */
-      if (seg->type == &gtk_text_char_type ||
+      if (_GTK_TEXT_SEGMENT_IS_CHARS (seg) ||
           seg->type == &gtk_text_pixbuf_type ||
           seg->type == &gtk_text_child_type)
         {
@@ -2257,7 +2588,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
            */
           if (!style->invisible)
             {
-              if (seg->type == &gtk_text_char_type)
+              if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
                 {
                   /* We don't want to split segments because of marks,
                    * so we scan forward for more segments only
@@ -2271,9 +2602,9 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   
  		  while (seg)
                     {
-                      if (seg->type == &gtk_text_char_type)
+                      if (_GTK_TEXT_SEGMENT_IS_CHARS (seg))
                         {
-                          memcpy (text + layout_byte_offset, seg->body.chars, seg->byte_count);
+                          memcpy (text + layout_byte_offset, _GTK_TEXT_SEGMENT_CHARS (seg), seg->byte_count);
                           layout_byte_offset += seg->byte_count;
                           buffer_byte_offset += seg->byte_count;
                           bytes += seg->byte_count;
@@ -2660,6 +2991,154 @@ gtk_text_layout_get_iter_at_pixel (GtkTextLayout *layout,
   gtk_text_iter_forward_chars (target_iter, trailing);  
 }
 
+/* The wrapped lines of a long paragraph, so that an index or a position
+ * can be mapped to its line by binary search instead of by walking the
+ * lines from the top as pango_layout_index_to_pos() and
+ * pango_layout_xy_to_index() do. It is kept with the PangoLayout of the
+ * display, which doesn't change once the display is built.
+ */
+typedef struct
+{
+  gint n_lines;
+  PangoLayoutLine **lines;
+  PangoRectangle *extents;   /* logical extents of each line */
+  gint *line_tops;           /* first y of each line, with spacing */
+} LongLineIndex;
+
+static void
+long_line_index_free (LongLineIndex *index)
+{
+  g_free (index->lines);
+  g_free (index->extents);
+  g_free (index->line_tops);
+  g_slice_free (LongLineIndex, index);
+}
+
+static LongLineIndex *
+get_long_line_index (GtkTextLineDisplay *display)
+{
+  static GQuark quark_long_line_index = 0;
+  LongLineIndex *index;
+  PangoLayoutIter *iter;
+  gint i;
+
+  if (display->layout == NULL ||
+      _gtk_text_line_byte_count (display->line) < LONG_LINE_BYTES)
+    return NULL;
+
+  if (!quark_long_line_index)
+    quark_long_line_index = g_quark_from_static_string ("gtk-text-long-line-index");
+
+  index = g_object_get_qdata (G_OBJECT (display->layout), quark_long_line_index);
+  if (index)
+    return index;
+
+  index = g_slice_new (LongLineIndex);
+  index->n_lines = pango_layout_get_line_count (display->layout);
+  index->lines = g_new (PangoLayoutLine *, index->n_lines);
+  index->extents = g_new (PangoRectangle, index->n_lines);
+  index->line_tops = g_new (gint, index->n_lines);
+
+  iter = pango_layout_get_iter (display->layout);
+  i = 0;
+  do
+    {
+      index->lines[i] = pango_layout_iter_get_line_readonly (iter);
+      pango_layout_iter_get_line_extents (iter, NULL, &index->extents[i]);
+      pango_layout_iter_get_line_yrange (iter, &index->line_tops[i], NULL);
+      i++;
+    }
+  while (i < index->n_lines && pango_layout_iter_next_line (iter));
+  pango_layout_iter_free (iter);
+
+  index->n_lines = i;
+
+  g_object_set_qdata_full (G_OBJECT (display->layout), quark_long_line_index,
+                           index, (GDestroyNotify) long_line_index_free);
+
+  return index;
+}
+
+/* Like pango_layout_index_to_pos(). Returns %FALSE for the indexes that
+ * are left to Pango.
+ */
+static gboolean
+long_line_index_to_pos (GtkTextLineDisplay *display,
+                        gint                byte_index,
+                        PangoRectangle     *pos)
+{
+  LongLineIndex *index = get_long_line_index (display);
+  PangoLayoutLine *line;
+  gint lo, hi, mid;
+  gint x, x_trailing;
+
+  if (index == NULL || index->n_lines == 0)
+    return FALSE;
+
+  lo = 0;
+  hi = index->n_lines - 1;
+  while (lo < hi)
+    {
+      mid = (lo + hi + 1) / 2;
+      if (index->lines[mid]->start_index <= byte_index)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+
+  line = index->lines[lo];
+  if (byte_index < line->start_index ||
+      (byte_index >= line->start_index + line->length &&
+       lo != index->n_lines - 1))
+    return FALSE;
+
+  pango_layout_line_index_to_x (line, byte_index, 0, &x);
+  if (byte_index < line->start_index + line->length)
+    pango_layout_line_index_to_x (line, byte_index, 1, &x_trailing);
+  else
+    x_trailing = x;
+
+  pos->x = index->extents[lo].x + x;
+  pos->width = x_trailing - x;
+  pos->y = index->extents[lo].y;
+  pos->height = index->extents[lo].height;
+
+  return TRUE;
+}
+
+/* Like pango_layout_xy_to_index(), without telling whether the
+ * position is inside the layout.
+ */
+static gboolean
+long_line_xy_to_index (GtkTextLineDisplay *display,
+                       gint                x,
+                       gint                y,
+                       gint               *byte_index,
+                       gint               *trailing)
+{
+  LongLineIndex *index = get_long_line_index (display);
+  gint lo, hi, mid;
+
+  if (index == NULL || index->n_lines == 0)
+    return FALSE;
+
+  lo = 0;
+  hi = index->n_lines - 1;
+  while (lo < hi)
+    {
+      mid = (lo + hi + 1) / 2;
+      if (index->line_tops[mid] <= y)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+
+  pango_layout_line_x_to_index (index->lines[lo], x - index->extents[lo].x,
+                                byte_index, trailing);
+
+  return TRUE;
+}
+
 void gtk_text_layout_get_iter_at_position (GtkTextLayout     *layout,
 					   GtkTextIter       *target_iter,
 					   gint              *trailing,
@@ -2696,8 +3175,10 @@ void gtk_text_layout_get_iter_at_position (GtkTextLayout     *layout,
         * the right thing even if we are outside the layout in the
         * x-direction.
         */
-      pango_layout_xy_to_index (display->layout, x * PANGO_SCALE, y * PANGO_SCALE,
-                                &byte_index, trailing);
+      if (!long_line_xy_to_index (display, x * PANGO_SCALE, y * PANGO_SCALE,
+                                  &byte_index, trailing))
+        pango_layout_xy_to_index (display->layout, x * PANGO_SCALE, y * PANGO_SCALE,
+                                  &byte_index, trailing);
     }
 
   line_display_index_to_iter (layout, display, target_iter, byte_index, 0);
@@ -2940,7 +3421,8 @@ gtk_text_layout_get_iter_location (GtkTextLayout     *layout,
 
   byte_index = gtk_text_iter_get_line_index (iter);
   
-  pango_layout_index_to_pos (display->layout, byte_index, &pango_rect);
+  if (!long_line_index_to_pos (display, byte_index, &pango_rect))
+    pango_layout_index_to_pos (display->layout, byte_index, &pango_rect);
   
   rect->x = PANGO_PIXELS (x_offset + pango_rect.x);
   rect->y += PANGO_PIXELS (pango_rect.y) + display->top_margin;
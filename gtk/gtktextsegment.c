@@ -158,6 +158,8 @@ gtk_text_line_segment_split (const GtkTextIter *iter)
         + 1 + (chars)))
 #define TSEG_SIZE ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
         + sizeof (GtkTextToggleBody)))
+#define MCSEG_SIZE ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
+        + sizeof (GtkTextMappedBody)))
 
 /*
  * Type functions
@@ -413,6 +415,158 @@ char_segment_check_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
     }
 }
 
+/*
+ * Mapped character segments: the text stays in a read-only
+ * GMappedFile and the segment only points at it, so loading a large
+ * file doesn't copy it. Splitting and merging such segments never
+ * copies either; text inserted later goes into ordinary character
+ * segments next to them.
+ */
+
+static void
+mapped_char_segment_self_check (GtkTextLineSegment *seg)
+{
+  const gchar *contents;
+
+  g_assert (seg != NULL);
+  g_assert (seg->body.mapped.file != NULL);
+
+  if (seg->byte_count <= 0)
+    {
+      g_error ("mapped segment has size <= 0");
+    }
+
+  contents = g_mapped_file_get_contents (seg->body.mapped.file);
+
+  if (seg->body.mapped.chars < contents ||
+      seg->body.mapped.chars + seg->byte_count >
+      contents + g_mapped_file_get_length (seg->body.mapped.file))
+    {
+      g_error ("mapped segment points outside of its mapping");
+    }
+
+  if (!g_utf8_validate (seg->body.mapped.chars, seg->byte_count, NULL))
+    {
+      g_error ("mapped segment contains invalid UTF-8");
+    }
+
+  if (g_utf8_strlen (seg->body.mapped.chars, seg->byte_count) != seg->char_count)
+    {
+      g_error ("mapped segment has wrong character count");
+    }
+}
+
+static GtkTextLineSegment*
+mapped_char_segment_new_with_count (GMappedFile *file,
+                                    const gchar *text,
+                                    guint        len,
+                                    guint        chars)
+{
+  GtkTextLineSegment *seg;
+
+  seg = g_malloc (MCSEG_SIZE);
+  seg->type = &gtk_text_mapped_char_type;
+  seg->next = NULL;
+  seg->byte_count = len;
+  seg->char_count = chars;
+  seg->body.mapped.chars = text;
+  seg->body.mapped.file = g_mapped_file_ref (file);
+
+  if (gtk_debug_flags & GTK_DEBUG_TEXT)
+    mapped_char_segment_self_check (seg);
+
+  return seg;
+}
+
+/* @text must point into @file, be valid UTF-8, and not span
+ * a paragraph delimiter (except at its end).
+ */
+GtkTextLineSegment*
+_gtk_mapped_char_segment_new (GMappedFile *file,
+                              const gchar *text,
+                              guint        len)
+{
+  g_assert (gtk_text_byte_begins_utf8_char (text));
+
+  return mapped_char_segment_new_with_count (file, text, len,
+                                             g_utf8_strlen (text, len));
+}
+
+static GtkTextLineSegment *
+mapped_char_segment_split_func (GtkTextLineSegment *seg, int index)
+{
+  GtkTextLineSegment *new1, *new2;
+  guint chars1;
+
+  g_assert (index < seg->byte_count);
+  g_assert (gtk_text_byte_begins_utf8_char (seg->body.mapped.chars + index));
+
+  chars1 = g_utf8_strlen (seg->body.mapped.chars, index);
+
+  new1 = mapped_char_segment_new_with_count (seg->body.mapped.file,
+                                             seg->body.mapped.chars,
+                                             index, chars1);
+  new2 = mapped_char_segment_new_with_count (seg->body.mapped.file,
+                                             seg->body.mapped.chars + index,
+                                             seg->byte_count - index,
+                                             seg->char_count - chars1);
+
+  new1->next = new2;
+  new2->next = seg->next;
+
+  g_mapped_file_unref (seg->body.mapped.file);
+  g_free (seg);
+  return new1;
+}
+
+/* Merges with the following segments only if they are contiguous
+ * slices of the same mapping, which keeps the merge zero-copy.
+ * The merge happens in place, so all candidates are absorbed here.
+ */
+static GtkTextLineSegment *
+mapped_char_segment_cleanup_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
+{
+  GtkTextLineSegment *segPtr2;
+
+  segPtr2 = segPtr->next;
+  while ((segPtr2 != NULL) &&
+         (segPtr2->type == &gtk_text_mapped_char_type) &&
+         (segPtr2->body.mapped.file == segPtr->body.mapped.file) &&
+         (segPtr2->body.mapped.chars ==
+          segPtr->body.mapped.chars + segPtr->byte_count))
+    {
+      segPtr->byte_count += segPtr2->byte_count;
+      segPtr->char_count += segPtr2->char_count;
+      segPtr->next = segPtr2->next;
+
+      g_mapped_file_unref (segPtr2->body.mapped.file);
+      g_free (segPtr2);
+
+      segPtr2 = segPtr->next;
+    }
+
+  if (gtk_debug_flags & GTK_DEBUG_TEXT)
+    mapped_char_segment_self_check (segPtr);
+
+  return segPtr;
+}
+
+        /* ARGSUSED */
+static int
+mapped_char_segment_delete_func (GtkTextLineSegment *segPtr, GtkTextLine *line, int treeGone)
+{
+  g_mapped_file_unref (segPtr->body.mapped.file);
+  g_free ((char*) segPtr);
+  return 0;
+}
+
+        /* ARGSUSED */
+static void
+mapped_char_segment_check_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
+{
+  mapped_char_segment_self_check (segPtr);
+}
+
 GtkTextLineSegment*
 _gtk_toggle_segment_new (GtkTextTagInfo *info, gboolean on)
 {
@@ -609,6 +763,16 @@ const GtkTextLineSegmentClass gtk_text_char_type = {
   char_segment_check_func                               /* checkFunc */
 };
 
+const GtkTextLineSegmentClass gtk_text_mapped_char_type = {
+  "mapped-character",                   /* name */
+  0,                                            /* leftGravity */
+  mapped_char_segment_split_func,                       /* splitFunc */
+  mapped_char_segment_delete_func,                      /* deleteFunc */
+  mapped_char_segment_cleanup_func,                     /* cleanupFunc */
+  NULL,         /* lineChangeFunc */
+  mapped_char_segment_check_func                        /* checkFunc */
+};
+
 /*
  * Type record for segments marking the beginning of a tagged
  * range:
@@ -61,6 +61,17 @@ struct _GtkTextToggleBody {
                                       * counts; FALSE means it hasn't, yet. */
 };
 
+/* Body of a character segment whose text is not owned by the segment
+ * but lives in a read-only file mapping (see
+ * gtk_text_buffer_set_mapped_file()). The text is not nul-terminated.
+ */
+typedef struct _GtkTextMappedBody GtkTextMappedBody;
+struct _GtkTextMappedBody {
+  const gchar *chars;                /* Start of the text in the mapping */
+  GMappedFile *file;                 /* The mapping; each segment holds
+                                      * a reference on it. */
+};
+
 
 /* Class struct for segments */
 
@@ -144,6 +155,7 @@ struct _GtkTextLineSegment {
     char chars[4];                      /* Characters that make up character
                                          * info.  Actual length varies to
                                          * hold as many characters as needed.*/
+    GtkTextMappedBody mapped;          /* Characters in a file mapping. */
     GtkTextToggleBody toggle;              /* Information about tag toggle. */
     GtkTextMarkBody mark;              /* Information about mark. */
     GtkTextPixbuf pixbuf;              /* Child pixbuf */
@@ -152,6 +164,17 @@ struct _GtkTextLineSegment {
 };
 
 
+/* Character segments come in two flavours, one owning its text and
+ * one referencing a file mapping; most code only cares about the text.
+ */
+#define _GTK_TEXT_SEGMENT_IS_CHARS(seg)                           \
+  ((seg)->type == &gtk_text_char_type ||                          \
+   (seg)->type == &gtk_text_mapped_char_type)
+
+#define _GTK_TEXT_SEGMENT_CHARS(seg)                              \
+  ((seg)->type == &gtk_text_mapped_char_type ?                    \
+   (seg)->body.mapped.chars : (const gchar *) (seg)->body.chars)
+
 GtkTextLineSegment  *gtk_text_line_segment_split (const GtkTextIter *iter);
 
 GtkTextLineSegment *_gtk_char_segment_new                  (const gchar    *text,
@@ -162,6 +185,9 @@ GtkTextLineSegment *_gtk_char_segment_new_from_two_strings (const gchar    *text
                                                             const gchar    *text2,
                                                             guint           len2,
 							    guint           chars2);
+GtkTextLineSegment *_gtk_mapped_char_segment_new           (GMappedFile    *file,
+                                                            const gchar    *text,
+                                                            guint           len);
 GtkTextLineSegment *_gtk_toggle_segment_new                (GtkTextTagInfo *info,
                                                             gboolean        on);
 
@@ -54,6 +54,7 @@ typedef struct _GtkTextMarkBody GtkTextMarkBody;
 
 /* In gtktextbtree.c */
 extern const GtkTextLineSegmentClass gtk_text_char_type;
+extern const GtkTextLineSegmentClass gtk_text_mapped_char_type;
 extern const GtkTextLineSegmentClass gtk_text_toggle_on_type;
 extern const GtkTextLineSegmentClass gtk_text_toggle_off_type;
 
@@ -3631,6 +3631,33 @@ first_validate_callback (gpointer data)
   return FALSE;
 }
 
+/* Validates a screenful around the visible area and around the
+ * insertion point, where the user is likely to go next, before the
+ * rest of the buffer is validated in document order.
+ */
+static void
+gtk_text_view_validate_nearby (GtkTextView *text_view)
+{
+  GtkWidget *widget = GTK_WIDGET (text_view);
+  GtkTextIter iter;
+  gint height;
+
+  height = SCREEN_HEIGHT (widget);
+
+  if (height <= 0 || text_view->first_validate_idle != 0)
+    return;
+
+  gtk_text_view_get_first_para_iter (text_view, &iter);
+  gtk_text_layout_validate_yrange (text_view->layout, &iter,
+                                   - height,
+                                   text_view->first_para_pixels + 2 * height);
+
+  gtk_text_buffer_get_iter_at_mark (get_buffer (text_view), &iter,
+                                    gtk_text_buffer_get_insert (get_buffer (text_view)));
+  gtk_text_layout_validate_yrange (text_view->layout, &iter,
+                                   - height / 2, height / 2);
+}
+
 static gboolean
 incremental_validate_callback (gpointer data)
 {
@@ -3639,6 +3666,7 @@ incremental_validate_callback (gpointer data)
 
   DV(g_print(G_STRLOC"\n"));
   
+  gtk_text_view_validate_nearby (text_view);
   gtk_text_layout_validate (text_view->layout, 2000);
 
   gtk_text_view_update_adjustments (text_view);
@@ -81,6 +81,8 @@ struct _Node {
 
   GList *uifiles;
 
+  GHashTable *children; /* named children, by name */
+
   guint dirty : 1;
   guint expand : 1;  /* used for separators */
   guint popup_accels : 1;
@@ -102,6 +104,14 @@ struct _GtkUIManagerPrivate
   guint update_tag;  
 
   gboolean add_tearoffs;
+
+  /* The last item update_node() inserted into a menu shell or
+   * toolbar, so that filling one item after the other doesn't need
+   * to look up the position of every previous item.
+   */
+  GtkWidget *last_container;
+  GtkWidget *last_item;
+  gint last_pos;
 };
 
 #define NODE_INFO(node) ((Node *)node->data)
@@ -129,6 +139,8 @@ static GtkAction * gtk_ui_manager_real_get_action (GtkUIManager      *manager,
                                                    const gchar       *path);
 static void        queue_update                   (GtkUIManager      *self);
 static void        dirty_all_nodes                (GtkUIManager      *self);
+static void        dirty_action_nodes             (GtkUIManager      *self,
+                                                   GtkActionGroup    *action_group);
 static void        mark_node_dirty                (GNode             *node);
 static GNode     * get_child_node                 (GtkUIManager      *self,
                                                    GNode             *parent,
@@ -738,8 +750,8 @@ gtk_ui_manager_insert_action_group (GtkUIManager   *self,
 		    "object-signal::post-activate", G_CALLBACK (cb_proxy_post_activate), self,
 		    NULL);
 
-  /* dirty all nodes, as action bindings may change */
-  dirty_all_nodes (self);
+  /* dirty the nodes whose action bindings may change */
+  dirty_action_nodes (self, action_group);
 
   g_signal_emit (self, ui_manager_signals[ACTIONS_CHANGED], 0);
 }
@@ -772,10 +784,11 @@ gtk_ui_manager_remove_action_group (GtkUIManager   *self,
                        "any-signal::pre-activate", G_CALLBACK (cb_proxy_pre_activate), self,
                        "any-signal::post-activate", G_CALLBACK (cb_proxy_post_activate), self, 
                        NULL);
-  g_object_unref (action_group);
 
-  /* dirty all nodes, as action bindings may change */
-  dirty_all_nodes (self);
+  /* dirty the nodes whose action bindings may change */
+  dirty_action_nodes (self, action_group);
+
+  g_object_unref (action_group);
 
   g_signal_emit (self, ui_manager_signals[ACTIONS_CHANGED], 0);
 }
@@ -961,6 +974,31 @@ node_is_dead (GNode *node)
   return TRUE;
 }
 
+/* Finds the child of @parent called @childname, which doesn't need to
+ * be nul-terminated.
+ */
+static GNode *
+lookup_child_node (GNode       *parent,
+		   const gchar *childname,
+		   gint         childname_length)
+{
+  GHashTable *children = NODE_INFO (parent)->children;
+  GNode *child;
+  gchar *name;
+
+  if (children == NULL)
+    return NULL;
+
+  if (childname[childname_length] == '\0')
+    return g_hash_table_lookup (children, childname);
+
+  name = g_strndup (childname, childname_length);
+  child = g_hash_table_lookup (children, name);
+  g_free (name);
+
+  return child;
+}
+
 static GNode *
 get_child_node (GtkUIManager *self, 
 		GNode        *parent,
@@ -977,38 +1015,34 @@ get_child_node (GtkUIManager *self,
     {
       if (childname)
 	{
-	  for (child = parent->children; child != NULL; child = child->next)
+	  child = lookup_child_node (parent, childname, childname_length);
+	  if (child)
 	    {
-	      if (NODE_INFO (child)->name &&
-		  strlen (NODE_INFO (child)->name) == childname_length &&
-		  !strncmp (NODE_INFO (child)->name, childname, childname_length))
+	      /* if undecided about node type, set it */
+	      if (NODE_INFO (child)->type == NODE_TYPE_UNDECIDED)
+		NODE_INFO (child)->type = node_type;
+	      
+	      /* warn about type mismatch */
+	      if (NODE_INFO (child)->type != NODE_TYPE_UNDECIDED &&
+		  node_type != NODE_TYPE_UNDECIDED &&
+		  NODE_INFO (child)->type != node_type)
+		g_warning ("node type doesn't match %d (%s is type %d)",
+			   node_type, 
+			   NODE_INFO (child)->name,
+			   NODE_INFO (child)->type);
+
+	      if (node_is_dead (child))
 		{
-		  /* if undecided about node type, set it */
-		  if (NODE_INFO (child)->type == NODE_TYPE_UNDECIDED)
-		    NODE_INFO (child)->type = node_type;
-		  
-		  /* warn about type mismatch */
-		  if (NODE_INFO (child)->type != NODE_TYPE_UNDECIDED &&
-		      node_type != NODE_TYPE_UNDECIDED &&
-		      NODE_INFO (child)->type != node_type)
-		    g_warning ("node type doesn't match %d (%s is type %d)",
-			       node_type, 
-			       NODE_INFO (child)->name,
-			       NODE_INFO (child)->type);
-
-                    if (node_is_dead (child))
-                      {
-                        /* This node was removed but is still dirty so
-                         * it is still in the tree. We want to treat this
-                         * as if it didn't exist, which means we move it
-                         * to the position it would have been created at.
-                         */
-                        g_node_unlink (child);
-                        goto insert_child;
-                      }
-
-		  return child;
+		  /* This node was removed but is still dirty so
+		   * it is still in the tree. We want to treat this
+		   * as if it didn't exist, which means we move it
+		   * to the position it would have been created at.
+		   */
+		  g_node_unlink (child);
+		  goto insert_child;
 		}
+
+	      return child;
 	    }
 	}
       if (!child && create)
@@ -1020,6 +1054,16 @@ get_child_node (GtkUIManager *self,
 	  mnode->name = g_strndup (childname, childname_length);
 
 	  child = g_node_new (mnode);
+
+	  if (mnode->name)
+	    {
+	      Node *info = NODE_INFO (parent);
+
+	      if (!info->children)
+		info->children = g_hash_table_new (g_str_hash, g_str_equal);
+	      g_hash_table_insert (info->children, mnode->name, child);
+	    }
+
 	insert_child:
 	  if (sibling)
 	    {
@@ -1122,6 +1166,11 @@ free_node (GNode *node)
   g_list_foreach (info->uifiles, (GFunc) node_ui_reference_free, NULL);
   g_list_free (info->uifiles);
 
+  if (info->name && node->parent && NODE_INFO (node->parent)->children)
+    g_hash_table_remove (NODE_INFO (node->parent)->children, info->name);
+  if (info->children)
+    g_hash_table_destroy (info->children);
+
   if (info->action)
     g_object_unref (info->action);
   if (info->proxy)
@@ -1954,10 +2003,79 @@ get_action_by_name (GtkUIManager *merge,
   return NULL;
 }
 
+static void
+remember_item (GtkUIManager *self,
+	       GtkWidget    *container,
+	       GtkWidget    *item,
+	       gint          pos)
+{
+  self->private_data->last_container = container;
+  self->private_data->last_item = item;
+  self->private_data->last_pos = pos;
+}
+
+static void
+forget_item (GtkUIManager *self)
+{
+  self->private_data->last_container = NULL;
+  self->private_data->last_item = NULL;
+}
+
+/* Returns the position of @item in @container, which is a menu shell
+ * or a toolbar.
+ */
+static gint
+get_item_position (GtkUIManager *self,
+		   GtkWidget    *container,
+		   GtkWidget    *item)
+{
+  if (item == self->private_data->last_item &&
+      container == self->private_data->last_container)
+    return self->private_data->last_pos;
+
+  if (GTK_IS_TOOLBAR (container))
+    return gtk_toolbar_get_item_index (GTK_TOOLBAR (container),
+				       GTK_TOOL_ITEM (item));
+  else
+    return g_list_index (GTK_MENU_SHELL (container)->children, item);
+}
+
+static void
+insert_menu_item (GtkUIManager *self,
+		  GtkWidget    *menushell,
+		  GtkWidget    *item,
+		  gint          pos)
+{
+  gtk_menu_shell_insert (GTK_MENU_SHELL (menushell), item, pos);
+  remember_item (self, menushell, item, pos);
+}
+
+static void
+insert_tool_item (GtkUIManager *self,
+		  GtkWidget    *toolbar,
+		  GtkToolItem  *item,
+		  gint          pos)
+{
+  gtk_toolbar_insert (GTK_TOOLBAR (toolbar), item, pos);
+  remember_item (self, toolbar, GTK_WIDGET (item), pos);
+}
+
+/* Removing an item moves the ones after it, so forget where the last
+ * one went.
+ */
+static void
+remove_item (GtkUIManager *self,
+	     GtkWidget    *item)
+{
+  forget_item (self);
+  gtk_container_remove (GTK_CONTAINER (item->parent), item);
+}
+
 static gboolean
-find_menu_position (GNode      *node, 
-		    GtkWidget **menushell_p, 
-		    gint       *pos_p)
+find_menu_position (GtkUIManager *self,
+		    GNode        *node, 
+		    GtkWidget   **menushell_p, 
+		    gint         *pos_p)
 {
   GtkWidget *menushell;
   gint pos = 0;
@@ -1998,8 +2116,8 @@ find_menu_position (GNode      *node,
 	case NODE_TYPE_MENU_PLACEHOLDER:
 	  menushell = gtk_widget_get_parent (NODE_INFO (parent)->proxy);
 	  g_return_val_if_fail (GTK_IS_MENU_SHELL (menushell), FALSE);
-	  pos = g_list_index (GTK_MENU_SHELL (menushell)->children,
-			      NODE_INFO (parent)->proxy) + 1;
+	  pos = get_item_position (self, menushell,
+				   NODE_INFO (parent)->proxy) + 1;
 	  break;
 	default:
 	  g_warning ("%s: bad parent node type %d", G_STRLOC,
@@ -2025,7 +2143,7 @@ find_menu_position (GNode      *node,
       if (!GTK_IS_MENU_SHELL (menushell))
         return FALSE;
 
-      pos = g_list_index (GTK_MENU_SHELL (menushell)->children, prev_child) + 1;
+      pos = get_item_position (self, menushell, prev_child) + 1;
     }
 
   if (menushell_p)
@@ -2037,9 +2155,10 @@ find_menu_position (GNode      *node,
 }
 
 static gboolean
-find_toolbar_position (GNode      *node, 
-		       GtkWidget **toolbar_p, 
-		       gint       *pos_p)
+find_toolbar_position (GtkUIManager *self,
+		       GNode        *node, 
+		       GtkWidget   **toolbar_p, 
+		       gint         *pos_p)
 {
   GtkWidget *toolbar;
   gint pos;
@@ -2066,8 +2185,8 @@ find_toolbar_position (GNode      *node,
 	case NODE_TYPE_TOOLBAR_PLACEHOLDER:
 	  toolbar = gtk_widget_get_parent (NODE_INFO (parent)->proxy);
 	  g_return_val_if_fail (GTK_IS_TOOLBAR (toolbar), FALSE);
-	  pos = gtk_toolbar_get_item_index (GTK_TOOLBAR (toolbar),
-					    GTK_TOOL_ITEM (NODE_INFO (parent)->proxy)) + 1;
+	  pos = get_item_position (self, toolbar,
+				   NODE_INFO (parent)->proxy) + 1;
 	  break;
 	default:
 	  g_warning ("%s: bad parent node type %d", G_STRLOC,
@@ -2093,8 +2212,7 @@ find_toolbar_position (GNode      *node,
       if (!GTK_IS_TOOLBAR (toolbar))
         return FALSE;
 
-      pos = gtk_toolbar_get_item_index (GTK_TOOLBAR (toolbar),
-					GTK_TOOL_ITEM (prev_child)) + 1;
+      pos = get_item_position (self, toolbar, prev_child) + 1;
     }
   
   if (toolbar_p)
@@ -2395,8 +2513,7 @@ update_node (GtkUIManager *self,
 	      }
 
             gtk_activatable_set_related_action (GTK_ACTIVATABLE (info->proxy), NULL);
-	    gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
-				  info->proxy);
+	    remove_item (self, info->proxy);
 	    g_object_unref (info->proxy);
 	    info->proxy = NULL;
 	  }
@@ -2445,7 +2562,7 @@ update_node (GtkUIManager *self,
 		GtkWidget *menushell;
 		gint pos;
 		
-		if (find_menu_position (node, &menushell, &pos))
+		if (find_menu_position (self, node, &menushell, &pos))
                   {
 		     info->proxy = gtk_action_create_menu_item (action);
 		     g_object_ref_sink (info->proxy);
@@ -2454,7 +2571,7 @@ update_node (GtkUIManager *self,
 		     gtk_widget_set_name (info->proxy, info->name);
 		
 		     gtk_menu_item_set_submenu (GTK_MENU_ITEM (info->proxy), menu);
-		     gtk_menu_shell_insert (GTK_MENU_SHELL (menushell), info->proxy, pos);
+		     insert_menu_item (self, menushell, info->proxy, pos);
                  }
 	      }
 	  }
@@ -2506,15 +2623,13 @@ update_node (GtkUIManager *self,
 	{
 	  if (info->proxy)
 	    {
-	      gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
-				    info->proxy);
+	      remove_item (self, info->proxy);
 	      g_object_unref (info->proxy);
 	      info->proxy = NULL;
 	    }
 	  if (info->extra)
 	    {
-	      gtk_container_remove (GTK_CONTAINER (info->extra->parent),
-				    info->extra);
+	      remove_item (self, info->extra);
 	      g_object_unref (info->extra);
 	      info->extra = NULL;
 	    }
@@ -2524,7 +2639,7 @@ update_node (GtkUIManager *self,
 	  GtkWidget *menushell;
 	  gint pos;
 	  
-	  if (find_menu_position (node, &menushell, &pos))
+	  if (find_menu_position (self, node, &menushell, &pos))
             {
 	      info->proxy = gtk_separator_menu_item_new ();
 	      g_object_ref_sink (info->proxy);
@@ -2532,8 +2647,7 @@ update_node (GtkUIManager *self,
 	  		         I_("gtk-separator-mode"),
 			         GINT_TO_POINTER (SEPARATOR_MODE_HIDDEN));
 	      gtk_widget_set_no_show_all (info->proxy, TRUE);
-	      gtk_menu_shell_insert (GTK_MENU_SHELL (menushell),
-	 			     NODE_INFO (node)->proxy, pos);
+	      insert_menu_item (self, menushell, info->proxy, pos);
 	  
 	      info->extra = gtk_separator_menu_item_new ();
 	      g_object_ref_sink (info->extra);
@@ -2541,8 +2655,7 @@ update_node (GtkUIManager *self,
 			         I_("gtk-separator-mode"),
 			         GINT_TO_POINTER (SEPARATOR_MODE_HIDDEN));
 	      gtk_widget_set_no_show_all (info->extra, TRUE);
-	      gtk_menu_shell_insert (GTK_MENU_SHELL (menushell),
-				     NODE_INFO (node)->extra, pos + 1);
+	      insert_menu_item (self, menushell, info->extra, pos + 1);
             }
 	}
       break;
@@ -2553,15 +2666,13 @@ update_node (GtkUIManager *self,
 	{
 	  if (info->proxy)
 	    {
-	      gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
-				    info->proxy);
+	      remove_item (self, info->proxy);
 	      g_object_unref (info->proxy);
 	      info->proxy = NULL;
 	    }
 	  if (info->extra)
 	    {
-	      gtk_container_remove (GTK_CONTAINER (info->extra->parent),
-				    info->extra);
+	      remove_item (self, info->extra);
 	      g_object_unref (info->extra);
 	      info->extra = NULL;
 	    }
@@ -2572,10 +2683,10 @@ update_node (GtkUIManager *self,
 	  gint pos;
 	  GtkToolItem *item;    
 	  
-	  if (find_toolbar_position (node, &toolbar, &pos))
+	  if (find_toolbar_position (self, node, &toolbar, &pos))
             {
 	      item = gtk_separator_tool_item_new ();
-	      gtk_toolbar_insert (GTK_TOOLBAR (toolbar), item, pos);
+	      insert_tool_item (self, toolbar, item, pos);
 	      info->proxy = GTK_WIDGET (item);
 	      g_object_ref_sink (info->proxy);
 	      g_object_set_data (G_OBJECT (info->proxy),
@@ -2584,7 +2695,7 @@ update_node (GtkUIManager *self,
 	      gtk_widget_set_no_show_all (info->proxy, TRUE);
 	  
 	      item = gtk_separator_tool_item_new ();
-	      gtk_toolbar_insert (GTK_TOOLBAR (toolbar), item, pos+1);
+	      insert_tool_item (self, toolbar, item, pos+1);
 	      info->extra = GTK_WIDGET (item);
 	      g_object_ref_sink (info->extra);
 	      g_object_set_data (G_OBJECT (info->extra),
@@ -2603,8 +2714,7 @@ update_node (GtkUIManager *self,
 						G_CALLBACK (update_smart_separators),
 						NULL);  
           gtk_activatable_set_related_action (GTK_ACTIVATABLE (info->proxy), NULL);
-	  gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
-				info->proxy);
+	  remove_item (self, info->proxy);
 	  g_object_unref (info->proxy);
 	  info->proxy = NULL;
 	}
@@ -2614,7 +2724,7 @@ update_node (GtkUIManager *self,
 	  GtkWidget *menushell;
 	  gint pos;
 	  
-	  if (find_menu_position (node, &menushell, &pos))
+	  if (find_menu_position (self, node, &menushell, &pos))
             {
 	      info->proxy = gtk_action_create_menu_item (action);
 	      g_object_ref_sink (info->proxy);
@@ -2625,8 +2735,7 @@ update_node (GtkUIManager *self,
                 gtk_image_menu_item_set_always_show_image (GTK_IMAGE_MENU_ITEM (info->proxy),
                                                            info->always_show_image);
 
-	      gtk_menu_shell_insert (GTK_MENU_SHELL (menushell),
-				     info->proxy, pos);
+	      insert_menu_item (self, menushell, info->proxy, pos);
            }
 	}
       else
@@ -2661,8 +2770,7 @@ update_node (GtkUIManager *self,
 						G_CALLBACK (update_smart_separators),
 						NULL);
           gtk_activatable_set_related_action (GTK_ACTIVATABLE (info->proxy), NULL);
-	  gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
-				info->proxy);
+	  remove_item (self, info->proxy);
 	  g_object_unref (info->proxy);
 	  info->proxy = NULL;
 	}
@@ -2672,14 +2780,13 @@ update_node (GtkUIManager *self,
 	  GtkWidget *toolbar;
 	  gint pos;
 	  
-	  if (find_toolbar_position (node, &toolbar, &pos))
+	  if (find_toolbar_position (self, node, &toolbar, &pos))
             {
 	      info->proxy = gtk_action_create_tool_item (action);
 	      g_object_ref_sink (info->proxy);
 	      gtk_widget_set_name (info->proxy, info->name);
 	      
-	      gtk_toolbar_insert (GTK_TOOLBAR (toolbar),
-	  		          GTK_TOOL_ITEM (info->proxy), pos);
+	      insert_tool_item (self, toolbar, GTK_TOOL_ITEM (info->proxy), pos);
             }
 	}
       else
@@ -2707,16 +2814,15 @@ update_node (GtkUIManager *self,
 
 	  if (GTK_IS_SEPARATOR_TOOL_ITEM (info->proxy))
 	    {
-	      gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
-				    info->proxy);
+	      remove_item (self, info->proxy);
 	      g_object_unref (info->proxy);
 	      info->proxy = NULL;
 	    }
 	  
-	  if (find_toolbar_position (node, &toolbar, &pos))
+	  if (find_toolbar_position (self, node, &toolbar, &pos))
             {
 	      item  = gtk_separator_tool_item_new ();
-	      gtk_toolbar_insert (GTK_TOOLBAR (toolbar), item, pos);
+	      insert_tool_item (self, toolbar, item, pos);
 	      info->proxy = GTK_WIDGET (item);
 	      g_object_ref_sink (info->proxy);
 	      gtk_widget_set_no_show_all (info->proxy, TRUE);
@@ -2742,13 +2848,12 @@ update_node (GtkUIManager *self,
 	  
 	  if (GTK_IS_SEPARATOR_MENU_ITEM (info->proxy))
 	    {
-	      gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
-				    info->proxy);
+	      remove_item (self, info->proxy);
 	      g_object_unref (info->proxy);
 	      info->proxy = NULL;
 	    }
 	  
-	  if (find_menu_position (node, &menushell, &pos))
+	  if (find_menu_position (self, node, &menushell, &pos))
 	    {
               info->proxy = gtk_separator_menu_item_new ();
 	      g_object_ref_sink (info->proxy);
@@ -2756,8 +2861,7 @@ update_node (GtkUIManager *self,
 	      g_object_set_data (G_OBJECT (info->proxy),
 			         I_("gtk-separator-mode"),
 			         GINT_TO_POINTER (SEPARATOR_MODE_SMART));
-	      gtk_menu_shell_insert (GTK_MENU_SHELL (menushell),
-				     info->proxy, pos);
+	      insert_menu_item (self, menushell, info->proxy, pos);
 	      gtk_widget_show (info->proxy);
             }
 	}
@@ -2798,6 +2902,7 @@ update_node (GtkUIManager *self,
   /* handle cleanup of dead nodes */
   if (node->children == NULL && info->uifiles == NULL)
     {
+      forget_item (self);
       if (info->proxy)
 	gtk_widget_destroy (info->proxy);
       if (info->extra)
@@ -2824,7 +2929,9 @@ do_updates (GtkUIManager *self)
    *    the proxy is reconnected to the new action (or a new proxy widget
    *    is created and added to the parent container).
    */
+  forget_item (self);
   update_node (self, self->private_data->root_node, FALSE, FALSE);
+  forget_item (self);
 
   self->private_data->update_tag = 0;
 
@@ -2900,6 +3007,58 @@ dirty_all_nodes (GtkUIManager *self)
   queue_update (self);
 }
 
+static gboolean
+dirty_action_traverse_func (GNode   *node,
+			    gpointer data)
+{
+  GtkActionGroup *action_group = data;
+  GtkActionGroup *bound_group;
+  NodeUIReference *ref;
+
+  if (NODE_INFO (node)->uifiles == NULL)
+    return FALSE;
+
+  ref = NODE_INFO (node)->uifiles->data;
+  if (ref->action_quark != 0 &&
+      gtk_action_group_get_action (action_group,
+				   g_quark_to_string (ref->action_quark)))
+    {
+      mark_node_dirty (node);
+      return FALSE;
+    }
+
+  /* The bound action may have been removed from @action_group
+   * already, but it still points back to it.
+   */
+  if (NODE_INFO (node)->action)
+    {
+      g_object_get (NODE_INFO (node)->action,
+		    "action-group", &bound_group,
+		    NULL);
+      if (bound_group == action_group)
+	mark_node_dirty (node);
+      if (bound_group)
+	g_object_unref (bound_group);
+    }
+
+  return FALSE;
+}
+
+/* Only the nodes for actions of @action_group, and the ones bound to
+ * an action that belonged to it, can be bound to another action when
+ * it is added or removed, so the other ones keep their proxies
+ * without being visited again.
+ */
+static void
+dirty_action_nodes (GtkUIManager   *self,
+		    GtkActionGroup *action_group)
+{
+  g_node_traverse (self->private_data->root_node,
+		   G_PRE_ORDER, G_TRAVERSE_ALL, -1,
+		   dirty_action_traverse_func, action_group);
+  queue_update (self);
+}
+
 static void
 mark_node_dirty (GNode *node)
 {
@@ -364,6 +364,7 @@ static guint            widget_signals[LAST_SIGNAL] = { 0 };
 static GtkStyle        *gtk_default_style = NULL;
 static GSList          *colormap_stack = NULL;
 static guint            composite_child_stack = 0;
+static guint            path_serial = 0;
 static GtkTextDirection gtk_default_direction = GTK_TEXT_DIR_LTR;
 static GParamSpecPool  *style_property_spec_pool = NULL;
 
@@ -3216,6 +3217,7 @@ gtk_widget_unparent (GtkWidget *widget)
     
   old_parent = widget->parent;
   widget->parent = NULL;
+  path_serial++;
   gtk_widget_set_parent_window (widget, NULL);
   g_signal_emit (widget, widget_signals[PARENT_SET], 0, old_parent);
   if (toplevel)
@@ -5956,6 +5958,7 @@ gtk_widget_set_name (GtkWidget	 *widget,
   new_name = g_strdup (name);
   g_free (widget->name);
   widget->name = new_name;
+  path_serial++;
 
   if (gtk_widget_has_rc_style (widget))
     gtk_widget_reset_rc_style (widget);
@@ -6566,6 +6569,7 @@ gtk_widget_set_parent (GtkWidget *widget,
 
   g_object_ref_sink (widget);
   widget->parent = parent;
+  path_serial++;
 
   if (gtk_widget_get_state (parent) != GTK_STATE_NORMAL)
     data.state = gtk_widget_get_state (parent);
@@ -10307,6 +10311,15 @@ gtk_widget_path (GtkWidget *widget,
     }
 }
 
+/* Changes whenever the result of gtk_widget_path() may have changed
+ * for some widget, since widget names or parents have changed.
+ */
+guint
+_gtk_widget_get_path_serial (void)
+{
+  return path_serial;
+}
+
 /**
  * gtk_widget_class_path:
  * @widget: a #GtkWidget
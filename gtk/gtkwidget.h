@@ -1348,6 +1348,8 @@ void       _gtk_widget_synthesize_crossing (GtkWidget      *from,
 
 GdkColormap* _gtk_widget_peek_colormap (void);
 
+guint        _gtk_widget_get_path_serial (void);
+
 void         _gtk_widget_buildable_finish_accelerator (GtkWidget *widget,
 						       GtkWidget *toplevel,
 						       gpointer   user_data);
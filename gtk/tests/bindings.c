@@ -0,0 +1,137 @@
+/* GTK - The GIMP Toolkit
+ * bindings.c: Check that key bindings follow widget and binding changes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+#include <gdk/gdkkeysyms.h>
+
+static gboolean
+show_help_cb (GtkWidget        *widget,
+              GtkWidgetHelpType help_type,
+              gpointer          data)
+{
+  gint *count = data;
+
+  (*count)++;
+
+  return TRUE;
+}
+
+static void
+add_show_help (GtkBindingSet *binding_set,
+               guint          keyval)
+{
+  gtk_binding_entry_add_signal (binding_set, keyval, 0,
+                                "show-help", 1,
+                                GTK_TYPE_WIDGET_HELP_TYPE,
+                                GTK_WIDGET_HELP_WHATS_THIS);
+}
+
+static void
+test_widget_path (void)
+{
+  GtkBindingSet *binding_set;
+  GtkWidget *box, *label;
+  gint count = 0;
+
+  binding_set = gtk_binding_set_new ("test-widget-path");
+  add_show_help (binding_set, GDK_F5);
+  add_show_help (binding_set, GDK_F6);
+  gtk_binding_set_add_path (binding_set, GTK_PATH_WIDGET,
+                            "*.test-bound", GTK_PATH_PRIO_APPLICATION);
+
+  box = g_object_ref_sink (gtk_event_box_new ());
+  gtk_widget_set_name (box, "test-outer");
+  label = g_object_ref_sink (gtk_label_new (NULL));
+  gtk_widget_set_name (label, "test-bound");
+  g_signal_connect (label, "show-help", G_CALLBACK (show_help_cb), &count);
+
+  /* A lone widget's path is just its name */
+  g_assert (!gtk_bindings_activate (GTK_OBJECT (label), GDK_F5, 0));
+  g_assert_cmpint (count, ==, 0);
+
+  gtk_container_add (GTK_CONTAINER (box), label);
+  g_assert (gtk_bindings_activate (GTK_OBJECT (label), GDK_F5, 0));
+  g_assert (gtk_bindings_activate (GTK_OBJECT (label), GDK_F5, 0));
+  g_assert (gtk_bindings_activate (GTK_OBJECT (label), GDK_F6, 0));
+  g_assert_cmpint (count, ==, 3);
+
+  /* Renaming the widget or an ancestor is noticed */
+  gtk_widget_set_name (label, "test-other");
+  g_assert (!gtk_bindings_activate (GTK_OBJECT (label), GDK_F5, 0));
+  gtk_widget_set_name (label, "test-bound");
+  gtk_container_remove (GTK_CONTAINER (box), label);
+  g_assert (!gtk_bindings_activate (GTK_OBJECT (label), GDK_F5, 0));
+  g_assert_cmpint (count, ==, 3);
+
+  /* So are changes to the bindings */
+  gtk_container_add (GTK_CONTAINER (box), label);
+  g_assert (gtk_bindings_activate (GTK_OBJECT (label), GDK_F5, 0));
+  gtk_binding_entry_remove (binding_set, GDK_F5, 0);
+  g_assert (!gtk_bindings_activate (GTK_OBJECT (label), GDK_F5, 0));
+  g_assert (gtk_bindings_activate (GTK_OBJECT (label), GDK_F6, 0));
+  g_assert_cmpint (count, ==, 5);
+
+  g_object_unref (label);
+  g_object_unref (box);
+}
+
+static void
+test_skip (void)
+{
+  GtkBindingSet *binding_set, *skip_set;
+  GtkWidget *label;
+  gint count = 0;
+
+  binding_set = gtk_binding_set_new ("test-skip");
+  add_show_help (binding_set, GDK_F7);
+  gtk_binding_set_add_path (binding_set, GTK_PATH_CLASS,
+                            "GtkWidget", GTK_PATH_PRIO_APPLICATION);
+
+  label = g_object_ref_sink (gtk_label_new (NULL));
+  g_signal_connect (label, "show-help", G_CALLBACK (show_help_cb), &count);
+
+  g_assert (gtk_bindings_activate (GTK_OBJECT (label), GDK_F7, 0));
+  g_assert_cmpint (count, ==, 1);
+
+  /* A skip in a set with a higher priority hides the binding */
+  skip_set = gtk_binding_set_new ("test-skip-label");
+  gtk_binding_entry_skip (skip_set, GDK_F7, 0);
+  gtk_binding_set_add_path (skip_set, GTK_PATH_CLASS,
+                            "GtkLabel", GTK_PATH_PRIO_HIGHEST);
+
+  g_assert (!gtk_bindings_activate (GTK_OBJECT (label), GDK_F7, 0));
+  g_assert_cmpint (count, ==, 1);
+
+  gtk_binding_entry_remove (skip_set, GDK_F7, 0);
+  g_assert (gtk_bindings_activate (GTK_OBJECT (label), GDK_F7, 0));
+  g_assert_cmpint (count, ==, 2);
+
+  g_object_unref (label);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/bindings/widget-path", test_widget_path);
+  g_test_add_func ("/bindings/skip", test_skip);
+
+  return g_test_run ();
+}
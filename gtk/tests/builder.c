@@ -20,10 +20,12 @@
  */
 
 #include <string.h>
+#include <unistd.h>
 #include <libintl.h>
 #include <locale.h>
 #include <math.h>
 
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
 
@@ -2576,6 +2578,372 @@ test_message_area (void)
   g_object_unref (builder);
 }
 
+static void
+record_signal (GtkBuilder    *builder,
+               GObject       *object,
+               const gchar   *signal_name,
+               const gchar   *handler_name,
+               GObject       *connect_object,
+               GConnectFlags  flags,
+               gpointer       user_data)
+{
+  g_string_append_printf (user_data, "%s ", handler_name);
+  if (connect_object)
+    g_string_append_printf (user_data, "(%s) ",
+                            gtk_buildable_get_name (GTK_BUILDABLE (connect_object)));
+}
+
+static gboolean
+has_object (GtkBuilder  *builder,
+            const gchar *name)
+{
+  GSList *objects, *l;
+  gboolean found = FALSE;
+
+  objects = gtk_builder_get_objects (builder);
+  for (l = objects; l; l = l->next)
+    {
+      if (GTK_IS_BUILDABLE (l->data) &&
+          g_strcmp0 (gtk_buildable_get_name (l->data), name) == 0)
+        found = TRUE;
+    }
+  g_slist_free (objects);
+
+  return found;
+}
+
+static void
+test_deferred (void)
+{
+  GtkBuilder *builder;
+  GError *error = NULL;
+  GObject *obj, *view;
+  GString *signals;
+  const gchar buffer[] =
+    "<interface>"
+    "  <object class=\"GtkListStore\" id=\"liststore1\" deferred=\"yes\">"
+    "    <columns>"
+    "      <column type=\"gchararray\"/>"
+    "    </columns>"
+    "  </object>"
+    "  <object class=\"GtkWindow\" id=\"window1\">"
+    "    <signal name=\"destroy\" handler=\"window_destroyed\"/>"
+    "    <child>"
+    "      <object class=\"GtkTreeView\" id=\"treeview1\">"
+    "        <property name=\"model\">liststore1</property>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "  <object class=\"GtkDialog\" id=\"dialog1\" deferred=\"yes\">"
+    "    <property name=\"title\">Deferred</property>"
+    "    <signal name=\"response\" handler=\"dialog_response\"/>"
+    "    <child internal-child=\"vbox\">"
+    "      <object class=\"GtkVBox\" id=\"dialog-vbox1\">"
+    "        <child>"
+    "          <object class=\"GtkLabel\" id=\"label1\">"
+    "            <property name=\"label\">Label</property>"
+    "          </object>"
+    "        </child>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "</interface>";
+  const gchar buffer2[] =
+    "<interface>"
+    "  <object class=\"GtkWindow\" id=\"window1\">"
+    "    <child>"
+    "      <object class=\"GtkLabel\" id=\"label1\" deferred=\"yes\"/>"
+    "    </child>"
+    "  </object>"
+    "</interface>";
+  const gchar buffer3[] =
+    "<interface>"
+    "  <object class=\"GtkWindow\" id=\"window1\">"
+    "    <child>"
+    "      <object class=\"GtkTreeView\" id=\"treeview1\">"
+    "        <property name=\"model\">liststore1</property>"
+    "        <signal name=\"row-activated\" handler=\"row_activated\" object=\"liststore2\"/>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "  <object class=\"GtkListStore\" id=\"liststore1\" deferred=\"yes\">"
+    "    <columns>"
+    "      <column type=\"gchararray\"/>"
+    "    </columns>"
+    "  </object>"
+    "  <object class=\"GtkListStore\" id=\"liststore2\" deferred=\"yes\">"
+    "    <columns>"
+    "      <column type=\"gchararray\"/>"
+    "    </columns>"
+    "  </object>"
+    "</interface>";
+
+  builder = builder_new_from_string (buffer, -1, NULL);
+  g_assert (!has_object (builder, "dialog1"));
+  g_assert (!has_object (builder, "label1"));
+
+  /* Objects referred to by others are built along with them */
+  view = gtk_builder_get_object (builder, "treeview1");
+  g_assert (GTK_IS_TREE_VIEW (view));
+  g_assert (has_object (builder, "liststore1"));
+  g_assert (gtk_tree_view_get_model (GTK_TREE_VIEW (view)) ==
+            GTK_TREE_MODEL (gtk_builder_get_object (builder, "liststore1")));
+
+  signals = g_string_new ("");
+  gtk_builder_connect_signals_full (builder, record_signal, signals);
+  g_assert_cmpstr (signals->str, ==, "window_destroyed ");
+
+  /* Asking for any object inside builds the whole deferred object */
+  obj = gtk_builder_get_object (builder, "label1");
+  g_assert (GTK_IS_LABEL (obj));
+  g_assert (has_object (builder, "dialog1"));
+  g_assert_cmpstr (gtk_window_get_title (GTK_WINDOW (gtk_builder_get_object (builder, "dialog1"))),
+                   ==, "Deferred");
+
+  /* Signals were connected before, so theirs are connected now */
+  g_assert_cmpstr (signals->str, ==, "window_destroyed dialog_response ");
+  gtk_builder_connect_signals_full (builder, record_signal, signals);
+  g_assert_cmpstr (signals->str, ==, "window_destroyed dialog_response ");
+
+  gtk_widget_destroy (GTK_WIDGET (gtk_builder_get_object (builder, "dialog1")));
+  gtk_widget_destroy (GTK_WIDGET (gtk_builder_get_object (builder, "window1")));
+  g_object_unref (builder);
+  g_string_free (signals, TRUE);
+
+  /* References to deferred objects further down are resolved too,
+   * for properties and for signals alike
+   */
+  builder = builder_new_from_string (buffer3, -1, NULL);
+  view = gtk_builder_get_object (builder, "treeview1");
+  g_assert (has_object (builder, "liststore1"));
+  g_assert (gtk_tree_view_get_model (GTK_TREE_VIEW (view)) ==
+            GTK_TREE_MODEL (gtk_builder_get_object (builder, "liststore1")));
+  g_assert (!has_object (builder, "liststore2"));
+
+  signals = g_string_new ("");
+  gtk_builder_connect_signals_full (builder, record_signal, signals);
+  g_assert_cmpstr (signals->str, ==, "row_activated (liststore2) ");
+  g_assert (has_object (builder, "liststore2"));
+
+  gtk_widget_destroy (GTK_WIDGET (gtk_builder_get_object (builder, "window1")));
+  g_object_unref (builder);
+  g_string_free (signals, TRUE);
+
+  /* Only toplevels can be deferred */
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_string (builder, buffer2, -1, &error);
+  g_assert (g_error_matches (error,
+                             GTK_BUILDER_ERROR,
+                             GTK_BUILDER_ERROR_INVALID_ATTRIBUTE));
+  g_error_free (error);
+  g_object_unref (builder);
+}
+
+static gchar *
+compile_string (const gchar  *buffer,
+                GError      **error)
+{
+  GtkBuilder *builder;
+  gchar *name, *filename, *compiled;
+  gboolean retval;
+
+  name = g_strdup_printf ("builder-%d.ui", (int) getpid ());
+  filename = g_build_filename (g_get_tmp_dir (), name, NULL);
+  compiled = g_strconcat (filename, "c", NULL);
+  g_assert (g_file_set_contents (filename, buffer, -1, NULL));
+
+  builder = gtk_builder_new ();
+  retval = gtk_builder_compile_file (builder, filename, compiled, error);
+  g_object_unref (builder);
+
+  g_remove (filename);
+  g_free (filename);
+  g_free (name);
+
+  if (!retval)
+    {
+      g_free (compiled);
+      return NULL;
+    }
+
+  return compiled;
+}
+
+static void
+test_compiled (void)
+{
+  GtkBuilder *builder;
+  GError *error;
+  GObject *window, *vbox, *label, *store;
+  GtkTreeIter iter;
+  gchar *compiled, *contents, *title, *text;
+  gsize length;
+  gint width, padding;
+  gfloat xalign;
+  gboolean modal;
+  GdkWindowTypeHint type_hint;
+  gchar *objects[] = { "liststore1", NULL };
+  const gchar buffer[] =
+    "<interface>"
+    "  <object class=\"GtkWindow\" id=\"window1\">"
+    "    <property name=\"title\" translatable=\"yes\">Compiled</property>"
+    "    <property name=\"default_width\">200</property>"
+    "    <property name=\"type_hint\">dialog</property>"
+    "    <property name=\"modal\">True</property>"
+    "    <signal name=\"destroy\" handler=\"gtk_main_quit\"/>"
+    "    <child>"
+    "      <object class=\"GtkVBox\" id=\"vbox1\">"
+    "        <child>"
+    "          <object class=\"GtkLabel\" id=\"label1\">"
+    "            <property name=\"label\">A &amp; B</property>"
+    "            <property name=\"xalign\">0.25</property>"
+    "          </object>"
+    "          <packing>"
+    "            <property name=\"padding\">3</property>"
+    "          </packing>"
+    "        </child>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "  <object class=\"GtkListStore\" id=\"liststore1\">"
+    "    <columns>"
+    "      <column type=\"gchararray\"/>"
+    "    </columns>"
+    "    <data>"
+    "      <row>"
+    "        <col id=\"0\">&lt;row&gt;</col>"
+    "      </row>"
+    "    </data>"
+    "  </object>"
+    "</interface>";
+  const gchar buffer2[] =
+    "<interface>"
+    "  <object class=\"GtkWindow\"/>"
+    "</interface>";
+
+  error = NULL;
+  compiled = compile_string (buffer, &error);
+  g_assert (compiled != NULL);
+  g_assert (error == NULL);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_file (builder, compiled, &error);
+  g_assert (error == NULL);
+
+  window = gtk_builder_get_object (builder, "window1");
+  g_assert (GTK_IS_WINDOW (window));
+  g_object_get (window,
+                "title", &title,
+                "default-width", &width,
+                "type-hint", &type_hint,
+                "modal", &modal,
+                NULL);
+  g_assert_cmpstr (title, ==, "Compiled");
+  g_assert_cmpint (width, ==, 200);
+  g_assert_cmpint (type_hint, ==, GDK_WINDOW_TYPE_HINT_DIALOG);
+  g_assert (modal);
+  g_free (title);
+
+  vbox = gtk_builder_get_object (builder, "vbox1");
+  label = gtk_builder_get_object (builder, "label1");
+  g_assert (gtk_widget_get_parent (GTK_WIDGET (label)) == GTK_WIDGET (vbox));
+  g_assert_cmpstr (gtk_label_get_label (GTK_LABEL (label)), ==, "A & B");
+  g_object_get (label, "xalign", &xalign, NULL);
+  g_assert_cmpfloat (xalign, ==, 0.25);
+
+  /* Custom tags are kept as markup */
+  gtk_container_child_get (GTK_CONTAINER (vbox), GTK_WIDGET (label),
+                           "padding", &padding, NULL);
+  g_assert_cmpint (padding, ==, 3);
+
+  store = gtk_builder_get_object (builder, "liststore1");
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &text, -1);
+  g_assert_cmpstr (text, ==, "<row>");
+  g_free (text);
+
+  gtk_widget_destroy (GTK_WIDGET (window));
+  g_object_unref (builder);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_objects_from_file (builder, compiled, objects, &error);
+  g_assert (error == NULL);
+  g_assert (gtk_builder_get_object (builder, "window1") == NULL);
+  g_assert (GTK_IS_LIST_STORE (gtk_builder_get_object (builder, "liststore1")));
+  g_object_unref (builder);
+
+  /* Truncated files are rejected */
+  g_assert (g_file_get_contents (compiled, &contents, &length, NULL));
+  g_assert (g_file_set_contents (compiled, contents, length - 3, NULL));
+  g_free (contents);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_file (builder, compiled, &error);
+  g_assert (g_error_matches (error,
+                             GTK_BUILDER_ERROR,
+                             GTK_BUILDER_ERROR_INVALID_VALUE));
+  g_error_free (error);
+  error = NULL;
+  g_object_unref (builder);
+
+  g_remove (compiled);
+  g_free (compiled);
+
+  /* Only malformed markup fails to compile */
+  compiled = compile_string ("<interface>", &error);
+  g_assert (compiled == NULL);
+  g_assert (error->domain == G_MARKUP_ERROR);
+  g_error_free (error);
+  error = NULL;
+
+  compiled = compile_string (buffer2, &error);
+  g_assert (compiled != NULL);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_file (builder, compiled, &error);
+  g_assert (g_error_matches (error,
+                             GTK_BUILDER_ERROR,
+                             GTK_BUILDER_ERROR_MISSING_ATTRIBUTE));
+  g_error_free (error);
+  g_object_unref (builder);
+
+  g_remove (compiled);
+  g_free (compiled);
+}
+
+static void
+test_compiled_lines (void)
+{
+  GtkBuilder *builder;
+  GError *error = NULL;
+  gchar *compiled;
+  const gchar buffer[] =
+    "<interface>\n"
+    "  <object class=\"GtkUIManager\" id=\"uimgr1\">\n"
+    "    <ui>\n"
+    "      <menubar name=\"menubar1\"\n"
+    "               action=\"file\">\n"
+    "        <bogus/>\n"
+    "      </menubar>\n"
+    "    </ui>\n"
+    "  </object>\n"
+    "</interface>\n";
+
+  compiled = compile_string (buffer, &error);
+  g_assert (compiled != NULL);
+
+  /* Errors in custom tags point at the source file */
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_file (builder, compiled, &error);
+  g_assert (error != NULL);
+  g_assert (strstr (error->message, "on line 6 ") != NULL);
+  g_error_free (error);
+  g_object_unref (builder);
+
+  g_remove (compiled);
+  g_free (compiled);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -2622,6 +2990,9 @@ main (int argc, char **argv)
   g_test_add_func ("/Builder/Menus", test_menus);
   g_test_add_func ("/Builder/MessageArea", test_message_area);
   g_test_add_func ("/Builder/MessageDialog", test_message_dialog);
+  g_test_add_func ("/Builder/Deferred", test_deferred);
+  g_test_add_func ("/Builder/Compiled", test_compiled);
+  g_test_add_func ("/Builder/Compiled Lines", test_compiled_lines);
 
   return g_test_run();
 }
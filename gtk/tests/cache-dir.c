@@ -0,0 +1,57 @@
+#include "config.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <unistd.h>
+
+static gchar *cache_dir = NULL;
+
+static void
+remove_dir (const gchar *path)
+{
+  GDir *dir;
+  const gchar *name;
+  gchar *child;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir == NULL)
+    {
+      g_remove (path);
+      return;
+    }
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      child = g_build_filename (path, name, NULL);
+      remove_dir (child);
+      g_free (child);
+    }
+  g_dir_close (dir);
+
+  g_rmdir (path);
+}
+
+/* Points XDG_CACHE_HOME to a directory of the test's own, so that
+ * whatever GTK+ caches stays out of the real cache directory. Has to
+ * be called before gtk_test_init().
+ */
+const gchar *
+cache_dir_init (const gchar *prefix)
+{
+  gchar *name;
+
+  name = g_strdup_printf ("%s-cache-%d", prefix, (int) getpid ());
+  cache_dir = g_build_filename (g_get_tmp_dir (), name, NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+  g_free (name);
+
+  return cache_dir;
+}
+
+void
+cache_dir_cleanup (void)
+{
+  remove_dir (cache_dir);
+  g_free (cache_dir);
+  cache_dir = NULL;
+}
@@ -0,0 +1,242 @@
+/* GTK - The GIMP Toolkit
+ * iconfactory.c: Check rendering and caching of icons
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+/* An odd width, so that rows don't end on whole vectors */
+static GdkPixbuf *
+create_pixbuf (gboolean has_alpha)
+{
+  GdkPixbuf *pixbuf;
+  guchar *pixels, *p;
+  gint x, y, n_channels, rowstride;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, 37, 20);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  for (y = 0; y < 20; y++)
+    for (x = 0; x < 37; x++)
+      {
+        p = pixels + y * rowstride + x * n_channels;
+        p[0] = x * 7;
+        p[1] = y * 13;
+        p[2] = (x * y) % 256;
+        if (has_alpha)
+          p[3] = 255 - x;
+      }
+
+  return pixbuf;
+}
+
+static GtkIconSource *
+create_source (GdkPixbuf *pixbuf)
+{
+  GtkIconSource *source = gtk_icon_source_new ();
+
+  gtk_icon_source_set_pixbuf (source, pixbuf);
+
+  return source;
+}
+
+static void
+assert_pixbufs_close (GdkPixbuf *a,
+                      GdkPixbuf *b)
+{
+  gint width, height, n_channels, x, y, c;
+  guchar *pa, *pb;
+
+  width = gdk_pixbuf_get_width (a);
+  height = gdk_pixbuf_get_height (a);
+  n_channels = gdk_pixbuf_get_n_channels (a);
+
+  g_assert_cmpint (gdk_pixbuf_get_width (b), ==, width);
+  g_assert_cmpint (gdk_pixbuf_get_height (b), ==, height);
+  g_assert_cmpint (gdk_pixbuf_get_n_channels (b), ==, n_channels);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        pa = gdk_pixbuf_get_pixels (a) + y * gdk_pixbuf_get_rowstride (a) + x * n_channels;
+        pb = gdk_pixbuf_get_pixels (b) + y * gdk_pixbuf_get_rowstride (b) + x * n_channels;
+
+        for (c = 0; c < n_channels; c++)
+          g_assert_cmpint (abs (pa[c] - pb[c]), <=, 3);
+      }
+}
+
+static void
+check_effects (gboolean has_alpha)
+{
+  GdkPixbuf *pixbuf, *rendered, *expected;
+  GtkIconSource *source;
+  GtkStyle *style;
+
+  pixbuf = create_pixbuf (has_alpha);
+  source = create_source (pixbuf);
+  style = gtk_style_new ();
+
+  rendered = gtk_style_render_icon (style, source, GTK_TEXT_DIR_NONE,
+                                    GTK_STATE_INSENSITIVE, -1, NULL, NULL);
+  expected = gdk_pixbuf_copy (pixbuf);
+  gdk_pixbuf_saturate_and_pixelate (pixbuf, expected, 0.8, TRUE);
+  assert_pixbufs_close (rendered, expected);
+  g_object_unref (expected);
+  g_object_unref (rendered);
+
+  rendered = gtk_style_render_icon (style, source, GTK_TEXT_DIR_NONE,
+                                    GTK_STATE_PRELIGHT, -1, NULL, NULL);
+  expected = gdk_pixbuf_copy (pixbuf);
+  gdk_pixbuf_saturate_and_pixelate (pixbuf, expected, 1.2, FALSE);
+  assert_pixbufs_close (rendered, expected);
+  g_object_unref (expected);
+  g_object_unref (rendered);
+
+  /* Other states are left alone */
+  rendered = gtk_style_render_icon (style, source, GTK_TEXT_DIR_NONE,
+                                    GTK_STATE_ACTIVE, -1, NULL, NULL);
+  g_assert (rendered == pixbuf);
+  g_object_unref (rendered);
+
+  g_object_unref (style);
+  gtk_icon_source_free (source);
+  g_object_unref (pixbuf);
+}
+
+static void
+test_effects_rgba (void)
+{
+  check_effects (TRUE);
+}
+
+static void
+test_effects_rgb (void)
+{
+  check_effects (FALSE);
+}
+
+static void
+test_shared (void)
+{
+  GdkPixbuf *pixbuf, *rendered1, *rendered2;
+  GtkIconSource *source;
+  GtkStyle *style1, *style2;
+
+  pixbuf = create_pixbuf (TRUE);
+  source = create_source (pixbuf);
+  style1 = gtk_style_new ();
+  style2 = gtk_style_new ();
+
+  /* Styles render the same icon the same way, but each caller gets
+   * a pixbuf of its own that it may change.
+   */
+  rendered1 = gtk_style_render_icon (style1, source, GTK_TEXT_DIR_NONE,
+                                     GTK_STATE_INSENSITIVE, GTK_ICON_SIZE_MENU,
+                                     NULL, NULL);
+  rendered2 = gtk_style_render_icon (style2, source, GTK_TEXT_DIR_NONE,
+                                     GTK_STATE_INSENSITIVE, GTK_ICON_SIZE_MENU,
+                                     NULL, NULL);
+  g_assert (rendered1 != rendered2);
+  assert_pixbufs_close (rendered1, rendered2);
+  gdk_pixbuf_fill (rendered2, 0);
+  g_object_unref (rendered2);
+
+  rendered2 = gtk_style_render_icon (style2, source, GTK_TEXT_DIR_NONE,
+                                     GTK_STATE_INSENSITIVE, GTK_ICON_SIZE_MENU,
+                                     NULL, NULL);
+  assert_pixbufs_close (rendered1, rendered2);
+  g_object_unref (rendered2);
+
+  rendered2 = gtk_style_render_icon (style2, source, GTK_TEXT_DIR_NONE,
+                                     GTK_STATE_PRELIGHT, GTK_ICON_SIZE_MENU,
+                                     NULL, NULL);
+  g_assert (rendered1 != rendered2);
+  g_object_unref (rendered2);
+
+  rendered2 = gtk_style_render_icon (style2, source, GTK_TEXT_DIR_NONE,
+                                     GTK_STATE_INSENSITIVE, GTK_ICON_SIZE_DIALOG,
+                                     NULL, NULL);
+  g_assert (rendered1 != rendered2);
+  g_object_unref (rendered2);
+
+  /* Rendered icons go with their source */
+  g_object_add_weak_pointer (G_OBJECT (rendered1), (gpointer *) &rendered1);
+  g_object_add_weak_pointer (G_OBJECT (pixbuf), (gpointer *) &pixbuf);
+  g_object_unref (rendered1);
+  g_assert (rendered1 == NULL);
+  gtk_icon_source_free (source);
+  g_object_unref (pixbuf);
+  g_assert (pixbuf == NULL);
+
+  g_object_unref (style1);
+  g_object_unref (style2);
+}
+
+static void
+test_icon_set (void)
+{
+  static const GtkIconSize sizes[] = {
+    GTK_ICON_SIZE_MENU, GTK_ICON_SIZE_BUTTON, GTK_ICON_SIZE_DIALOG
+  };
+  GdkPixbuf *pixbuf, *rendered[G_N_ELEMENTS (sizes)][5], *again;
+  GtkIconSet *icon_set;
+  GtkStyle *style;
+  gint i, state;
+
+  pixbuf = create_pixbuf (TRUE);
+  icon_set = gtk_icon_set_new_from_pixbuf (pixbuf);
+  style = gtk_style_new ();
+
+  /* More combinations than a set used to keep */
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    for (state = 0; state < 5; state++)
+      rendered[i][state] = gtk_icon_set_render_icon (icon_set, style,
+                                                     GTK_TEXT_DIR_NONE, state,
+                                                     sizes[i], NULL, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    for (state = 0; state < 5; state++)
+      {
+        again = gtk_icon_set_render_icon (icon_set, style,
+                                          GTK_TEXT_DIR_NONE, state,
+                                          sizes[i], NULL, NULL);
+        g_assert (again == rendered[i][state]);
+        g_object_unref (again);
+        g_object_unref (rendered[i][state]);
+      }
+
+  g_object_unref (style);
+  gtk_icon_set_unref (icon_set);
+  g_object_unref (pixbuf);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/icon-factory/render/effects-rgba", test_effects_rgba);
+  g_test_add_func ("/icon-factory/render/effects-rgb", test_effects_rgb);
+  g_test_add_func ("/icon-factory/render/shared", test_shared);
+  g_test_add_func ("/icon-factory/icon-set/cache", test_icon_set);
+
+  return g_test_run ();
+}
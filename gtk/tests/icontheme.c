@@ -0,0 +1,377 @@
+/* GTK - The GIMP Toolkit
+ * icontheme.c: Check icon lookups and loading
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <unistd.h>
+#include <utime.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+
+static gchar *icon_dir = NULL;
+static const gchar *cache_dir = NULL;
+static GSList *icon_files = NULL;
+
+/* An icon theme that only has unthemed icons, from a directory of
+ * our own.
+ */
+static GtkIconTheme *
+create_icon_theme (void)
+{
+  GtkIconTheme *icon_theme = gtk_icon_theme_new ();
+  const gchar *path[] = { icon_dir };
+
+  gtk_icon_theme_set_search_path (icon_theme, path, 1);
+
+  return icon_theme;
+}
+
+static void
+add_icon (const gchar *name)
+{
+  gchar *filename = g_strconcat (icon_dir, G_DIR_SEPARATOR_S, name, ".png", NULL);
+
+  g_assert (g_file_set_contents (filename, "", 0, NULL));
+  icon_files = g_slist_prepend (icon_files, filename);
+}
+
+static void
+set_mtime (const gchar *dir,
+           time_t       mtime)
+{
+  struct utimbuf times;
+
+  times.actime = times.modtime = mtime;
+  g_assert (g_utime (dir, &times) == 0);
+}
+
+static void
+test_shared (void)
+{
+  GtkIconTheme *icon_theme;
+  GtkIconInfo *info, *info2;
+
+  add_icon ("test-shared");
+  icon_theme = create_icon_theme ();
+
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-shared", 16, 0);
+  g_assert (info != NULL);
+  g_assert (g_str_has_suffix (gtk_icon_info_get_filename (info), "test-shared.png"));
+
+  info2 = gtk_icon_theme_lookup_icon (icon_theme, "test-shared", 16, 0);
+  g_assert (info2 == info);
+  gtk_icon_info_free (info2);
+
+  /* Anything else in the lookup is a different result */
+  info2 = gtk_icon_theme_lookup_icon (icon_theme, "test-shared", 24, 0);
+  g_assert (info2 != NULL && info2 != info);
+  gtk_icon_info_free (info2);
+
+  info2 = gtk_icon_theme_lookup_icon (icon_theme, "test-shared", 16,
+                                      GTK_ICON_LOOKUP_FORCE_SIZE);
+  g_assert (info2 != NULL && info2 != info);
+  gtk_icon_info_free (info2);
+
+  /* Raw coordinates aren't passed on to other users */
+  gtk_icon_info_set_raw_coordinates (info, TRUE);
+  info2 = gtk_icon_theme_lookup_icon (icon_theme, "test-shared", 16, 0);
+  g_assert (info2 != NULL && info2 != info);
+  gtk_icon_info_free (info2);
+
+  gtk_icon_info_free (info);
+  g_object_unref (icon_theme);
+}
+
+static void
+test_missing (void)
+{
+  GtkIconTheme *icon_theme;
+  GtkIconInfo *info;
+
+  icon_theme = create_icon_theme ();
+
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-missing", 16, 0);
+  g_assert (info == NULL);
+
+  /* Missing icons are remembered until the theme changes */
+  add_icon ("test-missing");
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-missing", 16, 0);
+  g_assert (info == NULL);
+
+  /* Make sure the rescan notices, even within the same second */
+  set_mtime (icon_dir, 0);
+  g_assert (gtk_icon_theme_rescan_if_needed (icon_theme));
+
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-missing", 16, 0);
+  g_assert (info != NULL);
+  gtk_icon_info_free (info);
+
+  g_object_unref (icon_theme);
+}
+
+static void
+test_builtin (void)
+{
+  GtkIconTheme *icon_theme;
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+
+  icon_theme = create_icon_theme ();
+
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-builtin", 16,
+                                     GTK_ICON_LOOKUP_USE_BUILTIN);
+  g_assert (info == NULL);
+
+  /* Adding a builtin icon makes the earlier miss stale */
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 16, 16);
+  gtk_icon_theme_add_builtin_icon ("test-builtin", 16, pixbuf);
+  g_object_unref (pixbuf);
+
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-builtin", 16,
+                                     GTK_ICON_LOOKUP_USE_BUILTIN);
+  g_assert (info != NULL);
+  gtk_icon_info_free (info);
+
+  g_object_unref (icon_theme);
+}
+
+static void
+test_theme_change (void)
+{
+  GtkIconTheme *icon_theme;
+  GtkIconInfo *info, *info2;
+  const gchar *path[] = { NULL };
+
+  add_icon ("test-change");
+  icon_theme = create_icon_theme ();
+
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-change", 16, 0);
+  g_assert (info != NULL);
+
+  gtk_icon_theme_set_custom_theme (icon_theme, "test-other");
+  info2 = gtk_icon_theme_lookup_icon (icon_theme, "test-change", 16, 0);
+  g_assert (info2 != NULL && info2 != info);
+  gtk_icon_info_free (info2);
+
+  gtk_icon_theme_set_search_path (icon_theme, path, 0);
+  info2 = gtk_icon_theme_lookup_icon (icon_theme, "test-change", 16, 0);
+  g_assert (info2 == NULL);
+
+  gtk_icon_info_free (info);
+  g_object_unref (icon_theme);
+}
+
+static gboolean
+has_icon (const gchar *name)
+{
+  GtkIconTheme *icon_theme;
+  gboolean result;
+
+  icon_theme = create_icon_theme ();
+  result = gtk_icon_theme_has_icon (icon_theme, name);
+  g_object_unref (icon_theme);
+
+  return result;
+}
+
+static void
+test_user_cache (void)
+{
+  gchar *checksum, *basename, *index_file;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, icon_dir, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  index_file = g_build_filename (cache_dir, "gtk-2.0", "icon-theme", basename, NULL);
+  g_remove (index_file);
+
+  /* Directories that just changed aren't indexed */
+  add_icon ("test-index");
+  g_assert (has_icon ("test-index"));
+  g_assert (!g_file_test (index_file, G_FILE_TEST_IS_REGULAR));
+
+  set_mtime (icon_dir, 1000);
+  g_assert (has_icon ("test-index"));
+  g_assert (g_file_test (index_file, G_FILE_TEST_IS_REGULAR));
+
+  /* The index is trusted as long as the mtime stays the same */
+  add_icon ("test-index-new");
+  set_mtime (icon_dir, 1000);
+  g_assert (has_icon ("test-index"));
+  g_assert (!has_icon ("test-index-new"));
+
+  set_mtime (icon_dir, 2000);
+  g_assert (has_icon ("test-index-new"));
+
+  g_free (index_file);
+  g_free (basename);
+  g_free (checksum);
+}
+
+/* A 16x16 red icon that can actually be loaded */
+static void
+add_png_icon (const gchar *name)
+{
+  GdkPixbuf *pixbuf;
+  gchar *filename;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 16, 16);
+  gdk_pixbuf_fill (pixbuf, 0xff0000ff);
+  filename = g_strconcat (icon_dir, G_DIR_SEPARATOR_S, name, ".png", NULL);
+  g_assert (gdk_pixbuf_save (pixbuf, filename, "png", NULL, NULL));
+  icon_files = g_slist_prepend (icon_files, filename);
+  g_object_unref (pixbuf);
+}
+
+typedef struct
+{
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+} LoadData;
+
+static void
+loaded_cb (GObject      *source,
+           GAsyncResult *result,
+           gpointer      data)
+{
+  LoadData *load = data;
+
+  load->pixbuf = gtk_icon_info_load_icon_finish (load->info, result, NULL);
+  g_assert (load->pixbuf != NULL);
+}
+
+static void
+test_load_async (void)
+{
+  GtkIconTheme *icon_theme;
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+  LoadData load1 = { NULL, }, load2 = { NULL, };
+
+  add_png_icon ("test-async");
+
+  icon_theme = create_icon_theme ();
+  info = gtk_icon_theme_lookup_icon (icon_theme, "test-async", 16, 0);
+  g_assert (info != NULL);
+
+  /* Both wait for the same load */
+  load1.info = load2.info = info;
+  gtk_icon_info_load_icon_async (info, NULL, loaded_cb, &load1);
+  gtk_icon_info_load_icon_async (info, NULL, loaded_cb, &load2);
+  while (load1.pixbuf == NULL || load2.pixbuf == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert (load1.pixbuf == load2.pixbuf);
+  g_assert_cmpint (gdk_pixbuf_get_width (load1.pixbuf), ==, 16);
+
+  /* The result stays with the info */
+  pixbuf = gtk_icon_info_load_icon (info, NULL);
+  g_assert (pixbuf == load1.pixbuf);
+
+  g_object_unref (pixbuf);
+  g_object_unref (load1.pixbuf);
+  g_object_unref (load2.pixbuf);
+  gtk_icon_info_free (info);
+  g_object_unref (icon_theme);
+}
+
+static void
+test_cell_load_async (void)
+{
+  GtkWidget *window;
+  GtkCellRenderer *cell;
+  GdkPixbuf *placeholder, *pixbuf;
+  const gchar *path[] = { icon_dir };
+
+  add_png_icon ("test-cell-async");
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_widget_realize (window);
+  gtk_icon_theme_set_search_path (gtk_icon_theme_get_for_screen (gtk_widget_get_screen (window)),
+                                  path, 1);
+
+  cell = gtk_cell_renderer_pixbuf_new ();
+  g_object_ref_sink (cell);
+  g_object_set (cell,
+                "icon-name", "test-cell-async",
+                "stock-size", GTK_ICON_SIZE_MENU,
+                "load-async", TRUE,
+                NULL);
+
+  /* The cell shows a placeholder until the icon is loaded */
+  gtk_cell_renderer_get_size (cell, window, NULL, NULL, NULL, NULL, NULL);
+  placeholder = GTK_CELL_RENDERER_PIXBUF (cell)->pixbuf;
+  g_assert (placeholder != NULL);
+  g_assert_cmpint (gdk_pixbuf_get_pixels (placeholder)[0], ==, 0);
+
+  while (GTK_CELL_RENDERER_PIXBUF (cell)->pixbuf == placeholder)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* and then the icon itself */
+  gtk_cell_renderer_get_size (cell, window, NULL, NULL, NULL, NULL, NULL);
+  pixbuf = GTK_CELL_RENDERER_PIXBUF (cell)->pixbuf;
+  g_assert (pixbuf != NULL && pixbuf != placeholder);
+  g_assert_cmpint (gdk_pixbuf_get_pixels (pixbuf)[0], ==, 0xff);
+
+  g_object_unref (cell);
+  gtk_widget_destroy (window);
+}
+
+extern void pixbuf_init (void);
+extern const gchar *cache_dir_init (const gchar *prefix);
+extern void cache_dir_cleanup (void);
+
+int
+main (int argc, char *argv[])
+{
+  gchar *name;
+  GSList *l;
+  int result;
+
+  /* Keep the per-user icon index out of the real cache directory */
+  cache_dir = cache_dir_init ("icontheme");
+
+  pixbuf_init ();
+  gtk_test_init (&argc, &argv, NULL);
+
+  /* Failed lookups warn once if the hicolor theme isn't installed */
+  g_log_set_always_fatal (G_LOG_LEVEL_CRITICAL | G_LOG_FATAL_MASK);
+
+  name = g_strdup_printf ("icontheme-%d", (int) getpid ());
+  icon_dir = g_build_filename (g_get_tmp_dir (), name, NULL);
+  g_assert (g_mkdir (icon_dir, 0700) == 0);
+  g_free (name);
+
+  g_test_add_func ("/icon-theme/lookup/shared", test_shared);
+  g_test_add_func ("/icon-theme/lookup/missing", test_missing);
+  g_test_add_func ("/icon-theme/lookup/builtin", test_builtin);
+  g_test_add_func ("/icon-theme/lookup/theme-change", test_theme_change);
+  g_test_add_func ("/icon-theme/index/user-cache", test_user_cache);
+  g_test_add_func ("/icon-theme/load/async", test_load_async);
+  g_test_add_func ("/icon-theme/load/cell-async", test_cell_load_async);
+
+  result = g_test_run ();
+
+  for (l = icon_files; l; l = l->next)
+    g_remove (l->data);
+  g_slist_foreach (icon_files, (GFunc) g_free, NULL);
+  g_slist_free (icon_files);
+  g_rmdir (icon_dir);
+  g_free (icon_dir);
+  cache_dir_cleanup ();
+
+  return result;
+}
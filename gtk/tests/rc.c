@@ -0,0 +1,168 @@
+/* GTK - The GIMP Toolkit
+ * rc.c: Check that compiled gtkrc files do what the files say
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <unistd.h>
+#include <utime.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+
+static const gchar *cache_dir = NULL;
+
+/* Has a bit of everything: settings, one of them an identifier that
+ * makes the parser look ahead, a style with a parent, literal and
+ * symbolic colors, a style property, and a widget pattern.
+ */
+static const gchar rc_format[] =
+  "gtk-double-click-time = 321\n"
+  "gtk-toolbar-style = GTK_TOOLBAR_ICONS\n"
+  "style \"test-base\" { xthickness = 7 }\n"
+  "style \"test\" = \"test-base\"\n"
+  "{\n"
+  "  color[\"test_fg\"] = \"#0000ff\"\n"
+  "  bg[NORMAL] = \"%s\"\n"
+  "  fg[NORMAL] = @test_fg\n"
+  "  GtkButton::child-displacement-x = 5\n"
+  "  font_name = \"Sans 13\"\n"
+  "}\n"
+  "widget \"test-widget\" style \"test\"\n";
+
+static void
+write_rc_file (const gchar *filename,
+               const gchar *bg,
+               time_t       mtime)
+{
+  struct utimbuf times;
+  gchar *contents;
+
+  contents = g_strdup_printf (rc_format, bg);
+  g_assert (g_file_set_contents (filename, contents, -1, NULL));
+  g_free (contents);
+
+  times.actime = times.modtime = mtime;
+  g_assert (g_utime (filename, &times) == 0);
+}
+
+static void
+check_style (guint16 bg_red)
+{
+  GtkSettings *settings = gtk_settings_get_default ();
+  GtkStyle *style;
+  GtkToolbarStyle toolbar_style;
+  gint double_click_time, displacement;
+
+  g_object_get (settings,
+                "gtk-double-click-time", &double_click_time,
+                "gtk-toolbar-style", &toolbar_style,
+                NULL);
+  g_assert_cmpint (double_click_time, ==, 321);
+  g_assert_cmpint (toolbar_style, ==, GTK_TOOLBAR_ICONS);
+
+  style = gtk_rc_get_style_by_paths (settings, "test-widget", NULL, G_TYPE_NONE);
+  g_assert (style != NULL);
+
+  g_assert_cmpuint (style->bg[GTK_STATE_NORMAL].red, ==, bg_red);
+  g_assert_cmpuint (style->fg[GTK_STATE_NORMAL].red, ==, 0);
+  g_assert_cmpuint (style->fg[GTK_STATE_NORMAL].blue, ==, 0xffff);
+  g_assert_cmpint (style->xthickness, ==, 7);
+  g_assert_cmpint (pango_font_description_get_size (style->font_desc), ==,
+                   13 * PANGO_SCALE);
+
+  gtk_style_get (style, GTK_TYPE_BUTTON,
+                 "child-displacement-x", &displacement,
+                 NULL);
+  g_assert_cmpint (displacement, ==, 5);
+}
+
+static void
+test_compiled (void)
+{
+  GtkSettings *settings = gtk_settings_get_default ();
+  gchar *name, *filename, *checksum, *basename, *cache_file, *contents;
+  gsize length, new_length;
+
+  name = g_strdup_printf ("rc-%d", (int) getpid ());
+  filename = g_build_filename (g_get_tmp_dir (), name, NULL);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, filename, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  cache_file = g_build_filename (cache_dir, "gtk-2.0", "rc", basename, NULL);
+
+  write_rc_file (filename, "#ff0000", 1000);
+  gtk_rc_parse (filename);
+  g_assert (g_file_test (cache_file, G_FILE_TEST_IS_REGULAR));
+  check_style (0xffff);
+
+  /* Running the compiled file does the same as parsing it */
+  gtk_rc_reparse_all_for_settings (settings, TRUE);
+  check_style (0xffff);
+
+  /* The compiled file is trusted as long as the file keeps its
+   * size and mtime
+   */
+  write_rc_file (filename, "#00ff00", 1000);
+  gtk_rc_reparse_all_for_settings (settings, TRUE);
+  check_style (0xffff);
+
+  write_rc_file (filename, "#00ff00", 2000);
+  gtk_rc_reparse_all_for_settings (settings, TRUE);
+  check_style (0);
+
+  /* A damaged compiled file is parsed again, and replaced */
+  g_assert (g_file_get_contents (cache_file, &contents, &length, NULL));
+  g_assert (g_file_set_contents (cache_file, contents, length - 3, NULL));
+  gtk_rc_reparse_all_for_settings (settings, TRUE);
+  check_style (0);
+  g_free (contents);
+
+  g_assert (g_file_get_contents (cache_file, &contents, &new_length, NULL));
+  g_assert_cmpuint (new_length, ==, length);
+  g_free (contents);
+
+  g_remove (filename);
+  g_free (cache_file);
+  g_free (basename);
+  g_free (checksum);
+  g_free (filename);
+  g_free (name);
+}
+
+extern const gchar *cache_dir_init (const gchar *prefix);
+extern void cache_dir_cleanup (void);
+
+int
+main (int argc, char *argv[])
+{
+  int result;
+
+  /* Keep compiled files out of the real cache directory */
+  cache_dir = cache_dir_init ("rc");
+
+  gtk_test_init (&argc, &argv, NULL);
+
+  /* Install the style property and setting the file uses */
+  g_type_class_unref (g_type_class_ref (GTK_TYPE_BUTTON));
+  g_type_class_unref (g_type_class_ref (GTK_TYPE_TOOLBAR));
+
+  g_test_add_func ("/rc/compiled", test_compiled);
+
+  result = g_test_run ();
+
+  cache_dir_cleanup ();
+
+  return result;
+}
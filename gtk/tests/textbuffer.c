@@ -21,7 +21,9 @@
 #include "config.h"
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include "gtk/gtktexttypes.h" /* Private header, for UNKNOWN_CHAR */
 
@@ -1320,6 +1322,387 @@ test_tag (void)
   g_object_unref (buffer);
 }
 
+static GMappedFile *
+map_text (const gchar *text,
+          gsize        len)
+{
+  GMappedFile *file;
+  GError *error = NULL;
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp ("textbuffer-XXXXXX", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  g_file_set_contents (filename, text, len, &error);
+  g_assert_no_error (error);
+
+  file = g_mapped_file_new (filename, FALSE, &error);
+  g_assert_no_error (error);
+
+  g_unlink (filename);
+  g_free (filename);
+
+  return file;
+}
+
+static void
+test_mapped_file (void)
+{
+  static const gchar contents[] = "First line\nSecond \xc3\xa9 line\r\nThird";
+  GtkTextBuffer *buffer;
+  GMappedFile *file;
+  GtkTextIter start, end;
+  gchar *text;
+
+  buffer = gtk_text_buffer_new (NULL);
+  fill_buffer (buffer);
+
+  file = map_text (contents, strlen (contents));
+  gtk_text_buffer_set_mapped_file (buffer, file);
+  g_mapped_file_unref (file);
+
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 3);
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==,
+                   g_utf8_strlen (contents, -1));
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpstr (text, ==, contents);
+  g_free (text);
+
+  run_tests (buffer);
+
+  /* Edits only replace the touched range */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 1, 7);
+  gtk_text_buffer_insert (buffer, &start, "new ", -1);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 0, 0);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &end, 0, 6);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 12);
+  gtk_text_buffer_apply_tag_by_name (buffer, "fg_blue", &start, &end);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpstr (text, ==, "line\nSecond new \xc3\xa9 line\r\nThird");
+  g_free (text);
+
+  run_tests (buffer);
+
+  /* Invalid UTF-8 is replaced, not referenced */
+  file = map_text ("a\xffb\n", 4);
+  gtk_text_buffer_set_mapped_file (buffer, file);
+  g_mapped_file_unref (file);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpstr (text, ==, "a\357\277\275b\n");
+  g_free (text);
+
+  run_tests (buffer);
+
+  g_object_unref (buffer);
+}
+
+/* MAPPED_SCAN_CHUNK in gtktextbuffer.c; slices are cut after a
+ * newline found between one and two chunks, or at two chunks.
+ */
+#define SCAN_CHUNK (256 * 1024)
+
+static void
+load_mapped (GtkTextBuffer *buffer,
+             const gchar   *contents,
+             gsize          len)
+{
+  GMappedFile *file;
+
+  file = map_text (contents, len);
+  gtk_text_buffer_set_mapped_file (buffer, file);
+  g_mapped_file_unref (file);
+}
+
+static void
+finish_loading (GtkTextBuffer *buffer)
+{
+  while (gtk_text_buffer_get_mapped_file (buffer))
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+check_text (GtkTextBuffer *buffer,
+            const gchar   *expected)
+{
+  GtkTextIter start, end;
+  gchar *text;
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpint (strlen (text), ==, strlen (expected));
+  g_assert (strcmp (text, expected) == 0);
+  g_free (text);
+
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==,
+                   g_utf8_strlen (expected, -1));
+}
+
+static void
+test_mapped_file_chunks (void)
+{
+  GtkTextBuffer *buffer;
+  GString *contents;
+  GtkTextIter iter, end;
+  gint i;
+
+  buffer = gtk_text_buffer_new (NULL);
+
+  /* Many lines over several slices */
+  contents = g_string_new (NULL);
+  for (i = 0; contents->len < 5 * SCAN_CHUNK; i++)
+    g_string_append_printf (contents, "line %d\n", i);
+  g_string_append (contents, "last");
+
+  load_mapped (buffer, contents->str, contents->len);
+  g_assert (gtk_text_buffer_get_mapped_file (buffer) != NULL);
+  finish_loading (buffer);
+  check_text (buffer, contents->str);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, i + 1);
+
+  /* Text typed at the end while loading stays at the end */
+  load_mapped (buffer, contents->str, contents->len);
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, " typed", -1);
+  g_assert (gtk_text_buffer_get_mapped_file (buffer) != NULL);
+  finish_loading (buffer);
+  g_string_append (contents, " typed");
+  check_text (buffer, contents->str);
+  g_string_truncate (contents, contents->len - strlen (" typed"));
+
+  /* Editing the loaded text stops loading */
+  load_mapped (buffer, contents->str, contents->len);
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, "x", -1);
+  g_assert (gtk_text_buffer_get_mapped_file (buffer) == NULL);
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), <, contents->len);
+
+  /* So does deleting all of it */
+  load_mapped (buffer, contents->str, contents->len);
+  gtk_text_buffer_get_bounds (buffer, &iter, &end);
+  gtk_text_buffer_delete (buffer, &iter, &end);
+  g_assert (gtk_text_buffer_get_mapped_file (buffer) == NULL);
+  while (g_main_context_iteration (NULL, FALSE));
+  check_text (buffer, "");
+
+  /* And replacing it */
+  load_mapped (buffer, contents->str, contents->len);
+  gtk_text_buffer_set_text (buffer, "replaced", -1);
+  g_assert (gtk_text_buffer_get_mapped_file (buffer) == NULL);
+  while (g_main_context_iteration (NULL, FALSE));
+  check_text (buffer, "replaced");
+
+  /* A line longer than a slice */
+  g_string_truncate (contents, 0);
+  for (i = 0; i < 5 * SCAN_CHUNK; i++)
+    g_string_append_c (contents, 'a' + i % 26);
+  g_string_append (contents, "\ntail");
+
+  load_mapped (buffer, contents->str, contents->len);
+  finish_loading (buffer);
+  check_text (buffer, contents->str);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 2);
+
+  /* A \r\n pair right at the cut stays together */
+  g_string_truncate (contents, 0);
+  for (i = 0; i < 2 * SCAN_CHUNK - 1; i++)
+    g_string_append_c (contents, 'a');
+  g_string_append (contents, "\r\n");
+  for (i = 0; i < 3 * SCAN_CHUNK; i++)
+    g_string_append_c (contents, 'b');
+
+  load_mapped (buffer, contents->str, contents->len);
+  finish_loading (buffer);
+  check_text (buffer, contents->str);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 2);
+
+  /* So does a character */
+  g_string_truncate (contents, 0);
+  for (i = 0; i < 2 * SCAN_CHUNK - 1; i++)
+    g_string_append_c (contents, 'a');
+  g_string_append (contents, "\xc3\xa9");
+  for (i = 0; i < 3 * SCAN_CHUNK; i++)
+    g_string_append_c (contents, 'b');
+
+  load_mapped (buffer, contents->str, contents->len);
+  finish_loading (buffer);
+  check_text (buffer, contents->str);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 2 * SCAN_CHUNK - 1);
+  g_assert_cmpint (gtk_text_iter_get_char (&iter), ==, 0xe9);
+
+  g_string_free (contents, TRUE);
+  g_object_unref (buffer);
+}
+
+static GtkTextBuffer *
+deserialize_into_new_buffer (const gchar  *mime_type,
+                             const guint8 *data,
+                             gsize         length)
+{
+  GtkTextBuffer *buffer;
+  GdkAtom format;
+  GtkTextIter iter;
+  GError *error = NULL;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_register_deserialize_tagset (buffer, "test");
+  format = gdk_atom_intern (mime_type, FALSE);
+  gtk_text_buffer_deserialize_set_can_create_tags (buffer,
+                                                   gdk_atom_intern ("application/x-gtk-text-buffer-rich-text;format=test", FALSE),
+                                                   TRUE);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_buffer_deserialize (buffer, buffer, format, &iter,
+                               data, length, &error);
+  g_assert_no_error (error);
+
+  return buffer;
+}
+
+static void
+check_same_contents (GtkTextBuffer *a,
+                     GtkTextBuffer *b)
+{
+  GtkTextIter ia, ib;
+  gchar *text_a, *text_b;
+
+  gtk_text_buffer_get_bounds (a, &ia, &ib);
+  text_a = gtk_text_buffer_get_slice (a, &ia, &ib, TRUE);
+  gtk_text_buffer_get_bounds (b, &ia, &ib);
+  text_b = gtk_text_buffer_get_slice (b, &ia, &ib, TRUE);
+  g_assert_cmpstr (text_a, ==, text_b);
+  g_free (text_a);
+  g_free (text_b);
+
+  gtk_text_buffer_get_start_iter (a, &ia);
+  gtk_text_buffer_get_start_iter (b, &ib);
+
+  do
+    {
+      GSList *tags_a, *tags_b, *l, *m;
+
+      tags_a = gtk_text_iter_get_tags (&ia);
+      tags_b = gtk_text_iter_get_tags (&ib);
+      g_assert_cmpint (g_slist_length (tags_a), ==, g_slist_length (tags_b));
+
+      for (l = tags_a, m = tags_b; l; l = l->next, m = m->next)
+        {
+          GtkTextTag *ta = l->data, *tb = m->data;
+
+          g_assert_cmpstr (ta->name, ==, tb->name);
+          g_assert_cmpint (ta->values->appearance.underline, ==,
+                           tb->values->appearance.underline);
+          g_assert_cmpint (ta->values->font ? 1 : 0, ==,
+                           tb->values->font ? 1 : 0);
+        }
+
+      g_slist_free (tags_a);
+      g_slist_free (tags_b);
+
+      gtk_text_iter_forward_char (&ib);
+    }
+  while (gtk_text_iter_forward_char (&ia));
+}
+
+static void
+test_rich_text_round_trip (void)
+{
+  GtkTextBuffer *buffer, *xml_copy, *binary_copy;
+  GtkTextTag *anonymous;
+  GtkTextIter start, end;
+  GdkAtom *formats;
+  gint n_formats, i;
+  gchar *binary_type;
+  guint8 *xml_data, *binary_data;
+  gsize xml_length, binary_length;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_register_serialize_tagset (buffer, "test");
+
+  gtk_text_buffer_create_tag (buffer, "bold", "weight", PANGO_WEIGHT_BOLD, NULL);
+  gtk_text_buffer_create_tag (buffer, "under & <over>",
+                              "underline", PANGO_UNDERLINE_SINGLE, NULL);
+  anonymous = gtk_text_tag_new (NULL);
+  g_object_set (anonymous, "family", "Monospace", "left-margin", 12, NULL);
+  gtk_text_tag_table_add (gtk_text_buffer_get_tag_table (buffer), anonymous);
+  g_object_unref (anonymous);
+
+  gtk_text_buffer_set_text (buffer, "plain \xc3\xa9 bold\nboth\n\nanon <&> end", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 8);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 17);
+  gtk_text_buffer_apply_tag_by_name (buffer, "bold", &start, &end);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 13);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 25);
+  gtk_text_buffer_apply_tag_by_name (buffer, "under & <over>", &start, &end);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 20);
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_apply_tag (buffer, anonymous, &start, &end);
+
+  binary_type = g_strdup_printf ("application/x-gtk-text-buffer-binary-rich-text-%d.%d;format=test",
+                                 GTK_MAJOR_VERSION, GTK_MINOR_VERSION);
+
+  formats = gtk_text_buffer_get_serialize_formats (buffer, &n_formats);
+  for (i = 0; i < n_formats; i++)
+    if (formats[i] == gdk_atom_intern (binary_type, FALSE))
+      break;
+  g_assert_cmpint (i, <, n_formats);
+  g_free (formats);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  xml_data = gtk_text_buffer_serialize (buffer, buffer,
+                                        gdk_atom_intern ("application/x-gtk-text-buffer-rich-text;format=test", FALSE),
+                                        &start, &end, &xml_length);
+  binary_data = gtk_text_buffer_serialize (buffer, buffer,
+                                           gdk_atom_intern (binary_type, FALSE),
+                                           &start, &end, &binary_length);
+  g_assert (xml_data != NULL);
+  g_assert (binary_data != NULL);
+  g_assert_cmpuint (binary_length, <, xml_length);
+
+  xml_copy = deserialize_into_new_buffer ("application/x-gtk-text-buffer-rich-text;format=test",
+                                          xml_data, xml_length);
+  binary_copy = deserialize_into_new_buffer (binary_type,
+                                             binary_data, binary_length);
+
+  check_same_contents (buffer, xml_copy);
+  check_same_contents (buffer, binary_copy);
+
+  /* The binary format is the one asked for first when pasting */
+  formats = gtk_text_buffer_get_deserialize_formats (binary_copy, &n_formats);
+  g_assert (formats[0] == gdk_atom_intern (binary_type, FALSE));
+  g_free (formats);
+
+  /* Unregistering the tagset takes the binary format with it */
+  gtk_text_buffer_unregister_deserialize_format (binary_copy,
+                                                 gdk_atom_intern ("application/x-gtk-text-buffer-rich-text;format=test", FALSE));
+  formats = gtk_text_buffer_get_deserialize_formats (binary_copy, &n_formats);
+  g_assert_cmpint (n_formats, ==, 0);
+  g_free (formats);
+
+  gtk_text_buffer_unregister_serialize_format (buffer,
+                                               gdk_atom_intern ("application/x-gtk-text-buffer-rich-text;format=test", FALSE));
+  formats = gtk_text_buffer_get_serialize_formats (buffer, &n_formats);
+  for (i = 0; i < n_formats; i++)
+    g_assert (formats[i] != gdk_atom_intern (binary_type, FALSE));
+  g_free (formats);
+
+  g_free (xml_data);
+  g_free (binary_data);
+  g_free (binary_type);
+  g_object_unref (xml_copy);
+  g_object_unref (binary_copy);
+  g_object_unref (buffer);
+}
+
 extern void pixbuf_init (void);
 
 int
@@ -1340,6 +1723,9 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Get and Set", test_get_set);
   g_test_add_func ("/TextBuffer/Fill and Empty", test_fill_empty);
   g_test_add_func ("/TextBuffer/Tag", test_tag);
+  g_test_add_func ("/TextBuffer/Mapped file", test_mapped_file);
+  g_test_add_func ("/TextBuffer/Mapped file chunks", test_mapped_file_chunks);
+  g_test_add_func ("/TextBuffer/Rich text round trip", test_rich_text_round_trip);
   
   return g_test_run();
 }
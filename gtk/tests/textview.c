@@ -0,0 +1,129 @@
+/* GTK - The GIMP Toolkit
+ * textview.c: Check positions in GtkTextView
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+/* LONG_LINE_BYTES in gtktextlayout.c; longer paragraphs map positions
+ * with an index of their wrapped lines.
+ */
+#define LONG_LINE_BYTES 32768
+
+static void
+check_round_trip (GtkTextView       *view,
+                  const GtkTextIter *iter)
+{
+  GdkRectangle rect;
+  GtkTextIter found;
+
+  gtk_text_view_get_iter_location (view, iter, &rect);
+  g_assert_cmpint (rect.width, >, 0);
+
+  gtk_text_view_get_iter_at_location (view, &found,
+                                      rect.x + rect.width / 2,
+                                      rect.y + rect.height / 2);
+  g_assert_cmpint (gtk_text_iter_get_offset (&found), ==,
+                   gtk_text_iter_get_offset (iter));
+}
+
+/* Goes over the wrapped lines of the first paragraph, checking the
+ * characters on both sides of each line break.
+ */
+static void
+check_wrapped_lines (GtkTextView *view)
+{
+  GtkTextBuffer *buffer = gtk_text_view_get_buffer (view);
+  GtkTextIter iter, prev;
+  GdkRectangle rect, prev_rect;
+  gint n_lines = 0;
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  check_round_trip (view, &iter);
+
+  while (gtk_text_view_forward_display_line (view, &iter) &&
+         gtk_text_iter_get_line (&iter) == 0)
+    {
+      g_assert (gtk_text_view_starts_display_line (view, &iter));
+
+      prev = iter;
+      gtk_text_iter_backward_char (&prev);
+      gtk_text_view_get_iter_location (view, &prev, &prev_rect);
+      gtk_text_view_get_iter_location (view, &iter, &rect);
+
+      g_assert_cmpint (rect.y, >=, prev_rect.y + prev_rect.height);
+      g_assert_cmpint (rect.x, <, prev_rect.x);
+
+      check_round_trip (view, &prev);
+      check_round_trip (view, &iter);
+
+      n_lines++;
+    }
+
+  g_assert_cmpint (n_lines, >, 100);
+}
+
+static void
+test_long_paragraph (void)
+{
+  GtkWidget *window, *view;
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  GString *text;
+  gint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; text->len < 2 * LONG_LINE_BYTES; i++)
+    g_string_append_printf (text, "word%d ", i);
+  g_string_append (text, "\nend");
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 300, 300);
+  view = gtk_text_view_new ();
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), GTK_WRAP_WORD);
+  gtk_container_add (GTK_CONTAINER (window), view);
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+  gtk_widget_show_all (window);
+
+  check_wrapped_lines (GTK_TEXT_VIEW (view));
+
+  /* Edits in the middle rewrap the paragraph */
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, LONG_LINE_BYTES);
+  gtk_text_buffer_insert (buffer, &iter, "inserted words ", -1);
+  check_wrapped_lines (GTK_TEXT_VIEW (view));
+
+  /* And so do width changes */
+  gtk_text_view_set_left_margin (GTK_TEXT_VIEW (view), 50);
+  check_wrapped_lines (GTK_TEXT_VIEW (view));
+
+  gtk_widget_destroy (window);
+  g_string_free (text, TRUE);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/TextView/Long paragraph", test_long_paragraph);
+
+  return g_test_run ();
+}
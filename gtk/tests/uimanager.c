@@ -0,0 +1,248 @@
+/* GTK - The GIMP Toolkit
+ * uimanager.c: Check merging and unmerging of UI definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static const gchar ui_base[] =
+  "<ui>"
+  "  <menubar name='menubar'>"
+  "    <menu action='file'>"
+  "      <menuitem action='a'/>"
+  "      <placeholder name='slot'/>"
+  "      <menuitem action='b'/>"
+  "      <separator/>"
+  "      <menuitem action='c'/>"
+  "    </menu>"
+  "  </menubar>"
+  "  <toolbar name='toolbar'>"
+  "    <toolitem action='a'/>"
+  "    <placeholder name='slot'/>"
+  "    <toolitem action='c'/>"
+  "  </toolbar>"
+  "</ui>";
+
+static const gchar ui_slot[] =
+  "<ui>"
+  "  <menubar name='menubar'>"
+  "    <menu action='file'>"
+  "      <placeholder name='slot'>"
+  "        <menuitem action='d'/>"
+  "        <menuitem action='e'/>"
+  "      </placeholder>"
+  "    </menu>"
+  "  </menubar>"
+  "  <toolbar name='toolbar'>"
+  "    <placeholder name='slot'>"
+  "      <toolitem action='d'/>"
+  "      <toolitem action='e'/>"
+  "    </placeholder>"
+  "  </toolbar>"
+  "</ui>";
+
+static GtkActionGroup *
+create_action_group (const gchar *name,
+                     const gchar *actions)
+{
+  GtkActionGroup *group;
+  gchar **names;
+  gint i;
+
+  group = gtk_action_group_new (name);
+  names = g_strsplit (actions, " ", 0);
+  for (i = 0; names[i]; i++)
+    {
+      GtkAction *action = gtk_action_new (names[i], names[i], NULL, NULL);
+
+      gtk_action_group_add_action (group, action);
+      g_object_unref (action);
+    }
+  g_strfreev (names);
+
+  return group;
+}
+
+/* Lists the actions of the visible items of @shell, with "-" for
+ * separators.
+ */
+static gchar *
+list_items (GtkWidget *shell)
+{
+  GString *items = g_string_new (NULL);
+  GList *children, *l;
+
+  children = gtk_container_get_children (GTK_CONTAINER (shell));
+  for (l = children; l; l = l->next)
+    {
+      GtkAction *action;
+
+      if (!gtk_widget_get_visible (l->data))
+        continue;
+
+      if (items->len)
+        g_string_append_c (items, ' ');
+
+      action = gtk_activatable_get_related_action (l->data);
+      if (action)
+        g_string_append (items, gtk_action_get_name (action));
+      else
+        g_string_append_c (items, '-');
+    }
+  g_list_free (children);
+
+  return g_string_free (items, FALSE);
+}
+
+static void
+assert_items (GtkUIManager *manager,
+              const gchar  *path,
+              const gchar  *expected)
+{
+  GtkWidget *widget;
+  gchar *items;
+
+  widget = gtk_ui_manager_get_widget (manager, path);
+  g_assert (widget != NULL);
+  if (GTK_IS_MENU_ITEM (widget))
+    widget = gtk_menu_item_get_submenu (GTK_MENU_ITEM (widget));
+
+  items = list_items (widget);
+  g_assert_cmpstr (items, ==, expected);
+  g_free (items);
+}
+
+static void
+test_merge (void)
+{
+  GtkUIManager *manager;
+  GtkActionGroup *group;
+  guint merge_id;
+  gint i;
+
+  manager = gtk_ui_manager_new ();
+  group = create_action_group ("base", "file a b c d e");
+  gtk_ui_manager_insert_action_group (manager, group, 0);
+
+  g_assert (gtk_ui_manager_add_ui_from_string (manager, ui_base, -1, NULL));
+  gtk_ui_manager_ensure_update (manager);
+
+  assert_items (manager, "/menubar/file", "a b - c");
+  assert_items (manager, "/toolbar", "a c");
+  g_assert (gtk_ui_manager_get_widget (manager, "/menubar/file/b") != NULL);
+  g_assert (gtk_ui_manager_get_widget (manager, "/menubar/file/x") == NULL);
+
+  /* Switching back and forth keeps the items in place */
+  for (i = 0; i < 3; i++)
+    {
+      merge_id = gtk_ui_manager_add_ui_from_string (manager, ui_slot, -1, NULL);
+      g_assert (merge_id != 0);
+      gtk_ui_manager_ensure_update (manager);
+
+      assert_items (manager, "/menubar/file", "a d e b - c");
+      assert_items (manager, "/toolbar", "a d e c");
+      g_assert (gtk_ui_manager_get_widget (manager, "/menubar/file/slot/e") != NULL);
+
+      gtk_ui_manager_remove_ui (manager, merge_id);
+      gtk_ui_manager_ensure_update (manager);
+
+      assert_items (manager, "/menubar/file", "a b - c");
+      assert_items (manager, "/toolbar", "a c");
+      g_assert (gtk_ui_manager_get_widget (manager, "/menubar/file/slot/e") == NULL);
+    }
+
+  /* Items added one by one go where they are asked to */
+  merge_id = gtk_ui_manager_new_merge_id (manager);
+  gtk_ui_manager_add_ui (manager, merge_id, "/menubar/file/slot",
+                         "e", "e", GTK_UI_MANAGER_MENUITEM, FALSE);
+  gtk_ui_manager_add_ui (manager, merge_id, "/menubar/file/slot",
+                         "d", "d", GTK_UI_MANAGER_MENUITEM, TRUE);
+  gtk_ui_manager_ensure_update (manager);
+  assert_items (manager, "/menubar/file", "a d e b - c");
+
+  g_object_unref (group);
+  g_object_unref (manager);
+}
+
+static void
+test_action_groups (void)
+{
+  GtkUIManager *manager;
+  GtkActionGroup *group, *other;
+  GtkWidget *a, *b;
+
+  manager = gtk_ui_manager_new ();
+  group = create_action_group ("base", "file a b c");
+  gtk_ui_manager_insert_action_group (manager, group, 0);
+  g_assert (gtk_ui_manager_add_ui_from_string (manager, ui_base, -1, NULL));
+  gtk_ui_manager_ensure_update (manager);
+
+  a = gtk_ui_manager_get_widget (manager, "/menubar/file/a");
+  b = gtk_ui_manager_get_widget (manager, "/menubar/file/b");
+  g_assert (a != NULL && b != NULL);
+
+  /* A group in front takes over the actions it has */
+  other = create_action_group ("other", "b");
+  gtk_ui_manager_insert_action_group (manager, other, 0);
+  gtk_ui_manager_ensure_update (manager);
+
+  g_assert (gtk_ui_manager_get_widget (manager, "/menubar/file/a") == a);
+  g_assert (gtk_ui_manager_get_widget (manager, "/menubar/file/b") == b);
+  g_assert (gtk_activatable_get_related_action (GTK_ACTIVATABLE (a)) ==
+            gtk_action_group_get_action (group, "a"));
+  g_assert (gtk_activatable_get_related_action (GTK_ACTIVATABLE (b)) ==
+            gtk_action_group_get_action (other, "b"));
+
+  gtk_ui_manager_remove_action_group (manager, other);
+  gtk_ui_manager_ensure_update (manager);
+
+  g_assert (gtk_activatable_get_related_action (GTK_ACTIVATABLE (b)) ==
+            gtk_action_group_get_action (group, "b"));
+  assert_items (manager, "/menubar/file", "a b - c");
+
+  /* Groups at the back are looked at too */
+  g_object_unref (other);
+  other = create_action_group ("other", "d e");
+  gtk_ui_manager_insert_action_group (manager, other, -1);
+  g_assert (gtk_ui_manager_add_ui_from_string (manager, ui_slot, -1, NULL));
+  gtk_ui_manager_ensure_update (manager);
+  assert_items (manager, "/toolbar", "a d e c");
+
+  /* Items of an action removed from its group before the group is
+   * removed from the manager go away with it
+   */
+  gtk_action_group_remove_action (other, gtk_action_group_get_action (other, "e"));
+  gtk_ui_manager_remove_action_group (manager, other);
+  gtk_ui_manager_ensure_update (manager);
+  assert_items (manager, "/toolbar", "a c");
+  assert_items (manager, "/menubar/file", "a b - c");
+
+  g_object_unref (other);
+  g_object_unref (group);
+  g_object_unref (manager);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/ui-manager/merge", test_merge);
+  g_test_add_func ("/ui-manager/action-groups", test_action_groups);
+
+  return g_test_run ();
+}